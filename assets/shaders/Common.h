@@ -24,4 +24,105 @@ struct ObjectParameterData
 	float4x4 localToWorld;
 };
 
+/**
+ * インスタンスのオブジェクトパラメータ
+ * 全オブジェクトのパラメータはエンジンが1本の配列(t3)にまとめ、メッシュ毎にインスタンス順の番号の配列(t0)を渡す
+ */
+StructuredBuffer<uint> InstanceObjects : register(t0);
+StructuredBuffer<ObjectParameterData> ObjectParameters : register(t3);
+
+ObjectParameterData GetInstanceObject(uint instanceId)
+{
+	return ObjectParameters[InstanceObjects[instanceId]];
+}
+
+/**
+ * 8面体写像した単位ベクトルの復元(エンジンのVertexQuantizer::DecodeOctahedral()と同じ計算)
+ */
+float3 DecodeOctahedral(float2 e)
+{
+	float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.0f) ? -t : t;
+	return normalize(n);
+}
+
+/**
+ * 頂点の法線、接線、従法線の復元
+ * VERTEX_QUANTIZEDはエンジンが量子化頂点用のVSをコンパイルする際に定義される
+ * 量子化時はsnorm16 x2で渡されるのでxyから復元する(UV、カラーはハードウェアで変換される)
+ */
+float3 DecodeVertexNormal(float3 n)
+{
+#if defined(VERTEX_QUANTIZED)
+	return DecodeOctahedral(n.xy);
+#else
+	return n;
+#endif
+}
+
+/**
+ * GPUスキニング
+ * VERTEX_SKINNEDはエンジンがスキニング用のVSをコンパイルする際に定義される
+ * SkinPaletteを参照しないシェーダはスキニングに対応していないとみなされCPU側の変形で描画される
+ * インフルエンスはエンジンのse::SkinInfluence(ジョイント番号16bit x4、ウェイトunorm8 x4)
+ * パレットはエンジンのse::SkinMatrix(行ベクトル規約の行列を転置した上3行)
+ */
+#if defined(VERTEX_SKINNED)
+struct SkinMatrix
+{
+	float4 rows[3];
+};
+StructuredBuffer<uint3> SkinInfluences : register(t1);
+StructuredBuffer<SkinMatrix> SkinPalette : register(t2);
+
+// 頂点のインフルエンスでブレンドしたパレット行列
+SkinMatrix GetSkinMatrix(uint vertexId)
+{
+	uint3 influence = SkinInfluences[vertexId];
+	uint joints[4] = { influence.x & 0xffff, influence.x >> 16, influence.y & 0xffff, influence.y >> 16 };
+	float4 weights = float4(influence.z & 0xff, (influence.z >> 8) & 0xff, (influence.z >> 16) & 0xff, influence.z >> 24) / 255.0f;
+
+	SkinMatrix result;
+	result.rows[0] = 0.0f;
+	result.rows[1] = 0.0f;
+	result.rows[2] = 0.0f;
+	[unroll]
+	for (uint i = 0; i < 4; i++) {
+		SkinMatrix m = SkinPalette[joints[i]];
+		result.rows[0] += m.rows[0] * weights[i];
+		result.rows[1] += m.rows[1] * weights[i];
+		result.rows[2] += m.rows[2] * weights[i];
+	}
+	return result;
+}
+#endif
+
+/**
+ * 頂点位置のスキニング(スキニングしないVSではそのまま返す)
+ */
+float4 SkinVertexPosition(float4 position, uint vertexId)
+{
+#if defined(VERTEX_SKINNED)
+	SkinMatrix m = GetSkinMatrix(vertexId);
+	float4 p = float4(position.xyz, 1.0f);
+	return float4(dot(m.rows[0], p), dot(m.rows[1], p), dot(m.rows[2], p), 1.0f);
+#else
+	return position;
+#endif
+}
+
+/**
+ * 法線系のスキニング(非一様スケールは考慮しない)
+ */
+float3 SkinVertexNormal(float3 normal, uint vertexId)
+{
+#if defined(VERTEX_SKINNED)
+	SkinMatrix m = GetSkinMatrix(vertexId);
+	return normalize(float3(dot(m.rows[0].xyz, normal), dot(m.rows[1].xyz, normal), dot(m.rows[2].xyz, normal)));
+#else
+	return normal;
+#endif
+}
+
 #endif
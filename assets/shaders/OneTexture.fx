@@ -8,9 +8,6 @@
 cbuffer ViewParameters : register(b0) {
 	ViewParameterData View;
 };
-cbuffer ObjectParameters : register(b1) {
-	ObjectParameterData Object;
-};
 Texture2D s_texture0 : register(t0);
 SamplerState s_sampler0 : register(s0);
 
@@ -26,11 +23,12 @@ struct VS_Output
 	float2 v_texcoord0	: TEXCOORD0;
 };
 
-VS_Output VS(VS_Input input)
+VS_Output VS(VS_Input input, uint instanceId : SV_InstanceID, uint vertexId : SV_VertexID)
 {
 	VS_Output output;
 
-	float4 worldPos = mul(input.a_position, Object.localToWorld);
+	float4 position = SkinVertexPosition(input.a_position, vertexId);
+	float4 worldPos = mul(position, GetInstanceObject(instanceId).localToWorld);
 	output.v_position = mul(worldPos, View.worldToClip);
 	output.v_texcoord0 = input.a_texcoord0;
 	return output;
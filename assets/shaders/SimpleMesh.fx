@@ -8,9 +8,6 @@
 cbuffer ViewParameters : register(b0) {
 	ViewParameterData View;
 };
-cbuffer ObjectParameters : register(b1) {
-	ObjectParameterData Object;
-};
 
 struct VS_Input
 {
@@ -22,11 +19,12 @@ struct VS_Output
 	float4 v_position 	: SV_POSITION;
 };
 
-VS_Output VS(VS_Input input)
+VS_Output VS(VS_Input input, uint instanceId : SV_InstanceID, uint vertexId : SV_VertexID)
 {
 	VS_Output output;
 
-	float4 worldPos = mul(input.a_position, Object.localToWorld);
+	float4 position = SkinVertexPosition(input.a_position, vertexId);
+	float4 worldPos = mul(position, GetInstanceObject(instanceId).localToWorld);
 	output.v_position = mul(worldPos, View.worldToClip);
 	return output;
 }
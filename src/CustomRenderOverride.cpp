@@ -6,8 +6,14 @@
 #include "CustomRenderOverride.h"
 #include "CustomRendererOperation.h"
 #include "bridge/DAGManager.h"
+#include "engine/Graphics/GeometryDiskCache.h"
 #include <shlobj.h>
 
+namespace {
+	// ジオメトリのディスクキャッシュの上限(globalsノードのdiskCacheSizeで上書きされる)
+	const uint64_t DefaultGeometryCacheSize = 1024ull << 20;
+}
+
 
 CustomRenderOverride::CustomRenderOverride(const MString& name)
 	: MRenderOverride(name)
@@ -105,8 +111,12 @@ bool CustomRenderOverride::InitializeEngine()
 
 	// エンジン
 	se::GraphicsCore::InitializeByExternalDevice(dxDevice);
+	se::ThreadPool::Get().Initialize();
+	se::GraphicsCore::InitializeDeferredContexts(se::ThreadPool::Get().GetWorkerCount() + 1);
 	std::string shaderDirectory = dataDirectory + "\\shaders";
 	se::ShaderManager::Get().Initialize(shaderDirectory.c_str());
+	std::string geometryCacheDirectory = dataDirectory + "\\geometry_cache";
+	se::GeometryDiskCache::Get().Initialize(geometryCacheDirectory.c_str(), DefaultGeometryCacheSize);
 	MDisplayInfo("MayaCustomViewport initialized. / %s", dataDirectory.c_str());
 
 	return true;
@@ -114,7 +124,9 @@ bool CustomRenderOverride::InitializeEngine()
 
 void CustomRenderOverride::FinalizeEngine()
 {
+	se::GeometryDiskCache::Get().Finalize();
 	se::ShaderManager::Get().Finalize();
+	se::ThreadPool::Get().Finalize();
 	se::GraphicsCore::Finalize();
 	MDisplayInfo("MayaCustomViewport Finalized.");
 }
@@ -102,7 +102,8 @@ MStatus CustomRenderOperation::execute(const MHWRender::MDrawContext& drawContex
 	ID3D11DeviceContext* dxContext = context.GetDeviceContext();
 	// 現在のステートをバックアップ
 	DX11StateBuckup dx11backup(dxContext);
-	dxContext->ClearState();
+	context.ClearState();
+	context.ResetStateStats();
 
 	// Maya内部ターゲットの取得
 	// 毎回作りなおしているのはMayaのテクスチャオブジェクトが変わっている可能性があるため
@@ -132,7 +133,8 @@ MStatus CustomRenderOperation::execute(const MHWRender::MDrawContext& drawContex
 		context.SetViewport(rect);
 		context.SetScissorRect(rect);
 
-		// シーン描画
+		// シーン描画(リングへの書き込みはフレームの間に行う)
+		se::GraphicsCore::BeginFrame();
 		scene_.Update(drawContext, cameraPath);
 		scene_.Draw(context);
 
@@ -153,6 +155,7 @@ MStatus CustomRenderOperation::execute(const MHWRender::MDrawContext& drawContex
 			context.SetRasterizerState(se::RasterizerState::Get(se::RasterizerState::BackFaceCull));
 			context.DrawIndexed(0, 3);
 		}
+		se::GraphicsCore::EndFrame();
 
 		// 描画フィルタをクリア
 		bridge::DAGManager::Get()->ClearDrawFilter();
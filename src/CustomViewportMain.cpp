@@ -9,6 +9,7 @@
 #include "CustomRenderOverride.h"
 #include "nodes/CustomViewportGlobals.h"
 #include "cmd/ShaderReloadCmd.h"
+#include "cmd/GeometryReportCmd.h"
 
 namespace {
 	CustomRenderOverride* renderOverrideInstance = nullptr;
@@ -46,6 +47,11 @@ MStatus initializePlugin(MObject obj)
 		status.perror("registerCommand");
 		return status;
 	}
+	status = plugin.registerCommand("customViewportGeometryReport", GeometryReportCmd::creator);
+	if (!status) {
+		status.perror("registerCommand");
+		return status;
+	}
 
 	return status;
 }
@@ -75,6 +81,11 @@ MStatus uninitializePlugin(MObject obj)
 		status.perror("deregisterCommand");
 		return status;
 	}
+	status = plugin.deregisterCommand("customViewportGeometryReport");
+	if (!status) {
+		status.perror("deregisterCommand");
+		return status;
+	}
 
 	return status;
 }
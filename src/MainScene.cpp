@@ -60,15 +60,27 @@ void MainScene::Update(const MHWRender::MDrawContext& drawContext, MDagPath came
 	auto& uniform = viewUniforms_.Contents();
 	CopyMatrix(&matrix, view);
 	uniform.worldToView = Matrix44::Transpose(matrix);
+	renderQueue_.SetView(matrix);
 	CopyMatrix(&matrix, projection);
 	uniform.viewToClip = Matrix44::Transpose(matrix);
 	CopyMatrix(&matrix, viewProjection);
 	uniform.worldToClip = Matrix44::Transpose(matrix);
 	viewUniforms_.Updated();
+	frustum_.SetFromMatrix(matrix);
+
+	// 背面カリング用の視点(カメラは-Z方向を向く、平行投影は射影行列の[3][3]が1)
+	MMatrix viewInverse = drawContext.getMatrix(MHWRender::MFrameContext::kViewInverseMtx);
+	frustum_.SetViewPoint(
+		se::Vector3(static_cast<float>(viewInverse[3][0]), static_cast<float>(viewInverse[3][1]), static_cast<float>(viewInverse[3][2])),
+		se::Vector3(static_cast<float>(-viewInverse[2][0]), static_cast<float>(-viewInverse[2][1]), static_cast<float>(-viewInverse[2][2])),
+		projection[3][3] != 0.0);
 
 	// DAG更新
 	auto* dagMgr = bridge::DAGManager::Get();
 	dagMgr->UpdateNode();
+
+	// 視錐台カリング(更新後のワールドバウンディングを使用)
+	dagMgr->CullNode(frustum_);
 }
 
 
@@ -79,7 +91,20 @@ void MainScene::Draw(se::GraphicsContext& context)
 	context.SetVSConstantBuffer(0, viewUniforms_.GetResource());
 	context.SetPSConstantBuffer(0, viewUniforms_.GetResource());
 
-	// 描画
-	bridge::DAGManager::Get()->DrawNode(context, ShadingPath::MainPath);
-	bridge::DAGManager::Get()->DrawNode(context, ShadingPath::UIPath);
+	// 描画パケットを集めてソートキー順に描画
+	auto* dagMgr = bridge::DAGManager::Get();
+	// インスタンスのオブジェクトパラメータは更新された範囲をまとめて転送
+	dagMgr->UploadObjectParameters(context);
+	renderQueue_.Clear();
+	dagMgr->DrawNode(context, renderQueue_, ShadingPath::MainPath);
+	dagMgr->DrawNode(context, renderQueue_, ShadingPath::UIPath);
+	renderQueue_.Sort();
+
+	// 遅延コンテキストがあればパケットを分割して並列に記録し、ソート順に実行する
+	// (リソースの更新はDrawNodeまでに済んでいるので、記録中はバインドと描画のみ)
+	se::DeferredCommandLists commandLists(context, renderQueue_, [this](se::GraphicsContext& deferred) {
+		deferred.SetVSConstantBuffer(0, viewUniforms_.GetResource());
+		deferred.SetPSConstantBuffer(0, viewUniforms_.GetResource());
+	});
+	parallelSubmit_.Submit(commandLists, renderQueue_.Count(), &se::ThreadPool::Get());
 }
\ No newline at end of file
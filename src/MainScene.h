@@ -15,6 +15,9 @@ class MainScene
 {
 private:
 	se::TUniformParameter<se::ViewParameterData> viewUniforms_;
+	se::Frustum frustum_;
+	se::RenderQueue renderQueue_;
+	se::ParallelSubmit parallelSubmit_;		// 描画パケットを遅延コンテキストに分けて並列に記録する
 
 public:
 	MainScene();
@@ -0,0 +1,104 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "bridge/DAGGeometryCache.h"
+#include "bridge/DAGMeshGeometry.h"
+#include <algorithm>
+
+namespace bridge {
+
+	DAGGeometryCache::DAGGeometryCache()
+		: lookups_(0)
+		, hits_(0)
+		, purgeThreshold_(64)
+	{
+	}
+
+	std::shared_ptr<GeometryResource> DAGGeometryCache::Create(const SubMeshGeometry& subMesh)
+	{
+		auto resource = std::make_shared<GeometryResource>();
+		resource->bytes = 0;
+
+		uint32_t indexCount = subMesh.GetIndexCount();
+		if (indexCount > 0) {
+			uint32_t size = indexCount * ((subMesh.indexStride == se::INDEX_BUFFER_STRIDE_U16) ? sizeof(uint16_t) : sizeof(uint32_t));
+			resource->indexBuffer.Create(subMesh.GetIndexData(), size, subMesh.indexStride);
+			resource->bytes += size;
+		}
+
+		resource->vertexBuffers.resize(subMesh.streams.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(subMesh.streams.size()); i++) {
+			const GeometryStream& stream = subMesh.streams[i];
+			uint32_t size = stream.stride * subMesh.vertexCount;
+			resource->vertexBuffers[i].Create(stream.GetData(),
+											  size,
+											  stream.attribute,
+											  stream.usage,
+											  stream.unorderedAccess,
+											  subMesh.quantized);
+			resource->bytes += size;
+		}
+		return resource;
+	}
+
+	void DAGGeometryCache::Purge()
+	{
+		for (auto it = entries_.begin(); it != entries_.end();) {
+			if (it->second.resource.expired()) {
+				it = entries_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		purgeThreshold_ = std::max<size_t>(64, entries_.size() * 2);
+	}
+
+	std::shared_ptr<const GeometryResource> DAGGeometryCache::Acquire(const SubMeshGeometry& subMesh)
+	{
+		lookups_++;
+
+		auto it = entries_.find(subMesh.contentHash);
+		if (it != entries_.end()) {
+			if (auto resource = it->second.resource.lock()) {
+				hits_++;
+				return resource;
+			}
+		}
+
+		// 解放済みのエントリが溜まっていれば掃除する
+		if (entries_.size() >= purgeThreshold_) {
+			Purge();
+		}
+
+		auto resource = Create(subMesh);
+		Entry& entry = entries_[subMesh.contentHash];
+		entry.resource = resource;
+		entry.bytes = resource->bytes;
+		return resource;
+	}
+
+	uint32_t DAGGeometryCache::GetResourceCount() const
+	{
+		uint32_t count = 0;
+		for (const auto& pair : entries_) {
+			if (!pair.second.resource.expired()) count++;
+		}
+		return count;
+	}
+
+	uint64_t DAGGeometryCache::GetSavedBytes() const
+	{
+		// 2つ目以降の参照は新たなメモリを消費していない
+		uint64_t bytes = 0;
+		for (const auto& pair : entries_) {
+			long count = pair.second.resource.use_count();
+			if (count > 1) {
+				bytes += pair.second.bytes * static_cast<uint64_t>(count - 1);
+			}
+		}
+		return bytes;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include "engine/Graphics/GPUBuffer.h"
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace bridge {
+	struct SubMeshGeometry;
+
+	/**
+	 * 複数のメッシュで共有するGPUジオメトリ
+	 */
+	struct GeometryResource
+	{
+		std::vector<se::VertexBuffer> vertexBuffers;
+		se::IndexBuffer indexBuffer;
+		uint64_t bytes;			// 頂点バッファとインデックスバッファの合計
+	};
+
+	/**
+	 * 内容のハッシュ値をキーにしたGPUジオメトリのキャッシュ
+	 * 同じ形状(頂点、インデックス、頂点属性の構成が一致)のメッシュはバッファを共有する
+	 * エントリは弱参照で保持し、使用するメッシュがなくなれば解放される
+	 */
+	class DAGGeometryCache
+	{
+	private:
+		struct Entry
+		{
+			std::weak_ptr<GeometryResource> resource;
+			uint64_t bytes;
+		};
+
+	private:
+		std::unordered_map<uint64_t, Entry> entries_;
+		uint64_t lookups_;
+		uint64_t hits_;
+		size_t purgeThreshold_;		// エントリ数がこれを超えたら解放済みのエントリを取り除く
+
+	private:
+		static std::shared_ptr<GeometryResource> Create(const SubMeshGeometry& subMesh);
+		void Purge();
+
+	public:
+		DAGGeometryCache();
+
+		// subMesh.contentHashが一致するリソースがあれば共有し、なければ作成して登録する
+		std::shared_ptr<const GeometryResource> Acquire(const SubMeshGeometry& subMesh);
+
+		uint64_t GetLookupCount() const { return lookups_; }
+		uint64_t GetHitCount() const { return hits_; }
+		float GetHitRate() const { return (lookups_ > 0) ? static_cast<float>(hits_) / lookups_ : 0.0f; }
+
+		// 共有中のリソース数と、共有により節約できているメモリ量
+		uint32_t GetResourceCount() const;
+		uint64_t GetSavedBytes() const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "bridge/DAGHierarchyCache.h"
+#include <algorithm>
+
+namespace bridge {
+
+	uint32_t DAGHierarchyCache::Add(DAGTransform* owner)
+	{
+		uint32_t index;
+		if (!freeList_.empty()) {
+			index = freeList_.back();
+			freeList_.pop_back();
+		} else {
+			index = static_cast<uint32_t>(entries_.size());
+			entries_.push_back(Entry());
+		}
+
+		Entry& entry = entries_[index];
+		entry.owner = owner;
+		entry.parent = InvalidIndex;
+		entry.firstChild = InvalidIndex;
+		entry.nextSibling = InvalidIndex;
+		entry.prevSibling = InvalidIndex;
+		entry.localVisibility = true;
+		entry.layerVisibility = true;
+		entry.visibility = true;
+		entry.changed = false;
+		return index;
+	}
+
+	void DAGHierarchyCache::Remove(uint32_t index)
+	{
+		UnlinkChild(index);
+
+		// 子は親なしとして再計算
+		uint32_t child = entries_[index].firstChild;
+		while (child != InvalidIndex) {
+			uint32_t next = entries_[child].nextSibling;
+			entries_[child].parent = InvalidIndex;
+			entries_[child].nextSibling = InvalidIndex;
+			entries_[child].prevSibling = InvalidIndex;
+			Propagate(child);
+			child = next;
+		}
+
+		// 再利用された後に別のノードの変化として通知しないよう外す
+		if (entries_[index].changed) {
+			changed_.erase(std::find(changed_.begin(), changed_.end(), index));
+			entries_[index].changed = false;
+		}
+
+		entries_[index].owner = nullptr;
+		entries_[index].firstChild = InvalidIndex;
+		freeList_.push_back(index);
+	}
+
+	void DAGHierarchyCache::ClearChanged()
+	{
+		for (uint32_t index : changed_) {
+			entries_[index].changed = false;
+		}
+		changed_.clear();
+	}
+
+	void DAGHierarchyCache::LinkChild(uint32_t parent, uint32_t child)
+	{
+		Entry& entry = entries_[child];
+		entry.parent = parent;
+		entry.prevSibling = InvalidIndex;
+		entry.nextSibling = entries_[parent].firstChild;
+		if (entry.nextSibling != InvalidIndex) {
+			entries_[entry.nextSibling].prevSibling = child;
+		}
+		entries_[parent].firstChild = child;
+	}
+
+	void DAGHierarchyCache::UnlinkChild(uint32_t child)
+	{
+		Entry& entry = entries_[child];
+		if (entry.parent == InvalidIndex) return;
+
+		if (entry.prevSibling != InvalidIndex) {
+			entries_[entry.prevSibling].nextSibling = entry.nextSibling;
+		} else {
+			entries_[entry.parent].firstChild = entry.nextSibling;
+		}
+		if (entry.nextSibling != InvalidIndex) {
+			entries_[entry.nextSibling].prevSibling = entry.prevSibling;
+		}
+		entry.parent = InvalidIndex;
+		entry.nextSibling = InvalidIndex;
+		entry.prevSibling = InvalidIndex;
+	}
+
+	void DAGHierarchyCache::SetParent(uint32_t index, uint32_t parent)
+	{
+		if (entries_[index].parent == parent) return;
+
+		UnlinkChild(index);
+		if (parent != InvalidIndex) {
+			LinkChild(parent, index);
+		}
+		Propagate(index);
+	}
+
+	void DAGHierarchyCache::SetLocalVisibility(uint32_t index, bool visible)
+	{
+		if (entries_[index].localVisibility == visible) return;
+		entries_[index].localVisibility = visible;
+		Propagate(index);
+	}
+
+	void DAGHierarchyCache::SetLayerVisibility(uint32_t index, bool visible)
+	{
+		if (entries_[index].layerVisibility == visible) return;
+		entries_[index].layerVisibility = visible;
+		Propagate(index);
+	}
+
+	void DAGHierarchyCache::Propagate(uint32_t index)
+	{
+		// 結果が変わらなかったノードより下は影響がないので辿らない
+		stack_.push_back(index);
+		while (!stack_.empty()) {
+			uint32_t current = stack_.back();
+			stack_.pop_back();
+
+			Entry& entry = entries_[current];
+			bool visibility = entry.localVisibility && entry.layerVisibility
+				&& (entry.parent == InvalidIndex || entries_[entry.parent].visibility);
+			if (visibility == entry.visibility) continue;
+
+			entry.visibility = visibility;
+			if (!entry.changed) {
+				entry.changed = true;
+				changed_.push_back(current);
+			}
+			for (uint32_t child = entry.firstChild; child != InvalidIndex; child = entries_[child].nextSibling) {
+				stack_.push_back(child);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,66 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace bridge {
+	class DAGTransform;
+
+	/**
+	 * トランスフォーム階層のキャッシュ
+	 * 親子関係と可視性(ローカル、レイヤー、親を含めた結果)を保持する
+	 * 値の変更時は影響のあるサブツリーのみ再計算し、結果が変化したものを記録する
+	 * Maya APIには依存しない
+	 */
+	class DAGHierarchyCache
+	{
+	public:
+		static const uint32_t InvalidIndex = 0xffffffff;
+
+	private:
+		struct Entry
+		{
+			DAGTransform* owner;
+			uint32_t parent;
+			uint32_t firstChild;
+			uint32_t nextSibling;
+			uint32_t prevSibling;
+			bool localVisibility;		// visibility, lodVisibility
+			bool layerVisibility;		// ディスプレイレイヤー(drawOverride)
+			bool visibility;			// 親を含めた最終的な可視性
+			bool changed;				// changed_に登録済み
+		};
+
+	private:
+		std::vector<Entry> entries_;
+		std::vector<uint32_t> freeList_;
+		std::vector<uint32_t> changed_;		// 可視性が変化したエントリ
+		std::vector<uint32_t> stack_;		// 再計算用の作業領域
+
+	private:
+		void LinkChild(uint32_t parent, uint32_t child);
+		void UnlinkChild(uint32_t child);
+		void Propagate(uint32_t index);
+
+	public:
+		uint32_t Add(DAGTransform* owner);
+		void Remove(uint32_t index);
+
+		void SetParent(uint32_t index, uint32_t parent);
+		void SetLocalVisibility(uint32_t index, bool visible);
+		void SetLayerVisibility(uint32_t index, bool visible);
+
+		DAGTransform* GetOwner(uint32_t index) const { return entries_[index].owner; }
+		uint32_t GetParent(uint32_t index) const { return entries_[index].parent; }
+		bool IsVisible(uint32_t index) const { return entries_[index].visibility; }
+
+		const std::vector<uint32_t>& GetChanged() const { return changed_; }
+		void ClearChanged();
+	};
+
+}
@@ -12,6 +12,7 @@ namespace bridge {
 
 	DAGLight::DAGLight(MObject& object, LightType type)
 		: DAGNode(object)
+		, transform_(nullptr)
 		, lightType_(type)
 		, direction_(0, 0, 1)
 		, color_(1, 1, 1)
@@ -40,12 +41,15 @@ namespace bridge {
 			if (sn == "cl") {			// color
 				GetVectorByPlug(color_.ToFloatArray(), plug);
 				updated_ = true;
+				RequestUpdate();
 			} else if (sn == "in") {	// intensity
 				intensity_ = plug.asFloat();
 				updated_ = true;
+				RequestUpdate();
 			} else if (sn == "ra") {	// range
 				range_ = plug.asFloat();
 				updated_ = true;
+				RequestUpdate();
 			}
 		} else if ((msg & MNodeMessage::kConnectionMade) && (msg & MNodeMessage::kOtherPlugSet)) {
 			// シーン読み込み時は初期パラメータを取得する
@@ -64,6 +68,7 @@ namespace bridge {
 				range_ = raPlug.asFloat();
 			}
 			updated_ = true;
+			RequestUpdate();
 		}
 	}
 
@@ -75,12 +80,15 @@ namespace bridge {
 		if (sn == "cl") {			// color
 			GetVectorByPlug(color_.ToFloatArray(), plug);
 			updated_ = true;
+			RequestUpdate();
 		} else if (sn == "in") {	// intensity
 			intensity_ = plug.asFloat();
 			updated_ = true;
+			RequestUpdate();
 		} else if (sn == "ra") {	// range
 			range_ = plug.asFloat();
 			updated_ = true;
+			RequestUpdate();
 		}
 	}
 
@@ -116,6 +124,7 @@ namespace bridge {
 	{
 		transform_ = static_cast<const DAGTransform*>(parent);
 		updated_ = true;
+		RequestUpdate();
 	}
 
 	void DAGLight::UnlinkParent(const DAGNode* parent)
@@ -124,11 +133,22 @@ namespace bridge {
 			transform_ = nullptr;
 		}
 		updated_ = true;
+		RequestUpdate();
+	}
+
+	void DAGLight::UnlinkAll()
+	{
+		DAGNode::UnlinkAll();
+		if (transform_) {
+			const_cast<DAGTransform*>(transform_)->RemoveChild(this);
+			transform_ = nullptr;
+		}
 	}
 
 	void DAGLight::NotifyParentTransformUpdated(const DAGNode* parent)
 	{
 		updated_ = true;
+		RequestUpdate();
 	}
 
 }
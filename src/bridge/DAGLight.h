@@ -43,6 +43,7 @@ namespace bridge {
 		virtual void Update() override;
 		virtual void LinkParent(const DAGNode* parent) override;
 		virtual void UnlinkParent(const DAGNode* parent) override;
+		virtual void UnlinkAll() override;
 		virtual void NotifyParentTransformUpdated(const DAGNode* parent) override;
 	};
 
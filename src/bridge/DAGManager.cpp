@@ -10,22 +10,52 @@
 #include "bridge/DAGTexture.h"
 #include "bridge/DAGLight.h"
 #include "bridge/DAGSettings.h"
+#include "Utility.h"
 
 namespace bridge {
 
 	namespace {
-		void TraverseDraw(const std::list<DAGNode*>& list, se::GraphicsContext& context, ShadingPath path)
+		void TraverseDraw(const DAGNodePool& pool, se::GraphicsContext& context, se::RenderQueue& queue, ShadingPath path)
 		{
-			for (DAGNode* node : list) {
-				node->Draw(context, path);
+			for (DAGNode* node : pool) {
+				node->Draw(context, queue, path);
 			}
 		}
 
-		void TraverseUpdate(const std::list<DAGNode*>& list)
+		// 更新順
+		// トランスフォームの状態を他のノードが参照するので最初に更新
+		const DAGType updateOrder[] = {
+			DAGType::Transform,
+			DAGType::Settings,
+			DAGType::Material,
+			DAGType::Texture,
+			DAGType::Mesh,
+			DAGType::Light,
+		};
+
+		// 1フレームでMayaからジオメトリを抽出する時間の目安(ms)
+		// 最低1メッシュは処理し、超えた分は次のフレームに回す
+		const double GeometryExtractBudget = 8.0;
+
+		// 1フレームで作成するGPUジオメトリの転送量の目安(バイト)
+		// 最低1サブメッシュは作成し、残りは次のフレームに回す(チャンクに分割した巨大なメッシュを複数フレームに分散する)
+		const uint64_t GeometryUploadBudget = 64ull << 20;
+
+		// オブジェクトパラメータの転送時に1つにまとめる範囲の間隔(要素数)
+		// 間の未更新の要素も転送するが、UpdateSubresourceの呼び出し回数を抑える
+		const uint32_t ObjectUploadMergeGap = 16;
+
+		Matrix44 ReadTransformMatrix(const DAGTransform* transform, uint32_t parent)
 		{
-			for (DAGNode* node : list) {
-				node->Update();
+			// ルート(Maya上の親が管理外の場合を含む)、親を継承しない場合はワールドをそのまま取得
+			// それ以外はローカルのみ取得して親と合成する
+			Matrix44 matrix;
+			if (parent == se::TransformHierarchy::InvalidIndex) {
+				GetWorldMatrixByDagPath(transform->GetDagPath(), &matrix);
+			} else {
+				CopyMatrix(&matrix, MFnDagNode(transform->Object()).transformationMatrix());
 			}
+			return matrix;
 		}
 	}
 
@@ -36,40 +66,52 @@ namespace bridge {
 	DAGManager::DAGManager()
 		: isIsolateSelected_(false)
 		, isTimeChanged_(false)
+		, isLayerChanged_(false)
+		, isHierarchyDirty_(true)
+		, deferredRemoveDepth_(0)
+		, teardownNodeCount_(0)
+		, teardownTime_(0.0)
 	{
 		settings_ = nullptr;
 
+		// ノードプール
+		pools_[static_cast<int32_t>(DAGType::Transform)].reset(new TDAGNodePool<DAGTransform>());
+		pools_[static_cast<int32_t>(DAGType::Mesh)].reset(new TDAGNodePool<DAGMesh>());
+		pools_[static_cast<int32_t>(DAGType::Material)].reset(new TDAGNodePool<DAGMaterial>());
+		pools_[static_cast<int32_t>(DAGType::Texture)].reset(new TDAGNodePool<DAGTexture>());
+		pools_[static_cast<int32_t>(DAGType::Light)].reset(new TDAGNodePool<DAGLight>());
+
 		// ノードフックコールバック
 		MStatus status;
 
 		addNodeCallBackId_[CallBack_Transform] = MDGMessage::addNodeAddedCallback(AddNodeCallback, "transform", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeAddedCallback");
 
-		removeNodeCallBackId_[CallBack_Transform] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "transform", &transformList_, &status);
+		removeNodeCallBackId_[CallBack_Transform] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "transform", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeRemovedCallback");
 
 		addNodeCallBackId_[CallBack_Mesh] = MDGMessage::addNodeAddedCallback(AddNodeCallback, "mesh", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeAddedCallback");
 
-		removeNodeCallBackId_[CallBack_Mesh] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "mesh", &meshList_, &status);
+		removeNodeCallBackId_[CallBack_Mesh] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "mesh", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeRemovedCallback");
 
 		addNodeCallBackId_[CallBack_ShadingEngine] = MDGMessage::addNodeAddedCallback(AddNodeCallback, "shadingEngine", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeAddedCallback");
 
-		removeNodeCallBackId_[CallBack_ShadingEngine] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "shadingEngine", &materialList_, &status);
+		removeNodeCallBackId_[CallBack_ShadingEngine] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "shadingEngine", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeRemovedCallback");
 
 		addNodeCallBackId_[CallBack_Texture] = MDGMessage::addNodeAddedCallback(AddNodeCallback, "file", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeAddedCallback");
 
-		removeNodeCallBackId_[CallBack_Texture] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "file", &materialList_, &status);
+		removeNodeCallBackId_[CallBack_Texture] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "file", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeRemovedCallback");
 
 		addNodeCallBackId_[CallBack_Light] = MDGMessage::addNodeAddedCallback(AddNodeCallback, "light", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeAddedCallback");
 
-		removeNodeCallBackId_[CallBack_Light] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "light", &lightList_, &status);
+		removeNodeCallBackId_[CallBack_Light] = MDGMessage::addNodeRemovedCallback(RemoveNodeCallback, "light", nullptr, &status);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed addNodeRemovedCallback");
 
 		addNodeCallBackId_[CallBack_Settings] = MDGMessage::addNodeAddedCallback(AddNodeCallback, "customViewportGlobals", nullptr, &status);
@@ -87,6 +129,62 @@ namespace bridge {
 			MDisplayError("Failed MEventMessage::addEventCallback\n");
 		}
 
+		// ディスプレイレイヤーの表示切り替え、メンバー変更をフック
+		// (レイヤーからの可視性の変更はトランスフォームのAttributeChangedに来ないため)
+		static const char* layerEvents[] = {
+			"displayLayerVisibilityChanged",
+			"displayLayerChange",
+		};
+		for (int32_t i = 0; i < ARRAYSIZE(layerEvents); i++) {
+			layerChangedCallBackId_[i] = MEventMessage::addEventCallback(layerEvents[i], [](void* clientData) {
+				DAGManager* mgr = reinterpret_cast<DAGManager*>(clientData);
+				mgr->LayerChanged();
+			}, this, &status);
+			if (status != MStatus::kSuccess) {
+				MDisplayError("Failed MEventMessage::addEventCallback / %s\n", layerEvents[i]);
+			}
+		}
+
+		// シーンの破棄(新規シーン、シーンを開く、リファレンスのアンロード)の前後をフック
+		// 破棄中のノード削除は溜めておき、終了時にまとめて行う
+		static const MSceneMessage::Message beginMessages[] = {
+			MSceneMessage::kBeforeNew,
+			MSceneMessage::kBeforeOpen,
+			MSceneMessage::kBeforeUnloadReference,
+		};
+		static const MSceneMessage::Message endMessages[] = {
+			MSceneMessage::kAfterNew,
+			MSceneMessage::kAfterOpen,
+			MSceneMessage::kAfterUnloadReference,
+		};
+		for (int32_t i = 0; i < ARRAYSIZE(beginMessages); i++) {
+			sceneCallBackId_[i * 2] = MSceneMessage::addCallback(beginMessages[i], [](void* clientData) {
+				DAGManager* mgr = reinterpret_cast<DAGManager*>(clientData);
+				mgr->BeginDeferredRemove();
+			}, this, &status);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed MSceneMessage::addCallback");
+
+			sceneCallBackId_[i * 2 + 1] = MSceneMessage::addCallback(endMessages[i], [](void* clientData) {
+				DAGManager* mgr = reinterpret_cast<DAGManager*>(clientData);
+				mgr->EndDeferredRemove();
+			}, this, &status);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed MSceneMessage::addCallback");
+		}
+
+		// 新規シーン、シーンを開く操作がキャンセルされた場合は終了のコールバックが来ないので、次の操作の開始前に戻す
+		static const MSceneMessage::Message checkMessages[] = {
+			MSceneMessage::kBeforeNewCheck,
+			MSceneMessage::kBeforeOpenCheck,
+		};
+		for (int32_t i = 0; i < ARRAYSIZE(checkMessages); i++) {
+			sceneCheckCallBackId_[i] = MSceneMessage::addCheckCallback(checkMessages[i], [](bool* retCode, void* clientData) {
+				DAGManager* mgr = reinterpret_cast<DAGManager*>(clientData);
+				mgr->ResetDeferredRemove();
+				*retCode = true;
+			}, this, &status);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed MSceneMessage::addCheckCallback");
+		}
+
 		// initialShadingGroupは追加コールバックが来ないので手動追加
 		MSelectionList list;
 		list.add("initialShadingGroup");
@@ -94,9 +192,9 @@ namespace bridge {
 			MObject node;
 			MStatus s = list.getDependNode(0, node);
 			if (s == MStatus::kSuccess) {
-				auto* mat = new DAGMaterial(node, true);
-				materialList_.push_back(mat);
+				auto* mat = GetPool<DAGMaterial>(DAGType::Material).Create(node, true);
 				nodeMap_[MObjectHandle(node)] = mat;
+				EnqueueUpdate(mat);
 			}
 		}
 	}
@@ -112,27 +210,33 @@ namespace bridge {
 		}
 		status = MDGMessage::removeCallback(timeChangedCallBackId_);
 		if (!status) MDisplayError("[MayaCustomViewport] / Failed removeTimeChangedCallback");
-
-		// リスト破棄
-		for (DAGNode* node : transformList_) {
-			delete node;
+		for (int32_t i = 0; i < ARRAYSIZE(layerChangedCallBackId_); i++) {
+			status = MMessage::removeCallback(layerChangedCallBackId_[i]);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed removeLayerChangedCallback");
 		}
-		transformList_.clear();
-
-		for (DAGNode* node : meshList_) {
-			delete node;
+		for (int32_t i = 0; i < ARRAYSIZE(sceneCallBackId_); i++) {
+			status = MMessage::removeCallback(sceneCallBackId_[i]);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed removeSceneCallback");
 		}
-		meshList_.clear();
-
-		for (DAGNode* node : materialList_) {
-			delete node;
+		for (int32_t i = 0; i < ARRAYSIZE(sceneCheckCallBackId_); i++) {
+			status = MMessage::removeCallback(sceneCheckCallBackId_[i]);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed removeSceneCheckCallback");
 		}
-		materialList_.clear();
 
-		for (DAGNode* node : lightList_) {
-			delete node;
+		// 破棄待ちのノード
+		FlushPendingRemoves();
+
+		// ノード破棄
+		static const DAGType destroyOrder[] = {
+			DAGType::Transform,
+			DAGType::Mesh,
+			DAGType::Material,
+			DAGType::Texture,
+			DAGType::Light,
+		};
+		for (DAGType type : destroyOrder) {
+			pools_[static_cast<int32_t>(type)]->Clear();
 		}
-		lightList_.clear();
 
 		// 設定ノード
 		if (settings_) {
@@ -141,6 +245,9 @@ namespace bridge {
 		}
 
 		nodeMap_.clear();
+		for (auto& queue : updateQueue_) {
+			queue.Clear();
+		}
 	}
 	
 	void DAGManager::AddNodeCallback(MObject& node, void* clientData)
@@ -153,28 +260,22 @@ namespace bridge {
 		switch (node.apiType())
 		{
 		case MFn::kTransform:
-			dagNode = new DAGTransform(node);
-			instance_->transformList_.push_back(dagNode);
+			dagNode = instance_->GetPool<DAGTransform>(DAGType::Transform).Create(node);
 			break;
 		case MFn::kMesh:
-			dagNode = new DAGMesh(node);
-			instance_->meshList_.push_back(dagNode);
+			dagNode = instance_->GetPool<DAGMesh>(DAGType::Mesh).Create(node);
 			break;
 		case MFn::kShadingEngine:
-			dagNode = new DAGMaterial(node);
-			instance_->materialList_.push_back(dagNode);
+			dagNode = instance_->GetPool<DAGMaterial>(DAGType::Material).Create(node);
 			break;
 		case MFn::kFileTexture:
-			dagNode = new DAGTexture(node);
-			instance_->materialList_.push_back(dagNode);
+			dagNode = instance_->GetPool<DAGTexture>(DAGType::Texture).Create(node);
 			break;
 		case MFn::kDirectionalLight:
-			dagNode = new DAGLight(node, DAGLight::LightType::Directional);
-			instance_->lightList_.push_back(dagNode);
+			dagNode = instance_->GetPool<DAGLight>(DAGType::Light).Create(node, DAGLight::LightType::Directional);
 			break;
 		case MFn::kPointLight:
-			dagNode = new DAGLight(node, DAGLight::LightType::Point);
-			instance_->lightList_.push_back(dagNode);
+			dagNode = instance_->GetPool<DAGLight>(DAGType::Light).Create(node, DAGLight::LightType::Point);
 			break;
 		case MFn::kPluginDependNode:
 			{
@@ -190,66 +291,383 @@ namespace bridge {
 		}
 
 		if (dagNode) {
+			if (dagNode->Type() == DAGType::Transform) {
+				instance_->InvalidateTransformHierarchy();
+			}
 			instance_->nodeMap_[MObjectHandle(node)] = dagNode;
+			// 生成直後は初期化のため一度更新する
+			instance_->EnqueueUpdate(dagNode);
 		}
 	}
 
 	void DAGManager::RemoveNodeCallback(MObject& node, void *clientData)
 	{
-		// 独自DAG破棄
-		if (clientData) {
-			DAGNodeList& list = *reinterpret_cast<DAGNodeList*>(clientData);
-			auto iter = list.begin();
-			while (iter != list.end()) {
-				DAGNode* curNode = *iter;
-				if (*curNode == node) {
-					delete curNode;
-					list.erase(iter);
-					break;
-				}
-				iter++;
+		// ハッシュから独自DAGを検索して破棄
+		MObjectHandle handle(node);
+		auto iter = instance_->nodeMap_.find(handle);
+		if (iter != instance_->nodeMap_.end()) {
+			DAGNode* dagNode = iter->second;
+			instance_->nodeMap_.erase(iter);
+			if (instance_->deferredRemoveDepth_ > 0) {
+				instance_->DeferDestroyNode(dagNode);
+			} else {
+				instance_->DestroyNode(dagNode);
 			}
 		}
+	}
+
+	void DAGManager::DestroyNode(DAGNode* node)
+	{
+		if (node->Type() == DAGType::Transform) {
+			InvalidateTransformHierarchy();
+		}
+		DequeueUpdate(node);
+		DequeueGeometry(node);
+		if (node->IsIsolateSelected()) {
+			isolateSelectNode_.erase(std::remove(isolateSelectNode_.begin(), isolateSelectNode_.end(), node), isolateSelectNode_.end());
+		}
 
 		// 設定ノード
-		if (instance_->settings_ && (*instance_->settings_) == node) {
-			delete instance_->settings_;
-			instance_->settings_ = nullptr;
+		if (node == settings_) {
+			delete settings_;
+			settings_ = nullptr;
+			return;
 		}
 
-		MObjectHandle handle(node);
-		auto iter = instance_->nodeMap_.find(handle);
-		if (iter != instance_->nodeMap_.end()) {
-			instance_->nodeMap_.erase(iter);
+		// プールから削除
+		pools_[static_cast<int32_t>(node->Type())]->Destroy(node);
+	}
+
+	void DAGManager::DeferDestroyNode(DAGNode* node)
+	{
+		if (node == settings_) {
+			DestroyNode(node);
+			return;
+		}
+
+		// 更新、描画の対象からは即座に外し、破棄のみ後回しにする
+		if (node->Type() == DAGType::Transform) {
+			InvalidateTransformHierarchy();
+		}
+		DequeueUpdate(node);
+		DequeueGeometry(node);
+		pools_[static_cast<int32_t>(node->Type())]->Detach(node);
+		pendingRemoveNodes_.push_back(node);
+	}
+
+	void DAGManager::BeginDeferredRemove()
+	{
+		deferredRemoveDepth_++;
+	}
+
+	void DAGManager::EndDeferredRemove()
+	{
+		if (deferredRemoveDepth_ == 0) return;
+
+		// 入れ子の内側(シーンを開く中のリファレンスのアンロード等)では溜めたままにする
+		if (--deferredRemoveDepth_ > 0) return;
+
+		// 計測は一括削除のみ(シーンの読み込み時間は含めない)
+		auto begin = std::chrono::high_resolution_clock::now();
+		teardownNodeCount_ = static_cast<uint32_t>(pendingRemoveNodes_.size());
+		FlushPendingRemoves();
+
+		auto elapsed = std::chrono::high_resolution_clock::now() - begin;
+		teardownTime_ = std::chrono::duration<double, std::milli>(elapsed).count();
+		if (teardownNodeCount_ > 0) {
+			MDisplayInfo("[MayaCustomViewport] Teardown / %u nodes, %.2f ms", teardownNodeCount_, teardownTime_);
+		}
+	}
+
+	void DAGManager::ResetDeferredRemove()
+	{
+		if (deferredRemoveDepth_ == 0) return;
+
+		// キャンセルされた操作の開始分を取り消して溜めたノードを破棄する
+		deferredRemoveDepth_ = 1;
+		EndDeferredRemove();
+	}
+
+	void DAGManager::FlushPendingRemoves()
+	{
+		if (pendingRemoveNodes_.empty()) return;
+
+		// 先にまとめて親子、接続の参照を外してから破棄する(破棄済みのノードを参照しないように)
+		for (DAGNode* node : pendingRemoveNodes_) {
+			node->UnlinkAll();
+		}
+		isolateSelectNode_.erase(std::remove_if(isolateSelectNode_.begin(), isolateSelectNode_.end(), [](const DAGNode* node) {
+			return DAGNodePool::IsDetached(node);
+		}), isolateSelectNode_.end());
+
+		// コールバックはノード毎に解除せず、まとめて一度で解除する
+		MCallbackIdArray callbacks;
+		for (DAGNode* node : pendingRemoveNodes_) {
+			node->CollectCallbacks(callbacks);
+		}
+		if (callbacks.length() > 0) {
+			MStatus status = MMessage::removeCallbacks(callbacks);
+			if (!status) MDisplayError("[MayaCustomViewport] / Failed MMessage::removeCallbacks");
+		}
+
+		for (DAGNode* node : pendingRemoveNodes_) {
+			pools_[static_cast<int32_t>(node->Type())]->Free(node);
+		}
+		pendingRemoveNodes_.clear();
+
+		// 空になったプールは確保領域ごと解放
+		for (auto& pool : pools_) {
+			if (pool) pool->Trim();
+		}
+	}
+
+	void DAGManager::EnqueueUpdate(DAGNode* node)
+	{
+		// 登録済み、破棄待ちなら何もしない
+		if (DAGNodePool::IsDetached(node)) return;
+		updateQueue_[static_cast<int32_t>(node->Type())].Push(node);
+	}
+
+	void DAGManager::DequeueUpdate(DAGNode* node)
+	{
+		// 削除時はキューの要素を無効化するだけにしてO(1)で外す
+		updateQueue_[static_cast<int32_t>(node->Type())].Remove(node);
+	}
+
+	void DAGManager::RequestGeometry(DAGMesh* mesh)
+	{
+		// 加工中、GPUリソース作成中のものは古くなるので破棄して抽出からやり直す
+		mesh->ResetPendingGeometry();
+
+		if (mesh->geometryQueueIndex_ >= 0) return;
+		mesh->geometryQueueIndex_ = static_cast<int32_t>(geometryQueue_.size());
+		geometryQueue_.push_back(mesh);
+	}
+
+	void DAGManager::InvalidateGeometry()
+	{
+		for (DAGNode* node : GetNodes(DAGType::Mesh)) {
+			static_cast<DAGMesh*>(node)->InvalidateGeometry();
+		}
+	}
+
+	void DAGManager::DequeueGeometry(DAGNode* node)
+	{
+		if (node->Type() != DAGType::Mesh) return;
+
+		DAGMesh* mesh = static_cast<DAGMesh*>(node);
+		if (mesh->geometryQueueIndex_ < 0) return;
+
+		Assert(geometryQueue_[mesh->geometryQueueIndex_] == mesh);
+		geometryQueue_[mesh->geometryQueueIndex_] = nullptr;
+		mesh->geometryQueueIndex_ = -1;
+	}
+
+	void DAGManager::ApplyReadyGeometry()
+	{
+		// 加工が完了したジオメトリをフレームの先頭で転送量の目安まで反映
+		uint64_t uploadBudget = GeometryUploadBudget;
+		for (DAGMesh*& mesh : geometryQueue_) {
+			if (!mesh || !mesh->IsGeometryReady()) continue;
+
+			// 作成しきれなかったものはキューに残して次のフレームで続ける
+			if (!mesh->ApplyGeometry(&uploadBudget)) continue;
+			mesh->geometryQueueIndex_ = -1;
+			mesh = nullptr;
 		}
 	}
 
+	void DAGManager::ProcessGeometryQueue()
+	{
+		// Mayaからの抽出はメインスレッドで時間の許す限り行う
+		auto begin = std::chrono::high_resolution_clock::now();
+		for (DAGMesh*& mesh : geometryQueue_) {
+			if (!mesh || mesh->IsGeometryPending()) continue;
+
+			double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+			if (elapsed > GeometryExtractBudget) break;
+
+			mesh->ExtractGeometry();
+			if (!mesh->IsGeometryPending()) {
+				// 抽出できなかった
+				mesh->geometryQueueIndex_ = -1;
+				mesh = nullptr;
+			}
+		}
+
+		// 空きを詰める
+		uint32_t count = 0;
+		for (DAGMesh* mesh : geometryQueue_) {
+			if (!mesh) continue;
+			mesh->geometryQueueIndex_ = static_cast<int32_t>(count);
+			geometryQueue_[count++] = mesh;
+		}
+		geometryQueue_.resize(count);
+
+		// 残りがある場合は反映のため再描画を要求
+		if (!geometryQueue_.empty()) {
+			M3dView::scheduleRefreshAllViews();
+		}
+	}
+
+	void DAGManager::DrainUpdateQueue(DAGType type)
+	{
+		// 更新中に追加されたノード(子トランスフォーム等)も同フレームで処理される
+		updateQueue_[static_cast<int32_t>(type)].Drain([](DAGNode* node) {
+			node->Update();
+		});
+	}
+
+	void DAGManager::EvaluateTransforms()
+	{
+		if (isHierarchyDirty_) {
+			BuildTransformHierarchy();
+			isHierarchyDirty_ = false;
+		} else {
+			// 親子関係が変わっていなければ並びはそのままでマトリクスのみ取り直す
+			for (uint32_t i = 0; i < transformHierarchy_.Count(); i++) {
+				DAGTransform* transform = hierarchyNodes_[i];
+				transformHierarchy_.Set(i, ReadTransformMatrix(transform, transformHierarchy_.GetParent(i)), transform->GetWorldMatrix());
+			}
+		}
+
+		// 計算(深さ毎にスレッドプールで並列計算)
+		transformHierarchy_.Evaluate(&se::ThreadPool::Get());
+
+		// 反映
+		for (uint32_t i = 0; i < transformHierarchy_.Count(); i++) {
+			hierarchyNodes_[i]->ApplyWorldMatrix(transformHierarchy_.GetWorld(i), transformHierarchy_.IsChanged(i));
+		}
+	}
+
+	void DAGManager::BuildTransformHierarchy()
+	{
+		const DAGNodePool& transforms = GetNodes(DAGType::Transform);
+		transformHierarchy_.Clear();
+		transformHierarchy_.Reserve(transforms.Count());
+		hierarchyNodes_.clear();
+		hierarchyNodes_.reserve(transforms.Count());
+
+		// 収集(Mayaへのアクセスはメインスレッドのみ)
+		// 親が子より先に並ぶようルートから深さ優先で辿る
+		const uint32_t rootIndex = se::TransformHierarchy::InvalidIndex;
+		std::vector<std::pair<DAGTransform*, uint32_t>> stack;
+		for (DAGNode* node : transforms) {
+			DAGTransform* root = static_cast<DAGTransform*>(node);
+			if (root->GetParent()) continue;
+
+			stack.push_back(std::make_pair(root, rootIndex));
+			while (!stack.empty()) {
+				DAGTransform* transform = stack.back().first;
+				uint32_t parent = stack.back().second;
+				stack.pop_back();
+
+				if (!transform->IsInheritsTransform()) {
+					parent = rootIndex;
+				}
+				uint32_t index = transformHierarchy_.Add(parent, ReadTransformMatrix(transform, parent), transform->GetWorldMatrix());
+				hierarchyNodes_.push_back(transform);
+				for (DAGNode* child : transform->GetChilds()) {
+					if (child->Type() == DAGType::Transform) {
+						stack.push_back(std::make_pair(static_cast<DAGTransform*>(child), index));
+					}
+				}
+			}
+		}
+	}
+
+	void DAGManager::RefreshVisibility()
+	{
+		// 接続元から値が来る可視性(アニメーション、レイヤー)はコールバックに来ないため該当するもののみ再取得
+		if (isTimeChanged_ || isLayerChanged_) {
+			for (DAGNode* node : GetNodes(DAGType::Transform)) {
+				static_cast<DAGTransform*>(node)->RefreshVisibility(isTimeChanged_, isLayerChanged_);
+			}
+		}
+		NotifyVisibilityChanges();
+	}
+
+	void DAGManager::NotifyVisibilityChanges()
+	{
+		// 可視性の変化したトランスフォームから子へ通知
+		for (uint32_t index : hierarchyCache_.GetChanged()) {
+			DAGTransform* transform = hierarchyCache_.GetOwner(index);
+			if (transform) {
+				transform->NotifyVisibilityChanged();
+			}
+		}
+		hierarchyCache_.ClearChanged();
+	}
+
 	void DAGManager::UpdateNode()
 	{
-		// トランスフォームの状態を他のノードが参照するので最初に更新
-		TraverseUpdate(transformList_);
+		// 前のフレームまでに加工の完了したジオメトリを反映
+		ApplyReadyGeometry();
+
+		// タイム変更時はアニメーションを反映させるため全トランスフォームのワールドを再計算
+		if (isTimeChanged_) {
+			EvaluateTransforms();
+		}
+		RefreshVisibility();
+
+		// 更新要求のあったノードのみ更新
+		for (DAGType type : updateOrder) {
+			DrainUpdateQueue(type);
 
-		if (settings_) settings_->Update();
-		TraverseUpdate(materialList_);
-		TraverseUpdate(meshList_);
-		TraverseUpdate(lightList_);
+			// 生成直後のトランスフォームは初回の更新で可視性を取得するので、その変化をここで反映
+			if (type == DAGType::Transform) {
+				NotifyVisibilityChanges();
+			}
+		}
 		isTimeChanged_ = false;
+		isLayerChanged_ = false;
+
+		// ジオメトリの抽出
+		ProcessGeometryQueue();
+	}
+
+	void DAGManager::CullNode(const se::Frustum& frustum)
+	{
+		// カリングが必要なのはメッシュのみ
+		for (DAGNode* node : GetNodes(DAGType::Mesh)) {
+			node->Cull(frustum);
+		}
 	}
 
-	void DAGManager::DrawNode(se::GraphicsContext& context, ShadingPath path)
+	void DAGManager::DrawNode(se::GraphicsContext& context, se::RenderQueue& queue, ShadingPath path)
 	{
 		if (!isIsolateSelected_) {
 			// 描画の必要があるのはメッシュ、ライトのみ
-			TraverseDraw(meshList_, context, path);
-			TraverseDraw(lightList_, context, path);
+			TraverseDraw(GetNodes(DAGType::Mesh), context, queue, path);
+			TraverseDraw(GetNodes(DAGType::Light), context, queue, path);
 		} else {
 			// 選択項目の分離時
 			for (DAGNode* node : isolateSelectNode_) {
-				node->Draw(context, path);
+				node->Draw(context, queue, path);
 			}
 		}
 	}
 
+	void DAGManager::UploadObjectParameters(se::GraphicsContext& context)
+	{
+		uint32_t capacity = objectTable_.GetCapacity();
+		if (capacity == 0) return;
+
+		// 足りなければ倍々で確保し直して全体を転送する
+		if (objectBuffer_.GetElementCount() < capacity) {
+			uint32_t count = Max(capacity, objectBuffer_.GetElementCount() * 2);
+			objectBuffer_.Destroy();
+			objectBuffer_.Create(sizeof(se::ObjectParameterData), count);
+			objectTable_.MarkAllDirty();
+		}
+
+		// 更新された範囲のみ転送
+		const se::ObjectParameterData* data = objectTable_.GetData();
+		for (const auto& range : objectTable_.CollectDirtyRanges(ObjectUploadMergeGap)) {
+			objectBuffer_.UpdateRange(context, data + range.first, range.first, range.count);
+		}
+	}
+
 	void DAGManager::SetDrawFilter(MDagPath path)
 	{
 		MStatus status;
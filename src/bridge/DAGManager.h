@@ -7,9 +7,15 @@
 
 #include "Common.h"
 #include "bridge/DAGNode.h"
+#include "bridge/DAGNodePool.h"
+#include "bridge/DAGHierarchyCache.h"
+#include "bridge/DAGGeometryCache.h"
 
 namespace bridge {
 
+	class DAGTransform;
+	class DAGMesh;
+
 	/**
 	 * MObjectHandleのHashオブジェクト
 	 */
@@ -21,7 +27,6 @@ namespace bridge {
 	};
 
 
-	typedef std::list<DAGNode*> DAGNodeList;
 	typedef std::unordered_map<MObjectHandle, DAGNode*, MObjectHandleHash> DAGNodeMap;
 
 
@@ -30,6 +35,9 @@ namespace bridge {
 	 */
 	class DAGManager
 	{
+	private:
+		typedef se::UpdateQueue<DAGNode, &DAGNode::updateQueueIndex_> DAGNodeQueue;
+
 	private:
 		DAGManager();
 		virtual ~DAGManager();
@@ -64,20 +72,63 @@ namespace bridge {
 		MCallbackId addNodeCallBackId_[CallBack_Max];
 		MCallbackId removeNodeCallBackId_[CallBack_Max];
 		MCallbackId timeChangedCallBackId_;
+		MCallbackId layerChangedCallBackId_[2];
+		MCallbackId sceneCallBackId_[6];
+		MCallbackId sceneCheckCallBackId_[2];
 
 		DAGNode* settings_;
-		DAGNodeList transformList_;
-		DAGNodeList meshList_;
-		DAGNodeList materialList_;
-		DAGNodeList lightList_;
+		std::unique_ptr<DAGNodePool> pools_[DAGTypeNum];	// タイプ別ノードプール(設定ノードは除く)
 
 		DAGNodeMap nodeMap_;
+		DAGNodeQueue updateQueue_[DAGTypeNum];		// 更新要求のあったノード(タイプ別)
 		std::vector<DAGNode*> isolateSelectNode_;
 		bool isIsolateSelected_;
 		bool isTimeChanged_;
+		bool isLayerChanged_;
+
+		DAGHierarchyCache hierarchyCache_;		// トランスフォームの親子関係と可視性
+		DAGGeometryCache geometryCache_;		// 同じ内容のメッシュで共有するGPUジオメトリ
+
+		// 全メッシュのインスタンスで共有するオブジェクトパラメータ(DAGMeshは番号で参照する)
+		se::ObjectParameterTable objectTable_;
+		se::StructuredBuffer objectBuffer_;
+
+		// 非同期のジオメトリ更新(抽出待ち、加工中のメッシュ)
+		std::vector<DAGMesh*> geometryQueue_;
+
+		// タイム変更時のワールドマトリクス計算
+		se::TransformHierarchy transformHierarchy_;
+		std::vector<DAGTransform*> hierarchyNodes_;		// transformHierarchy_のインデックスに対応するノード
+		bool isHierarchyDirty_;							// 親子関係が変わったのでtransformHierarchy_を作り直す
+
+		// シーン破棄時の一括削除
+		std::vector<DAGNode*> pendingRemoveNodes_;	// 破棄待ちのノード
+		int32_t deferredRemoveDepth_;	// 破棄の開始、終了の入れ子の深さ(シーンを開く中のリファレンスのアンロード等)
+		uint32_t teardownNodeCount_;	// 直近のシーン破棄で削除したノード数
+		double teardownTime_;			// 直近のシーン破棄にかかった時間(ms)
 
 	private:
 		void SetDrawFilter(MDagPath path);
+		void DrainUpdateQueue(DAGType type);
+		void EvaluateTransforms();
+		void BuildTransformHierarchy();
+		void RefreshVisibility();
+		void NotifyVisibilityChanges();
+		void DequeueUpdate(DAGNode* node);
+		void DequeueGeometry(DAGNode* node);
+		void ApplyReadyGeometry();
+		void ProcessGeometryQueue();
+		void DestroyNode(DAGNode* node);
+		void DeferDestroyNode(DAGNode* node);
+		void BeginDeferredRemove();
+		void EndDeferredRemove();
+		void ResetDeferredRemove();
+		void FlushPendingRemoves();
+
+		template <class T>
+		TDAGNodePool<T>& GetPool(DAGType type) {
+			return *static_cast<TDAGNodePool<T>*>(pools_[static_cast<int32_t>(type)].get());
+		}
 
 	public:
 		static void AddNodeCallback(MObject& node, void *clientData);
@@ -85,15 +136,29 @@ namespace bridge {
 
 	public:
 		void UpdateNode();
-		void DrawNode(se::GraphicsContext& context, ShadingPath path);
+		void CullNode(const se::Frustum& frustum);
+		void DrawNode(se::GraphicsContext& context, se::RenderQueue& queue, ShadingPath path);
+		void UploadObjectParameters(se::GraphicsContext& context);
 		void SetDrawFilter(MSelectionList list);
 		void ClearDrawFilter();
 
 		DAGNode* FindDAGNode(const MObject& object);
 		DAGNode* GetSettingsNode() { return settings_; }
+		const DAGNodePool& GetNodes(DAGType type) const { return *pools_[static_cast<int32_t>(type)]; }
+		DAGHierarchyCache& GetHierarchyCache() { return hierarchyCache_; }
+		void InvalidateTransformHierarchy() { isHierarchyDirty_ = true; }
+		DAGGeometryCache& GetGeometryCache() { return geometryCache_; }
+		se::ObjectParameterTable& GetObjectTable() { return objectTable_; }
+		const se::StructuredBuffer& GetObjectBuffer() const { return objectBuffer_; }
 		bool IsIsolateSelected() const { return isIsolateSelected_; }
 		void TimeChanged() { isTimeChanged_ = true; };
 		bool IsTimeChanged() const { return isTimeChanged_; }
+		void LayerChanged() { isLayerChanged_ = true; }
+		void EnqueueUpdate(DAGNode* node);
+		void RequestGeometry(DAGMesh* mesh);
+		void InvalidateGeometry();
+		uint32_t GetTeardownNodeCount() const { return teardownNodeCount_; }
+		double GetTeardownTime() const { return teardownTime_; }
 
 		void ForEach(std::function<void(DAGNode*)> func);
 	};
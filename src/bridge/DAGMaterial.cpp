@@ -109,6 +109,7 @@ namespace bridge {
 	DAGMaterial::DAGMaterial(MObject& object, bool connect)
 		: DAGNode(object)
 		, shadingNodeCallbackId_(0)
+		, shadingNodeDirtyCallbackId_(0)
 		, updated_(true)
 		, shader_(nullptr)
 	{
@@ -195,6 +196,21 @@ namespace bridge {
 	}
 	
 
+	void DAGMaterial::CollectCallbacks(MCallbackIdArray& callbacks)
+	{
+		DAGNode::CollectCallbacks(callbacks);
+
+		// シェーディングノードのコールバックも回収し、デストラクタでの解除を行わないようにする
+		if (connectedShadingNode_.isValid()) {
+			callbacks.append(shadingNodeCallbackId_);
+#if USE_NODE_PLUG_DIRTY_CALLBACK
+			callbacks.append(shadingNodeDirtyCallbackId_);
+#endif
+		}
+		connectedShadingNode_ = MObjectHandle();	// 無効ハンドル
+	}
+
+
 	void DAGMaterial::ConnectTexture(MObject attr, MObject texture)
 	{
 		// バインドインデックスの取得
@@ -233,6 +249,7 @@ namespace bridge {
 				if (attr.name() == "surfaceShader") {
 					ConnectSurfaceShader(otherPlug.node());
 					updated_ = true;
+					RequestUpdate();
 				} else if (attr.name() == "dagSetMembers") {
 					// メッシュオブジェクトへの接続
 					MObject mesh = otherPlug.node();
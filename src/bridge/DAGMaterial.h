@@ -50,6 +50,7 @@ namespace bridge {
 
 		virtual void AttributeChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug) override;
 		virtual void Update() override;
+		virtual void CollectCallbacks(MCallbackIdArray& callbacks) override;
 		virtual DAGType Type() const override { return DAGType::Material; }
 
 		const se::ShaderSet* GetEngineShader() const { return shader_; }
@@ -8,31 +8,37 @@
 #include "bridge/DAGTexture.h"
 #include "bridge/DAGTransform.h"
 #include "bridge/DAGManager.h"
+#include "bridge/DAGSettings.h"
 #include "Utility.h"
+#include "engine/Graphics/GraphicsCore.h"
+#include "engine/Graphics/GeometryDiskCache.h"
+#include "engine/Graphics/GeometryCacheKey.h"
+#include "engine/Graphics/PolygonBuckets.h"
+#include "engine/Core/Hash.h"
+#include "engine/Core/ScratchArena.h"
+#include <maya/MPolyMessage.h>
 
 namespace bridge {
 
 	namespace {
-		// 指定したシェーダがアサインされているポリゴンを取得する
-		void GetShaderAsignPolygonIndex(MIntArray* output, MIntArray& poly_shader_ids, int32_t shader_id)
+		// ポリゴンのシェーダ振り分けに使うバッファ(抽出はメインスレッドのみなので全メッシュで使い回す)
+		struct PolygonBucketPool
 		{
-			int32_t numPolys = poly_shader_ids.length();
+			std::vector<int32_t> shaderIds;
+			se::PolygonBuckets buckets;
+		};
 
-			// 一旦数を数え上げ
-			int32_t shaderPolyCount = 0;
-			for (int32_t i = 0; i < numPolys; i++) {
-				if (poly_shader_ids[i] == shader_id) {
-					shaderPolyCount++;
-				}
-			}
-			// バッファにプッシュ
-			int32_t count = 0;
-			output->setLength(shaderPolyCount);
-			for (int32_t i = 0; i < numPolys; i++) {
-				if (poly_shader_ids[i] == shader_id) {
-					(*output)[count++] = i;
-				}
+		// 各ポリゴンにアサインされているシェーダ番号から、シェーダ毎のポリゴンリストをまとめて作る
+		const se::PolygonBuckets& BucketShaderPolygons(const MIntArray& polyShaderIds, uint32_t numShaders)
+		{
+			static PolygonBucketPool pool;
+			uint32_t numPolys = polyShaderIds.length();
+			pool.shaderIds.resize(numPolys);
+			if (numPolys > 0) {
+				polyShaderIds.get(pool.shaderIds.data());
 			}
+			pool.buckets.Build(pool.shaderIds.data(), numPolys, numShaders);
+			return pool.buckets;
 		}
 
 		// アトリビュートを持っているか
@@ -41,6 +47,116 @@ namespace bridge {
 			return (flag & (1 << id)) != 0;
 		}
 
+		// ディスクキャッシュのキーの互換性(抽出、加工の内容を変えたら更新する)
+		const uint64_t DiskCacheVersion = 1;
+
+		inline void AddArray(se::GeometryCacheKey& key, const MIntArray& array)
+		{
+			std::vector<int> values(array.length());
+			if (!values.empty()) array.get(values.data());
+			key.Add(values.data(), sizeof(int) * values.size());
+		}
+
+		inline void AddArray(se::GeometryCacheKey& key, const MFloatArray& array)
+		{
+			std::vector<float> values(array.length());
+			if (!values.empty()) array.get(values.data());
+			key.Add(values.data(), sizeof(float) * values.size());
+		}
+
+		inline void AddArray(se::GeometryCacheKey& key, const MColorArray& array)
+		{
+			std::vector<float> values(array.length() * 4);
+			if (!values.empty()) array.get(reinterpret_cast<float(*)[4]>(values.data()));
+			key.Add(values.data(), sizeof(float) * values.size());
+		}
+
+		inline void AddString(se::GeometryCacheKey& key, const MString& text)
+		{
+			key.Add(text.asChar(), text.length());
+		}
+
+		// 空のセット名はカレントのセット
+		inline const MString* GetSetName(const MString& name)
+		{
+			return (name.length() > 0) ? &name : nullptr;
+		}
+
+		// 抽出元のメッシュのトポロジ(頂点と法線の割り当て)のハッシュ値
+		uint64_t HashMeshTopology(const MFnMesh& mesh)
+		{
+			se::GeometryCacheKey key(se::Hash64(&DiskCacheVersion, sizeof(DiskCacheVersion)));
+			MIntArray counts, ids;
+			mesh.getVertices(counts, ids);
+			AddArray(key, counts);
+			AddArray(key, ids);
+			mesh.getNormalIds(counts, ids);
+			AddArray(key, counts);
+			AddArray(key, ids);
+			return key.Get();
+		}
+
+		// 抽出元のメッシュの形状(変形で変わる位置と法線)のハッシュ値
+		uint64_t HashMeshShape(const MFnMesh& mesh)
+		{
+			MStatus status;
+			se::GeometryCacheKey key;
+			const float* points = mesh.getRawPoints(&status);
+			if (status && points) {
+				key.Add(points, sizeof(float) * 3 * mesh.numVertices());
+			}
+			const float* normals = mesh.getRawNormals(&status);
+			if (status && normals) {
+				key.Add(normals, sizeof(float) * 3 * mesh.numNormals());
+			}
+			return key.Get();
+		}
+
+		// 抽出元のサブメッシュの変形しない内容(使用するポリゴン、要求する頂点属性とセット、加工の設定)のハッシュ値
+		// シェーダはアドレスではなく名前で識別する(アドレスは開き直すと変わり、ディスクキャッシュに当たらなくなる)
+		uint64_t HashSubMeshSource(const MFnMesh& mesh, uint64_t topologyHash, DAGMaterial* material, const SubMeshGeometry& subMesh, const int32_t* polyIds, uint32_t polyCount)
+		{
+			se::GeometryCacheKey key(topologyHash);
+			key.Add(subMesh.attributes);
+			key.Add(material->GetEngineShader()->GetName());
+			key.Add((subMesh.interleaved ? 1u : 0u) | (subMesh.quantized ? 2u : 0u)
+				| (subMesh.optimizeVertexCache ? 4u : 0u) | (subMesh.optimizeOverdraw ? 8u : 0u) | (subMesh.chunked ? 16u : 0u));
+			key.Add(polyIds, sizeof(int32_t) * polyCount);
+
+			// UV(タンジェント、バイノーマルもUVセットから求まる)
+			auto addUVSet = [&](const MString& name) {
+				MFloatArray u, v;
+				MIntArray counts, ids;
+				mesh.getUVs(u, v, GetSetName(name));
+				mesh.getAssignedUVs(counts, ids, GetSetName(name));
+				AddString(key, name);
+				AddArray(key, u);
+				AddArray(key, v);
+				AddArray(key, counts);
+				AddArray(key, ids);
+			};
+			for (uint32_t i = 0; i < se::VERTEX_ATTR_TEXCOORD_NUM; i++) {
+				if (!HasAttr(subMesh.attributes, se::VERTEX_ATTR_TEXCOORD0 + i)) break;
+				addUVSet(material->GetTexcoordSet(i));
+			}
+			if (HasAttr(subMesh.attributes, se::VERTEX_ATTR_TANGENT)) {
+				addUVSet(material->GetTangentSet());
+			}
+			if (HasAttr(subMesh.attributes, se::VERTEX_ATTR_BITANGENT)) {
+				addUVSet(material->GetBinormalSet());
+			}
+
+			// 頂点カラー
+			if (HasAttr(subMesh.attributes, se::VERTEX_ATTR_COLOR)) {
+				MColorArray colors;
+				mesh.getFaceVertexColors(colors, GetSetName(material->GetColorSet()));
+				AddString(key, material->GetColorSet());
+				AddArray(key, colors);
+			}
+
+			return key.Get();
+		}
+
 		// ノードのVisibilityを取得
 		inline bool GetNodeVisible(const DAGTransform* node)
 		{
@@ -51,13 +167,57 @@ namespace bridge {
 
 	DAGMesh::DAGMesh(MObject& object)
 		: DAGNode(object, true)
+		, boundsLayoutDirty_(true)
 		, updated_(false)
+		, deformed_(false)
+		, deforming_(false)
+		, fullExtract_(true)
+		, layoutHash_(0)
+		, layoutDirty_(true)
+		, sourceLayoutHash_(0)
+		, sourceExtractKey_(0)
+		, topologyCallback_(0)
+		, uvSetCallback_(0)
+		, skinDirty_(false)
+		, paletteUpdated_(false)
+		, geometryQueueIndex_(-1)
+		, uploadedCount_(0)
 	{
+		// トポロジとUVセットの変更を監視する(変形のみの判定でメッシュ全体を読み直さないため)
+		topologyCallback_ = MPolyMessage::addPolyTopologyChangedCallback(object, [](MObject& node, void* clientData) {
+			DAGMesh* own = reinterpret_cast<DAGMesh*>(clientData);
+			own->layoutDirty_ = true;
+		}, this);
+
+		uvSetCallback_ = MPolyMessage::addUVSetChangedCallback(object, [](MObject& node, const MString& name, int type, void* clientData) {
+			DAGMesh* own = reinterpret_cast<DAGMesh*>(clientData);
+			own->layoutDirty_ = true;
+		}, this);
 	}
 
 
 	DAGMesh::~DAGMesh()
 	{
+		if (topologyCallback_) MMessage::removeCallback(topologyCallback_);
+		if (uvSetCallback_) MMessage::removeCallback(uvSetCallback_);
+		auto& objectTable = DAGManager::Get()->GetObjectTable();
+		for (auto& pair : uniformMap_) {
+			objectTable.Free(pair.second.objectIndex);
+		}
+	}
+
+
+	void DAGMesh::CollectCallbacks(MCallbackIdArray& callbacks)
+	{
+		DAGNode::CollectCallbacks(callbacks);
+		if (topologyCallback_) {
+			callbacks.append(topologyCallback_);
+			topologyCallback_ = 0;
+		}
+		if (uvSetCallback_) {
+			callbacks.append(uvSetCallback_);
+			uvSetCallback_ = 0;
+		}
 	}
 
 
@@ -96,6 +256,7 @@ namespace bridge {
 
 		// ジオメトリの更新フラグを立てる
 		updated_ = true;
+		RequestUpdate();
 	}
 
 	void DAGMesh::NodeDirtyPlug(MObject& node, MPlug& plug)
@@ -103,7 +264,21 @@ namespace bridge {
 		// スキニング等でデフォームした場合inMesh(shortname:i)の更新通知がくる
 		MFnAttribute aFn(plug.attribute());
 		if (aFn.shortName() == "i") {
-			updated_ = true;
+			if (skin_) {
+				// GPUスキニングしている場合はパレットのみ更新する
+				skinDirty_ = true;
+			} else {
+				// ジオメトリがあれば変形とみなし、トポロジ等が同じなら位置と法線のみ更新する
+				deformed_ = true;
+				deforming_ = deforming_ || !meshes_.empty();
+
+				// 接続元がデフォーマ(位置のみ変える)でなければ、ヒストリの編集でトポロジやUVが変わった可能性がある
+				MPlugArray sources;
+				if (!plug.connectedTo(sources, true, false) || sources.length() == 0 || !sources[0].node().hasFn(MFn::kGeometryFilt)) {
+					layoutDirty_ = true;
+				}
+			}
+			RequestUpdate();
 		}
 	}
 
@@ -111,73 +286,221 @@ namespace bridge {
 	{
 		if (!handle_.isValid()) return;
 
+		// 更新があるならモデル更新を要求(表示されているインスタンスがある場合のみ)
+		// 反映されるまでは現在のジオメトリで描画を続ける
+		if (updated_ || deformed_) {
+			for (auto& pair : uniformMap_) {
+				if (pair.first->IsVisible()) {
+					DAGManager::Get()->RequestGeometry(this);
+					fullExtract_ = fullExtract_ || updated_;
+					updated_ = false;
+					deformed_ = false;
+					break;
+				}
+			}
+		}
+
+		// GPUスキニングしている場合はジョイントの行列からパレットとバウンディングを更新
+		if (skinDirty_ && skin_) {
+			UpdateSkinPalette();
+		}
 
+		// インスタンス、メッシュ数が変わった場合はバウンディングの配置を更新
+		if (boundsLayoutDirty_) {
+			UpdateBoundsLayout();
+		}
+
+		auto& objectTable = DAGManager::Get()->GetObjectTable();
 		for (auto& pair : uniformMap_) {
 			if (!pair.first->IsVisible()) continue;
 
-			// 更新があるならモデル更新
-			if (updated_) {
-				UpdateGeometry();
-				updated_ = false;
-			}
-
-			// トランスフォーム更新
+			// トランスフォーム更新(共有のパラメータ配列に書き込み、転送はDAGManagerでまとめて行う)
 			auto& data = pair.second;
 			if (data.updated) {
-				data.uniforms.Contents().localToWorld = Matrix44::Transpose(pair.first->GetWorldMatrix());
-				data.uniforms.Updated();
-				pair.second.updated = false;
+				const Matrix44& world = pair.first->GetWorldMatrix();
+				se::ObjectParameterData object;
+				object.localToWorld = Matrix44::Transpose(world);
+				objectTable.Set(data.objectIndex, object);
+				UpdateWorldBounds(data, world);
+				data.updated = false;
 			}
 		}
 	}
 
-	void DAGMesh::Draw(se::GraphicsContext& context, ShadingPath path)
+	void DAGMesh::UpdateBoundsLayout()
 	{
-		if (path != ShadingPath::MainPath) return;
-
-		// ユニフォーム更新
+		uint32_t meshCount = static_cast<uint32_t>(meshes_.size());
+		uint32_t offset = 0;
 		for (auto& pair : uniformMap_) {
-			if (GetNodeVisible(pair.first)) {
-				pair.second.uniforms.Update(context);
+			pair.second.boundsOffset = offset;
+			pair.second.updated = true;		// ワールドバウンディングを再計算させる
+			offset += meshCount;
+		}
+		worldBounds_.assign(offset, se::AABB());
+		inFrustum_.assign(offset, 1);
+
+		// 法線コーンはチャンクに分割したメッシュのみ
+		bool hasCone = std::any_of(meshes_.begin(), meshes_.end(), [](const Mesh& mesh) { return se::MeshClusterizer::IsConeValid(mesh.cone); });
+		if (hasCone) {
+			worldCones_.assign(offset, se::MeshClusterizer::InvalidCone());
+		} else {
+			std::vector<se::NormalCone>().swap(worldCones_);
+		}
+		boundsLayoutDirty_ = false;
+	}
+
+	void DAGMesh::UpdateWorldBounds(const TransformData& data, const Matrix44& world)
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(meshes_.size()); i++) {
+			worldBounds_[data.boundsOffset + i] = se::AABB::Transform(meshes_[i].bounds, world);
+		}
+		if (!worldCones_.empty()) {
+			for (uint32_t i = 0; i < static_cast<uint32_t>(meshes_.size()); i++) {
+				worldCones_[data.boundsOffset + i] = se::MeshClusterizer::TransformCone(meshes_[i].cone, &world.m[0][0]);
 			}
 		}
+	}
 
-		// メッシュを描画
-		auto iter = meshes_.begin();
-		for (; iter != meshes_.end(); iter++) {
-			DAGMaterial* material = iter->material;
-			const se::ShaderSet* shader = material->GetEngineShader();
-			if (!shader) continue;
+	bool DAGMesh::IsInFrustum(const TransformData& data, uint32_t meshIndex) const
+	{
+		// 配置の更新待ちの間はカリングしない
+		if (boundsLayoutDirty_) return true;
+		return inFrustum_[data.boundsOffset + meshIndex] != 0;
+	}
+
+	void DAGMesh::Cull(const se::Frustum& frustum)
+	{
+		if (boundsLayoutDirty_ || worldBounds_.empty()) return;
+		frustum.CullAABBs(worldBounds_.data(), static_cast<uint32_t>(worldBounds_.size()), inFrustum_.data());
 
-			context.SetVertexShader(shader->GetVS());
-			context.SetPixelShader(shader->GetPS());
-			context.SetIndexBuffer(iter->indexBuffer);
-			for(uint32_t i = 0; i < static_cast<uint32_t>(iter->vertexBuffers.size()); i++) {
-				context.SetVertexBuffer(i, iter->vertexBuffers[i]);
+		// 視錐台内のチャンクのうち全ての三角形が裏を向いているものも除く
+		for (uint32_t i = 0; i < static_cast<uint32_t>(worldCones_.size()); i++) {
+			if (!inFrustum_[i]) continue;
+			bool backfacing = frustum.IsOrthographic()
+				? se::MeshClusterizer::IsBackfacingDirection(worldCones_[i], frustum.GetViewDirection().ToFloatArray())
+				: se::MeshClusterizer::IsBackfacing(worldCones_[i], frustum.GetViewPosition().ToFloatArray());
+			if (backfacing) {
+				inFrustum_[i] = 0;
 			}
-			context.SetInputLayout(*iter->layout);
-			context.SetPrimitiveType(se::PRIMITIVE_TYPE_TRIANGLE_LIST);
-			for (uint32_t i = 0; i < material->GetDAGTextureNum(); i++) {
-				auto* texture = material->GetDAGTexture(i);
-				if (!texture || !texture->GetEngineTexture() || !texture->GetEngineSampler()) continue;
-				
-				context.SetPSResource(i, *texture->GetEngineTexture());
-				context.SetPSSamplerState(i, *texture->GetEngineSampler());
+		}
+	}
+
+	bool DAGMesh::BuildInstances(se::GraphicsContext& context, Mesh& mesh, uint32_t meshIndex, se::AABB* bounds)
+	{
+		// 視錐台内のインスタンスを詰める
+		auto& batch = mesh.instances;
+		batch.Begin();
+		for (auto& pair : uniformMap_) {
+			if (GetNodeVisible(pair.first) && IsInFrustum(pair.second, meshIndex)) {
+				batch.Add(pair.second.objectIndex);
+				if (!boundsLayoutDirty_) {
+					bounds->Extend(worldBounds_[pair.second.boundsOffset + meshIndex]);
+				}
 			}
+		}
+		if (batch.Count() == 0) return false;
 
-			// ステート
-			context.SetBlendState(se::BlendState::Get(se::BlendState::Opacity));
-			context.SetDepthStencilState(se::DepthStencilState::Get(se::DepthStencilState::WriteEnable));
-			context.SetRasterizerState(se::RasterizerState::Get(se::RasterizerState::BackFaceCull));
+		// 描画するインスタンスが変わった場合のみ番号を転送(足りなければ倍々で確保し直す)
+		// トランスフォームのみの更新ではDAGManagerの共有バッファが更新されるので転送不要
+		if (batch.End()) {
+			auto& buffer = mesh.instanceBuffer;
+			if (buffer.GetElementCount() < batch.Count()) {
+				uint32_t capacity = Max(batch.Count(), buffer.GetElementCount() * 2);
+				buffer.Destroy();
+				buffer.Create(sizeof(uint32_t), capacity);
+			}
+			buffer.Update(context, batch.Data(), batch.Count());
+		}
+		return true;
+	}
 
-			// 全インスタンス分描画
-			for (auto& pair : uniformMap_) {
-				if (GetNodeVisible(pair.first)) {
-					context.SetVSConstantBuffer(1, pair.second.uniforms.GetResource());
-					context.DrawIndexed(0, iter->indexBuffer.GetIndexCount());
-				}
+	void DAGMesh::Draw(se::GraphicsContext& context, se::RenderQueue& queue, ShadingPath path)
+	{
+		if (path != ShadingPath::MainPath) return;
+
+		FlushDeformStreams(context);
+
+		// パレットは全メッシュで共有する(足りなければ作り直す)
+		if (paletteUpdated_ && !palette_.empty()) {
+			uint32_t count = static_cast<uint32_t>(palette_.size());
+			if (paletteBuffer_.GetElementCount() < count) {
+				paletteBuffer_.Destroy();
+				paletteBuffer_.Create(sizeof(se::SkinMatrix), count);
 			}
+			paletteBuffer_.Update(context, palette_.data(), count);
+			paletteUpdated_ = false;
+		}
+
+		// メッシュ毎に描画パケットを登録
+		for (uint32_t meshIndex = 0; meshIndex < static_cast<uint32_t>(meshes_.size()); meshIndex++) {
+			Mesh& mesh = meshes_[meshIndex];
+			if (!mesh.resource || mesh.resource->indexBuffer.GetIndexCount() == 0) continue;
+
+			// 描画するインスタンスがなければスキップ
+			se::AABB bounds;
+			if (!BuildInstances(context, mesh, meshIndex, &bounds)) continue;
+
+			const se::ShaderSet* shader = mesh.material->GetEngineShader();
+			if (!shader) continue;
+
+			float depth = bounds.IsEmpty() ? 0.0f : queue.GetViewDepth(bounds.Center());
+			uint64_t sortKey = se::RenderQueue::MakeSortKey(
+				static_cast<uint32_t>(path),
+				shader->GetBlendType(),
+				static_cast<uint32_t>(shader->GetHash()),
+				static_cast<uint32_t>(std::hash<const void*>()(mesh.layout)),
+				static_cast<uint32_t>(std::hash<const void*>()(mesh.material)),
+				depth);
+			queue.Push(sortKey, this, meshIndex);
+		}
+	}
+
+	void DAGMesh::SubmitDrawPacket(se::GraphicsContext& context, uint32_t param)
+	{
+		Mesh& mesh = meshes_[param];
+		DAGMaterial* material = mesh.material;
+		const se::ShaderSet* shader = material->GetEngineShader();
+
+		bool skinned = mesh.skinBuffer.GetResource() != nullptr;
+		context.SetVertexShader(shader->GetVS(mesh.layout->quantized, skinned));
+		context.SetPixelShader(shader->GetPS());
+		const GeometryResource& resource = *mesh.resource;
+		context.SetIndexBuffer(resource.indexBuffer);
+		for(uint32_t i = 0; i < static_cast<uint32_t>(resource.vertexBuffers.size()); i++) {
+			context.SetVertexBuffer(i, resource.vertexBuffers[i]);
+		}
+		for (const auto& stream : mesh.deformStreams) {
+			if (stream.ringOffset != se::RingAllocator::InvalidOffset) {
+				context.SetVertexBuffer(stream.slot, se::GraphicsCore::GetVertexRing(), stream.stride, stream.ringOffset);
+			} else if (stream.buffer.GetResource()) {
+				context.SetVertexBuffer(stream.slot, stream.buffer);
+			}
+		}
+		context.SetInputLayout(*mesh.layout);
+		context.SetPrimitiveType(se::PRIMITIVE_TYPE_TRIANGLE_LIST);
+		for (uint32_t i = 0; i < material->GetDAGTextureNum(); i++) {
+			auto* texture = material->GetDAGTexture(i);
+			if (!texture || !texture->GetEngineTexture() || !texture->GetEngineSampler()) continue;
+			
+			context.SetPSResource(i, *texture->GetEngineTexture());
+			context.SetPSSamplerState(i, *texture->GetEngineSampler());
 		}
+
+		// ステート(半透明はデプスを書き込まない)
+		se::BlendState::BlendType blendType = shader->GetBlendType();
+		context.SetBlendState(se::BlendState::Get(blendType));
+		context.SetDepthStencilState(se::DepthStencilState::Get(
+			(blendType == se::BlendState::Opacity) ? se::DepthStencilState::WriteEnable : se::DepthStencilState::Enable));
+		context.SetRasterizerState(se::RasterizerState::Get(se::RasterizerState::BackFaceCull));
+
+		// 視錐台内のインスタンスをまとめて描画(番号で共有のパラメータを参照する)
+		context.SetVSResource(0, mesh.instanceBuffer);
+		context.SetVSResource(3, DAGManager::Get()->GetObjectBuffer());
+		if (skinned) {
+			context.SetVSResource(1, mesh.skinBuffer);
+			context.SetVSResource(2, paletteBuffer_);
+		}
+		context.DrawIndexedInstanced(0, resource.indexBuffer.GetIndexCount(), mesh.instances.Count());
 	}
 
 
@@ -185,6 +508,14 @@ namespace bridge {
 	{
 		// 外部から変更通知があった場合頂点レイアウトに影響を及ぼすので更新する
 		updated_ = true;
+		RequestUpdate();
+	}
+
+	void DAGMesh::InvalidateGeometry()
+	{
+		updated_ = true;
+		fullExtract_ = true;
+		RequestUpdate();
 	}
 
 	void DAGMesh::LinkParent(const DAGNode* parent)
@@ -193,8 +524,11 @@ namespace bridge {
 		auto pair = uniformMap_.emplace(transform, TransformData());
 		Assert(pair.second);	// すでにあるのはエラー
 
-		auto& uniforms = pair.first->second;
-		uniforms.updated = true;
+		auto& data = pair.first->second;
+		data.objectIndex = DAGManager::Get()->GetObjectTable().Allocate();
+		data.updated = true;
+		boundsLayoutDirty_ = true;
+		RequestUpdate();
 	}
 
 	void DAGMesh::UnlinkParent(const DAGNode* parent)
@@ -202,7 +536,31 @@ namespace bridge {
 		const DAGTransform* transform = static_cast<const DAGTransform*>(parent);
 		auto iter = uniformMap_.find(transform);
 		Assert(iter != uniformMap_.end());
+		DAGManager::Get()->GetObjectTable().Free(iter->second.objectIndex);
 		uniformMap_.erase(iter);
+		boundsLayoutDirty_ = true;
+		RequestUpdate();
+	}
+
+	void DAGMesh::UnlinkAll()
+	{
+		DAGNode::UnlinkAll();
+
+		// 親(インスタンス)側から外す(UnlinkParentでuniformMap_から削除される)
+		std::vector<const DAGTransform*> parents;
+		for (auto& pair : uniformMap_) {
+			parents.push_back(pair.first);
+		}
+		for (auto* parent : parents) {
+			const_cast<DAGTransform*>(parent)->RemoveChild(this);
+		}
+
+		// 親の子に登録されていなかったもの
+		auto& objectTable = DAGManager::Get()->GetObjectTable();
+		for (auto& pair : uniformMap_) {
+			objectTable.Free(pair.second.objectIndex);
+		}
+		uniformMap_.clear();
 	}
 
 	void DAGMesh::NotifyParentTransformUpdated(const DAGNode* parent)
@@ -211,13 +569,19 @@ namespace bridge {
 		auto iter = uniformMap_.find(transform);
 		Assert(iter != uniformMap_.end());
 
-		auto& uniforms = iter->second;
-		uniforms.updated = true;
+		auto& data = iter->second;
+		data.updated = true;
+		RequestUpdate();
 	}
 
 
-	void DAGMesh::UpdateGeometry()
+	void DAGMesh::ExtractGeometry()
 	{
+		// 加工中のものがあれば破棄(ワーカー側は参照を持っているので完了後に解放される)
+		pendingGeometry_.reset();
+		pendingSkin_.reset();
+		if (!handle_.isValid()) return;
+
 		MStatus status;
 		MFnMesh mesh(handle_.objectRef(), &status);
 		if (!status) {
@@ -227,7 +591,7 @@ namespace bridge {
 		MDagPath dagPath;
 		status = mesh.getPath(dagPath);
 		if (!status) {
-			MDisplayError("[MayaCustomViewport] / DAGMesh::UpdateGeometry / mesh.getPath()");
+			MDisplayError("[MayaCustomViewport] / DAGMesh::ExtractGeometry / mesh.getPath()");
 			return;
 		}
 
@@ -237,15 +601,66 @@ namespace bridge {
 		shaders.clear();
 		shaderIndices.clear();
 		if (!mesh.getConnectedShaders(0, shaders, shaderIndices)) {
-			MDisplayError("[MayaCustomViewport] / %s / DAGMesh::UpdateGeometry / mesh.getConnectedShaders()", mesh.name().asChar());
+			MDisplayError("[MayaCustomViewport] / %s / DAGMesh::ExtractGeometry / mesh.getConnectedShaders()", mesh.name().asChar());
 			return;
 		}
 		int numShaders = shaders.length();
 		if (numShaders <= 0) return;
 
+		// 頂点属性を1本のストリームにまとめるか、量子化するか、並べ替えるか
+		// 変形するメッシュは位置と法線を単独で書き換えられるようにまとめない
+		auto* settings = static_cast<DAGSettings*>(DAGManager::Get()->GetSettingsNode());
+		bool interleaved = settings && settings->IsInterleavedVertex() && !deforming_;
+		bool quantized = settings && settings->IsQuantizedVertex();
+		bool optimizeVertexCache = settings && settings->IsOptimizeVertexCache();
+		bool optimizeOverdraw = optimizeVertexCache && settings->IsOptimizeOverdraw();
+
+		// 巨大なメッシュはチャンクに分割してチャンク単位でカリングする
+		// 法線コーンが変形で変わるので、変形のみの更新は行わず毎回分割し直す
+		bool chunked = settings && settings->IsChunkedMesh();
+
+		// スキンクラスタで変形するメッシュはバインドポーズから抽出し、変形はVSで行う(全シェーダが対応している場合のみ)
+		std::shared_ptr<DAGSkinBinding> skin;
+		if (settings && settings->IsGpuSkinningEnabled()) {
+			skin = DAGSkinBinding::Find(dagPath);
+			for (int32_t i = 0; skin && i < numShaders; i++) {
+				auto* dagMat = static_cast<DAGMaterial*>(FindConnectedItem(shaders[i]));
+				if (!dagMat || !dagMat->GetEngineShader() || !dagMat->GetEngineShader()->IsSkinningSupported()) {
+					skin.reset();
+				}
+			}
+		}
+
+		// ウェイトはワーカースレッドで頂点毎に詰める
+		std::shared_ptr<SkinSource> skinSource;
+		if (skin) {
+			skinSource = std::make_shared<SkinSource>();
+			skinSource->jointCount = skin->GetJointCount();
+			skinSource->bindMatrices.assign(skin->GetBindMatrices(), skin->GetBindMatrices() + skinSource->jointCount * 16);
+			if (!skin->GetWeights(&skinSource->weights)) {
+				skin.reset();
+				skinSource.reset();
+			}
+		}
+		MDagPath sourcePath = skin ? skin->GetInputPath() : dagPath;
+
+		// ディスクキャッシュは初回の抽出(シーンを開いた時など)のみ使う
+		// 編集やデフォーメーションによる再抽出は毎回内容が変わるので読み書きしない
+		bool useDiskCache = !skin && !chunked && meshes_.empty() && settings && settings->IsDiskCacheEnabled() && se::GeometryDiskCache::Get().IsEnabled();
+		uint64_t shapeHash = 0;
+		if (useDiskCache) {
+			shapeHash = HashMeshShape(mesh);
+		}
+
 		// シェーダ数だけメッシュを作成
-		meshes_.clear();
-		meshes_.resize(numShaders);
+		std::shared_ptr<MeshGeometry> geometry = std::make_shared<MeshGeometry>();
+		auto& subMeshes = geometry->GetSubMeshes();
+		subMeshes.resize(numShaders);
+		std::vector<MIntArray> shadingPolyIds(numShaders);
+		const se::PolygonBuckets& shadingBuckets = BucketShaderPolygons(shaderIndices, numShaders);
+		// 抽出の設定とマテリアル(ハッシュ値のうちメッシュ以外から決まるもの、セッション内の比較のみに使う)
+		uint64_t extractKey = se::HashCombine(static_cast<uint64_t>(numShaders), (interleaved ? 1u : 0u) | (quantized ? 2u : 0u)
+			| (optimizeVertexCache ? 4u : 0u) | (optimizeOverdraw ? 8u : 0u) | (chunked ? 16u : 0u) | (skin ? 32u : 0u));
 		for (int32_t i = 0; i < numShaders; i++) {
 			// shadingEngine取得
 			MObject shader = shaders[i];
@@ -255,24 +670,82 @@ namespace bridge {
 				MDisplayError("[MayaCustomViewport] / メッシュに接続されているシェーディングエンジンから必要なミラーノード見つかりませんでした。%s / %s"
 					, Name().asChar(), MFnDependencyNode(shader).name().asChar());
 				meshes_.clear();
+				boundsLayoutDirty_ = true;
 				return;
 			}
-			meshes_[i].material = dagMat;
-			uint32_t attrFlag = dagMat->GetEngineShader()->GetVS().GetVertexAttribute();
+			SubMeshGeometry& subMesh = subMeshes[i];
+			subMesh.material = dagMat;
+			subMesh.attributes = dagMat->GetEngineShader()->GetVS().GetVertexAttribute();
+			subMesh.interleaved = interleaved;
+			subMesh.quantized = quantized;
+			subMesh.optimizeVertexCache = optimizeVertexCache;
+			subMesh.optimizeOverdraw = optimizeOverdraw;
+			subMesh.chunked = chunked;
+			subMesh.cone = se::MeshClusterizer::InvalidCone();
+			if (!chunked && i < static_cast<int32_t>(meshes_.size()) && meshes_[i].material == dagMat) {
+				subMesh.topology = meshes_[i].topology;
+			}
 
 			// シェーダがアサインされているポリゴンリストを取得
-			MIntArray shadingPolyIds;
-			shadingPolyIds.clear();
-			GetShaderAsignPolygonIndex(&shadingPolyIds, shaderIndices, i);
+			const int32_t* polygons = shadingBuckets.GetPolygons(i);
+			uint32_t polygonCount = shadingBuckets.GetCount(i);
+			shadingPolyIds[i] = MIntArray(polygons, polygonCount);
+			subMesh.diskCacheKey = 0;
+			extractKey = se::HashCombine(extractKey, reinterpret_cast<uintptr_t>(dagMat));
+			extractKey = se::HashCombine(extractKey, reinterpret_cast<uintptr_t>(dagMat->GetEngineShader()));
+		}
+
+		// 変形しない内容のハッシュ値(変形のみの判定とディスクキャッシュのキー)
+		// メッシュ全体を読むので、トポロジ、UV等の変更通知か設定の変更があった場合のみ計算し直す
+		// ポリゴンのシェーダ割り当てや頂点カラー等の編集はアトリビュートの変更としてfullExtract_になる
+		bool hashLayout = layoutDirty_ || fullExtract_ || useDiskCache || extractKey != sourceExtractKey_;
+		if (hashLayout) {
+			uint64_t layoutHash = se::HashCombine(HashMeshTopology(mesh), skin ? 1u : 0u);
+			for (int32_t i = 0; i < numShaders; i++) {
+				SubMeshGeometry& subMesh = subMeshes[i];
+				uint64_t sourceHash = HashSubMeshSource(mesh, layoutHash, subMesh.material, subMesh, shadingBuckets.GetPolygons(i), shadingBuckets.GetCount(i));
+				layoutHash = se::HashCombine(layoutHash, sourceHash);
+				if (useDiskCache) {
+					se::GeometryCacheKey key(sourceHash);
+					key.Add(shapeHash);
+					subMesh.diskCacheKey = key.GetDiskCacheKey();
+				}
+			}
+			sourceLayoutHash_ = layoutHash;
+			sourceExtractKey_ = extractKey;
+			layoutDirty_ = false;
+		}
+		uint64_t layoutHash = sourceLayoutHash_;
+		geometry->SetLayoutHash(layoutHash);
+
+		// トポロジ、UV等が前回と同じなら位置と法線のみ取得し、インデックスと他の属性は現在のバッファを使い続ける
+		bool deformOnly = !skin && !skin_ && !chunked && !fullExtract_ && layoutHash == layoutHash_ && meshes_.size() == subMeshes.size();
+		for (int32_t i = 0; deformOnly && i < numShaders; i++) {
+			const Mesh& current = meshes_[i];
+			deformOnly = current.material == subMeshes[i].material && current.sourceVertexCount > 0
+				&& (!subMeshes[i].optimizeVertexCache || current.topology);
+		}
+		geometry->SetDeformOnly(deformOnly);
+
+		geometry->SetSkin(skinSource);
+
+		for (int32_t i = 0; i < numShaders; i++) {
+			SubMeshGeometry& subMesh = subMeshes[i];
+			DAGMaterial* dagMat = subMesh.material;
+			uint32_t attrFlag = subMesh.attributes;
+
+			// 加工済みのものがディスクキャッシュにあれば抽出しない
+			if (useDiskCache) {
+				auto file = se::GeometryDiskCache::Get().Find(subMesh.diskCacheKey);
+				if (file && MeshGeometry::Restore(subMesh, file)) continue;
+			}
 
 			MHWRender::MGeometryRequirements requirements;
-			auto& vb = meshes_[i].vertexBuffers;
-			auto& ib = meshes_[i].indexBuffer;
 
 			// インデックス要項
 			MFnSingleIndexedComponent comp;
 			MObject compObj = comp.create(MFn::kMeshPolygonComponent);
-			comp.addElements(shadingPolyIds);	// IDによる制御
+			comp.addElements(shadingPolyIds[i]);	// IDによる制御
 			MHWRender::MIndexBufferDescriptor triangleDesc(MHWRender::MIndexBufferDescriptor::kTriangle, "", MHWRender::MGeometry::kTriangles, 3, compObj);
 			requirements.addIndexingRequirement(triangleDesc);
 
@@ -304,122 +777,337 @@ namespace bridge {
 				if (!HasAttr(attrFlag, se::VERTEX_ATTR_TEXCOORD0 + j)) break;
 				requirements.addVertexRequirement(uvDesc[j]);
 			}
+			uint32_t streamCount = requirements.vertexRequirements().length();
+
+			// GPUスキニングする場合はウェイトを割り当てるためにMayaの頂点番号も取得
+			MHWRender::MVertexBufferDescriptor vertexIdDesc("", MHWRender::MGeometry::kTexture, MHWRender::MGeometry::kFloat, 1);
+			vertexIdDesc.setSemanticName("vertexid");
+			if (skin) {
+				requirements.addVertexRequirement(vertexIdDesc);
+			}
 
 			// 抽出器
-			MHWRender::MGeometryExtractor extractor(requirements, dagPath, true, &status);
+			MHWRender::MGeometryExtractor extractor(requirements, sourcePath, true, &status);
 			if (!status) {
 				MDisplayError("[MayaCustomViewport] / MHWRender::MGeometryExtractor()");
 				meshes_.clear();
+				boundsLayoutDirty_ = true;
 				return;
 			}
 			uint32_t numVertices = extractor.vertexCount();
 			uint32_t numTriangles = extractor.primitiveCount(triangleDesc);
 			uint32_t minBufferSize = extractor.minimumBufferSize(numTriangles, triangleDesc.primitive());
 			//MDisplayInfo("material index: %d / triNum: %d / instanceCount: %d", i, numTriangles, mesh.parentCount());
+			subMesh.vertexCount = numVertices;
+			subMesh.sourceVertexCount = numVertices;
 
-			// 頂点データを抽出器から取得
-			std::unique_ptr<uint32_t[]> triangleIdx(new uint32_t[minBufferSize]);
-			std::unique_ptr<float[]> vertices(new float[numVertices * posDesc.stride()]);
-			std::unique_ptr<float[]> normals;
-			std::unique_ptr<float[]> colors;
-			std::unique_ptr<float[]> tangents;
-			std::unique_ptr<float[]> binormals;
-			std::unique_ptr<float[]> uvs[se::VERTEX_ATTR_TEXCOORD_NUM];
-
-			vb.resize(requirements.vertexRequirements().length());
-			{
-				// インデックスバッファ取得
-				if (numTriangles != 0) {
-					if (!extractor.populateIndexBuffer(triangleIdx.get(), numTriangles, triangleDesc)) {
-						MDisplayError("[MayaCustomViewport] / Failed populateIndexBuffer.");
-						meshes_.clear();
-						return;
-					}
-					ib.Create(triangleIdx.get(), sizeof(uint32_t) * numTriangles * 3, se::INDEX_BUFFER_STRIDE_U32);
-				}
+			// 変形のみの場合は前回と頂点の構成が同じでなければ作り直す
+			if (deformOnly && numVertices != meshes_[i].sourceVertexCount) {
+				fullExtract_ = true;
+				ExtractGeometry();
+				return;
+			}
 
-				// 各種バッファ取得
-				uint32_t bufferCounter = 0;
-				// pos
-				if (!extractor.populateVertexBuffer(vertices.get(), numVertices, posDesc)) {
-					MDisplayError("[MayaCustomViewport] / Failed populateVertexBuffer / position.");
+			// インデックスバッファ取得
+			if (!deformOnly && numTriangles != 0) {
+				subMesh.indices.resize(minBufferSize);
+				if (!extractor.populateIndexBuffer(subMesh.indices.data(), numTriangles, triangleDesc)) {
+					MDisplayError("[MayaCustomViewport] / Failed populateIndexBuffer.");
 					meshes_.clear();
+					boundsLayoutDirty_ = true;
 					return;
 				}
-				vb[bufferCounter].Create(vertices.get(), sizeof(float) * 3 * numVertices, se::VERTEX_ATTR_FLAG_POSITION, se::BUFFER_USAGE_DEFAULT, true);
+				subMesh.indices.resize(numTriangles * 3);
+			}
+
+			// 頂点データを抽出器から取得(加工はワーカースレッドで行う)
+			auto& streams = subMesh.streams;
+			streams.resize(streamCount);
+			auto populate = [&](GeometryStream& stream, MHWRender::MVertexBufferDescriptor& desc, uint32_t attribute, uint32_t components) {
+				stream.data.assign(numVertices * desc.stride(), 0.0f);
+				stream.attribute = attribute;
+				stream.components = components;
+				stream.stride = static_cast<uint32_t>(sizeof(float)) * components;
+				stream.usage = se::BUFFER_USAGE_IMMUTABLE;
+				stream.unorderedAccess = false;
+				return extractor.populateVertexBuffer(stream.data.data(), numVertices, desc);
+			};
+			uint32_t bufferCounter = 0;
+
+			// pos
+			if (!populate(streams[bufferCounter], posDesc, se::VERTEX_ATTR_FLAG_POSITION, 3)) {
+				MDisplayError("[MayaCustomViewport] / Failed populateVertexBuffer / position.");
+				meshes_.clear();
+				boundsLayoutDirty_ = true;
+				return;
+			}
+			streams[bufferCounter].usage = se::BUFFER_USAGE_DEFAULT;
+			streams[bufferCounter].unorderedAccess = true;
+			bufferCounter++;
+
+			// normal
+			if (HasAttr(attrFlag, se::VERTEX_ATTR_NORMAL)) {
+				if (!populate(streams[bufferCounter], normalDesc, se::VERTEX_ATTR_FLAG_NORMAL, 3)) {
+					MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / normal.");
+				}
 				bufferCounter++;
+			}
 
-				// normal
-				if (HasAttr(attrFlag, se::VERTEX_ATTR_NORMAL)) {
-					normals.reset(new float[numVertices * normalDesc.stride()]);
-					if (!extractor.populateVertexBuffer(normals.get(), numVertices, normalDesc)) {
-						MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / normal.");
-					}
-					vb[bufferCounter].Create(normals.get(), sizeof(float) * 3 * numVertices, se::VERTEX_ATTR_FLAG_NORMAL);
-					bufferCounter++;
+			// 変形のみの場合は位置と法線で終わり
+			if (deformOnly) {
+				streams.resize(bufferCounter);
+				continue;
+			}
+
+			// color
+			if (HasAttr(attrFlag, se::VERTEX_ATTR_COLOR)) {
+				if (!populate(streams[bufferCounter], colorDesc, se::VERTEX_ATTR_FLAG_COLOR, 4)) {
+					MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / color.");
+					// 初期値でバッファを埋める
+					std::fill(streams[bufferCounter].data.begin(), streams[bufferCounter].data.end(), 0.0f);
 				}
+				bufferCounter++;
+			}
 
-				// color
-				if (HasAttr(attrFlag, se::VERTEX_ATTR_COLOR)) {
-					colors.reset(new float[numVertices * colorDesc.stride()]);
-					if (!extractor.populateVertexBuffer(colors.get(), numVertices, colorDesc)) {
-						MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / color.");
-						// 初期値でバッファを埋める
-						memset(colors.get(), 0, sizeof(float) * colorDesc.stride() * numVertices);
-					}
-					vb[bufferCounter].Create(colors.get(), sizeof(float) * 4 * numVertices, se::VERTEX_ATTR_FLAG_COLOR);
-					bufferCounter++;
+			// uv
+			for (int32_t j = 0; j < se::VERTEX_ATTR_TEXCOORD_NUM; j++) {
+				if (!HasAttr(attrFlag, se::VERTEX_ATTR_TEXCOORD0 + j)) break;
+
+				if (!populate(streams[bufferCounter], uvDesc[j], 1 << (se::VERTEX_ATTR_TEXCOORD0 + j), 2)) {
+					MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / texcoord%d.", j);
 				}
+				streams[bufferCounter].usage = se::BUFFER_USAGE_DEFAULT;
+				streams[bufferCounter].unorderedAccess = true;
+				bufferCounter++;
+			}
 
-				// uv
-				for (int32_t j = 0; j < se::VERTEX_ATTR_TEXCOORD_NUM; j++) {
-					if (!HasAttr(attrFlag, se::VERTEX_ATTR_TEXCOORD0 + j)) break;
+			// tangent
+			if (HasAttr(attrFlag, se::VERTEX_ATTR_TANGENT)) {
+				if (!populate(streams[bufferCounter], tangentDesc, se::VERTEX_ATTR_FLAG_TANGENT, 3)) {
+					MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / tangent.");
+				}
+				bufferCounter++;
+			}
 
-					int stride = uvDesc[j].stride();
-					uvs[j].reset(new float[numVertices * stride]);
-					float* ptr = uvs[j].get();
-					if (!extractor.populateVertexBuffer(ptr, numVertices, uvDesc[j])) {
-						MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / texcoord%d.", j);
-					}
-					// UVをOpenGL->DirectX変換するためにVを反転(TODO:コンピュートシェーダに移動した方がCPUを圧迫しない)
-					int num = numVertices * stride;
-					for (int32_t k = 1; k < num; k += stride) {
-						ptr[k] = 1.0f - ptr[k];
-					}
-					vb[bufferCounter].Create(uvs[j].get(), 
-											sizeof(float) * 2 * numVertices, 
-											1 << (se::VERTEX_ATTR_TEXCOORD0 + j),
-											se::BUFFER_USAGE_DEFAULT,
-											true);
-					bufferCounter++;
+			// binormal
+			if (HasAttr(attrFlag, se::VERTEX_ATTR_BITANGENT)) {
+				if (!populate(streams[bufferCounter], binormalDesc, se::VERTEX_ATTR_FLAG_BITANGENT, 3)) {
+					MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / binormal.");
 				}
+				bufferCounter++;
+			}
 
-				// tangent
-				if (HasAttr(attrFlag, se::VERTEX_ATTR_TANGENT)) {
-					tangents.reset(new float[numVertices * tangentDesc.stride()]);
-					if (!extractor.populateVertexBuffer(tangents.get(), numVertices, tangentDesc)) {
-						MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / tangent.");
-					}
-					vb[bufferCounter].Create(tangents.get(), sizeof(float) * 3 * numVertices, se::VERTEX_ATTR_FLAG_TANGENT);
-					bufferCounter++;
+			// Mayaの頂点番号
+			if (skin) {
+				se::ScratchScope scope;
+				float* vertexIds = scope.Get().Allocate<float>(numVertices);
+				if (!extractor.populateVertexBuffer(vertexIds, numVertices, vertexIdDesc)) {
+					MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / vertexid.");
+				}
+				subMesh.sourceVertexIds.resize(numVertices);
+				for (uint32_t v = 0; v < numVertices; v++) {
+					subMesh.sourceVertexIds[v] = static_cast<uint32_t>(vertexIds[v] + 0.5f);
 				}
+			}
+		}
 
-				// binormal
-				if (HasAttr(attrFlag, se::VERTEX_ATTR_BITANGENT)) {
-					binormals.reset(new float[numVertices * binormalDesc.stride()]);
-					if (!extractor.populateVertexBuffer(binormals.get(), numVertices, binormalDesc)) {
-						MDisplayWarning("[MayaCustomViewport] / Failed populateVertexBuffer / binormal.");
-					}
-					vb[bufferCounter].Create(binormals.get(), sizeof(float) * 3 * numVertices, se::VERTEX_ATTR_FLAG_BITANGENT);
-					bufferCounter++;
+		// 加工はワーカースレッドで行い、完了後のフレーム境界でGPUリソースを作成する
+		// 数フレームかかることがあるので、フレーム内の並列処理を妨げないようバックグラウンドで行う
+		pendingGeometry_ = geometry;
+		pendingSkin_ = skin;
+		se::ThreadPool::Get().SubmitBackground([geometry]() {
+			geometry->Process();
+			geometry->MarkReady();
+		});
+	}
+
+	bool DAGMesh::ApplyGeometry(uint64_t* uploadBudget)
+	{
+		Assert(IsGeometryReady());
+		if (pendingGeometry_->IsDeformOnly()) {
+			std::shared_ptr<MeshGeometry> geometry = std::move(pendingGeometry_);
+			ApplyDeformation(geometry);
+			return true;
+		}
+
+		// GPUリソースは転送量の目安に達するまで作成し、残りは次のフレームで続ける
+		// 全て作成するまでは現在のジオメトリで描画を続ける
+		const auto& subMeshes = pendingGeometry_->GetSubMeshes();
+		if (uploadedCount_ == 0) {
+			std::vector<Mesh> meshes(subMeshes.size());
+			uploadingMeshes_.swap(meshes);
+		}
+		for (; uploadedCount_ < static_cast<uint32_t>(subMeshes.size()); uploadedCount_++) {
+			if (*uploadBudget == 0) return false;
+
+			const SubMeshGeometry& subMesh = subMeshes[uploadedCount_];
+			Mesh& mesh = uploadingMeshes_[uploadedCount_];
+			mesh.material = subMesh.material;
+			mesh.bounds = subMesh.bounds;
+			mesh.topology = subMesh.topology;
+			mesh.sourceVertexCount = subMesh.sourceVertexCount;
+			mesh.jointBounds = subMesh.jointBounds;
+			// GPUスキニングでは法線の向きが変わるので背面カリングしない
+			mesh.cone = subMesh.skinInfluences.empty() ? subMesh.cone : se::MeshClusterizer::InvalidCone();
+
+			// 抽出後にシェーダが外れた場合は再抽出を待つ
+			const se::ShaderSet* shader = subMesh.material->GetEngineShader();
+			if (!shader) {
+				ResetPendingGeometry();
+				return true;
+			}
+
+			// 同じ内容のバッファが既にあれば共有する
+			mesh.resource = DAGManager::Get()->GetGeometryCache().Acquire(subMesh);
+			if (!subMesh.skinInfluences.empty()) {
+				mesh.skinBuffer.Create(sizeof(se::SkinInfluence), static_cast<uint32_t>(subMesh.skinInfluences.size()), subMesh.skinInfluences.data());
+			}
+
+			// 頂点レイアウト算出
+			mesh.layout = se::VertexLayoutManager::Get().GetLayout(shader->GetVS(subMesh.quantized), subMesh.attributes, subMesh.interleaved, subMesh.quantized);
+			Assert(mesh.layout);
+
+			uint64_t bytes = subMesh.stats.vertexBytes + subMesh.stats.indexBytes;
+			*uploadBudget -= (std::min)(*uploadBudget, bytes);
+		}
+
+		std::shared_ptr<MeshGeometry> geometry = std::move(pendingGeometry_);
+		meshes_.swap(uploadingMeshes_);
+		deformSource_.reset();
+		std::vector<Mesh>().swap(uploadingMeshes_);
+		uploadedCount_ = 0;
+		geometryStats_ = geometry->GetStats();
+		layoutHash_ = geometry->GetLayoutHash();
+		fullExtract_ = false;
+		boundsLayoutDirty_ = true;
+
+		// バインドポーズのバウンディングを現在の姿勢に合わせる
+		skin_ = std::move(pendingSkin_);
+		if (skin_) {
+			UpdateSkinPalette();
+		}
+		return true;
+	}
+
+	void DAGMesh::ResetPendingGeometry()
+	{
+		pendingGeometry_.reset();
+		std::vector<Mesh>().swap(uploadingMeshes_);
+		uploadedCount_ = 0;
+	}
+
+	void DAGMesh::UpdateSkinPalette()
+	{
+		skinDirty_ = false;
+
+		// スキンクラスタが削除された場合はCPUで変形する形で抽出し直す
+		if (!skin_->UpdateJointMatrices()) {
+			skin_.reset();
+			InvalidateGeometry();
+			return;
+		}
+
+		uint32_t jointCount = skin_->GetJointCount();
+		palette_.resize(jointCount);
+		se::Skinning::BuildPalette(skin_->GetBindMatrices(), skin_->GetJointMatrices(), jointCount, palette_.data());
+		paletteUpdated_ = true;
+
+		for (auto& mesh : meshes_) {
+			if (mesh.jointBounds.size() != jointCount * 6) continue;
+			se::Vector3 boundsMin, boundsMax;
+			if (se::Skinning::ComputeSkinnedBounds(mesh.jointBounds.data(), skin_->GetJointMatrices(), jointCount, boundsMin.ToFloatArray(), boundsMax.ToFloatArray())) {
+				mesh.bounds = se::AABB(boundsMin, boundsMax);
+			}
+		}
+		boundsLayoutDirty_ = true;
+	}
+
+	void DAGMesh::ApplyDeformation(const std::shared_ptr<const MeshGeometry>& geometry)
+	{
+		// 抽出後にメッシュの構成が変わった場合は全て抽出し直す
+		const auto& subMeshes = geometry->GetSubMeshes();
+		bool valid = subMeshes.size() == meshes_.size() && geometry->GetLayoutHash() == layoutHash_;
+		for (uint32_t i = 0; valid && i < static_cast<uint32_t>(meshes_.size()); i++) {
+			valid = meshes_[i].resource && meshes_[i].material == subMeshes[i].material;
+		}
+		if (!valid) {
+			InvalidateGeometry();
+			return;
+		}
+
+		se::GraphicsContext& context = se::GraphicsCore::GetImmediateContext();
+		se::UploadRing& ring = se::GraphicsCore::GetVertexRing();
+		uint64_t frame = se::GraphicsCore::GetFrameIndex();
+		deformSource_.reset();
+		for (uint32_t i = 0; i < static_cast<uint32_t>(meshes_.size()); i++) {
+			const SubMeshGeometry& subMesh = subMeshes[i];
+			Mesh& mesh = meshes_[i];
+			mesh.bounds = subMesh.bounds;
+
+			// 共有している頂点バッファはそのままで、位置と法線は自分専用の領域に書き込む
+			// 変形が続く間は毎フレーム書き換わるので頂点リングに書き込み、空きがなければ専用の動的バッファを使う
+			const auto& vertexBuffers = mesh.resource->vertexBuffers;
+			for (uint32_t s = 0; s < static_cast<uint32_t>(subMesh.streams.size()) && s < _countof(mesh.deformStreams); s++) {
+				const GeometryStream& stream = subMesh.streams[s];
+				DeformStream& deform = mesh.deformStreams[s];
+				uint32_t size = stream.stride * subMesh.vertexCount;
+				if (deform.stride == 0) {
+					auto iter = std::find_if(vertexBuffers.begin(), vertexBuffers.end(), [&](const se::VertexBuffer& buffer) {
+						return buffer.GetAttributes() == stream.attribute;
+					});
+					if (iter == vertexBuffers.end()) continue;
+					deform.slot = static_cast<uint32_t>(iter - vertexBuffers.begin());
+					deform.stride = stream.stride;
+				}
+
+				deform.ringOffset = ring.Write(context, stream.GetData(), size, se::UploadRing::VertexAlignment);
+				if (deform.ringOffset != se::RingAllocator::InvalidOffset) {
+					deform.ringFrame = frame;
+					deformSource_ = geometry;
+				} else if (!deform.buffer.GetResource()) {
+					deform.buffer.Create(stream.GetData(), size, stream.attribute, se::BUFFER_USAGE_DYNAMIC, false, subMesh.quantized);
+				} else {
+					deform.buffer.Update(context, stream.GetData(), size);
+				}
+			}
+		}
+
+		// バウンディングが変わるのでワールドバウンディングを更新
+		boundsLayoutDirty_ = true;
+	}
+
+	void DAGMesh::FlushDeformStreams(se::GraphicsContext& context)
+	{
+		if (!deformSource_) return;
+
+		// 前のフレームまでに頂点リングに書き込んだものは次の変形まで使えるよう専用の動的バッファに移す
+		uint64_t frame = se::GraphicsCore::GetFrameIndex();
+		const auto& subMeshes = deformSource_->GetSubMeshes();
+		bool pending = false;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(meshes_.size()) && i < static_cast<uint32_t>(subMeshes.size()); i++) {
+			const SubMeshGeometry& subMesh = subMeshes[i];
+			Mesh& mesh = meshes_[i];
+			for (uint32_t s = 0; s < static_cast<uint32_t>(subMesh.streams.size()) && s < _countof(mesh.deformStreams); s++) {
+				DeformStream& deform = mesh.deformStreams[s];
+				if (deform.ringOffset == se::RingAllocator::InvalidOffset) continue;
+				if (deform.ringFrame == frame) {
+					pending = true;
+					continue;
 				}
 
-				// 頂点レイアウト算出
-				auto& vs = dagMat->GetEngineShader()->GetVS();
-				meshes_[i].layout = se::VertexLayoutManager::Get().GetLayout(vs, attrFlag);
-				Assert(meshes_[i].layout);
+				const GeometryStream& stream = subMesh.streams[s];
+				uint32_t size = stream.stride * subMesh.vertexCount;
+				if (!deform.buffer.GetResource()) {
+					deform.buffer.Create(stream.GetData(), size, stream.attribute, se::BUFFER_USAGE_DYNAMIC, false, subMesh.quantized);
+				} else {
+					deform.buffer.Update(context, stream.GetData(), size);
+				}
+				deform.ringOffset = se::RingAllocator::InvalidOffset;
 			}
 		}
+		if (!pending) {
+			deformSource_.reset();
+		}
 	}
 
 }
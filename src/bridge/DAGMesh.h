@@ -7,6 +7,9 @@
 
 #include "Common.h"
 #include "DAGNode.h"
+#include "DAGMeshGeometry.h"
+#include "DAGGeometryCache.h"
+#include "DAGSkinBinding.h"
 
 namespace bridge {
 	class DAGMaterial;
@@ -14,7 +17,8 @@ namespace bridge {
 
 	struct TransformData
 	{
-		se::TUniformParameter<se::ObjectParameterData> uniforms;
+		uint32_t objectIndex;		// DAGManagerのObjectParameterTable内の番号
+		uint32_t boundsOffset;		// DAGMeshのワールドバウンディング配列内の位置
 		bool updated;
 	};
 
@@ -23,25 +27,91 @@ namespace bridge {
 	/**
 	 * DAGMesh
 	 */
-	class DAGMesh : public DAGNode
+	class DAGMesh : public DAGNode, public se::Drawable
 	{
+		friend class DAGManager;
+
 	private:
+		// 変形時に書き換える頂点ストリーム(共有バッファの代わりにバインドする)
+		// 変形したフレームは頂点リングに書き込み、変形が止まったらbufferに移す
+		struct DeformStream
+		{
+			uint32_t slot;				// 差し替える頂点バッファの位置
+			uint32_t stride;			// 0: 未使用
+			se::VertexBuffer buffer;	// BUFFER_USAGE_DYNAMIC
+			uint32_t ringOffset;		// 頂点リング内の位置(se::RingAllocator::InvalidOffset: bufferを使う)
+			uint64_t ringFrame;			// 頂点リングに書き込んだフレーム
+
+			DeformStream() : slot(0), stride(0), ringOffset(se::RingAllocator::InvalidOffset), ringFrame(0) {}
+		};
+
 		// メッシュリソース
 		struct Mesh 
 		{
-			std::vector<se::VertexBuffer> vertexBuffers;
-			se::IndexBuffer indexBuffer;
+			std::shared_ptr<const GeometryResource> resource;		// 同じ内容のメッシュと共有する頂点、インデックスバッファ
 			const se::VertexInputLayout* layout;
 			DAGMaterial* material;
+			se::AABB bounds;		// ローカル空間のバウンディング
+			se::InstanceBatch instances;			// 描画するインスタンスのオブジェクトパラメータの番号
+			se::StructuredBuffer instanceBuffer;	// instancesの転送先(uint32_t)
+			std::shared_ptr<const OptimizedTopology> topology;		// インデックス最適化の結果(再抽出時に再利用)
+			uint32_t sourceVertexCount;		// 抽出時の頂点数(変形のみの更新で構成が同じか判定する)
+			DeformStream deformStreams[2];	// 位置、法線(未使用はstrideが0)
+			se::StructuredBuffer skinBuffer;	// GPUスキニングする場合の頂点毎のインフルエンス(se::SkinInfluence)
+			std::vector<float> jointBounds;		// GPUスキニングする場合のジョイント毎のバウンディング
+			se::NormalCone cone;			// チャンクに分割した場合のローカル空間の法線コーン(背面カリング用)
 		};
 
 	private:
 		std::vector<Mesh> meshes_;
 		NodeUniformMap uniformMap_;
+		GeometryStats geometryStats_;		// 現在のジオメトリのメモリ使用量と量子化誤差
+
+		// インスタンス x メッシュ毎のワールドバウンディングとカリング結果
+		std::vector<se::AABB> worldBounds_;
+		std::vector<uint8_t> inFrustum_;
+		std::vector<se::NormalCone> worldCones_;		// 法線コーンを持つメッシュがある場合のみ
+		bool boundsLayoutDirty_;
+
 		bool updated_;
+		bool deformed_;			// inMeshが更新された(位置と法線のみの更新で済む可能性がある)
+		bool deforming_;		// 変形するメッシュ(頂点ストリームをまとめない)
+		std::shared_ptr<const MeshGeometry> deformSource_;	// 頂点リングに書き込んだ変形(bufferに移すまで保持)
+		bool fullExtract_;		// 変形のみの更新を使わずに全て抽出し直す
+		uint64_t layoutHash_;	// 現在のジオメトリのトポロジ、UV等のハッシュ値
+		bool layoutDirty_;			// トポロジ、UV等が変わった可能性がある(sourceLayoutHash_を計算し直す)
+		uint64_t sourceLayoutHash_;	// 最後に計算したMaya側のトポロジ、UV等のハッシュ値(変形のたびに計算し直さない)
+		uint64_t sourceExtractKey_;	// sourceLayoutHash_を計算した時の抽出の設定とマテリアル
+		MCallbackId topologyCallback_;
+		MCallbackId uvSetCallback_;
+
+		// GPUスキニング
+		std::shared_ptr<DAGSkinBinding> skin_;			// 現在のジオメトリのスキンクラスタ(CPUで変形する場合はnullptr)
+		std::shared_ptr<DAGSkinBinding> pendingSkin_;	// 加工中のジオメトリのスキンクラスタ
+		std::vector<se::SkinMatrix> palette_;
+		se::StructuredBuffer paletteBuffer_;
+		bool skinDirty_;			// ジョイントの行列を読み直す
+		bool paletteUpdated_;		// パレットを転送する
+
+		// 非同期のジオメトリ更新
+		std::shared_ptr<MeshGeometry> pendingGeometry_;		// 加工中のジオメトリ
+		int32_t geometryQueueIndex_;						// DAGManagerのジオメトリキュー内の位置(-1: 未登録)
+		std::vector<Mesh> uploadingMeshes_;					// GPUリソース作成中のメッシュ(全て作成したらmeshes_と入れ替える)
+		uint32_t uploadedCount_;							// uploadingMeshes_の作成済みの数
 
 	private:
-		void UpdateGeometry();
+		void ExtractGeometry();
+		bool ApplyGeometry(uint64_t* uploadBudget);
+		void ResetPendingGeometry();
+		void ApplyDeformation(const std::shared_ptr<const MeshGeometry>& geometry);
+		void FlushDeformStreams(se::GraphicsContext& context);
+		void UpdateSkinPalette();
+		bool IsGeometryPending() const { return pendingGeometry_ != nullptr; }
+		bool IsGeometryReady() const { return pendingGeometry_ && pendingGeometry_->IsReady(); }
+		void UpdateBoundsLayout();
+		void UpdateWorldBounds(const TransformData& data, const Matrix44& world);
+		bool IsInFrustum(const TransformData& data, uint32_t meshIndex) const;
+		bool BuildInstances(se::GraphicsContext& context, Mesh& mesh, uint32_t meshIndex, se::AABB* bounds);
 
 	protected:
 		virtual void AttributeChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug) override;
@@ -53,11 +123,19 @@ namespace bridge {
 
 		virtual DAGType Type() const override { return DAGType::Mesh; }
 		virtual void Update() override;
-		virtual void Draw(se::GraphicsContext& context, ShadingPath path) override;
+		virtual void Draw(se::GraphicsContext& context, se::RenderQueue& queue, ShadingPath path) override;
+		virtual void SubmitDrawPacket(se::GraphicsContext& context, uint32_t param) override;
+		virtual void Cull(const se::Frustum& frustum) override;
 		virtual void NotifyUpdateConnection(const DAGNode* node) override;
 		virtual void LinkParent(const DAGNode* parent) override;
 		virtual void UnlinkParent(const DAGNode* parent) override;
+		virtual void UnlinkAll() override;
 		virtual void NotifyParentTransformUpdated(const DAGNode* parent) override;
+		virtual void CollectCallbacks(MCallbackIdArray& callbacks) override;
+
+		// ジオメトリを作り直す(頂点フォーマットの設定変更時など)
+		void InvalidateGeometry();
+		const GeometryStats& GetGeometryStats() const { return geometryStats_; }
 	};
 
 }
\ No newline at end of file
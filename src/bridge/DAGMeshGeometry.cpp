@@ -0,0 +1,539 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "bridge/DAGMeshGeometry.h"
+#include "engine/Graphics/VertexPacker.h"
+#include "engine/Graphics/VertexQuantizer.h"
+#include "engine/Graphics/MeshOptimizer.h"
+#include "engine/Graphics/StreamKernels.h"
+#include "engine/Graphics/GeometryDiskCache.h"
+#include "engine/Core/Hash.h"
+#include "engine/Core/ScratchArena.h"
+#include <algorithm>
+#include <cstring>
+
+namespace bridge {
+
+	namespace {
+		const uint32_t CacheFlagInterleaved = 1 << 0;
+		const uint32_t CacheFlagQuantized = 1 << 1;
+
+		const uint32_t TexcoordFlags = se::VERTEX_ATTR_FLAG_TEXCOORD0 | se::VERTEX_ATTR_FLAG_TEXCOORD1
+			| se::VERTEX_ATTR_FLAG_TEXCOORD2 | se::VERTEX_ATTR_FLAG_TEXCOORD3;
+
+		// 単一属性のフラグから属性を取得
+		se::VertexAttribute GetAttribute(uint32_t flag)
+		{
+			uint32_t attribute = 0;
+			while (attribute < se::VERTEX_ATTR_NUM - 1 && flag != (1u << attribute)) {
+				attribute++;
+			}
+			return static_cast<se::VertexAttribute>(attribute);
+		}
+
+		// UVをOpenGL->DirectX変換するためにVを反転
+		void FlipV(GeometryStream& stream)
+		{
+			uint32_t vertexCount = static_cast<uint32_t>(stream.data.size() / stream.components);
+			se::StreamKernels::FlipV(stream.data.data(), vertexCount, stream.components);
+		}
+
+		// 位置のストリームからバウンディングを求める
+		se::AABB ComputeBounds(const GeometryStream& stream, uint32_t vertexCount)
+		{
+			se::AABB bounds;
+			se::StreamKernels::ComputeBounds(stream.data.data(), stream.components, vertexCount, bounds.minPos.ToFloatArray(), bounds.maxPos.ToFloatArray());
+			return bounds;
+		}
+
+		// 縮退ポリゴン(同じ頂点を含む三角形)を詰めて取り除き、取り除いた数を返す
+		uint32_t RemoveDegenerateTriangles(std::vector<uint32_t>& indices)
+		{
+			size_t count = 0;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+				uint32_t a = indices[i];
+				uint32_t b = indices[i + 1];
+				uint32_t c = indices[i + 2];
+				if (a == b || b == c || c == a) continue;
+				indices[count++] = a;
+				indices[count++] = b;
+				indices[count++] = c;
+			}
+			uint32_t removed = static_cast<uint32_t>((indices.size() - count) / 3);
+			indices.resize(count);
+			return removed;
+		}
+
+		// 頂点を新しい順番に並べ替える(参照されない頂点は取り除く)
+		// 元の内容を一時領域に写して、ストリームはその場で詰め直す(頂点数は増えないので再確保しない)
+		void RemapVertices(SubMeshGeometry& subMesh, const OptimizedTopology& topology, se::ScratchArena& scratch)
+		{
+			for (auto& stream : subMesh.streams) {
+				se::ScratchArena::Marker marker = scratch.GetMarker();
+				size_t size = static_cast<size_t>(subMesh.vertexCount) * stream.components;
+				float* source = scratch.Allocate<float>(size);
+				std::copy_n(stream.data.data(), size, source);
+				stream.data.resize(static_cast<size_t>(topology.vertexCount) * stream.components);
+				for (uint32_t v = 0; v < subMesh.vertexCount; v++) {
+					uint32_t to = topology.remap[v];
+					if (to == se::MeshOptimizer::InvalidIndex) continue;
+					std::copy_n(source + static_cast<size_t>(v) * stream.components, stream.components,
+						stream.data.data() + static_cast<size_t>(to) * stream.components);
+				}
+				scratch.Rewind(marker);
+			}
+			if (!subMesh.sourceVertexIds.empty()) {
+				se::ScratchArena::Marker marker = scratch.GetMarker();
+				uint32_t* source = scratch.Allocate<uint32_t>(subMesh.vertexCount);
+				std::copy_n(subMesh.sourceVertexIds.data(), subMesh.vertexCount, source);
+				subMesh.sourceVertexIds.resize(topology.vertexCount);
+				for (uint32_t v = 0; v < subMesh.vertexCount; v++) {
+					uint32_t to = topology.remap[v];
+					if (to == se::MeshOptimizer::InvalidIndex) continue;
+					subMesh.sourceVertexIds[to] = source[v];
+				}
+				scratch.Rewind(marker);
+			}
+			subMesh.vertexCount = topology.vertexCount;
+		}
+
+		// 頂点キャッシュ(とオーバードロー)向けに三角形を並べ替え、頂点を参照順に並べ替える
+		// トポロジが前回と同じなら前回の結果を再利用する
+		void OptimizeTopology(SubMeshGeometry& subMesh, se::ScratchArena& scratch)
+		{
+			auto& indices = subMesh.indices;
+			uint64_t hash = se::MeshOptimizer::HashTopology(indices.data(), indices.size(), subMesh.vertexCount);
+
+			std::shared_ptr<const OptimizedTopology> topology = subMesh.topology;
+			if (!topology || topology->hash != hash || topology->overdraw != subMesh.optimizeOverdraw) {
+				auto result = std::make_shared<OptimizedTopology>();
+				result->hash = hash;
+				result->overdraw = subMesh.optimizeOverdraw;
+				result->indices = indices;
+
+				std::vector<uint32_t> clusters;
+				se::MeshOptimizer::OptimizeVertexCache(result->indices.data(), result->indices.size(), subMesh.vertexCount,
+					se::MeshOptimizer::DefaultCacheSize, subMesh.optimizeOverdraw ? &clusters : nullptr);
+				if (subMesh.optimizeOverdraw) {
+					for (const auto& stream : subMesh.streams) {
+						if (stream.attribute != se::VERTEX_ATTR_FLAG_POSITION) continue;
+						se::MeshOptimizer::OptimizeOverdraw(result->indices.data(), result->indices.size(), clusters,
+							stream.data.data(), stream.components, subMesh.vertexCount);
+						break;
+					}
+				}
+
+				result->remap.resize(subMesh.vertexCount);
+				result->vertexCount = se::MeshOptimizer::OptimizeVertexFetch(result->indices.data(), result->indices.size(), subMesh.vertexCount, result->remap.data());
+				topology = result;
+			}
+
+			RemapVertices(subMesh, *topology, scratch);
+			indices = topology->indices;
+			subMesh.topology = topology;
+		}
+
+		// 頂点数が16bitに収まる場合はインデックスを16bitにする
+		void NarrowIndices(SubMeshGeometry& subMesh)
+		{
+			if (subMesh.vertexCount > 0x10000) {
+				subMesh.indexStride = se::INDEX_BUFFER_STRIDE_U32;
+				return;
+			}
+			subMesh.shortIndices.assign(subMesh.indices.begin(), subMesh.indices.end());
+			subMesh.indexStride = se::INDEX_BUFFER_STRIDE_U16;
+			std::vector<uint32_t>().swap(subMesh.indices);
+		}
+
+		// 属性毎のストリームをそれぞれ量子化する(位置はfloatのまま)
+		void Quantize(SubMeshGeometry& subMesh)
+		{
+			for (auto& stream : subMesh.streams) {
+				if (stream.attribute == se::VERTEX_ATTR_FLAG_POSITION) continue;
+
+				se::VertexAttribute attribute = GetAttribute(stream.attribute);
+				uint32_t stride = se::VertexQuantizer::GetAttributeSize(attribute);
+				std::vector<float> encoded(static_cast<size_t>(stride / sizeof(float)) * subMesh.vertexCount);
+				se::VertexQuantizer::Encode(attribute, stream.data.data(), stream.components, subMesh.vertexCount, encoded.data(), stride);
+				stream.data.swap(encoded);
+				stream.stride = stride;
+			}
+		}
+
+		// シェーダが要求する属性を1本のストリームに詰める
+		void Interleave(SubMeshGeometry& subMesh, se::ScratchArena& scratch)
+		{
+			se::VertexStreamSource* sources = scratch.Allocate<se::VertexStreamSource>(subMesh.streams.size());
+			GeometryStream packed;
+			packed.mapped = nullptr;
+			packed.attribute = subMesh.attributes;
+			packed.stride = se::VertexPacker::GetStride(subMesh.attributes, subMesh.quantized);
+			packed.components = packed.stride / sizeof(float);
+			packed.usage = se::BUFFER_USAGE_IMMUTABLE;
+			packed.unorderedAccess = false;
+			for (size_t i = 0; i < subMesh.streams.size(); i++) {
+				const GeometryStream& stream = subMesh.streams[i];
+				sources[i].data = stream.data.empty() ? nullptr : stream.data.data();
+				sources[i].attribute = stream.attribute;
+				sources[i].components = stream.components;
+				// UAVを要求するストリームがあればまとめたバッファも合わせる
+				if (stream.unorderedAccess) {
+					packed.usage = se::BUFFER_USAGE_DEFAULT;
+					packed.unorderedAccess = true;
+				}
+			}
+
+			packed.data.resize(static_cast<size_t>(packed.components) * subMesh.vertexCount);
+			se::VertexPacker::Pack(subMesh.attributes, sources, static_cast<uint32_t>(subMesh.streams.size()), subMesh.vertexCount, packed.data.data(), subMesh.quantized);
+
+			subMesh.streams.clear();
+			subMesh.streams.push_back(std::move(packed));
+		}
+
+		// GPUリソースの内容(頂点、インデックス、頂点属性の構成)のハッシュ値
+		uint64_t HashContent(const SubMeshGeometry& subMesh)
+		{
+			uint64_t hash = se::Hash64(&subMesh.vertexCount, sizeof(subMesh.vertexCount));
+			hash = se::HashCombine(hash, subMesh.attributes);
+			hash = se::HashCombine(hash, (subMesh.interleaved ? 1u : 0u) | (subMesh.quantized ? 2u : 0u));
+			hash = se::HashCombine(hash, subMesh.indexStride);
+			if (subMesh.indexStride == se::INDEX_BUFFER_STRIDE_U16) {
+				hash = se::HashCombine(hash, se::Hash64(subMesh.shortIndices.data(), sizeof(uint16_t) * subMesh.shortIndices.size()));
+			} else {
+				hash = se::HashCombine(hash, se::Hash64(subMesh.indices.data(), sizeof(uint32_t) * subMesh.indices.size()));
+			}
+			for (const auto& stream : subMesh.streams) {
+				hash = se::HashCombine(hash, stream.attribute);
+				hash = se::HashCombine(hash, stream.stride);
+				hash = se::HashCombine(hash, (static_cast<uint32_t>(stream.usage) << 1) | (stream.unorderedAccess ? 1u : 0u));
+				hash = se::HashCombine(hash, se::Hash64(stream.data.data(), static_cast<size_t>(stream.stride) * subMesh.vertexCount));
+			}
+			return hash;
+		}
+
+		// Mayaの頂点毎に詰めたインフルエンスを抽出した頂点に割り当て、ジョイント毎のバウンディングを求める(量子化より前に行う)
+		void AssignSkinInfluences(SubMeshGeometry& subMesh, const se::SkinInfluence* influences, uint32_t influenceCount, const SkinSource& skin)
+		{
+			subMesh.skinInfluences.resize(subMesh.vertexCount);
+			for (uint32_t v = 0; v < subMesh.vertexCount; v++) {
+				uint32_t source = subMesh.sourceVertexIds[v];
+				if (source < influenceCount) {
+					subMesh.skinInfluences[v] = influences[source];
+				} else {
+					memset(&subMesh.skinInfluences[v], 0, sizeof(se::SkinInfluence));
+					subMesh.skinInfluences[v].weights[0] = 255;
+				}
+			}
+			std::vector<uint32_t>().swap(subMesh.sourceVertexIds);
+
+			subMesh.jointBounds.resize(static_cast<size_t>(skin.jointCount) * 6);
+			for (const auto& stream : subMesh.streams) {
+				if (stream.attribute != se::VERTEX_ATTR_FLAG_POSITION) continue;
+				se::Skinning::ComputeJointBounds(stream.data.data(), stream.components, subMesh.skinInfluences.data(), subMesh.vertexCount,
+					skin.bindMatrices.data(), skin.jointCount, subMesh.jointBounds.data());
+			}
+		}
+
+		// 位置が近い三角形のチャンク毎のサブメッシュに分割する(頂点は各チャンクが参照するものを複製する)
+		void SplitChunks(std::vector<SubMeshGeometry>& subMeshes, se::ScratchArena& scratch)
+		{
+			auto isChunked = [](const SubMeshGeometry& subMesh) { return subMesh.chunked; };
+			if (std::none_of(subMeshes.begin(), subMeshes.end(), isChunked)) return;
+
+			std::vector<SubMeshGeometry> result;
+			std::vector<uint32_t> triangles;
+			std::vector<se::MeshChunk> chunks;
+			for (auto& subMesh : subMeshes) {
+				subMesh.cone = se::MeshClusterizer::InvalidCone();
+				auto position = std::find_if(subMesh.streams.begin(), subMesh.streams.end(), [](const GeometryStream& stream) {
+					return stream.attribute == se::VERTEX_ATTR_FLAG_POSITION;
+				});
+				if (!subMesh.chunked || subMesh.cacheFile || subMesh.indices.empty() || position == subMesh.streams.end()) {
+					result.push_back(std::move(subMesh));
+					continue;
+				}
+
+				se::MeshClusterizer::Build(subMesh.indices.data(), subMesh.indices.size(), position->data.data(), position->components, subMesh.vertexCount,
+					&triangles, &chunks);
+				if (chunks.size() == 1) {
+					// 1つに収まる場合はそのまま(法線コーンのみ使う)
+					subMesh.cone = chunks[0].cone;
+					result.push_back(std::move(subMesh));
+					continue;
+				}
+
+				// 頂点の印と各チャンクの頂点の並びは一時領域に置く
+				se::ScratchArena::Marker marker = scratch.GetMarker();
+				uint32_t* local = scratch.Allocate<uint32_t>(subMesh.vertexCount);
+				std::fill_n(local, subMesh.vertexCount, se::MeshOptimizer::InvalidIndex);
+				for (const auto& chunk : chunks) {
+					SubMeshGeometry part;
+					part.material = subMesh.material;
+					part.attributes = subMesh.attributes;
+					part.sourceVertexCount = 0;
+					part.interleaved = subMesh.interleaved;
+					part.quantized = subMesh.quantized;
+					part.optimizeVertexCache = subMesh.optimizeVertexCache;
+					part.optimizeOverdraw = subMesh.optimizeOverdraw;
+					part.chunked = true;
+					part.cone = chunk.cone;
+					part.indexStride = subMesh.indexStride;
+					part.contentHash = 0;
+					part.diskCacheKey = 0;
+
+					// チャンク内で最初に参照された順に頂点を詰める
+					se::ScratchArena::Marker chunkMarker = scratch.GetMarker();
+					uint32_t* vertices = scratch.Allocate<uint32_t>(chunk.vertexCount);
+					uint32_t vertexCount = 0;
+					part.indices.resize(static_cast<size_t>(chunk.triangleCount) * 3);
+					for (uint32_t t = 0; t < chunk.triangleCount; t++) {
+						const uint32_t* triangle = subMesh.indices.data() + static_cast<size_t>(triangles[chunk.triangleOffset + t]) * 3;
+						for (uint32_t k = 0; k < 3; k++) {
+							uint32_t v = triangle[k];
+							if (local[v] == se::MeshOptimizer::InvalidIndex) {
+								local[v] = vertexCount;
+								vertices[vertexCount++] = v;
+							}
+							part.indices[t * 3 + k] = local[v];
+						}
+					}
+					part.vertexCount = vertexCount;
+
+					part.streams.resize(subMesh.streams.size());
+					for (size_t s = 0; s < subMesh.streams.size(); s++) {
+						const GeometryStream& stream = subMesh.streams[s];
+						GeometryStream& partStream = part.streams[s];
+						partStream.mapped = nullptr;
+						partStream.attribute = stream.attribute;
+						partStream.components = stream.components;
+						partStream.stride = stream.stride;
+						partStream.usage = stream.usage;
+						partStream.unorderedAccess = stream.unorderedAccess;
+						partStream.data.resize(static_cast<size_t>(stream.components) * part.vertexCount);
+						for (uint32_t v = 0; v < part.vertexCount; v++) {
+							std::copy_n(stream.data.data() + static_cast<size_t>(vertices[v]) * stream.components, stream.components,
+								partStream.data.data() + static_cast<size_t>(v) * stream.components);
+						}
+					}
+					if (!subMesh.sourceVertexIds.empty()) {
+						part.sourceVertexIds.resize(part.vertexCount);
+						for (uint32_t v = 0; v < part.vertexCount; v++) {
+							part.sourceVertexIds[v] = subMesh.sourceVertexIds[vertices[v]];
+						}
+					}
+
+					// 次のチャンクのために印を戻す
+					for (uint32_t v = 0; v < vertexCount; v++) {
+						local[vertices[v]] = se::MeshOptimizer::InvalidIndex;
+					}
+					scratch.Rewind(chunkMarker);
+					result.push_back(std::move(part));
+				}
+				scratch.Rewind(marker);
+			}
+			subMeshes.swap(result);
+		}
+
+		// 加工結果をディスクキャッシュに書き込む(統計は付加情報として保存)
+		void StoreDiskCache(const SubMeshGeometry& subMesh)
+		{
+			se::GeometryCacheSubMesh cached;
+			cached.contentHash = subMesh.contentHash;
+			cached.attributes = subMesh.attributes;
+			cached.vertexCount = subMesh.vertexCount;
+			cached.indexCount = subMesh.GetIndexCount();
+			cached.indexStride = (subMesh.indexStride == se::INDEX_BUFFER_STRIDE_U16) ? sizeof(uint16_t) : sizeof(uint32_t);
+			cached.flags = (subMesh.interleaved ? CacheFlagInterleaved : 0) | (subMesh.quantized ? CacheFlagQuantized : 0);
+			cached.boundsMin[0] = subMesh.bounds.minPos.x;
+			cached.boundsMin[1] = subMesh.bounds.minPos.y;
+			cached.boundsMin[2] = subMesh.bounds.minPos.z;
+			cached.boundsMax[0] = subMesh.bounds.maxPos.x;
+			cached.boundsMax[1] = subMesh.bounds.maxPos.y;
+			cached.boundsMax[2] = subMesh.bounds.maxPos.z;
+			cached.indices = subMesh.GetIndexData();
+			cached.userData = &subMesh.stats;
+			cached.userDataSize = sizeof(GeometryStats);
+			cached.streams.resize(subMesh.streams.size());
+			for (size_t i = 0; i < subMesh.streams.size(); i++) {
+				const GeometryStream& stream = subMesh.streams[i];
+				se::GeometryCacheStream& cachedStream = cached.streams[i];
+				cachedStream.attribute = stream.attribute;
+				cachedStream.components = stream.components;
+				cachedStream.stride = stream.stride;
+				cachedStream.flags = (static_cast<uint32_t>(stream.usage) << 1) | (stream.unorderedAccess ? 1u : 0u);
+				cachedStream.data = stream.GetData();
+			}
+			se::GeometryDiskCache::Get().Store(subMesh.diskCacheKey, &cached, 1);
+		}
+	}
+
+
+	MeshGeometry::MeshGeometry()
+		: layoutHash_(0)
+		, deformOnly_(false)
+		, ready_(false)
+	{
+	}
+
+	void MeshGeometry::Process()
+	{
+		if (deformOnly_) {
+			ProcessDeformation();
+			return;
+		}
+
+		// 加工途中の一時バッファはジョブの間だけ借りるアリーナから取る
+		se::ScratchScope scope;
+		se::ScratchArena& scratch = scope.Get();
+
+		// ウェイトはMayaの頂点単位で1回だけ詰める
+		se::SkinInfluence* influences = nullptr;
+		uint32_t influenceCount = 0;
+		if (skin_) {
+			influenceCount = skin_->jointCount ? static_cast<uint32_t>(skin_->weights.size() / skin_->jointCount) : 0;
+			influences = scratch.Allocate<se::SkinInfluence>(influenceCount);
+			se::Skinning::PackInfluences(skin_->weights.data(), influenceCount, skin_->jointCount, influences);
+		}
+
+		SplitChunks(subMeshes_, scratch);
+
+		stats_ = GeometryStats();
+		for (auto& subMesh : subMeshes_) {
+			// ディスクキャッシュから復元したものは加工済み
+			if (subMesh.cacheFile) {
+				stats_.Add(subMesh.stats);
+				continue;
+			}
+
+			se::ScratchArena::Marker marker = scratch.GetMarker();
+			GeometryStats& stats = subMesh.stats;
+			stats = GeometryStats();
+			stats.chunks = subMesh.chunked ? 1 : 0;
+			for (auto& stream : subMesh.streams) {
+				if (stream.attribute == se::VERTEX_ATTR_FLAG_POSITION) {
+					subMesh.bounds = ComputeBounds(stream, subMesh.vertexCount);
+				} else if (stream.attribute & TexcoordFlags) {
+					FlipV(stream);
+				}
+				stats.floatVertexBytes += static_cast<uint64_t>(stream.stride) * subMesh.vertexCount;
+			}
+
+			// インデックスの加工(頂点の並べ替えは量子化より前に行う)
+			stats.wideIndexBytes += sizeof(uint32_t) * subMesh.indices.size();
+			stats.degenerateTriangles += RemoveDegenerateTriangles(subMesh.indices);
+			if (subMesh.optimizeVertexCache) {
+				OptimizeTopology(subMesh, scratch);
+			}
+			se::VertexCacheStats cacheStats = se::MeshOptimizer::AnalyzeVertexCache(subMesh.indices.data(), subMesh.indices.size(), subMesh.vertexCount);
+			uint64_t triangles = subMesh.indices.size() / 3;
+			stats.triangles += triangles;
+			stats.vertexCacheMisses += static_cast<uint64_t>(cacheStats.acmr * triangles + 0.5f);
+
+			if (skin_ && subMesh.sourceVertexIds.size() == subMesh.vertexCount) {
+				AssignSkinInfluences(subMesh, influences, influenceCount, *skin_);
+			}
+
+			// 量子化する前に誤差を計測(位置はfloatのまま)
+			if (subMesh.quantized) {
+				for (auto& stream : subMesh.streams) {
+					if (stream.attribute == se::VERTEX_ATTR_FLAG_POSITION) continue;
+					se::VertexAttribute attribute = GetAttribute(stream.attribute);
+					float error = se::VertexQuantizer::MeasureError(attribute, stream.data.data(), stream.components, subMesh.vertexCount);
+					stats.maxError[attribute] = (std::max)(stats.maxError[attribute], error);
+				}
+			}
+
+			if (subMesh.interleaved) {
+				Interleave(subMesh, scratch);
+			} else if (subMesh.quantized) {
+				Quantize(subMesh);
+			}
+			scratch.Rewind(marker);
+
+			for (auto& stream : subMesh.streams) {
+				stats.vertexBytes += static_cast<uint64_t>(stream.stride) * subMesh.vertexCount;
+			}
+			NarrowIndices(subMesh);
+			stats.indexBytes += (subMesh.indexStride == se::INDEX_BUFFER_STRIDE_U16)
+				? sizeof(uint16_t) * subMesh.shortIndices.size()
+				: sizeof(uint32_t) * subMesh.indices.size();
+			subMesh.contentHash = HashContent(subMesh);
+			stats_.Add(stats);
+
+			if (subMesh.diskCacheKey != 0) {
+				StoreDiskCache(subMesh);
+			}
+		}
+	}
+
+	void MeshGeometry::ProcessDeformation()
+	{
+		// 位置と法線のストリームのみ(頂点の並べ替えは前回の結果をそのまま使う)
+		se::ScratchScope scope;
+		se::ScratchArena& scratch = scope.Get();
+		for (auto& subMesh : subMeshes_) {
+			if (subMesh.topology) {
+				RemapVertices(subMesh, *subMesh.topology, scratch);
+			}
+			for (auto& stream : subMesh.streams) {
+				if (stream.attribute == se::VERTEX_ATTR_FLAG_POSITION) {
+					subMesh.bounds = ComputeBounds(stream, subMesh.vertexCount);
+				}
+			}
+			if (subMesh.quantized) {
+				Quantize(subMesh);
+			}
+		}
+	}
+
+	bool MeshGeometry::Restore(SubMeshGeometry& subMesh, const std::shared_ptr<const se::GeometryCacheFile>& file)
+	{
+		if (file->GetSubMeshes().size() != 1) return false;
+
+		// 抽出時の設定と一致するか
+		const se::GeometryCacheSubMesh& cached = file->GetSubMeshes()[0];
+		uint32_t flags = (subMesh.interleaved ? CacheFlagInterleaved : 0) | (subMesh.quantized ? CacheFlagQuantized : 0);
+		if (cached.attributes != subMesh.attributes || cached.flags != flags || cached.userDataSize != sizeof(GeometryStats)
+			|| (cached.indexStride != sizeof(uint16_t) && cached.indexStride != sizeof(uint32_t))) {
+			return false;
+		}
+
+		subMesh.streams.resize(cached.streams.size());
+		for (size_t i = 0; i < cached.streams.size(); i++) {
+			const se::GeometryCacheStream& source = cached.streams[i];
+			GeometryStream& stream = subMesh.streams[i];
+			stream.data.clear();
+			stream.mapped = source.data;
+			stream.attribute = source.attribute;
+			stream.components = source.components;
+			stream.stride = source.stride;
+			stream.usage = static_cast<se::BufferUsage>(source.flags >> 1);
+			stream.unorderedAccess = (source.flags & 1) != 0;
+		}
+		subMesh.vertexCount = cached.vertexCount;
+		subMesh.indices.clear();
+		subMesh.shortIndices.clear();
+		subMesh.indexStride = (cached.indexStride == sizeof(uint16_t)) ? se::INDEX_BUFFER_STRIDE_U16 : se::INDEX_BUFFER_STRIDE_U32;
+		subMesh.bounds = se::AABB(se::Vector3(cached.boundsMin[0], cached.boundsMin[1], cached.boundsMin[2]),
+			se::Vector3(cached.boundsMax[0], cached.boundsMax[1], cached.boundsMax[2]));
+		subMesh.contentHash = cached.contentHash;
+		memcpy(&subMesh.stats, cached.userData, sizeof(GeometryStats));
+		subMesh.cacheFile = file;
+		return true;
+	}
+
+	const void* SubMeshGeometry::GetIndexData() const
+	{
+		if (cacheFile) return cacheFile->GetSubMeshes()[0].indices;
+		return (indexStride == se::INDEX_BUFFER_STRIDE_U16) ? static_cast<const void*>(shortIndices.data()) : indices.data();
+	}
+
+	uint32_t SubMeshGeometry::GetIndexCount() const
+	{
+		if (cacheFile) return cacheFile->GetSubMeshes()[0].indexCount;
+		return static_cast<uint32_t>((indexStride == se::INDEX_BUFFER_STRIDE_U16) ? shortIndices.size() : indices.size());
+	}
+
+}
\ No newline at end of file
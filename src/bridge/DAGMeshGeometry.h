@@ -0,0 +1,182 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include "engine/Graphics/GPUBuffer.h"
+#include "engine/Math/Bounds.h"
+#include "engine/Graphics/GeometryCacheFile.h"
+#include "engine/Graphics/Skinning.h"
+#include "engine/Graphics/MeshClusterizer.h"
+#include <vector>
+#include <atomic>
+#include <memory>
+
+namespace bridge {
+	class DAGMaterial;
+
+	/**
+	 * 抽出した頂点ストリーム
+	 */
+	struct GeometryStream
+	{
+		std::vector<float> data;		// 量子化後は4バイト単位のバイト列として扱う
+		const void* mapped;				// ディスクキャッシュから復元した場合のマップ領域(dataは空)
+		uint32_t attribute;				// se::VertexAttributeFlags(インターリーブ後は複数属性)
+		uint32_t components;			// 1頂点あたりの要素数
+		uint32_t stride;				// 1頂点あたりのバイト数
+		se::BufferUsage usage;
+		bool unorderedAccess;
+
+		const void* GetData() const { return mapped ? mapped : data.data(); }
+	};
+
+	/**
+	 * インデックス最適化の結果(トポロジが変わらなければ再利用する)
+	 */
+	struct OptimizedTopology
+	{
+		uint64_t hash;					// 最適化前のトポロジのハッシュ値
+		bool overdraw;					// オーバードローの最適化を行ったか
+		uint32_t vertexCount;			// 最適化後の頂点数
+		std::vector<uint32_t> indices;	// 最適化後のインデックス
+		std::vector<uint32_t> remap;	// remap[元の頂点] = 新しい頂点
+	};
+
+	/**
+	 * ジオメトリのメモリ使用量と量子化誤差
+	 */
+	struct GeometryStats
+	{
+		uint64_t vertexBytes;						// 頂点バッファの合計
+		uint64_t floatVertexBytes;					// 全属性をfloatで持った場合の頂点バッファの合計
+		uint64_t indexBytes;						// インデックスバッファの合計
+		uint64_t wideIndexBytes;					// 縮退ポリゴンを含め全て32bitで持った場合のインデックスバッファの合計
+		uint32_t degenerateTriangles;				// 取り除いた縮退ポリゴン数
+		uint64_t triangles;							// 描画する三角形数
+		uint64_t vertexCacheMisses;					// 頂点キャッシュのミス数の見積もり(se::MeshOptimizer::AnalyzeVertexCache())
+		uint32_t chunks;							// 分割したチャンク数(se::MeshClusterizer)
+		float maxError[se::VERTEX_ATTR_NUM];		// 属性毎の量子化の最大誤差(se::VertexQuantizer::MeasureError())
+
+		GeometryStats()
+			: vertexBytes(0)
+			, floatVertexBytes(0)
+			, indexBytes(0)
+			, wideIndexBytes(0)
+			, degenerateTriangles(0)
+			, triangles(0)
+			, vertexCacheMisses(0)
+			, chunks(0)
+			, maxError()
+		{
+		}
+
+		void Add(const GeometryStats& other)
+		{
+			vertexBytes += other.vertexBytes;
+			floatVertexBytes += other.floatVertexBytes;
+			indexBytes += other.indexBytes;
+			wideIndexBytes += other.wideIndexBytes;
+			degenerateTriangles += other.degenerateTriangles;
+			triangles += other.triangles;
+			vertexCacheMisses += other.vertexCacheMisses;
+			chunks += other.chunks;
+			for (uint32_t i = 0; i < se::VERTEX_ATTR_NUM; i++) {
+				maxError[i] = (maxError[i] > other.maxError[i]) ? maxError[i] : other.maxError[i];
+			}
+		}
+
+		float GetACMR() const { return (triangles > 0) ? static_cast<float>(vertexCacheMisses) / triangles : 0.0f; }
+	};
+
+	/**
+	 * GPUスキニングの抽出元(抽出時にメインスレッドで取得する)
+	 */
+	struct SkinSource
+	{
+		uint32_t jointCount;
+		std::vector<double> weights;		// Mayaの頂点 x ジョイントのウェイト
+		std::vector<float> bindMatrices;	// ジョイント毎のバインド行列(se::Skinning::BuildBindMatrices())
+	};
+
+	/**
+	 * シェーダ(マテリアル)単位のジオメトリ
+	 */
+	struct SubMeshGeometry
+	{
+		DAGMaterial* material;
+		uint32_t attributes;			// シェーダが要求する頂点属性
+		uint32_t vertexCount;
+		uint32_t sourceVertexCount;		// 抽出時の頂点数(変形のみの更新で抽出結果と照合する。0: 不明)
+		bool interleaved;				// Process()で属性を1本のストリームに詰める
+		bool quantized;					// Process()で属性をse::VertexQuantizerの形式に変換する
+		bool optimizeVertexCache;		// Process()で三角形と頂点を並べ替える
+		bool optimizeOverdraw;			// optimizeVertexCacheの並べ替えでオーバードローも考慮する
+		bool chunked;					// Process()で空間的に近い三角形のチャンクに分割する(分割後は各チャンク)
+		se::NormalCone cone;			// Process()で算出するチャンクの法線コーン(分割しない場合は判定しないコーン)
+		std::shared_ptr<const OptimizedTopology> topology;		// 前回の最適化結果(Process()で更新)
+		std::vector<uint32_t> indices;
+		std::vector<uint16_t> shortIndices;		// Process()で16bitに収まる場合はこちらに移す
+		se::IndexBufferStride indexStride;		// Process()で決定
+		std::vector<GeometryStream> streams;
+		se::AABB bounds;				// ローカル空間のバウンディング
+		uint64_t contentHash;			// Process()で算出するGPUリソースの内容のハッシュ値(DAGGeometryCacheのキー)
+		GeometryStats stats;			// Process()で算出
+		uint64_t diskCacheKey;			// 抽出元の内容のハッシュ値(0: ディスクキャッシュを使わない)
+		std::shared_ptr<const se::GeometryCacheFile> cacheFile;		// ディスクキャッシュから復元した場合のファイル(Process()は加工しない)
+		std::vector<uint32_t> sourceVertexIds;					// 頂点毎のMayaの頂点番号(GPUスキニング時のみ)
+		std::vector<se::SkinInfluence> skinInfluences;			// Process()で詰めた頂点毎のインフルエンス
+		std::vector<float> jointBounds;							// Process()で算出するジョイント毎のバウンディング(se::Skinning::ComputeJointBounds())
+
+		const void* GetIndexData() const;
+		uint32_t GetIndexCount() const;
+	};
+
+	/**
+	 * メッシュから抽出したCPU側のジオメトリ
+	 * Mayaからの抽出はメインスレッド、Process()はワーカースレッド、GPUリソースの生成はメインスレッドで行う
+	 * Maya APIには依存しない
+	 */
+	class MeshGeometry
+	{
+	private:
+		std::vector<SubMeshGeometry> subMeshes_;
+		GeometryStats stats_;
+		uint64_t layoutHash_;			// 抽出元のトポロジ、UV等の変形しない属性、設定のハッシュ値
+		std::shared_ptr<const SkinSource> skin_;		// GPUスキニングする場合のウェイトとバインド行列
+		bool deformOnly_;				// 位置と法線のみ(インデックスと他の属性は現在のものを使い続ける)
+		std::atomic<bool> ready_;		// Process()完了
+
+	private:
+		void ProcessDeformation();
+
+	public:
+		MeshGeometry();
+
+		std::vector<SubMeshGeometry>& GetSubMeshes() { return subMeshes_; }
+		const std::vector<SubMeshGeometry>& GetSubMeshes() const { return subMeshes_; }
+		const GeometryStats& GetStats() const { return stats_; }
+		uint64_t GetLayoutHash() const { return layoutHash_; }
+		void SetLayoutHash(uint64_t hash) { layoutHash_ = hash; }
+		bool IsDeformOnly() const { return deformOnly_; }
+		void SetDeformOnly(bool deformOnly) { deformOnly_ = deformOnly; }
+		const std::shared_ptr<const SkinSource>& GetSkin() const { return skin_; }
+		void SetSkin(const std::shared_ptr<const SkinSource>& skin) { skin_ = skin; }
+
+		// 抽出後の加工(UVのV反転、バウンディング計算、インデックスの縮退除去と最適化、量子化、インターリーブ、インデックスの16bit化、内容のハッシュ値)
+		// diskCacheKeyが設定されていれば加工結果をディスクキャッシュに書き込む
+		// GPUスキニングする場合はウェイトを詰めて頂点毎のインフルエンスとジョイント毎のバウンディングを求める
+		// chunkedのサブメッシュはまずチャンク毎のサブメッシュに分割し、以降の加工はチャンク単位で行う
+		// 変形のみの場合は前回の並べ替えを適用し、バウンディング計算と法線の量子化のみ行う
+		void Process();
+
+		// ディスクキャッシュから加工済みのサブメッシュを復元(抽出時と設定が一致しなければ失敗)
+		static bool Restore(SubMeshGeometry& subMesh, const std::shared_ptr<const se::GeometryCacheFile>& file);
+
+		void MarkReady() { ready_.store(true, std::memory_order_release); }
+		bool IsReady() const { return ready_.load(std::memory_order_acquire); }
+	};
+
+}
@@ -4,6 +4,7 @@
 //
 
 #include <bridge/DAGNode.h>
+#include <bridge/DAGManager.h>
 
 namespace bridge {
 
@@ -11,6 +12,8 @@ namespace bridge {
 		: attrChangeCallBackId_(0)
 		, nodeDirtyPlugCallBackId_(0)
 		, isIsolateSelected_(false)
+		, updateQueueIndex_(-1)
+		, poolIndex_(0)
 	{
 		handle_ = object;
 
@@ -31,9 +34,12 @@ namespace bridge {
 
 	DAGNode::~DAGNode()
 	{
-		MStatus status = MMessage::removeCallback(attrChangeCallBackId_);
-		if (status != MStatus::kSuccess){
-			MDisplayError("[MayaCustomViewport] / Failed MMessage::removeCallback.\n");
+		// CollectCallbacksで回収済みの場合は解除不要
+		if (attrChangeCallBackId_) {
+			MStatus status = MMessage::removeCallback(attrChangeCallBackId_);
+			if (status != MStatus::kSuccess){
+				MDisplayError("[MayaCustomViewport] / Failed MMessage::removeCallback.\n");
+			}
 		}
 
 		if (nodeDirtyPlugCallBackId_) {
@@ -48,6 +54,19 @@ namespace bridge {
 	}
 
 
+	void DAGNode::CollectCallbacks(MCallbackIdArray& callbacks)
+	{
+		if (attrChangeCallBackId_) {
+			callbacks.append(attrChangeCallBackId_);
+			attrChangeCallBackId_ = 0;
+		}
+		if (nodeDirtyPlugCallBackId_) {
+			callbacks.append(nodeDirtyPlugCallBackId_);
+			nodeDirtyPlugCallBackId_ = 0;
+		}
+	}
+
+
 	void DAGNode::AttributeChangeCallcack(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* obj)
 	{
 		auto* node = static_cast<DAGNode*>(obj);
@@ -88,6 +107,24 @@ namespace bridge {
 		}
 	}
 
+	void DAGNode::RemoveConnection(const DAGNode* node)
+	{
+		connections_.remove_if([node](const DAGConnection& c) { return c.node() == node; });
+	}
+
+
+	/**
+	 * 破棄前に接続先から自身への参照を外す
+	 * 一括削除では全ノードの参照を外してから破棄するので、破棄済みのノードには触れない
+	 */
+	void DAGNode::UnlinkAll()
+	{
+		for (auto& c : connections_) {
+			c.node()->RemoveConnection(this);
+		}
+		connections_.clear();
+	}
+
 	DAGNode* DAGNode::FindConnectedItem(MObject obj)
 	{
 		auto iter = connections_.begin();
@@ -107,4 +144,16 @@ namespace bridge {
 		}
 	}
 
+
+	/**
+	 * 次フレームの更新を要求する
+	 * 更新キューへの登録は1フレームにつき1回のみ
+	 */
+	void DAGNode::RequestUpdate()
+	{
+		// DAGManager生成中に生成されたノードはDAGManager側で登録する
+		DAGManager* mgr = DAGManager::Get();
+		if (mgr) mgr->EnqueueUpdate(this);
+	}
+
 }
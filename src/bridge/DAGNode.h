@@ -21,6 +21,7 @@ namespace bridge {
 		Light,
 		Settings,
 	};
+	const int32_t DAGTypeNum = static_cast<int32_t>(DAGType::Settings) + 1;
 
 
 	/**
@@ -50,12 +51,17 @@ namespace bridge {
 	 */
 	class DAGNode
 	{
+		friend class DAGManager;
+		friend class DAGNodePool;
+
 	protected:
 		MObjectHandle handle_;
 		MCallbackId attrChangeCallBackId_;
 		MCallbackId nodeDirtyPlugCallBackId_;
 		std::list<DAGConnection> connections_;
 		bool isIsolateSelected_;
+		int32_t updateQueueIndex_;		// 更新キュー内の位置(-1: 未登録)
+		uint32_t poolIndex_;			// DAGNodePool内の位置
 
 	protected:
 		static void AttributeChangeCallcack(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void*);
@@ -79,15 +85,21 @@ namespace bridge {
 
 		virtual DAGType Type() const = 0;
 		virtual void Update() {}
-		virtual void Draw(se::GraphicsContext& context, ShadingPath path) {}
+		virtual void Draw(se::GraphicsContext& context, se::RenderQueue& queue, ShadingPath path) {}	// 描画パケットをキューに登録
+		virtual void Cull(const se::Frustum& frustum) {}						// 描画前の視錐台カリング
 		virtual void LinkParent(const DAGNode* parent) {}						// 親トランスフォーム接続用
 		virtual void UnlinkParent(const DAGNode* parent) {}						// 親トランスフォーム接続解除用
 		virtual void NotifyParentTransformUpdated(const DAGNode* parent) {}		// 親トランスフォーム更新通知
 		virtual void NotifyUpdateConnection(const DAGNode* node) {}
+		virtual void CollectCallbacks(MCallbackIdArray& callbacks);				// 一括解除用にコールバックを回収
+		virtual void UnlinkAll();												// 一括削除用に親子、接続の参照をすべて外す
 
 		void Connect(DAGNode* node);
 		void Disconnect(DAGNode* node);
+		void RemoveConnection(const DAGNode* node);		// 参照数によらず外す
 		void NotifyUpdateConnectionAll();
+		void RequestUpdate();
+		bool IsUpdateRequested() const { return updateQueueIndex_ >= 0; }
 		DAGNode* FindConnectedItem(MObject obj);
 		void SetIsolateSelected(bool selected) { isIsolateSelected_ = selected; }
 		bool IsIsolateSelected() const { return isIsolateSelected_; }
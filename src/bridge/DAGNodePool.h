@@ -0,0 +1,151 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include "Common.h"
+#include "DAGNode.h"
+#include <type_traits>
+
+namespace bridge {
+
+	/**
+	 * DAGノードプール
+	 * 走査用のノード配列を密に保ち、削除は末尾との入れ替えでO(1)で行う
+	 */
+	class DAGNodePool
+	{
+	public:
+		typedef std::vector<DAGNode*>::const_iterator const_iterator;
+		static const uint32_t DetachedIndex = 0xffffffff;	// Detach済み(破棄待ち)
+
+	protected:
+		std::vector<DAGNode*> nodes_;
+
+	protected:
+		void Register(DAGNode* node)
+		{
+			node->poolIndex_ = static_cast<uint32_t>(nodes_.size());
+			nodes_.push_back(node);
+		}
+
+		void Unregister(DAGNode* node)
+		{
+			uint32_t index = node->poolIndex_;
+			Assert(index < nodes_.size() && nodes_[index] == node);
+
+			// 末尾のノードを削除位置へ移動
+			DAGNode* last = nodes_.back();
+			nodes_[index] = last;
+			last->poolIndex_ = index;
+			nodes_.pop_back();
+			node->poolIndex_ = DetachedIndex;
+		}
+
+	public:
+		DAGNodePool() {}
+		virtual ~DAGNodePool() {}
+
+		virtual void Free(DAGNode* node) = 0;		// Detach済みのノードを破棄
+		virtual void Clear() = 0;
+		virtual void Trim() = 0;					// 空の場合は確保領域ごと解放
+
+		void Detach(DAGNode* node) { Unregister(node); }
+		void Destroy(DAGNode* node)
+		{
+			Unregister(node);
+			Free(node);
+		}
+
+		static bool IsDetached(const DAGNode* node) { return node->poolIndex_ == DetachedIndex; }
+
+		uint32_t Count() const { return static_cast<uint32_t>(nodes_.size()); }
+		DAGNode* At(uint32_t index) const { return nodes_[index]; }
+		const_iterator begin() const { return nodes_.begin(); }
+		const_iterator end() const { return nodes_.end(); }
+	};
+
+
+	/**
+	 * タイプ別DAGノードプール
+	 * ノード本体はチャンク単位で確保した連続領域に配置する
+	 * チャンクは移動しないためノードのポインタは削除まで不変(ハンドルとして使用できる)
+	 */
+	template <class T, uint32_t ChunkSize = 256>
+	class TDAGNodePool : public DAGNodePool
+	{
+	private:
+		typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+	private:
+		std::vector<std::unique_ptr<Storage[]>> chunks_;
+		std::vector<Storage*> freeList_;
+		uint32_t chunkUsed_;		// 最終チャンクの使用数
+
+	private:
+		Storage* Allocate()
+		{
+			// 解放済み領域を優先して再利用
+			if (!freeList_.empty()) {
+				Storage* slot = freeList_.back();
+				freeList_.pop_back();
+				return slot;
+			}
+			if (chunks_.empty() || chunkUsed_ == ChunkSize) {
+				chunks_.emplace_back(new Storage[ChunkSize]);
+				chunkUsed_ = 0;
+			}
+			return &chunks_.back()[chunkUsed_++];
+		}
+
+	public:
+		TDAGNodePool()
+			: chunkUsed_(0)
+		{
+		}
+
+		virtual ~TDAGNodePool()
+		{
+			Clear();
+		}
+
+		template <class... Args>
+		T* Create(Args&&... args)
+		{
+			Storage* slot = Allocate();
+			T* node = new (slot) T(std::forward<Args>(args)...);
+			Register(node);
+			return node;
+		}
+
+		virtual void Free(DAGNode* node) override
+		{
+			T* object = static_cast<T*>(node);
+			object->~T();
+			freeList_.push_back(reinterpret_cast<Storage*>(object));
+		}
+
+		virtual void Clear() override
+		{
+			for (DAGNode* node : nodes_) {
+				static_cast<T*>(node)->~T();
+			}
+			nodes_.clear();
+			freeList_.clear();
+			chunks_.clear();
+			chunkUsed_ = 0;
+		}
+
+		virtual void Trim() override
+		{
+			// チャンク内にDetach済みで未破棄のノードが残っていないこと
+			if (!nodes_.empty()) return;
+			freeList_.clear();
+			chunks_.clear();
+			chunkUsed_ = 0;
+		}
+	};
+
+}
@@ -4,6 +4,8 @@
 //
 
 #include "bridge/DAGSettings.h"
+#include "bridge/DAGManager.h"
+#include "engine/Graphics/GeometryDiskCache.h"
 
 namespace bridge {
 
@@ -11,6 +13,13 @@ namespace bridge {
 		: DAGNode(object)
 		, initialized_(false)
 		, fxaaEnable_(true)
+		, interleavedVertex_(false)
+		, quantizedVertex_(false)
+		, optimizeVertexCache_(false)
+		, optimizeOverdraw_(false)
+		, diskCache_(true)
+		, gpuSkinning_(false)
+		, chunkedMesh_(false)
 	{
 	}
 
@@ -58,6 +67,52 @@ namespace bridge {
 		// ショートネームからパラメータを取得
 		if (sn == "fae") {
 			fxaaEnable_ = plug.asBool();
+		} else if (sn == "ilv") {
+			// 頂点フォーマットが変わるので全メッシュを作り直す
+			bool interleaved = plug.asBool();
+			if (interleaved != interleavedVertex_) {
+				interleavedVertex_ = interleaved;
+				DAGManager::Get()->InvalidateGeometry();
+			}
+		} else if (sn == "qvx") {
+			bool quantized = plug.asBool();
+			if (quantized != quantizedVertex_) {
+				quantizedVertex_ = quantized;
+				DAGManager::Get()->InvalidateGeometry();
+			}
+		} else if (sn == "ovc") {
+			bool optimize = plug.asBool();
+			if (optimize != optimizeVertexCache_) {
+				optimizeVertexCache_ = optimize;
+				DAGManager::Get()->InvalidateGeometry();
+			}
+		} else if (sn == "ood") {
+			bool optimize = plug.asBool();
+			if (optimize != optimizeOverdraw_) {
+				optimizeOverdraw_ = optimize;
+				DAGManager::Get()->InvalidateGeometry();
+			}
+		} else if (sn == "dkc") {
+			// 次に開いたメッシュから有効
+			diskCache_ = plug.asBool();
+		} else if (sn == "dcs") {
+			// MB単位
+			int32_t size = plug.asInt();
+			se::GeometryDiskCache::Get().SetCapacity((size > 0) ? static_cast<uint64_t>(size) << 20 : 0);
+		} else if (sn == "gsk") {
+			// スキンクラスタで変形するメッシュをバインドポーズから抽出し直す
+			bool skinning = plug.asBool();
+			if (skinning != gpuSkinning_) {
+				gpuSkinning_ = skinning;
+				DAGManager::Get()->InvalidateGeometry();
+			}
+		} else if (sn == "cmk") {
+			// 巨大なメッシュをカリング単位のチャンクに分割し直す
+			bool chunked = plug.asBool();
+			if (chunked != chunkedMesh_) {
+				chunkedMesh_ = chunked;
+				DAGManager::Get()->InvalidateGeometry();
+			}
 		}
 	}
 
@@ -18,6 +18,13 @@ namespace bridge {
 	protected:
 		bool initialized_;
 		bool fxaaEnable_;
+		bool interleavedVertex_;
+		bool quantizedVertex_;
+		bool optimizeVertexCache_;
+		bool optimizeOverdraw_;
+		bool diskCache_;
+		bool gpuSkinning_;
+		bool chunkedMesh_;
 
 	protected:
 		virtual void AttributeChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug) override;
@@ -33,6 +40,13 @@ namespace bridge {
 		virtual DAGType Type() const override { return DAGType::Settings; }
 
 		bool IsEnableFXAA() const { return fxaaEnable_; }
+		bool IsInterleavedVertex() const { return interleavedVertex_; }
+		bool IsQuantizedVertex() const { return quantizedVertex_; }
+		bool IsOptimizeVertexCache() const { return optimizeVertexCache_; }
+		bool IsOptimizeOverdraw() const { return optimizeOverdraw_; }
+		bool IsDiskCacheEnabled() const { return diskCache_; }
+		bool IsGpuSkinningEnabled() const { return gpuSkinning_; }
+		bool IsChunkedMesh() const { return chunkedMesh_; }
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "bridge/DAGSkinBinding.h"
+#include "engine/Graphics/Skinning.h"
+#include "Utility.h"
+
+namespace bridge {
+
+	namespace {
+		// 行列型のプラグの値を取得
+		bool GetMatrixByPlug(const MPlug& plug, Matrix44* out)
+		{
+			MStatus status;
+			MObject data = plug.asMObject(MDGContext::fsNormal, &status);
+			if (!status || data.isNull()) return false;
+			MFnMatrixData fnData(data, &status);
+			if (!status) return false;
+			CopyMatrix(out, fnData.matrix());
+			return true;
+		}
+	}
+
+	std::shared_ptr<DAGSkinBinding> DAGSkinBinding::Find(const MDagPath& meshPath)
+	{
+		MStatus status;
+		MFnDependencyNode fnMesh(meshPath.node());
+		MPlug inMesh = fnMesh.findPlug("inMesh", &status);
+		if (!status) return nullptr;
+
+		// inMeshの接続元がスキンクラスタであること
+		MPlugArray sources;
+		if (!inMesh.connectedTo(sources, true, false) || sources.length() == 0) return nullptr;
+		MObject skinCluster = sources[0].node();
+		if (!skinCluster.hasFn(MFn::kSkinClusterFilter)) return nullptr;
+
+		MFnSkinCluster fnSkin(skinCluster, &status);
+		if (!status) return nullptr;
+		uint32_t geometryIndex = fnSkin.indexForOutputShape(meshPath.node(), &status);
+		if (!status) return nullptr;
+
+		auto binding = std::make_shared<DAGSkinBinding>();
+		binding->skinCluster_ = MObjectHandle(skinCluster);
+		binding->outputPath_ = meshPath;
+
+		// 入力を上流にたどって最初に見つかったメッシュをバインドポーズの形状とする(tweakの移動量は反映しない)
+		MPlug input = fnSkin.findPlug("input", &status).elementByLogicalIndex(geometryIndex, &status);
+		if (!status) return nullptr;
+		MPlug inputGeometry = input.child(0, &status);
+		if (!status) return nullptr;
+		MItDependencyGraph it(inputGeometry, MFn::kMesh, MItDependencyGraph::kUpstream,
+			MItDependencyGraph::kDepthFirst, MItDependencyGraph::kNodeLevel, &status);
+		if (!status || it.isDone()) return nullptr;
+		if (!MDagPath::getAPathTo(it.currentItem(), binding->inputPath_)) return nullptr;
+
+		// ジョイント(インフルエンス)とバインド行列
+		MDagPathArray influences;
+		uint32_t jointCount = fnSkin.influenceObjects(influences, &status);
+		if (!status || jointCount == 0 || jointCount > 0x10000) return nullptr;
+
+		Matrix44 geometry;
+		if (!GetMatrixByPlug(fnSkin.findPlug("geomMatrix"), &geometry)) {
+			geometry = Matrix44(XMMatrixIdentity());
+		}
+		MPlug bindPreMatrix = fnSkin.findPlug("bindPreMatrix");
+		std::vector<Matrix44> bindPre(jointCount);
+		binding->logicalIndices_.resize(jointCount);
+		for (uint32_t j = 0; j < jointCount; j++) {
+			uint32_t index = fnSkin.indexForInfluenceObject(influences[j], &status);
+			if (!status) return nullptr;
+			binding->logicalIndices_[j] = index;
+			if (!GetMatrixByPlug(bindPreMatrix.elementByLogicalIndex(index), &bindPre[j])) {
+				// 未設定ならバインド時のジョイントの逆行列
+				MMatrix inverse = influences[j].inclusiveMatrixInverse();
+				CopyMatrix(&bindPre[j], inverse);
+			}
+		}
+		binding->bindMatrices_.resize(jointCount);
+		se::Skinning::BuildBindMatrices(&geometry.m[0][0], &bindPre[0].m[0][0], jointCount, &binding->bindMatrices_[0].m[0][0]);
+
+		binding->jointMatrices_.resize(jointCount);
+		if (!binding->UpdateJointMatrices()) return nullptr;
+		return binding;
+	}
+
+	bool DAGSkinBinding::GetWeights(std::vector<double>* weights) const
+	{
+		if (!IsValid()) return false;
+
+		MStatus status;
+		MFnSkinCluster fnSkin(skinCluster_.object(), &status);
+		if (!status) return false;
+		MFnMesh fnMesh(outputPath_, &status);
+		if (!status) return false;
+
+		// 全頂点のウェイトをまとめて取得
+		MFnSingleIndexedComponent fnComponent;
+		MObject components = fnComponent.create(MFn::kMeshVertComponent, &status);
+		if (!status) return false;
+		fnComponent.setCompleteData(fnMesh.numVertices());
+
+		MDoubleArray values;
+		uint32_t influenceCount = 0;
+		status = fnSkin.getWeights(outputPath_, components, values, influenceCount);
+		if (!status || influenceCount != GetJointCount()) return false;
+
+		weights->resize(values.length());
+		if (values.length() > 0) {
+			values.get(weights->data());
+		}
+		return true;
+	}
+
+	bool DAGSkinBinding::UpdateJointMatrices()
+	{
+		if (!IsValid()) return false;
+
+		MStatus status;
+		MFnDependencyNode fnSkin(skinCluster_.object(), &status);
+		if (!status) return false;
+
+		// スキンクラスタが実際に使うmatrixの入力を読む
+		MPlug matrix = fnSkin.findPlug("matrix", &status);
+		if (!status) return false;
+		for (uint32_t j = 0; j < GetJointCount(); j++) {
+			if (!GetMatrixByPlug(matrix.elementByLogicalIndex(logicalIndices_[j]), &jointMatrices_[j])) {
+				jointMatrices_[j] = Matrix44(XMMatrixIdentity());
+			}
+		}
+		return true;
+	}
+
+}
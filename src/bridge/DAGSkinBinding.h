@@ -0,0 +1,44 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include "Common.h"
+#include <vector>
+
+namespace bridge {
+
+	/**
+	 * メッシュを変形するスキンクラスタ(GPUスキニング用)
+	 * バインドポーズの形状、ジョイント、ウェイトは抽出時に取得し、毎フレームはジョイントの行列のみ読む
+	 * スキンクラスタの出力が直接inMeshに接続されている場合のみ対応する(後段のデフォーマがある場合はCPUで変形する)
+	 */
+	class DAGSkinBinding
+	{
+	private:
+		MObjectHandle skinCluster_;
+		MDagPath outputPath_;						// 変形後のメッシュ
+		MDagPath inputPath_;						// バインドポーズの形状(スキンクラスタに入力される中間オブジェクト)
+		std::vector<uint32_t> logicalIndices_;		// ジョイント毎のmatrix、bindPreMatrixの論理インデックス
+		std::vector<Matrix44> bindMatrices_;		// geomMatrix * bindPreMatrix(ジョイント毎)
+		std::vector<Matrix44> jointMatrices_;		// 現在のジョイントのワールド行列
+
+	public:
+		// meshPathを変形するスキンクラスタを探す(GPUスキニングできない構成ならnullptr)
+		static std::shared_ptr<DAGSkinBinding> Find(const MDagPath& meshPath);
+
+		bool IsValid() const { return skinCluster_.isValid(); }
+		const MDagPath& GetInputPath() const { return inputPath_; }
+		uint32_t GetJointCount() const { return static_cast<uint32_t>(logicalIndices_.size()); }
+		const float* GetBindMatrices() const { return &bindMatrices_[0].m[0][0]; }
+		const float* GetJointMatrices() const { return &jointMatrices_[0].m[0][0]; }
+
+		// Mayaの頂点 x ジョイントのウェイトを取得
+		bool GetWeights(std::vector<double>* weights) const;
+		// ジョイントの現在の行列を読み直す
+		bool UpdateJointMatrices();
+	};
+
+}
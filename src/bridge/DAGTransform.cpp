@@ -16,24 +16,29 @@ namespace bridge {
 		, position_(0, 0, 0)
 		, rotate_(0, 0, 0)
 		, scale_(1, 1, 1)
-		, visibility_(true)
+		, hierarchyIndex_(DAGHierarchyCache::InvalidIndex)
+		, inheritsTransform_(true)
+		, isLayerMember_(false)
+		, isVisibilityDriven_(false)
 		, updated_(true)
 		, initialized_(false)
 		, parent_(nullptr)
 		, dagAddedChildCallback_(0)
 		, dagRemovedChildCallback_(0)
 	{
-		MDagPath path;
-		MFnDagNode(object).getPath(path);
+		MFnDagNode dagFn(object);
+		dagFn.getPath(path_);
+		inheritsTransform_ = dagFn.findPlug("inheritsTransform").asBool();
+		hierarchyIndex_ = DAGManager::Get()->GetHierarchyCache().Add(this);
 
 		// DAG監視用のコールバックを登録
-		dagAddedChildCallback_ = MDagMessage::addChildAddedDagPathCallback(path, [](MDagPath& child, MDagPath& parent, void* clientData) {
+		dagAddedChildCallback_ = MDagMessage::addChildAddedDagPathCallback(path_, [](MDagPath& child, MDagPath& parent, void* clientData) {
 			DAGTransform* own = reinterpret_cast<DAGTransform*>(clientData);
 			DAGNode* node = DAGManager::Get()->FindDAGNode(child.node());
 			if (node) own->AddChild(node);
 		}, this);
 
-		dagRemovedChildCallback_ = MDagMessage::addChildRemovedDagPathCallback(path, [](MDagPath& child, MDagPath& parent, void* clientData) {
+		dagRemovedChildCallback_ = MDagMessage::addChildRemovedDagPathCallback(path_, [](MDagPath& child, MDagPath& parent, void* clientData) {
 			DAGTransform* own = reinterpret_cast<DAGTransform*>(clientData);
 			DAGNode* node = DAGManager::Get()->FindDAGNode(child.node());
 			if (node) own->RemoveChild(node);
@@ -43,17 +48,70 @@ namespace bridge {
 
 	DAGTransform::~DAGTransform()
 	{
-		MDagMessage::removeCallback(dagAddedChildCallback_);
-		MDagMessage::removeCallback(dagRemovedChildCallback_);
+		if (dagAddedChildCallback_) MDagMessage::removeCallback(dagAddedChildCallback_);
+		if (dagRemovedChildCallback_) MDagMessage::removeCallback(dagRemovedChildCallback_);
+		DAGManager::Get()->GetHierarchyCache().Remove(hierarchyIndex_);
+	}
+
+
+	void DAGTransform::CollectCallbacks(MCallbackIdArray& callbacks)
+	{
+		DAGNode::CollectCallbacks(callbacks);
+		if (dagAddedChildCallback_) {
+			callbacks.append(dagAddedChildCallback_);
+			dagAddedChildCallback_ = 0;
+		}
+		if (dagRemovedChildCallback_) {
+			callbacks.append(dagRemovedChildCallback_);
+			dagRemovedChildCallback_ = 0;
+		}
+	}
+
+
+	void DAGTransform::UnlinkAll()
+	{
+		DAGNode::UnlinkAll();
+		if (parent_) {
+			const_cast<DAGTransform*>(parent_)->RemoveChild(this);
+		}
+		std::vector<DAGNode*> childs;
+		childs.swap(childs_);
+		DAGManager::Get()->InvalidateTransformHierarchy();
+		for (auto* node : childs) {
+			node->UnlinkParent(this);
+		}
 	}
 
 
 	void DAGTransform::AttributeChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug)
 	{
 		MStatus s;
-		if (msg & MNodeMessage::kAttributeSet) {
+		if (msg & (MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken)) {
+			// レイヤーへの所属、visibilityへの接続を監視
+			// 接続元の値の変化はAttributeChangedに来ないため、DAGManagerからのレイヤー、タイムの変更時に再取得する
+			MFnAttribute fnAttr(plug.attribute());
+			MString sn = fnAttr.shortName();
+			bool connected = (msg & MNodeMessage::kConnectionMade) != 0;
+			if (sn == "do") {
+				isLayerMember_ = connected;
+				ReadLayerVisibility();
+			} else if (sn == "v") {
+				isVisibilityDriven_ = connected;
+				ReadLocalVisibility();
+			}
+		} else if (msg & MNodeMessage::kAttributeSet) {
 			MFnAttribute fnAttr(plug.attribute());
 			MString sn = fnAttr.shortName();
+
+			// 可視性はキャッシュのみ更新(トランスフォームの再計算は不要)
+			if (sn == "v" || sn == "lodv") {
+				ReadLocalVisibility();
+				return;
+			} else if (sn == "ove" || sn == "ovv") {
+				ReadLayerVisibility();
+				return;
+			}
+
 			if (sn == "t") {
 				GetVectorByPlug(position_.ToFloatArray(), plug);
 			} else if (sn == "r") {
@@ -78,12 +136,10 @@ namespace bridge {
 				scale_.y = plug.asFloat();
 			} else if (sn == "sz") {
 				scale_.z = plug.asFloat();
-			} 
-#if 0
-			else if (sn == "v") {
-				visibility_ = plug.asBool();
+			} else if (sn == "it") {
+				inheritsTransform_ = plug.asBool();
+				DAGManager::Get()->InvalidateTransformHierarchy();
 			}
-#endif
 			Updated();
 		}
 	}
@@ -91,54 +147,102 @@ namespace bridge {
 	void DAGTransform::Updated()
 	{
 		updated_ = true;
+		RequestUpdate();
 		for (auto* node : childs_) {
 			node->NotifyParentTransformUpdated(this);
 		}
 	}
 
-	void DAGTransform::Update()
+	void DAGTransform::UpdateDagPath()
+	{
+		// 親の変更でパスが変わるため取り直す
+		MFnDagNode(handle_.objectRef()).getPath(path_);
+	}
+
+	void DAGTransform::ReadLocalVisibility()
 	{
 		MFnDagNode dagFn(handle_.objectRef());
+		bool visible = dagFn.findPlug("visibility").asBool() && dagFn.findPlug("lodVisibility").asBool();
+		DAGManager::Get()->GetHierarchyCache().SetLocalVisibility(hierarchyIndex_, visible);
+	}
+
+	void DAGTransform::ReadLayerVisibility()
+	{
+		// レイヤーの表示状態はdrawOverrideを通してoverrideEnabled, overrideVisibilityに反映される
+		MFnDagNode dagFn(handle_.objectRef());
+		bool enabled = dagFn.findPlug("overrideEnabled").asBool();
+		bool visible = dagFn.findPlug("overrideVisibility").asBool();
+		DAGManager::Get()->GetHierarchyCache().SetLayerVisibility(hierarchyIndex_, !enabled || visible);
+	}
 
+	void DAGTransform::RefreshVisibility(bool timeChanged, bool layerChanged)
+	{
+		// 接続元から値が来るもののみ再取得
+		if (timeChanged && isVisibilityDriven_) {
+			ReadLocalVisibility();
+		}
+		if (layerChanged && isLayerMember_) {
+			ReadLayerVisibility();
+		}
+	}
+
+	void DAGTransform::NotifyVisibilityChanged()
+	{
+		// 子トランスフォームの可視性はキャッシュ側で伝搬済み
+		// 非表示中に保留していた子の更新を反映させるため、それ以外に通知
+		for (auto* node : childs_) {
+			if (node->Type() != DAGType::Transform) {
+				node->NotifyParentTransformUpdated(this);
+			}
+		}
+	}
+
+	bool DAGTransform::IsVisible() const
+	{
+		return DAGManager::Get()->GetHierarchyCache().IsVisible(hierarchyIndex_);
+	}
+
+	void DAGTransform::Update()
+	{
 		// ノードの生成順の関係でTransformを生成したタイミングだと
 		// DAGManagerにまだchildが登録されていない場合があるため一度セットアップする
+		// 可視性もここで初期値を取得し、以降はコールバックからの差分で更新する
 		if (!initialized_) {
+			MFnDagNode dagFn(handle_.objectRef());
 			for (uint32_t i = 0; i < dagFn.childCount(); i++) {
 				DAGNode* node = DAGManager::Get()->FindDAGNode(dagFn.child(i));
 				if (node) {
 					AddChild(node);
 				}
 			}
+			isLayerMember_ = dagFn.findPlug("drawOverride").isDestination();
+			isVisibilityDriven_ = dagFn.findPlug("visibility").isDestination();
+			ReadLocalVisibility();
+			ReadLayerVisibility();
 			initialized_ = true;
 		}
 
-		// Visibilityだけは毎フレーム監視
-		// レイヤーからの操作による切り替えにAttributeChangedでは対応できないため
-		MDagPath path;
-		if (!dagFn.getPath(path)) return;
-		visibility_ = path.isVisible();
-
 		// トランスフォーム更新
 		// 親が計算済みかによらずMaya側から値を取得できるのでトランスフォーム間で更新順を気にする必要はない
-		// タイムに変化がある場合アニメーションを反映させるため現在の値を再取得している
-		// (アニメーションの場合AttributeChangedには来ず、DirtyPlugは重いため)
-		// 可視性とワールドしか使用していないのでこれらのみ再取得しているが、必要に応じて他のパラメータも再取得する必要がある
-		if (updated_ || DAGManager::Get()->IsTimeChanged()) {
-			if (DAGManager::Get()->IsTimeChanged()) {
-				Matrix44 cache = world_;
-				GetWorldMatrixByDagPath(path, &world_);
-
-				// タイム変更時はここでも子に更新を通知
-				if (cache != world_) {
-					for (auto* node : childs_) {
-						node->NotifyParentTransformUpdated(this);
-					}
+		// タイム変更時のアニメーションの反映はDAGManagerで全トランスフォームをまとめて計算している(ApplyWorldMatrix)
+		if (updated_) {
+			GetWorldMatrixByDagPath(path_, &world_);
+			updated_ = false;
+		}
+	}
+
+	void DAGTransform::ApplyWorldMatrix(const Matrix44& world, bool changed)
+	{
+		world_ = world;
+		updated_ = false;
+
+		// 子トランスフォームはDAGManager側で計算済みなので、それ以外に更新を通知
+		if (changed) {
+			for (auto* node : childs_) {
+				if (node->Type() != DAGType::Transform) {
+					node->NotifyParentTransformUpdated(this);
 				}
-			} else {
-				GetWorldMatrixByDagPath(path, &world_);
 			}
-
-			updated_ = false;
 		}
 	}
 
@@ -146,6 +250,8 @@ namespace bridge {
 	{
 		if (!parent_) {
 			parent_ = static_cast<const DAGTransform*>(parent);
+			UpdateDagPath();
+			DAGManager::Get()->GetHierarchyCache().SetParent(hierarchyIndex_, parent_->GetHierarchyIndex());
 			Updated();
 		} else {
 			MDisplayError("[MayaCustomViewport] / 子にトランスフォームを持つトランスフォームのインスタンスはサポートされていません。");
@@ -156,7 +262,13 @@ namespace bridge {
 	{
 		if (parent_ == static_cast<const DAGTransform*>(parent)) {
 			parent_ = nullptr;
-			Updated();
+			DAGManager::Get()->GetHierarchyCache().SetParent(hierarchyIndex_, DAGHierarchyCache::InvalidIndex);
+
+			// 破棄待ちのノードはMaya側のノードも削除中なのでパスを取り直さない
+			if (!DAGNodePool::IsDetached(this)) {
+				UpdateDagPath();
+				Updated();
+			}
 		}
 	}
 
@@ -176,6 +288,7 @@ namespace bridge {
 		}
 		childs_.push_back(node);
 		node->LinkParent(this);
+		DAGManager::Get()->InvalidateTransformHierarchy();
 		MDisplayDebugInfo("AddChild / parent: %s, child: %s", MFnDagNode(Object()).name().asChar(), MFnDagNode(node->Object()).name().asChar());
 	}
 
@@ -186,6 +299,7 @@ namespace bridge {
 			if (node == *iter) {
 				childs_.erase(iter);
 				node->UnlinkParent(this);
+				DAGManager::Get()->InvalidateTransformHierarchy();
 				MDisplayDebugInfo("RemoveChild / parent: %s, child: %s", MFnDagNode(Object()).name().asChar(), MFnDagNode(node->Object()).name().asChar());
 				break;
 			}
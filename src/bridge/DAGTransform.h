@@ -20,7 +20,11 @@ namespace bridge {
 		Vector3 rotate_;
 		Vector3 scale_;
 		Matrix44 world_;
-		bool visibility_;
+		MDagPath path_;
+		uint32_t hierarchyIndex_;		// DAGHierarchyCache内の位置
+		bool inheritsTransform_;
+		bool isLayerMember_;			// ディスプレイレイヤーに所属しているか(drawOverrideが接続されている)
+		bool isVisibilityDriven_;		// visibilityに接続があるか(アニメーション等)
 		bool updated_;
 		bool initialized_;
 
@@ -32,6 +36,9 @@ namespace bridge {
 	protected:
 		virtual void AttributeChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug) override;
 		void Updated();
+		void UpdateDagPath();
+		void ReadLocalVisibility();
+		void ReadLayerVisibility();
 
 	public:
 		DAGTransform(MObject& object);
@@ -42,12 +49,22 @@ namespace bridge {
 		virtual void LinkParent(const DAGNode* parent) override;
 		virtual void UnlinkParent(const DAGNode* parent) override;
 		virtual void NotifyParentTransformUpdated(const DAGNode* parent) override;
+		virtual void CollectCallbacks(MCallbackIdArray& callbacks) override;
+		virtual void UnlinkAll() override;
 
 		void AddChild(DAGNode* node);
 		void RemoveChild(DAGNode* node);
+		void ApplyWorldMatrix(const Matrix44& world, bool changed);
+		void RefreshVisibility(bool timeChanged, bool layerChanged);
+		void NotifyVisibilityChanged();
 
+		const DAGTransform* GetParent() const { return parent_; }
+		bool IsInheritsTransform() const { return inheritsTransform_; }
+		const std::vector<DAGNode*>& GetChilds() const { return childs_; }
 		const Matrix44& GetWorldMatrix() const { return world_; }
-		bool IsVisible() const { return visibility_ && (!parent_ || parent_->IsVisible()); }
+		const MDagPath& GetDagPath() const { return path_; }
+		uint32_t GetHierarchyIndex() const { return hierarchyIndex_; }
+		bool IsVisible() const;
 	};
 
 }
\ No newline at end of file
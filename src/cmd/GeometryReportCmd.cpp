@@ -0,0 +1,148 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "GeometryReportCmd.h"
+#include "bridge/DAGManager.h"
+#include "bridge/DAGMesh.h"
+#include "engine/Graphics/VertexQuantizer.h"
+#include "engine/Graphics/GeometryDiskCache.h"
+#include "engine/Graphics/GraphicsCore.h"
+#include "engine/Core/ScratchArena.h"
+
+namespace {
+	const char* attributeNames[se::VERTEX_ATTR_NUM] = {
+		"position",
+		"normal",
+		"color",
+		"texcoord0",
+		"texcoord1",
+		"texcoord2",
+		"texcoord3",
+		"tangent",
+		"binormal",
+	};
+
+	inline double ToMB(uint64_t bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+	inline double Percent(uint64_t bytes, uint64_t baseBytes)
+	{
+		return (baseBytes > 0) ? 100.0 * bytes / baseBytes : 100.0;
+	}
+}
+
+void* GeometryReportCmd::creator()
+{
+	return new GeometryReportCmd();
+}
+
+MStatus GeometryReportCmd::doIt(const MArgList& args)
+{
+	MStatus s;
+
+	// オプション
+	bool perMesh = false;
+	for (uint32_t i = 0; i < args.length(); i++) {
+		auto arg = args.asString(i, &s);
+		if (!s) continue;
+
+		// メッシュ毎に表示
+		if (arg == "-m" || arg == "-mesh") {
+			perMesh = true;
+		}
+	}
+
+	// 全メッシュの集計
+	bridge::GeometryStats total;
+	uint32_t meshCount = 0;
+	for (bridge::DAGNode* node : bridge::DAGManager::Get()->GetNodes(bridge::DAGType::Mesh)) {
+		const bridge::GeometryStats& stats = static_cast<bridge::DAGMesh*>(node)->GetGeometryStats();
+		if (perMesh) {
+			MDisplayInfo("[MayaCustomViewport] %s / vertex: %.1f KB (%.1f%%) / index: %.1f KB (%.1f%%) / degenerate: %u / ACMR: %.3f",
+				node->Name().asChar(),
+				stats.vertexBytes / 1024.0, Percent(stats.vertexBytes, stats.floatVertexBytes),
+				stats.indexBytes / 1024.0, Percent(stats.indexBytes, stats.wideIndexBytes),
+				stats.degenerateTriangles, stats.GetACMR());
+		}
+		total.Add(stats);
+		meshCount++;
+	}
+
+	MDisplayInfo("[MayaCustomViewport] Geometry / mesh: %u / vertex: %.2f MB (float: %.2f MB, %.1f%%) / index: %.2f MB (32bit: %.2f MB, %.1f%%) / degenerate: %u / ACMR: %.3f",
+		meshCount,
+		ToMB(total.vertexBytes), ToMB(total.floatVertexBytes), Percent(total.vertexBytes, total.floatVertexBytes),
+		ToMB(total.indexBytes), ToMB(total.wideIndexBytes), Percent(total.indexBytes, total.wideIndexBytes),
+		total.degenerateTriangles, total.GetACMR());
+
+	// チャンクに分割したメッシュ(チャンク単位で視錐台、背面カリングする)
+	if (total.chunks > 0) {
+		MDisplayInfo("[MayaCustomViewport] Geometry chunk / chunk: %u", total.chunks);
+	}
+
+	// 同じ内容のメッシュ間でのバッファ共有
+	const bridge::DAGGeometryCache& cache = bridge::DAGManager::Get()->GetGeometryCache();
+	MDisplayInfo("[MayaCustomViewport] Geometry cache / resource: %u / hit: %llu / lookup: %llu (%.1f%%) / saved: %.2f MB",
+		cache.GetResourceCount(),
+		static_cast<unsigned long long>(cache.GetHitCount()), static_cast<unsigned long long>(cache.GetLookupCount()),
+		100.0 * cache.GetHitRate(), ToMB(cache.GetSavedBytes()));
+
+	// シーンを開いた時などに抽出を省略できたサブメッシュ
+	const se::GeometryDiskCache& diskCache = se::GeometryDiskCache::Get();
+	if (diskCache.IsEnabled()) {
+		MDisplayInfo("[MayaCustomViewport] Geometry disk cache / file: %u / hit: %llu / lookup: %llu / size: %.2f MB (capacity: %.2f MB)",
+			diskCache.GetEntryCount(),
+			static_cast<unsigned long long>(diskCache.GetHitCount()), static_cast<unsigned long long>(diskCache.GetLookupCount()),
+			ToMB(diskCache.GetTotalBytes()), ToMB(diskCache.GetCapacity()));
+	}
+
+	// 加工ジョブの一時バッファ(growとmergeが増え続けなければヒープの確保は発生していない、trimは上限を超えて解放した回数)
+	se::ScratchArena::Stats scratch = se::ScratchArena::GetStats();
+	MDisplayInfo("[MayaCustomViewport] Scratch arena / arena: %u / capacity: %.2f MB / high water: %.2f MB / scope: %llu / grow: %llu / merge: %llu / trim: %llu",
+		scratch.arenaCount, ToMB(scratch.capacity), ToMB(scratch.highWater),
+		static_cast<unsigned long long>(scratch.scopeCount), static_cast<unsigned long long>(scratch.growCount),
+		static_cast<unsigned long long>(scratch.mergeCount), static_cast<unsigned long long>(scratch.trimCount));
+
+	// フレーム毎に書き換えるデータのリング(failureは空きがなく専用のバッファに書き込んだ数)
+	const se::RingAllocator::Stats& vertexRing = se::GraphicsCore::GetVertexRing().GetStats();
+	MDisplayInfo("[MayaCustomViewport] Vertex ring / capacity: %.2f MB / in flight: %.2f MB (peak: %.2f MB, frame: %u) / write: %llu / failure: %llu / wrap: %llu",
+		ToMB(vertexRing.capacity), ToMB(vertexRing.inFlightBytes), ToMB(vertexRing.peakBytes), vertexRing.inFlightFrames,
+		static_cast<unsigned long long>(vertexRing.allocations), static_cast<unsigned long long>(vertexRing.failures),
+		static_cast<unsigned long long>(vertexRing.wraps));
+	const se::UploadRing* constantRing = se::GraphicsCore::GetConstantRing();
+	if (constantRing) {
+		const se::RingAllocator::Stats& stats = constantRing->GetStats();
+		MDisplayInfo("[MayaCustomViewport] Constant ring / capacity: %.2f MB / in flight: %.2f MB (peak: %.2f MB, frame: %u) / write: %llu / failure: %llu / wrap: %llu",
+			ToMB(stats.capacity), ToMB(stats.inFlightBytes), ToMB(stats.peakBytes), stats.inFlightFrames,
+			static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.failures),
+			static_cast<unsigned long long>(stats.wraps));
+	} else {
+		MDisplayInfo("[MayaCustomViewport] Constant ring / unsupported (D3D11.1 constant buffer offsetting is not available)");
+	}
+
+	// 全インスタンスで共有するオブジェクトパラメータ(uploadは範囲をまとめた際の未更新の要素を含む)
+	const se::ObjectParameterTable& objectTable = bridge::DAGManager::Get()->GetObjectTable();
+	const se::ObjectParameterTable::Stats& objectStats = objectTable.GetStats();
+	MDisplayInfo("[MayaCustomViewport] Object parameters / object: %u (capacity: %u) / update: %llu / range: %llu / upload: %llu",
+		objectTable.GetCount(), objectTable.GetCapacity(),
+		static_cast<unsigned long long>(objectStats.updates), static_cast<unsigned long long>(objectStats.uploadRanges),
+		static_cast<unsigned long long>(objectStats.uploadObjects));
+
+	// 量子化誤差(誤差の上限を超えたものは警告)
+	for (uint32_t i = 0; i < se::VERTEX_ATTR_NUM; i++) {
+		float bound = se::VertexQuantizer::GetErrorBound(static_cast<se::VertexAttribute>(i));
+		if (bound <= 0.0f || total.maxError[i] <= 0.0f) continue;
+
+		if (total.maxError[i] > bound) {
+			MDisplayWarning("[MayaCustomViewport] Quantization error / %s: %g (bound: %g)", attributeNames[i], total.maxError[i], bound);
+		} else {
+			MDisplayInfo("[MayaCustomViewport] Quantization error / %s: %g (bound: %g)", attributeNames[i], total.maxError[i], bound);
+		}
+	}
+
+	setResult(static_cast<double>(total.vertexBytes));
+	return MStatus::kSuccess;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include "Common.h"
+
+
+/**
+ * ジオメトリのメモリ使用量、量子化誤差の表示用コマンド
+ */
+class GeometryReportCmd: public MPxCommand
+{
+public:
+	GeometryReportCmd() {};
+	virtual      ~GeometryReportCmd() {};
+
+	virtual MStatus doIt(const MArgList& args) override;
+	virtual bool  isUndoable() const override { return false; };
+
+	static void* creator();
+};
\ No newline at end of file
@@ -0,0 +1,108 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Core/Hash.h"
+#include <cstring>
+
+namespace se
+{
+	namespace
+	{
+		const uint64_t Prime1 = 11400714785074694791ull;
+		const uint64_t Prime2 = 14029467366897019727ull;
+		const uint64_t Prime3 = 1609587929392839161ull;
+		const uint64_t Prime4 = 9650029242287828579ull;
+		const uint64_t Prime5 = 2870177450012600261ull;
+
+		inline uint64_t Rotl(uint64_t x, int r)
+		{
+			return (x << r) | (x >> (64 - r));
+		}
+
+		inline uint64_t Read64(const uint8_t* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint32_t Read32(const uint8_t* p)
+		{
+			uint32_t v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint64_t Round(uint64_t acc, uint64_t input)
+		{
+			acc += input * Prime2;
+			acc = Rotl(acc, 31);
+			return acc * Prime1;
+		}
+
+		inline uint64_t MergeRound(uint64_t acc, uint64_t value)
+		{
+			acc ^= Round(0, value);
+			return acc * Prime1 + Prime4;
+		}
+	}
+
+	uint64_t Hash64(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		const uint8_t* end = p + size;
+		uint64_t hash;
+
+		// 32バイト単位で4レーン並列に処理
+		if (size >= 32) {
+			const uint8_t* limit = end - 32;
+			uint64_t v1 = seed + Prime1 + Prime2;
+			uint64_t v2 = seed + Prime2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - Prime1;
+			do {
+				v1 = Round(v1, Read64(p));
+				v2 = Round(v2, Read64(p + 8));
+				v3 = Round(v3, Read64(p + 16));
+				v4 = Round(v4, Read64(p + 24));
+				p += 32;
+			} while (p <= limit);
+
+			hash = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+			hash = MergeRound(hash, v1);
+			hash = MergeRound(hash, v2);
+			hash = MergeRound(hash, v3);
+			hash = MergeRound(hash, v4);
+		} else {
+			hash = seed + Prime5;
+		}
+		hash += static_cast<uint64_t>(size);
+
+		// 残り
+		while (p + 8 <= end) {
+			hash ^= Round(0, Read64(p));
+			hash = Rotl(hash, 27) * Prime1 + Prime4;
+			p += 8;
+		}
+		if (p + 4 <= end) {
+			hash ^= static_cast<uint64_t>(Read32(p)) * Prime1;
+			hash = Rotl(hash, 23) * Prime2 + Prime3;
+			p += 4;
+		}
+		while (p < end) {
+			hash ^= (*p) * Prime5;
+			hash = Rotl(hash, 11) * Prime1;
+			p++;
+		}
+
+		// 攪拌
+		hash ^= hash >> 33;
+		hash *= Prime2;
+		hash ^= hash >> 29;
+		hash *= Prime3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+}
\ No newline at end of file
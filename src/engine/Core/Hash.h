@@ -0,0 +1,24 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+
+namespace se
+{
+	/**
+	 * 64bitハッシュ(xxHash64と同じアルゴリズム)
+	 * 大きなバッファの内容比較用(暗号学的な強度はない)
+	 */
+	uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+	// ハッシュ値の連結
+	inline uint64_t HashCombine(uint64_t hash, uint64_t value)
+	{
+		return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Core/MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace se
+{
+#ifdef _WIN32
+	MappedFile::MappedFile()
+		: data_(nullptr)
+		, size_(0)
+		, file_(INVALID_HANDLE_VALUE)
+		, mapping_(nullptr)
+	{
+	}
+#else
+	MappedFile::MappedFile()
+		: data_(nullptr)
+		, size_(0)
+		, file_(-1)
+	{
+	}
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+
+		file_ = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_ == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!::GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+			Close();
+			return false;
+		}
+		size_ = static_cast<size_t>(size.QuadPart);
+
+		mapping_ = ::CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping_) {
+			Close();
+			return false;
+		}
+		data_ = static_cast<const uint8_t*>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+		if (!data_) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data_) {
+			::UnmapViewOfFile(data_);
+			data_ = nullptr;
+		}
+		if (mapping_) {
+			::CloseHandle(mapping_);
+			mapping_ = nullptr;
+		}
+		if (file_ != INVALID_HANDLE_VALUE) {
+			::CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+		}
+		size_ = 0;
+	}
+#else
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+
+		file_ = ::open(path, O_RDONLY);
+		if (file_ < 0) return false;
+
+		struct stat st;
+		if (::fstat(file_, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+			Close();
+			return false;
+		}
+		size_ = static_cast<size_t>(st.st_size);
+
+		void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0);
+		if (data == MAP_FAILED) {
+			Close();
+			return false;
+		}
+		data_ = static_cast<const uint8_t*>(data);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data_) {
+			::munmap(const_cast<uint8_t*>(data_), size_);
+			data_ = nullptr;
+		}
+		if (file_ >= 0) {
+			::close(file_);
+			file_ = -1;
+		}
+		size_ = 0;
+	}
+#endif
+}
\ No newline at end of file
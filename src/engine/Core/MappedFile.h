@@ -0,0 +1,41 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+
+namespace se
+{
+	/**
+	 * 読み込み専用のメモリマップドファイル
+	 */
+	class MappedFile
+	{
+	private:
+		const uint8_t* data_;
+		size_t size_;
+#ifdef _WIN32
+		void* file_;
+		void* mapping_;
+#else
+		int file_;
+#endif
+
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const char* path);
+		void Close();
+
+		bool IsOpen() const { return data_ != nullptr; }
+		const uint8_t* Data() const { return data_; }
+		size_t Size() const { return size_; }
+	};
+}
\ No newline at end of file
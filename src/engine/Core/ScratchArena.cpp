@@ -0,0 +1,212 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Core/ScratchArena.h"
+#include <algorithm>
+#include <mutex>
+
+namespace se
+{
+	namespace {
+		// 借用されていないアリーナと全体の統計
+		struct ArenaPool
+		{
+			std::mutex mutex;
+			std::vector<ScratchArena*> arenas;
+			std::vector<ScratchArena*> available;
+			uint64_t highWater;
+			uint64_t scopeCount;
+			uint64_t growCount;
+			uint64_t mergeCount;
+			uint64_t trimCount;
+			size_t retainedCapacity;
+
+			ArenaPool() : highWater(0), scopeCount(0), growCount(0), mergeCount(0), trimCount(0), retainedCapacity(ScratchArena::DefaultRetainedCapacity) {}
+			~ArenaPool()
+			{
+				for (ScratchArena* arena : arenas) {
+					delete arena;
+				}
+			}
+		};
+
+		ArenaPool& GetPool()
+		{
+			static ArenaPool pool;
+			return pool;
+		}
+
+		inline size_t AlignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	// std::maxで参照渡しするので定義が要る
+	const size_t ScratchArena::DefaultBlockSize;
+	const size_t ScratchArena::DefaultAlignment;
+	const size_t ScratchArena::DefaultRetainedCapacity;
+
+
+	ScratchArena::ScratchArena()
+		: current_(0)
+		, offset_(0)
+		, used_(0)
+		, highWater_(0)
+		, growCount_(0)
+		, mergeCount_(0)
+		, trimCount_(0)
+		, releasedCapacity_(0)
+	{
+	}
+
+	ScratchArena::~ScratchArena()
+	{
+		for (const Block& block : blocks_) {
+			delete[] block.data;
+		}
+	}
+
+	void ScratchArena::AddBlock(size_t size)
+	{
+		Block block;
+		block.data = new uint8_t[size];
+		block.size = size;
+		blocks_.push_back(block);
+	}
+
+	void* ScratchArena::Allocate(size_t size, size_t alignment)
+	{
+		// 現在のブロックに収まらなければ後ろのブロックを探し、なければ追加する(それまでの合計以上にして倍々で増やす)
+		while (true) {
+			if (current_ < blocks_.size()) {
+				const Block& block = blocks_[current_];
+				uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+				size_t aligned = AlignUp(base + offset_, alignment) - base;
+				if (aligned + size <= block.size) {
+					used_ += aligned + size - offset_;
+					offset_ = aligned + size;
+					highWater_ = (std::max)(highWater_, used_);
+					return block.data + aligned;
+				}
+				if (current_ + 1 < blocks_.size()) {
+					used_ += block.size - offset_;
+					current_++;
+					offset_ = 0;
+					continue;
+				}
+				used_ += block.size - offset_;
+			}
+			AddBlock((std::max)((std::max)(DefaultBlockSize, size + alignment), GetCapacity()));
+			growCount_++;
+			current_ = blocks_.size() - 1;
+			offset_ = 0;
+		}
+	}
+
+	ScratchArena::Marker ScratchArena::GetMarker() const
+	{
+		Marker marker;
+		marker.block = current_;
+		marker.offset = offset_;
+		marker.used = used_;
+		return marker;
+	}
+
+	void ScratchArena::Rewind(const Marker& marker)
+	{
+		current_ = marker.block;
+		offset_ = marker.offset;
+		used_ = marker.used;
+	}
+
+	void ScratchArena::Reset(size_t maxCapacity)
+	{
+		size_t capacity = GetCapacity();
+		bool trim = capacity > maxCapacity;
+		if (trim || blocks_.size() > 1) {
+			for (const Block& block : blocks_) {
+				delete[] block.data;
+			}
+			blocks_.clear();
+			if (trim) {
+				trimCount_++;
+			} else {
+				AddBlock(capacity);
+				mergeCount_++;
+			}
+		}
+		current_ = 0;
+		offset_ = 0;
+		used_ = 0;
+	}
+
+	size_t ScratchArena::GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : blocks_) {
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+	ScratchArena* ScratchArena::Acquire()
+	{
+		ArenaPool& pool = GetPool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.scopeCount++;
+		if (!pool.available.empty()) {
+			ScratchArena* arena = pool.available.back();
+			pool.available.pop_back();
+			return arena;
+		}
+		ScratchArena* arena = new ScratchArena();
+		pool.arenas.push_back(arena);
+		return arena;
+	}
+
+	void ScratchArena::Release(ScratchArena* arena)
+	{
+		ArenaPool& pool = GetPool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		// まとめ直しと解放はこの借用の統計に含める
+		arena->Reset(pool.retainedCapacity);
+		pool.highWater = (std::max)(pool.highWater, static_cast<uint64_t>(arena->highWater_));
+		pool.growCount += arena->growCount_;
+		pool.mergeCount += arena->mergeCount_;
+		pool.trimCount += arena->trimCount_;
+		arena->highWater_ = 0;
+		arena->growCount_ = 0;
+		arena->mergeCount_ = 0;
+		arena->trimCount_ = 0;
+		arena->releasedCapacity_ = arena->GetCapacity();
+		pool.available.push_back(arena);
+	}
+
+	ScratchArena::Stats ScratchArena::GetStats()
+	{
+		ArenaPool& pool = GetPool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		Stats stats;
+		stats.arenaCount = static_cast<uint32_t>(pool.arenas.size());
+		stats.capacity = 0;
+		for (const ScratchArena* arena : pool.arenas) {
+			stats.capacity += arena->releasedCapacity_;
+		}
+		stats.highWater = pool.highWater;
+		stats.scopeCount = pool.scopeCount;
+		stats.growCount = pool.growCount;
+		stats.mergeCount = pool.mergeCount;
+		stats.trimCount = pool.trimCount;
+		return stats;
+	}
+
+	void ScratchArena::SetRetainedCapacity(size_t capacity)
+	{
+		ArenaPool& pool = GetPool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.retainedCapacity = capacity;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * 一時バッファ用の線形アロケータ
+	 * 確保はポインタを進めるだけで、解放はRewind()、Reset()でまとめて行う
+	 * ブロックが足りなければ追加し、Reset()時に合計サイズの1ブロックにまとめるので、使用量が安定すれば確保は発生しない
+	 * プールに返す際は保持する容量の上限(SetRetainedCapacity())を超えた分を解放し、一度の巨大な借用で使った分を持ち続けない
+	 * スレッドセーフではないので、ジョブ毎にScratchScopeで借りて使う
+	 */
+	class ScratchArena
+	{
+	public:
+		static const size_t DefaultBlockSize = 1 << 20;
+		static const size_t DefaultAlignment = 16;
+		static const size_t DefaultRetainedCapacity = 64 << 20;
+
+		// Rewind()で戻す位置
+		struct Marker
+		{
+			size_t block;
+			size_t offset;
+			size_t used;
+		};
+
+		// 使い回しているアリーナ全体の統計(サイズの見積もり用)
+		struct Stats
+		{
+			uint32_t arenaCount;		// 作成したアリーナ数(同時に借りられた最大数)
+			uint64_t capacity;			// 全アリーナのブロックの合計
+			uint64_t highWater;			// 1回の借用で使った最大量
+			uint64_t scopeCount;		// 借用回数
+			uint64_t growCount;			// 借用中に足りずにブロックを確保した回数
+			uint64_t mergeCount;		// 返す際に複数のブロックを1ブロックにまとめ直した回数
+			uint64_t trimCount;			// 返す際に保持する容量の上限を超えて解放した回数
+		};
+
+	private:
+		struct Block
+		{
+			uint8_t* data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks_;
+		size_t current_;		// 確保中のブロック
+		size_t offset_;			// 確保中のブロック内の位置
+		size_t used_;			// 先頭からの使用量(ブロックの切り替えで余った分を含む)
+		size_t highWater_;
+		uint64_t growCount_;
+		uint64_t mergeCount_;
+		uint64_t trimCount_;
+		size_t releasedCapacity_;	// 最後に返された時の容量(統計用、借用中のアリーナには触れない)
+
+	private:
+		void AddBlock(size_t size);
+
+	public:
+		ScratchArena();
+		~ScratchArena();
+		ScratchArena(const ScratchArena&) = delete;
+		ScratchArena& operator=(const ScratchArena&) = delete;
+
+		// alignmentは2のべき乗(Rewind()、Reset()まで有効)
+		void* Allocate(size_t size, size_t alignment = DefaultAlignment);
+		template<typename T>
+		T* Allocate(size_t count) { return static_cast<T*>(Allocate(sizeof(T) * count)); }
+
+		Marker GetMarker() const;
+		void Rewind(const Marker& marker);
+		// 全て解放する(複数ブロックに分かれていれば1ブロックにまとめ直す、容量がmaxCapacityを超えていればブロックも解放する)
+		void Reset(size_t maxCapacity = SIZE_MAX);
+
+		size_t GetUsedBytes() const { return used_; }
+		size_t GetHighWaterBytes() const { return highWater_; }
+		size_t GetCapacity() const;
+		uint64_t GetGrowCount() const { return growCount_; }
+		uint64_t GetMergeCount() const { return mergeCount_; }
+		uint64_t GetTrimCount() const { return trimCount_; }
+
+		// スレッド間で使い回すアリーナを借りる、返す(返す際にリセットして統計に加える)
+		static ScratchArena* Acquire();
+		static void Release(ScratchArena* arena);
+		static Stats GetStats();
+		// 返されたアリーナが保持する容量の上限
+		static void SetRetainedCapacity(size_t capacity);
+	};
+
+	/**
+	 * スコープの間だけアリーナを借りる
+	 */
+	class ScratchScope
+	{
+	private:
+		ScratchArena* arena_;
+
+	public:
+		ScratchScope() : arena_(ScratchArena::Acquire()) {}
+		~ScratchScope() { ScratchArena::Release(arena_); }
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+
+		ScratchArena& Get() const { return *arena_; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Core/ThreadPool.h"
+#include <algorithm>
+#include <memory>
+
+namespace se
+{
+	ThreadPool::ThreadPool()
+		: stop_(false)
+	{
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		Finalize();
+	}
+
+	void ThreadPool::Initialize(uint32_t threadCount)
+	{
+		Finalize();
+
+		if (threadCount == 0) {
+			uint32_t hardwareCount = std::thread::hardware_concurrency();
+			threadCount = (hardwareCount > 1) ? hardwareCount - 1 : 0;
+		}
+
+		stop_ = false;
+		workers_.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++) {
+			workers_.emplace_back(&ThreadPool::WorkerMain, this);
+		}
+	}
+
+	void ThreadPool::Finalize()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		condition_.notify_all();
+		for (auto& worker : workers_) {
+			worker.join();
+		}
+		workers_.clear();
+
+		// 未処理のタスクは呼び出しスレッドで消化
+		while (RunPendingTask()) {}
+	}
+
+	void ThreadPool::WorkerMain()
+	{
+		for (;;) {
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				condition_.wait(lock, [this] { return stop_ || !tasks_.empty() || !backgroundTasks_.empty(); });
+				if (!PopTask(task)) return;		// 停止要求
+			}
+			task();
+		}
+	}
+
+	bool ThreadPool::PopTask(Task& task)
+	{
+		// mutex_をロックした状態で呼ぶ
+		std::deque<Task>& queue = !tasks_.empty() ? tasks_ : backgroundTasks_;
+		if (queue.empty()) return false;
+		task = std::move(queue.front());
+		queue.pop_front();
+		return true;
+	}
+
+	bool ThreadPool::RunPendingTask()
+	{
+		Task task;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!PopTask(task)) return false;
+		}
+		task();
+		return true;
+	}
+
+	void ThreadPool::Submit(Task task)
+	{
+		if (workers_.empty()) {
+			// ワーカーがない場合はその場で実行
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.push_back(std::move(task));
+		}
+		condition_.notify_one();
+	}
+
+	void ThreadPool::SubmitBackground(Task task)
+	{
+		if (workers_.empty()) {
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			backgroundTasks_.push_back(std::move(task));
+		}
+		condition_.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, uint32_t grainSize, const RangeTask& func)
+	{
+		if (count == 0) return;
+		if (grainSize == 0) grainSize = 1;
+
+		// 分割数が1以下、ワーカーなしの場合は直接実行
+		uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+		if (chunkCount <= 1 || workers_.empty()) {
+			func(0, count);
+			return;
+		}
+
+		// 投入したタスクはワーカーが塞がっていると呼び出しから戻った後に始まることがあるので、
+		// 範囲の状態は共有して、範囲を取れなかったタスクはfuncに触れずに終わる
+		struct State
+		{
+			std::atomic<uint32_t> next;
+			std::atomic<uint32_t> completed;		// 処理を終えた分割数
+			const RangeTask* func;
+			uint32_t count;
+			uint32_t grainSize;
+		};
+		std::shared_ptr<State> state = std::make_shared<State>();
+		state->next = 0;
+		state->completed = 0;
+		state->func = &func;
+		state->count = count;
+		state->grainSize = grainSize;
+
+		// 各タスクは未処理の範囲がなくなるまで取り出して処理する
+		auto worker = [](State& s) {
+			for (;;) {
+				uint32_t begin = s.next.fetch_add(s.grainSize);
+				if (begin >= s.count) break;
+				(*s.func)(begin, (s.count - begin < s.grainSize) ? s.count : begin + s.grainSize);
+				s.completed.fetch_add(1);
+			}
+		};
+
+		uint32_t taskCount = std::min<uint32_t>(GetWorkerCount(), chunkCount - 1);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (uint32_t i = 0; i < taskCount; i++) {
+				tasks_.push_back([state, worker]() { worker(*state); });
+			}
+		}
+		condition_.notify_all();
+
+		worker(*state);
+
+		// 範囲は全て取り出し済みなので、他のスレッドが処理中の範囲が終わるのを待つ
+		// キューの他のタスク(バックグラウンドの重い処理など)は呼び出しスレッドでは実行しない
+		while (state->completed.load() < chunkCount) {
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,69 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace se
+{
+	/**
+	 * スレッドプール
+	 * ワーカースレッドは起動時に生成して使い回す
+	 * フレーム内で完了を待つタスクと、複数フレームにまたがる重いタスク(バックグラウンド)は別のキューに積み、
+	 * ワーカーは通常のキューが空の場合のみバックグラウンドのタスクを取り出す
+	 */
+	class ThreadPool
+	{
+	public:
+		static ThreadPool& Get() {
+			static ThreadPool instance;
+			return instance;
+		}
+
+	public:
+		typedef std::function<void()> Task;
+		typedef std::function<void(uint32_t begin, uint32_t end)> RangeTask;
+
+	private:
+		std::vector<std::thread> workers_;
+		std::deque<Task> tasks_;
+		std::deque<Task> backgroundTasks_;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		bool stop_;
+
+	private:
+		void WorkerMain();
+		bool PopTask(Task& task);
+		bool RunPendingTask();
+
+	public:
+		ThreadPool();
+		~ThreadPool();
+
+		// threadCountが0の場合は論理コア数 - 1(呼び出しスレッドの分)
+		void Initialize(uint32_t threadCount = 0);
+		void Finalize();
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+		// タスクを追加(完了は呼び出し側で管理する)
+		void Submit(Task task);
+		// 完了を待たない重いタスクを追加(通常のタスクより後に処理する)
+		void SubmitBackground(Task task);
+
+		// [0, count)をgrainSize単位に分割して並列実行し、全て完了するまで待つ
+		// 呼び出しスレッドも処理に参加するが、他のタスクは実行しない
+		void ParallelFor(uint32_t count, uint32_t grainSize, const RangeTask& func);
+	};
+}
@@ -0,0 +1,67 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * 更新要求のあった要素のキュー(侵入型、Mayaには依存しない)
+	 * 要素側にキュー内の位置(IndexMember、-1: 未登録)を持たせ、登録は1回のみ、削除は位置を無効化するだけにしてO(1)で外す
+	 * Drain()中に登録された要素も同じDrain()で処理する
+	 */
+	template <class T, int32_t T::*IndexMember>
+	class UpdateQueue
+	{
+	private:
+		std::vector<T*> items_;
+
+	public:
+		static bool IsQueued(const T* item) { return item->*IndexMember >= 0; }
+
+		// 登録済みなら何もしない(登録した場合はtrue)
+		bool Push(T* item)
+		{
+			if (IsQueued(item)) return false;
+			item->*IndexMember = static_cast<int32_t>(items_.size());
+			items_.push_back(item);
+			return true;
+		}
+
+		void Remove(T* item)
+		{
+			if (!IsQueued(item)) return;
+			assert(items_[item->*IndexMember] == item);
+			items_[item->*IndexMember] = nullptr;
+			item->*IndexMember = -1;
+		}
+
+		// 登録順に処理して空にする(funcの呼び出し前に未登録に戻すので、func内で再登録できる)
+		template <class Func>
+		void Drain(Func func)
+		{
+			for (size_t i = 0; i < items_.size(); i++) {
+				T* item = items_[i];
+				if (!item) continue;	// 削除済み
+
+				item->*IndexMember = -1;
+				func(item);
+			}
+			items_.clear();
+		}
+
+		// 要素の位置は戻さずに空にする(要素を破棄した後に使う)
+		void Clear() { items_.clear(); }
+
+		// 削除済みの空きを含む数
+		uint32_t Size() const { return static_cast<uint32_t>(items_.size()); }
+		bool Empty() const { return items_.empty(); }
+	};
+}
@@ -0,0 +1,104 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/DeferredCommandLists.h"
+#include "engine/Graphics/GraphicsCore.h"
+#include "engine/Graphics/GraphicsContext.h"
+#include "engine/Graphics/RenderQueue.h"
+
+namespace se
+{
+	DeferredCommandLists::DeferredCommandLists(GraphicsContext& immediate, const RenderQueue& queue, const SetupFunc& setup)
+		: immediate_(immediate)
+		, queue_(queue)
+		, setup_(setup)
+	{
+		ZeroMemory(&output_, sizeof(output_));
+	}
+
+	DeferredCommandLists::~DeferredCommandLists()
+	{
+		ReleaseCommandLists();
+		ReleaseOutputState();
+	}
+
+	void DeferredCommandLists::ReleaseOutputState()
+	{
+		for (auto*& view : output_.renderTargets) {
+			COMPTR_RELEASE(view);
+		}
+		COMPTR_RELEASE(output_.depthStencil);
+	}
+
+	void DeferredCommandLists::ReleaseCommandLists()
+	{
+		for (auto*& commandList : commandLists_) {
+			COMPTR_RELEASE(commandList);
+		}
+		commandLists_.clear();
+	}
+
+	uint32_t DeferredCommandLists::GetContextCount() const
+	{
+		return GraphicsCore::GetDeferredContextCount();
+	}
+
+	void DeferredCommandLists::Begin(uint32_t chunkCount)
+	{
+		ReleaseCommandLists();
+		commandLists_.assign(chunkCount, nullptr);
+		chunks_.assign(chunkCount, ParallelSubmit::Chunk());
+
+		// 出力先は記録中に変わらないので、呼び出しスレッドで一度だけ取得する
+		ReleaseOutputState();
+		ID3D11DeviceContext* context = immediate_.GetDeviceContext();
+		context->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, output_.renderTargets, &output_.depthStencil);
+		output_.viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+		context->RSGetViewports(&output_.viewportCount, output_.viewports);
+		output_.scissorCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+		context->RSGetScissorRects(&output_.scissorCount, output_.scissorRects);
+	}
+
+	void DeferredCommandLists::End()
+	{
+		ReleaseCommandLists();
+		ReleaseOutputState();
+	}
+
+	void DeferredCommandLists::Record(uint32_t contextIndex, uint32_t begin, uint32_t end)
+	{
+		chunks_[contextIndex].begin = begin;
+		chunks_[contextIndex].end = end;
+
+		GraphicsContext& context = GraphicsCore::GetDeferredContext(contextIndex);
+		ID3D11DeviceContext* deviceContext = context.GetDeviceContext();
+		deviceContext->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, output_.renderTargets, output_.depthStencil);
+		deviceContext->RSSetViewports(output_.viewportCount, output_.viewports);
+		deviceContext->RSSetScissorRects(output_.scissorCount, output_.scissorRects);
+		if (setup_) {
+			setup_(context);
+		}
+
+		queue_.Submit(context, begin, end);
+		commandLists_[contextIndex] = context.FinishCommandList();
+	}
+
+	void DeferredCommandLists::Execute(uint32_t contextIndex)
+	{
+		ID3D11CommandList* commandList = commandLists_[contextIndex];
+		if (commandList) {
+			immediate_.ExecuteCommandList(commandList);
+		} else {
+			// 記録に失敗した範囲は即時コンテキストで描画し直す
+			const ParallelSubmit::Chunk& chunk = chunks_[contextIndex];
+			queue_.Submit(immediate_, chunk.begin, chunk.end);
+		}
+	}
+
+	void DeferredCommandLists::SubmitDirect(uint32_t begin, uint32_t end)
+	{
+		queue_.Submit(immediate_, begin, end);
+	}
+}
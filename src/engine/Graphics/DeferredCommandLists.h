@@ -0,0 +1,65 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include "engine/Graphics/GraphicsCommon.h"
+#include "engine/Graphics/ParallelSubmit.h"
+#include <functional>
+#include <vector>
+
+namespace se
+{
+	class GraphicsContext;
+	class RenderQueue;
+
+	/**
+	 * 遅延コンテキストによる描画キューの記録(ParallelSubmitの記録先)
+	 * 遅延コンテキストは初期状態から記録するので、即時コンテキストの出力先(レンダーターゲット、ビューポート、シザー)を引き継ぎ、
+	 * setupで共通のリソース(ビューのコンスタントバッファ等)を設定してからパケットを記録する
+	 * 記録中はリソースを更新しないこと(Map、UpdateSubresourceは記録前に即時コンテキストで済ませる)
+	 */
+	class DeferredCommandLists : public CommandListDevice
+	{
+	public:
+		typedef std::function<void(GraphicsContext& context)> SetupFunc;
+
+	private:
+		// 即時コンテキストから引き継ぐ出力先
+		struct OutputState
+		{
+			ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+			ID3D11DepthStencilView* depthStencil;
+			D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+			UINT viewportCount;
+			D3D11_RECT scissorRects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+			UINT scissorCount;
+		};
+
+		GraphicsContext& immediate_;
+		const RenderQueue& queue_;
+		SetupFunc setup_;
+		OutputState output_;
+		std::vector<ID3D11CommandList*> commandLists_;
+		std::vector<ParallelSubmit::Chunk> chunks_;		// 記録に失敗した場合に直接描画する範囲
+
+	private:
+		void ReleaseOutputState();
+		void ReleaseCommandLists();
+
+	public:
+		DeferredCommandLists(GraphicsContext& immediate, const RenderQueue& queue, const SetupFunc& setup);
+		virtual ~DeferredCommandLists();
+		DeferredCommandLists(const DeferredCommandLists&) = delete;
+		DeferredCommandLists& operator=(const DeferredCommandLists&) = delete;
+
+		virtual uint32_t GetContextCount() const override;
+		virtual void Begin(uint32_t chunkCount) override;
+		virtual void End() override;
+		virtual void Record(uint32_t contextIndex, uint32_t begin, uint32_t end) override;
+		virtual void Execute(uint32_t contextIndex) override;
+		virtual void SubmitDirect(uint32_t begin, uint32_t end) override;
+	};
+}
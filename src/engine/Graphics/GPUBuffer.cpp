@@ -7,6 +7,7 @@
 #include "engine/Graphics/GraphicsCore.h"
 #include "engine/Graphics/GraphicsContext.h"
 #include "engine/Graphics/Shader.h"
+#include "engine/Graphics/VertexPacker.h"
 
 namespace se
 {
@@ -14,6 +15,10 @@ namespace se
 
 	ConstantBuffer::ConstantBuffer()
 		: buffer_(nullptr)
+		, size_(0)
+		, usage_(BUFFER_USAGE_DEFAULT)
+		, ringBuffer_(nullptr)
+		, ringOffset_(RingAllocator::InvalidOffset)
 	{
 	}
 
@@ -25,11 +30,22 @@ namespace se
 	void ConstantBuffer::Create(uint32_t size, BufferUsage usage)
 	{
 		Assert(size % 16 == 0);
+		size_ = size;
+		usage_ = usage;
+
+		// リングを使う場合は専用のバッファはリングが一杯になった時に作る
+		if (!GraphicsCore::GetConstantRing()) {
+			CreateBuffer();
+		}
+	}
+
+	void ConstantBuffer::CreateBuffer()
+	{
 		D3D11_BUFFER_DESC bd;
 		ZeroMemory(&bd, sizeof(bd));
 		bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		bd.ByteWidth = size;
-		switch (usage)
+		bd.ByteWidth = size_;
+		switch (usage_)
 		{
 		case BUFFER_USAGE_DYNAMIC:
 			bd.Usage = D3D11_USAGE_DYNAMIC;
@@ -42,14 +58,39 @@ namespace se
 		}
 
 		THROW_IF_FAILED(GraphicsCore::GetDevice()->CreateBuffer(&bd, nullptr, &buffer_));
-		size_ = size;
 	}
 
 	void ConstantBuffer::Update(GraphicsContext& context, const void* data, uint32_t size)
 	{
+		UploadRing* ring = GraphicsCore::GetConstantRing();
+		if (ring) {
+			ringOffset_ = ring->Write(context, data, size, UploadRing::ConstantAlignment);
+			if (ringOffset_ != RingAllocator::InvalidOffset) {
+				ringBuffer_ = ring->Get<ID3D11Buffer>();
+				return;
+			}
+		}
+
+		// リングが使えないか空きがない場合は専用のバッファを更新する
+		ringBuffer_ = nullptr;
+		if (!buffer_) {
+			CreateBuffer();
+		}
 		context.UpdateSubresource(*this, data, size);
 	}
 
+	void ConstantBuffer::Destroy()
+	{
+		COMPTR_RELEASE(buffer_);
+		ringBuffer_ = nullptr;
+		ringOffset_ = RingAllocator::InvalidOffset;
+	}
+
+	uint32_t ConstantBuffer::GetConstantCount() const
+	{
+		return ((size_ + UploadRing::ConstantAlignment - 1) & ~(UploadRing::ConstantAlignment - 1)) / 16;
+	}
+
 #pragma endregion
 
 
@@ -80,24 +121,6 @@ namespace se
 
 #pragma region VertexBuffer
 
-	namespace
-	{
-		uint32_t GetVertexStride(uint32_t attr)
-		{
-			uint32_t size = 0;
-			if (attr & VERTEX_ATTR_FLAG_POSITION) size += 12;
-			if (attr & VERTEX_ATTR_FLAG_NORMAL) size += 12;
-			if (attr & VERTEX_ATTR_FLAG_COLOR) size += 16;
-			if (attr & VERTEX_ATTR_FLAG_TEXCOORD0) size += 8;
-			if (attr & VERTEX_ATTR_FLAG_TEXCOORD1) size += 8;
-			if (attr & VERTEX_ATTR_FLAG_TEXCOORD2) size += 8;
-			if (attr & VERTEX_ATTR_FLAG_TEXCOORD3) size += 8;
-			if (attr & VERTEX_ATTR_FLAG_TANGENT) size += 12;
-			if (attr & VERTEX_ATTR_FLAG_BITANGENT) size += 12;
-			return size;
-		}
-	}
-
 	VertexBuffer::VertexBuffer()
 		: stride_(0)
 		, attributes_(0)
@@ -108,7 +131,7 @@ namespace se
 	{
 	}
 
-	void VertexBuffer::Create(const void* data, uint32_t size, VertexAttributeFlags attributes, BufferUsage usage, bool unorderedAccess)
+	void VertexBuffer::Create(const void* data, uint32_t size, VertexAttributeFlags attributes, BufferUsage usage, bool unorderedAccess, bool quantized)
 	{
 		Assert(!resource_);
 
@@ -148,7 +171,7 @@ namespace se
 		THROW_IF_FAILED(GraphicsCore::GetDevice()->CreateBuffer(&bd, pInit, &buffer));
 
 		resource_ = buffer;
-		stride_ = GetVertexStride(attributes);
+		stride_ = VertexPacker::GetStride(attributes, quantized);
 		attributes_ = attributes;
 
 		// アンオーダードアクセスビューを生成
@@ -163,6 +186,11 @@ namespace se
 		}
 	}
 
+	void VertexBuffer::Update(GraphicsContext& context, const void* data, uint32_t size)
+	{
+		context.UpdateDynamic(*this, data, size);
+	}
+
 	void VertexBuffer::Destroy()
 	{
 		GPUResource::Destroy();
@@ -212,6 +240,175 @@ namespace se
 
 #pragma endregion
 
+#pragma region StructuredBuffer
+
+	StructuredBuffer::StructuredBuffer()
+		: elementSize_(0)
+		, elementCount_(0)
+	{
+	}
+
+	StructuredBuffer::~StructuredBuffer()
+	{
+	}
+
+	void StructuredBuffer::Create(uint32_t elementSize, uint32_t elementCount, const void* data)
+	{
+		Assert(!resource_);
+		Assert(elementSize % 4 == 0 && elementCount > 0);
+
+		D3D11_BUFFER_DESC bd;
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_DEFAULT;
+		bd.ByteWidth = elementSize * elementCount;
+		bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bd.CPUAccessFlags = 0;
+		bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bd.StructureByteStride = elementSize;
+
+		D3D11_SUBRESOURCE_DATA* pInit = nullptr;
+		D3D11_SUBRESOURCE_DATA initData;
+		if (data) {
+			ZeroMemory(&initData, sizeof(initData));
+			initData.pSysMem = data;
+			pInit = &initData;
+		}
+
+		auto* device = GraphicsCore::GetDevice();
+		ID3D11Buffer* buffer;
+		THROW_IF_FAILED(device->CreateBuffer(&bd, pInit, &buffer));
+		resource_ = buffer;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		ZeroMemory(&srvDesc, sizeof(srvDesc));
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = elementCount;
+		THROW_IF_FAILED(device->CreateShaderResourceView(resource_, &srvDesc, &srv_));
+
+		elementSize_ = elementSize;
+		elementCount_ = elementCount;
+	}
+
+	void StructuredBuffer::Update(GraphicsContext& context, const void* data, uint32_t elementCount)
+	{
+		Assert(elementCount <= elementCount_);
+		context.UpdateSubresource(*this, data, elementSize_ * elementCount);
+	}
+
+	void StructuredBuffer::UpdateRange(GraphicsContext& context, const void* data, uint32_t firstElement, uint32_t elementCount)
+	{
+		Assert(firstElement + elementCount <= elementCount_);
+		context.UpdateSubresource(*this, elementSize_ * firstElement, data, elementSize_ * elementCount);
+	}
+
+	void StructuredBuffer::Destroy()
+	{
+		GPUResource::Destroy();
+		elementSize_ = 0;
+		elementCount_ = 0;
+	}
+
+#pragma endregion
+
+#pragma region UploadRing
+
+	UploadRing::UploadRing()
+		: fenceValue_(0)
+	{
+	}
+
+	UploadRing::~UploadRing()
+	{
+		Destroy();
+	}
+
+	void UploadRing::Create(uint32_t size, uint32_t bindFlags)
+	{
+		Assert(!resource_);
+
+		D3D11_BUFFER_DESC bd;
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_DYNAMIC;
+		bd.ByteWidth = size;
+		bd.BindFlags = bindFlags;
+		bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		ID3D11Buffer* buffer;
+		THROW_IF_FAILED(GraphicsCore::GetDevice()->CreateBuffer(&bd, nullptr, &buffer));
+		resource_ = buffer;
+		allocator_.Initialize(size);
+		fenceValue_ = 0;
+	}
+
+	void UploadRing::Destroy()
+	{
+		for (auto& fence : fences_) {
+			COMPTR_RELEASE(fence.query);
+		}
+		for (auto* query : freeQueries_) {
+			COMPTR_RELEASE(query);
+		}
+		fences_.clear();
+		freeQueries_.clear();
+		allocator_.Finalize();
+		GPUResource::Destroy();
+	}
+
+	uint32_t UploadRing::Write(GraphicsContext& context, const void* data, uint32_t size, uint32_t alignment)
+	{
+		if (!resource_) return RingAllocator::InvalidOffset;
+
+		uint32_t allocationSize = (size + alignment - 1) & ~(alignment - 1);
+		uint32_t offset = allocator_.Allocate(allocationSize, alignment);
+		if (offset == RingAllocator::InvalidOffset) return offset;
+		if (!context.UpdateNoOverwrite(*this, offset, data, size)) return RingAllocator::InvalidOffset;
+		return offset;
+	}
+
+	void UploadRing::BeginFrame(GraphicsContext& context)
+	{
+		if (!resource_) return;
+
+		// 発行順に完了を確認し、最後に完了したフェンスまでを解放する(待たずに未完了で止める)
+		uint64_t completed = 0;
+		auto* deviceContext = context.GetDeviceContext();
+		while (!fences_.empty()) {
+			Fence& fence = fences_.front();
+			BOOL done = FALSE;
+			if (deviceContext->GetData(fence.query, &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || !done) break;
+			completed = fence.value;
+			freeQueries_.push_back(fence.query);
+			fences_.pop_front();
+		}
+		if (completed > 0) {
+			allocator_.Retire(completed);
+		}
+	}
+
+	void UploadRing::EndFrame(GraphicsContext& context)
+	{
+		if (!resource_) return;
+
+		Fence fence;
+		if (freeQueries_.empty()) {
+			D3D11_QUERY_DESC desc;
+			desc.Query = D3D11_QUERY_EVENT;
+			desc.MiscFlags = 0;
+			THROW_IF_FAILED(GraphicsCore::GetDevice()->CreateQuery(&desc, &fence.query));
+		} else {
+			fence.query = freeQueries_.back();
+			freeQueries_.pop_back();
+		}
+		fence.value = ++fenceValue_;
+		context.GetDeviceContext()->End(fence.query);
+		fences_.push_back(fence);
+		allocator_.EndFrame(fence.value);
+	}
+
+#pragma endregion
+
 #pragma region PixelBuffer
 
 	PixelBuffer::PixelBuffer()
@@ -7,6 +7,9 @@
 
 #include "engine/Graphics/GraphicsCommon.h"
 #include "engine/Graphics/GraphicsContext.h"
+#include "engine/Graphics/RingAllocator.h"
+#include <deque>
+#include <vector>
 
 namespace se
 {
@@ -29,14 +32,22 @@ namespace se
 
 	/**
 	 * コンスタントバッファ
+	 * GraphicsCoreのコンスタントリングが使える場合はUpdate()の内容をリングに書き込み、範囲を指定して設定する
+	 * リングに書き込んだ内容はそのフレームのみ有効なので、毎フレームUpdate()すること(IsTransient())
 	 */
 	class ConstantBuffer
 	{
 		friend class GraphicsContext;
 
 	private:
-		ID3D11Buffer* buffer_;
+		ID3D11Buffer* buffer_;		// リングを使えなかった場合に作成する専用のバッファ
 		uint32_t size_;
+		BufferUsage usage_;
+		ID3D11Buffer* ringBuffer_;
+		uint32_t ringOffset_;		// リング内の位置(RingAllocator::InvalidOffset: 専用のバッファを使う)
+
+	private:
+		void CreateBuffer();
 
 	public:
 		ConstantBuffer();
@@ -44,6 +55,10 @@ namespace se
 
 		void Create(uint32_t size, BufferUsage usage);
 		void Update(GraphicsContext& context, const void* data, uint32_t size);
+		void Destroy();
+
+		bool IsTransient() const { return ringOffset_ != RingAllocator::InvalidOffset; }
+		uint32_t GetConstantCount() const;		// リングで設定する定数の数(16バイト単位)
 	};
 
 
@@ -85,7 +100,8 @@ namespace se
 		VertexBuffer();
 		virtual ~VertexBuffer();
 
-		void Create(const void* data, uint32_t size, VertexAttributeFlags attributes, BufferUsage usage = BUFFER_USAGE_IMMUTABLE, bool unorderedAccess = false);
+		void Create(const void* data, uint32_t size, VertexAttributeFlags attributes, BufferUsage usage = BUFFER_USAGE_IMMUTABLE, bool unorderedAccess = false, bool quantized = false);
+		void Update(GraphicsContext& context, const void* data, uint32_t size);		// BUFFER_USAGE_DYNAMICで作成したもののみ
 		virtual void Destroy() override;
 
 		uint32_t GetStride() const { return stride_; }
@@ -116,6 +132,72 @@ namespace se
 	};
 
 
+	/**
+	 * 構造化バッファ
+	 * シェーダからStructuredBuffer<T>として読み込む
+	 */
+	class StructuredBuffer : public GPUResource
+	{
+	private:
+		uint32_t elementSize_;
+		uint32_t elementCount_;
+
+	public:
+		StructuredBuffer();
+		virtual ~StructuredBuffer();
+
+		void Create(uint32_t elementSize, uint32_t elementCount, const void* data = nullptr);
+		void Update(GraphicsContext& context, const void* data, uint32_t elementCount);
+		// firstElementからelementCount分を更新(dataは更新する範囲の先頭)
+		void UpdateRange(GraphicsContext& context, const void* data, uint32_t firstElement, uint32_t elementCount);
+		virtual void Destroy() override;
+
+		uint32_t GetElementSize() const { return elementSize_; }
+		uint32_t GetElementCount() const { return elementCount_; }
+	};
+
+
+	/**
+	 * フレーム毎に書き換えるデータ用の動的バッファ
+	 * 1本のD3D11_USAGE_DYNAMICのバッファからRingAllocatorで切り出し、MAP_WRITE_NO_OVERWRITEで追記する
+	 * フレームの終わりにイベントクエリを発行し、GPUが完了したフレームの領域を次のBeginFrame()で再利用する
+	 */
+	class UploadRing : public GPUResource
+	{
+	public:
+		static const uint32_t VertexAlignment = 16;
+		static const uint32_t ConstantAlignment = 256;		// VSSetConstantBuffers1のオフセットは16定数単位
+
+	private:
+		struct Fence
+		{
+			ID3D11Query* query;
+			uint64_t value;
+		};
+
+		RingAllocator allocator_;
+		std::deque<Fence> fences_;				// 発行順
+		std::vector<ID3D11Query*> freeQueries_;
+		uint64_t fenceValue_;
+
+	public:
+		UploadRing();
+		virtual ~UploadRing();
+
+		// bindFlagsはD3D11_BIND_VERTEX_BUFFER等(D3D11_BIND_CONSTANT_BUFFERは他と組み合わせられない)
+		void Create(uint32_t size, uint32_t bindFlags);
+		virtual void Destroy() override;
+
+		// dataをalignment単位で確保した領域に書き込み、位置を返す(空きがなければRingAllocator::InvalidOffset)
+		uint32_t Write(GraphicsContext& context, const void* data, uint32_t size, uint32_t alignment);
+
+		void BeginFrame(GraphicsContext& context);		// GPUが完了したフレームの領域を解放する
+		void EndFrame(GraphicsContext& context);		// このフレームの書き込みを締めてフェンスを発行する
+
+		const RingAllocator::Stats& GetStats() const { return allocator_.GetStats(); }
+	};
+
+
 	/**
 	 * ピクセルバッファ
 	 */
@@ -238,7 +320,8 @@ namespace se
 				resource_.Create(sizeof(T), BUFFER_USAGE_DEFAULT);
 				isCreated_ = true;
 			}
-			if (isUpdated_ || forceUpdate) {
+			// リングに書き込んだ内容は前のフレームのものなので毎回書き込む
+			if (isUpdated_ || forceUpdate || resource_.IsTransient()) {
 				resource_.Update(context, &contents_, sizeof(T));
 				isUpdated_ = false;
 			}
@@ -0,0 +1,245 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/GeometryCacheFile.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+namespace se
+{
+	namespace
+	{
+		// ファイル内のレイアウト
+		// FileHeader, SubMeshRecord[subMeshCount], StreamRecord[streamCount], データ(Alignment単位)
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			uint64_t fileSize;
+			uint32_t subMeshCount;
+			uint32_t streamCount;
+		};
+
+		struct SubMeshRecord
+		{
+			uint64_t contentHash;
+			uint32_t attributes;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t indexStride;
+			uint32_t flags;
+			uint32_t streamBegin;
+			uint32_t streamCount;
+			uint32_t userDataSize;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint64_t indexOffset;
+			uint64_t userDataOffset;
+		};
+
+		struct StreamRecord
+		{
+			uint32_t attribute;
+			uint32_t components;
+			uint32_t stride;
+			uint32_t flags;
+			uint64_t offset;
+		};
+
+		inline uint64_t Align(uint64_t offset)
+		{
+			return (offset + GeometryCacheFile::Alignment - 1) & ~static_cast<uint64_t>(GeometryCacheFile::Alignment - 1);
+		}
+
+		// [offset, offset + size)がファイル内に収まっていて、先頭がアライメントされているか
+		inline bool InRange(uint64_t offset, uint64_t size, uint64_t fileSize)
+		{
+			return (offset & (GeometryCacheFile::Alignment - 1)) == 0 && offset <= fileSize && size <= fileSize - offset;
+		}
+	}
+
+	GeometryCacheFile::GeometryCacheFile()
+		: key_(0)
+	{
+	}
+
+	bool GeometryCacheFile::Write(const char* path, uint64_t key, const GeometryCacheSubMesh* subMeshes, uint32_t subMeshCount, uint64_t* fileSize)
+	{
+		// レコードとデータの配置を決める
+		std::vector<SubMeshRecord> subMeshRecords(subMeshCount);
+		std::vector<StreamRecord> streamRecords;
+		uint32_t streamCount = 0;
+		for (uint32_t i = 0; i < subMeshCount; i++) {
+			streamCount += static_cast<uint32_t>(subMeshes[i].streams.size());
+		}
+		streamRecords.resize(streamCount);
+
+		uint64_t offset = sizeof(FileHeader) + sizeof(SubMeshRecord) * subMeshCount + sizeof(StreamRecord) * streamCount;
+		uint32_t streamIndex = 0;
+		for (uint32_t i = 0; i < subMeshCount; i++) {
+			const GeometryCacheSubMesh& subMesh = subMeshes[i];
+			SubMeshRecord& record = subMeshRecords[i];
+			memset(&record, 0, sizeof(record));
+			record.contentHash = subMesh.contentHash;
+			record.attributes = subMesh.attributes;
+			record.vertexCount = subMesh.vertexCount;
+			record.indexCount = subMesh.indexCount;
+			record.indexStride = subMesh.indexStride;
+			record.flags = subMesh.flags;
+			record.streamBegin = streamIndex;
+			record.streamCount = static_cast<uint32_t>(subMesh.streams.size());
+			record.userDataSize = subMesh.userDataSize;
+			memcpy(record.boundsMin, subMesh.boundsMin, sizeof(record.boundsMin));
+			memcpy(record.boundsMax, subMesh.boundsMax, sizeof(record.boundsMax));
+
+			offset = Align(offset);
+			record.indexOffset = offset;
+			offset += static_cast<uint64_t>(subMesh.indexStride) * subMesh.indexCount;
+			offset = Align(offset);
+			record.userDataOffset = offset;
+			offset += subMesh.userDataSize;
+
+			for (const auto& stream : subMesh.streams) {
+				StreamRecord& streamRecord = streamRecords[streamIndex++];
+				memset(&streamRecord, 0, sizeof(streamRecord));
+				streamRecord.attribute = stream.attribute;
+				streamRecord.components = stream.components;
+				streamRecord.stride = stream.stride;
+				streamRecord.flags = stream.flags;
+				offset = Align(offset);
+				streamRecord.offset = offset;
+				offset += static_cast<uint64_t>(stream.stride) * subMesh.vertexCount;
+			}
+		}
+
+		FileHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = Magic;
+		header.version = Version;
+		header.key = key;
+		header.fileSize = offset;
+		header.subMeshCount = subMeshCount;
+		header.streamCount = streamCount;
+
+		// 書き出し
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		if (!stream) return false;
+
+		uint64_t position = 0;
+		auto write = [&](const void* data, uint64_t size) {
+			stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			position += size;
+		};
+		auto pad = [&](uint64_t target) {
+			static const char zero[Alignment] = {};
+			while (position < target) {
+				write(zero, std::min<uint64_t>(target - position, Alignment));
+			}
+		};
+		write(&header, sizeof(header));
+		write(subMeshRecords.data(), sizeof(SubMeshRecord) * subMeshRecords.size());
+		write(streamRecords.data(), sizeof(StreamRecord) * streamRecords.size());
+		streamIndex = 0;
+		for (uint32_t i = 0; i < subMeshCount; i++) {
+			const GeometryCacheSubMesh& subMesh = subMeshes[i];
+			const SubMeshRecord& record = subMeshRecords[i];
+			pad(record.indexOffset);
+			write(subMesh.indices, static_cast<uint64_t>(subMesh.indexStride) * subMesh.indexCount);
+			pad(record.userDataOffset);
+			write(subMesh.userData, subMesh.userDataSize);
+			for (const auto& s : subMesh.streams) {
+				pad(streamRecords[streamIndex++].offset);
+				write(s.data, static_cast<uint64_t>(s.stride) * subMesh.vertexCount);
+			}
+		}
+		stream.close();
+		if (stream.fail() || position != header.fileSize) return false;
+
+		if (fileSize) *fileSize = header.fileSize;
+		return true;
+	}
+
+	bool GeometryCacheFile::Open(const char* path, uint64_t key)
+	{
+		Close();
+		if (!file_.Open(path)) return false;
+
+		const uint8_t* data = file_.Data();
+		uint64_t fileSize = file_.Size();
+		if (fileSize < sizeof(FileHeader)) {
+			Close();
+			return false;
+		}
+
+		// ヘッダの照合
+		FileHeader header;
+		memcpy(&header, data, sizeof(header));
+		uint64_t recordsSize = sizeof(SubMeshRecord) * static_cast<uint64_t>(header.subMeshCount)
+			+ sizeof(StreamRecord) * static_cast<uint64_t>(header.streamCount);
+		if (header.magic != Magic || header.version != Version || header.key != key || header.fileSize != fileSize
+			|| !InRange(sizeof(FileHeader), recordsSize, fileSize)) {
+			Close();
+			return false;
+		}
+
+		const SubMeshRecord* subMeshRecords = reinterpret_cast<const SubMeshRecord*>(data + sizeof(FileHeader));
+		const StreamRecord* streamRecords = reinterpret_cast<const StreamRecord*>(subMeshRecords + header.subMeshCount);
+
+		// 各データがファイル内に収まっているか確認しながらマップ領域を指す
+		subMeshes_.resize(header.subMeshCount);
+		for (uint32_t i = 0; i < header.subMeshCount; i++) {
+			const SubMeshRecord& record = subMeshRecords[i];
+			GeometryCacheSubMesh& subMesh = subMeshes_[i];
+			uint64_t indexSize = static_cast<uint64_t>(record.indexStride) * record.indexCount;
+			if (!InRange(record.indexOffset, indexSize, fileSize)
+				|| !InRange(record.userDataOffset, record.userDataSize, fileSize)
+				|| record.streamBegin > header.streamCount || record.streamCount > header.streamCount - record.streamBegin) {
+				Close();
+				return false;
+			}
+
+			subMesh.contentHash = record.contentHash;
+			subMesh.attributes = record.attributes;
+			subMesh.vertexCount = record.vertexCount;
+			subMesh.indexCount = record.indexCount;
+			subMesh.indexStride = record.indexStride;
+			subMesh.flags = record.flags;
+			memcpy(subMesh.boundsMin, record.boundsMin, sizeof(subMesh.boundsMin));
+			memcpy(subMesh.boundsMax, record.boundsMax, sizeof(subMesh.boundsMax));
+			subMesh.indices = data + record.indexOffset;
+			subMesh.userData = data + record.userDataOffset;
+			subMesh.userDataSize = record.userDataSize;
+
+			subMesh.streams.resize(record.streamCount);
+			for (uint32_t j = 0; j < record.streamCount; j++) {
+				const StreamRecord& streamRecord = streamRecords[record.streamBegin + j];
+				uint64_t streamSize = static_cast<uint64_t>(streamRecord.stride) * record.vertexCount;
+				if (!InRange(streamRecord.offset, streamSize, fileSize)) {
+					Close();
+					return false;
+				}
+
+				GeometryCacheStream& stream = subMesh.streams[j];
+				stream.attribute = streamRecord.attribute;
+				stream.components = streamRecord.components;
+				stream.stride = streamRecord.stride;
+				stream.flags = streamRecord.flags;
+				stream.data = data + streamRecord.offset;
+			}
+		}
+
+		key_ = key;
+		return true;
+	}
+
+	void GeometryCacheFile::Close()
+	{
+		subMeshes_.clear();
+		file_.Close();
+		key_ = 0;
+	}
+}
\ No newline at end of file
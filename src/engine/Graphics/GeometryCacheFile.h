@@ -0,0 +1,77 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Core/MappedFile.h"
+#include <cstdint>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * キャッシュファイル内の頂点ストリーム
+	 */
+	struct GeometryCacheStream
+	{
+		uint32_t attribute;			// VertexAttributeFlags
+		uint32_t components;
+		uint32_t stride;			// 1頂点あたりのバイト数
+		uint32_t flags;				// 呼び出し側で定義するフラグ
+		const void* data;			// stride * 頂点数
+	};
+
+	/**
+	 * キャッシュファイル内のサブメッシュ
+	 */
+	struct GeometryCacheSubMesh
+	{
+		uint64_t contentHash;
+		uint32_t attributes;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t indexStride;		// インデックス1つあたりのバイト数(2 or 4)
+		uint32_t flags;				// 呼び出し側で定義するフラグ
+		float boundsMin[3];
+		float boundsMax[3];
+		const void* indices;		// indexStride * indexCount
+		const void* userData;		// 呼び出し側で定義する付加情報
+		uint32_t userDataSize;
+		std::vector<GeometryCacheStream> streams;
+	};
+
+	/**
+	 * 加工済みジオメトリのキャッシュファイル
+	 * 読み込みはファイルをメモリにマップし、各データはマップ領域を直接指す(コピーしない)
+	 * プラットフォームのグラフィックスAPIには依存しない
+	 */
+	class GeometryCacheFile
+	{
+	public:
+		static const uint32_t Magic = 0x31434753;		// "SGC1"
+		static const uint32_t Version = 1;
+		static const uint32_t Alignment = 16;			// 各データの先頭のアライメント
+
+	private:
+		MappedFile file_;
+		uint64_t key_;
+		std::vector<GeometryCacheSubMesh> subMeshes_;
+
+	public:
+		GeometryCacheFile();
+
+		// 書き出し(keyは読み込み時の照合に使う)
+		static bool Write(const char* path, uint64_t key, const GeometryCacheSubMesh* subMeshes, uint32_t subMeshCount, uint64_t* fileSize = nullptr);
+
+		// 読み込み(keyが一致しない場合、内容が壊れている場合は失敗)
+		bool Open(const char* path, uint64_t key);
+		void Close();
+
+		uint64_t GetKey() const { return key_; }
+		const uint8_t* GetData() const { return file_.Data(); }
+		size_t GetSize() const { return file_.Size(); }
+		const std::vector<GeometryCacheSubMesh>& GetSubMeshes() const { return subMeshes_; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Core/Hash.h"
+#include <string>
+
+namespace se
+{
+	/**
+	 * ディスクキャッシュのキーの組み立て
+	 * キーはセッションをまたいで照合するので、内容(値、バイト列、名前)のみを連結する
+	 * アドレスは実行毎に変わるため、ポインタを渡すとコンパイルエラーにする
+	 */
+	class GeometryCacheKey
+	{
+	private:
+		uint64_t hash_;
+
+	public:
+		explicit GeometryCacheKey(uint64_t seed = 0) : hash_(seed) {}
+
+		void Add(uint64_t value) { hash_ = HashCombine(hash_, value); }
+		void Add(const void* data, size_t size) { hash_ = HashCombine(hash_, Hash64(data, size)); }
+		void Add(const std::string& text) { Add(text.data(), text.size()); }
+		template <class T> void Add(const T* pointer) = delete;
+
+		uint64_t Get() const { return hash_; }
+		// 0はキャッシュを使わない印なので避ける
+		uint64_t GetDiskCacheKey() const { return (hash_ != 0) ? hash_ : 1; }
+	};
+}
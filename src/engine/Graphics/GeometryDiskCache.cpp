@@ -0,0 +1,375 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/GeometryDiskCache.h"
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace se
+{
+	namespace
+	{
+		const char* FileExtension = ".sgc";
+		const char* IndexFileName = "index.bin";
+		const uint32_t IndexMagic = 0x31494753;		// "SGI1"
+
+		struct IndexRecord
+		{
+			uint64_t key;
+			uint64_t lastUse;
+		};
+
+#ifdef _WIN32
+		const char PathSeparator = '\\';
+
+		bool MakeDirectory(const std::string& path)
+		{
+			return ::CreateDirectoryA(path.c_str(), nullptr) || ::GetLastError() == ERROR_ALREADY_EXISTS;
+		}
+
+		bool RenameFile(const std::string& from, const std::string& to)
+		{
+			return ::MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+		}
+
+		// 削除できた、または既にない
+		bool RemoveFile(const std::string& path)
+		{
+			if (::DeleteFileA(path.c_str())) return true;
+			DWORD error = ::GetLastError();
+			return error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND;
+		}
+
+		// ディレクトリ内のキャッシュファイル(名前、サイズ)を列挙
+		template <class Func>
+		void ListFiles(const std::string& directory, Func func)
+		{
+			WIN32_FIND_DATAA data;
+			HANDLE find = ::FindFirstFileA((directory + PathSeparator + "*" + FileExtension).c_str(), &data);
+			if (find == INVALID_HANDLE_VALUE) return;
+			do {
+				if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+				uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+				func(std::string(data.cFileName), size);
+			} while (::FindNextFileA(find, &data));
+			::FindClose(find);
+		}
+#else
+		const char PathSeparator = '/';
+
+		bool MakeDirectory(const std::string& path)
+		{
+			struct stat st;
+			return ::mkdir(path.c_str(), 0755) == 0 || (::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+		}
+
+		bool RenameFile(const std::string& from, const std::string& to)
+		{
+			return ::rename(from.c_str(), to.c_str()) == 0;
+		}
+
+		bool RemoveFile(const std::string& path)
+		{
+			return ::unlink(path.c_str()) == 0 || errno == ENOENT;
+		}
+
+		template <class Func>
+		void ListFiles(const std::string& directory, Func func)
+		{
+			DIR* dir = ::opendir(directory.c_str());
+			if (!dir) return;
+			size_t extLength = strlen(FileExtension);
+			while (dirent* entry = ::readdir(dir)) {
+				std::string name = entry->d_name;
+				if (name.size() <= extLength || name.compare(name.size() - extLength, extLength, FileExtension) != 0) continue;
+				struct stat st;
+				if (::stat((directory + PathSeparator + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+				func(name, static_cast<uint64_t>(st.st_size));
+			}
+			::closedir(dir);
+		}
+#endif
+
+		// キー -> 16桁の16進数
+		std::string FormatKey(uint64_t key)
+		{
+			static const char digits[] = "0123456789abcdef";
+			std::string text(16, '0');
+			for (size_t i = 0; i < 16; i++) {
+				text[15 - i] = digits[(key >> (i * 4)) & 0xf];
+			}
+			return text;
+		}
+
+		// "0123456789abcdef.sgc" -> キー
+		bool ParseFileName(const std::string& name, uint64_t* key)
+		{
+			if (name.size() != 16 + strlen(FileExtension)) return false;
+			uint64_t value = 0;
+			for (size_t i = 0; i < 16; i++) {
+				char c = name[i];
+				uint32_t digit;
+				if (c >= '0' && c <= '9') digit = c - '0';
+				else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+				else return false;
+				value = (value << 4) | digit;
+			}
+			*key = value;
+			return true;
+		}
+	}
+
+	GeometryDiskCache::GeometryDiskCache()
+		: capacity_(0)
+		, totalBytes_(0)
+		, clock_(0)
+		, tempCounter_(0)
+		, lookups_(0)
+		, hits_(0)
+	{
+	}
+
+	GeometryDiskCache::~GeometryDiskCache()
+	{
+		Finalize();
+	}
+
+	std::string GeometryDiskCache::GetPath(uint64_t key) const
+	{
+		return directory_ + PathSeparator + FormatKey(key) + FileExtension;
+	}
+
+	bool GeometryDiskCache::Initialize(const char* directory, uint64_t capacity)
+	{
+		Finalize();
+		if (!MakeDirectory(directory)) return false;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		directory_ = directory;
+		capacity_ = capacity;
+		Scan();
+		LoadIndex();
+		Evict(0);
+		return true;
+	}
+
+	void GeometryDiskCache::Finalize()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (directory_.empty()) return;
+
+		SaveIndex();
+		directory_.clear();
+		entries_.clear();
+		totalBytes_ = 0;
+		clock_ = 0;
+	}
+
+	void GeometryDiskCache::Scan()
+	{
+		// 実際にあるファイルを正とする(前回異常終了してインデックスに載っていないものも含める)
+		entries_.clear();
+		totalBytes_ = 0;
+		ListFiles(directory_, [this](const std::string& name, uint64_t size) {
+			uint64_t key;
+			if (!ParseFileName(name, &key)) return;
+			Entry& entry = entries_[key];
+			entry.size = size;
+			entry.lastUse = 0;
+			entry.removing = false;
+			totalBytes_ += size;
+		});
+	}
+
+	void GeometryDiskCache::LoadIndex()
+	{
+		// 前回までの使用順を復元
+		std::ifstream stream(directory_ + PathSeparator + IndexFileName, std::ios::binary | std::ios::ate);
+		if (!stream) return;
+		uint64_t fileSize = static_cast<uint64_t>(stream.tellg());
+		stream.seekg(0);
+
+		// 壊れたインデックスで巨大な領域を確保しないよう、レコード数をファイルサイズと照合する
+		uint32_t header[2] = {};
+		stream.read(reinterpret_cast<char*>(header), sizeof(header));
+		if (!stream || header[0] != IndexMagic || fileSize != sizeof(header) + sizeof(IndexRecord) * static_cast<uint64_t>(header[1])) return;
+
+		std::vector<IndexRecord> records(header[1]);
+		stream.read(reinterpret_cast<char*>(records.data()), sizeof(IndexRecord) * records.size());
+		if (!stream) return;
+
+		for (const auto& record : records) {
+			auto it = entries_.find(record.key);
+			if (it == entries_.end()) continue;
+			it->second.lastUse = record.lastUse;
+			clock_ = (std::max)(clock_, record.lastUse);
+		}
+	}
+
+	void GeometryDiskCache::SaveIndex()
+	{
+		std::vector<IndexRecord> records;
+		records.reserve(entries_.size());
+		for (const auto& pair : entries_) {
+			IndexRecord record = { pair.first, pair.second.lastUse };
+			records.push_back(record);
+		}
+
+		std::ofstream stream(directory_ + PathSeparator + IndexFileName, std::ios::binary | std::ios::trunc);
+		if (!stream) return;
+		uint32_t header[2] = { IndexMagic, static_cast<uint32_t>(records.size()) };
+		stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(records.data()), sizeof(IndexRecord) * records.size());
+	}
+
+	bool GeometryDiskCache::Remove(uint64_t key)
+	{
+		auto it = entries_.find(key);
+		if (it == entries_.end()) return true;
+
+		// 削除できなければディスク上に残っているので、サイズは計上したままにする
+		if (!RemoveFile(GetPath(key))) {
+			it->second.removing = true;
+			return false;
+		}
+		totalBytes_ -= it->second.size;
+		entries_.erase(it);
+		return true;
+	}
+
+	void GeometryDiskCache::Evict(uint64_t reserve)
+	{
+		if (totalBytes_ + reserve <= capacity_) return;
+
+		// 削除に失敗したもの、古いものの順に上限に収まるまで削除
+		std::vector<std::pair<uint64_t, uint64_t>> order;		// (lastUse, key)
+		order.reserve(entries_.size());
+		for (const auto& pair : entries_) {
+			order.push_back(std::make_pair(pair.second.removing ? 0 : pair.second.lastUse, pair.first));
+		}
+		std::sort(order.begin(), order.end());
+		for (const auto& item : order) {
+			if (totalBytes_ + reserve <= capacity_) break;
+			Remove(item.second);
+		}
+	}
+
+	void GeometryDiskCache::SetCapacity(uint64_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		capacity_ = capacity;
+		if (!directory_.empty()) {
+			Evict(0);
+		}
+	}
+
+	std::shared_ptr<const GeometryCacheFile> GeometryDiskCache::Find(uint64_t key)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (directory_.empty()) return nullptr;
+
+		lookups_++;
+		auto it = entries_.find(key);
+		if (it == entries_.end() || it->second.removing) return nullptr;
+
+		auto file = std::make_shared<GeometryCacheFile>();
+		if (!file->Open(GetPath(key).c_str(), key)) {
+			// 壊れている、または古い形式のものは削除
+			Remove(key);
+			return nullptr;
+		}
+		it->second.lastUse = ++clock_;
+		hits_++;
+		return file;
+	}
+
+	bool GeometryDiskCache::Store(uint64_t key, const GeometryCacheSubMesh* subMeshes, uint32_t subMeshCount)
+	{
+		std::string path;
+		std::string tempPath;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (directory_.empty()) return false;
+			path = GetPath(key);
+			tempPath = path + "." + FormatKey(++tempCounter_) + ".tmp";
+		}
+
+		// 書き出しはロックの外で一時ファイルに行い、置き換える
+		uint64_t size = 0;
+		if (!GeometryCacheFile::Write(tempPath.c_str(), key, subMeshes, subMeshCount, &size)) {
+			std::remove(tempPath.c_str());
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (directory_.empty() || size > capacity_) {
+			std::remove(tempPath.c_str());
+			return false;
+		}
+		// 置き換え対象は追い出しの対象から外す
+		Entry previous = { 0, 0, false };
+		auto it = entries_.find(key);
+		bool replace = (it != entries_.end());
+		if (replace) {
+			previous = it->second;
+			totalBytes_ -= previous.size;
+			entries_.erase(it);
+		}
+		Evict(size);
+		if (!RenameFile(tempPath, path)) {
+			// マップ中などで置き換えられなかった場合は元のファイルを使い続ける
+			std::remove(tempPath.c_str());
+			if (replace) {
+				entries_[key] = previous;
+				totalBytes_ += previous.size;
+			}
+			return false;
+		}
+
+		Entry& entry = entries_[key];
+		entry.size = size;
+		entry.lastUse = ++clock_;
+		entry.removing = false;
+		totalBytes_ += size;
+		return true;
+	}
+
+	void GeometryDiskCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::vector<uint64_t> keys;
+		keys.reserve(entries_.size());
+		for (const auto& pair : entries_) {
+			keys.push_back(pair.first);
+		}
+		for (uint64_t key : keys) {
+			Remove(key);
+		}
+		clock_ = 0;
+	}
+
+	uint64_t GeometryDiskCache::GetTotalBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return totalBytes_;
+	}
+
+	uint32_t GeometryDiskCache::GetEntryCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return static_cast<uint32_t>(entries_.size());
+	}
+}
\ No newline at end of file
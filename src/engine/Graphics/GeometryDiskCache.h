@@ -0,0 +1,86 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Graphics/GeometryCacheFile.h"
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace se
+{
+	/**
+	 * 加工済みジオメトリのディスクキャッシュ
+	 * キー毎に1つのGeometryCacheFileとしてディレクトリに保存する
+	 * 合計サイズが上限を超えたら最後に使われたのが古いものから削除する(LRU)
+	 * 削除できなかったファイル(Windowsでマップ中など)はサイズを計上したまま残し、次の追い出しで優先して削除し直す
+	 * 使用順はインデックスファイルに保存し、次回起動時に引き継ぐ
+	 * 書き込みはワーカースレッドからも行えるように排他する
+	 */
+	class GeometryDiskCache
+	{
+	public:
+		static GeometryDiskCache& Get() {
+			static GeometryDiskCache instance;
+			return instance;
+		}
+
+	private:
+		struct Entry
+		{
+			uint64_t size;
+			uint64_t lastUse;		// 使用順(大きいほど新しい)
+			bool removing;			// 削除に失敗した(検索では見つからない扱い)
+		};
+
+	private:
+		std::string directory_;
+		uint64_t capacity_;
+		uint64_t totalBytes_;
+		uint64_t clock_;
+		uint64_t tempCounter_;		// 書き込み中の一時ファイル名
+		std::unordered_map<uint64_t, Entry> entries_;
+		mutable std::mutex mutex_;
+		uint64_t lookups_;
+		uint64_t hits_;
+
+	private:
+		std::string GetPath(uint64_t key) const;
+		void Scan();
+		void LoadIndex();
+		void SaveIndex();
+		void Evict(uint64_t reserve);
+		bool Remove(uint64_t key);
+
+	public:
+		GeometryDiskCache();
+		~GeometryDiskCache();
+
+		// directoryが存在しなければ作成する
+		bool Initialize(const char* directory, uint64_t capacity);
+		void Finalize();
+		bool IsEnabled() const { return !directory_.empty(); }
+
+		void SetCapacity(uint64_t capacity);
+		uint64_t GetCapacity() const { return capacity_; }
+
+		// キーに一致するファイルをマップして返す(なければnullptr)
+		std::shared_ptr<const GeometryCacheFile> Find(uint64_t key);
+
+		// 書き込み(既にあれば置き換える)
+		bool Store(uint64_t key, const GeometryCacheSubMesh* subMeshes, uint32_t subMeshCount);
+
+		// 全て削除
+		void Clear();
+
+		uint64_t GetLookupCount() const { return lookups_; }
+		uint64_t GetHitCount() const { return hits_; }
+		uint64_t GetTotalBytes() const;
+		uint32_t GetEntryCount() const;
+	};
+}
\ No newline at end of file
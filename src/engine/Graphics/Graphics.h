@@ -14,4 +14,12 @@
 #include "engine/Graphics/GraphicsStates.h"
 #include "engine/Graphics/GPUBuffer.h"
 #include "engine/Graphics/Shader.h"
-#include "engine/Graphics/ShaderConstants.h"
\ No newline at end of file
+#include "engine/Graphics/ShaderConstants.h"
+#include "engine/Graphics/InstanceBatch.h"
+#include "engine/Graphics/ObjectParameterTable.h"
+#include "engine/Graphics/RenderQueue.h"
+#include "engine/Graphics/ParallelSubmit.h"
+#include "engine/Graphics/DeferredCommandLists.h"
+#include "engine/Graphics/VertexPacker.h"
+#include "engine/Graphics/VertexQuantizer.h"
+#include "engine/Graphics/MeshOptimizer.h"
\ No newline at end of file
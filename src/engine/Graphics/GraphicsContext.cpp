@@ -10,19 +10,121 @@
 
 namespace se
 {
+#pragma region D3D11StateDevice
+
+	void D3D11StateDevice::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		deviceContext_->VSSetShader(shader, nullptr, 0);
+	}
+
+	void D3D11StateDevice::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		deviceContext_->PSSetShader(shader, nullptr, 0);
+	}
+
+	void D3D11StateDevice::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		deviceContext_->IASetInputLayout(layout);
+	}
+
+	void D3D11StateDevice::SetPrimitiveTopology(uint32_t topology)
+	{
+		deviceContext_->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology));
+	}
+
+	void D3D11StateDevice::SetBlendState(ID3D11BlendState* state)
+	{
+		deviceContext_->OMSetBlendState(state, 0, 0xFFFFFFFF);
+	}
+
+	void D3D11StateDevice::SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef)
+	{
+		deviceContext_->OMSetDepthStencilState(state, stencilRef);
+	}
+
+	void D3D11StateDevice::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		deviceContext_->RSSetState(state);
+	}
+
+	void D3D11StateDevice::SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset)
+	{
+		deviceContext_->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+	}
+
+	void D3D11StateDevice::SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format)
+	{
+		deviceContext_->IASetIndexBuffer(buffer, static_cast<DXGI_FORMAT>(format), 0);
+	}
+
+	void D3D11StateDevice::SetVSResource(uint32_t slot, ID3D11ShaderResourceView* srv)
+	{
+		deviceContext_->VSSetShaderResources(slot, 1, &srv);
+	}
+
+	void D3D11StateDevice::SetPSResource(uint32_t slot, ID3D11ShaderResourceView* srv)
+	{
+		deviceContext_->PSSetShaderResources(slot, 1, &srv);
+	}
+
+	void D3D11StateDevice::SetPSSamplerState(uint32_t slot, ID3D11SamplerState* sampler)
+	{
+		deviceContext_->PSSetSamplers(slot, 1, &sampler);
+	}
+
+	void D3D11StateDevice::SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+	{
+		if (constantCount > 0) {
+			deviceContext1_->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+		} else {
+			deviceContext_->VSSetConstantBuffers(slot, 1, &buffer);
+		}
+	}
+
+	void D3D11StateDevice::SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+	{
+		if (constantCount > 0) {
+			deviceContext1_->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+		} else {
+			deviceContext_->PSSetConstantBuffers(slot, 1, &buffer);
+		}
+	}
+
+	void D3D11StateDevice::SetCSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+	{
+		if (constantCount > 0) {
+			deviceContext1_->CSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+		} else {
+			deviceContext_->CSSetConstantBuffers(slot, 1, &buffer);
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region GraphicsContext
+
 	GraphicsContext::GraphicsContext()
 		: deviceContext_(nullptr)
+		, deviceContext1_(nullptr)
 	{
+		stateFilter_.SetDevice(&stateDevice_);
 	}
 
 	GraphicsContext::~GraphicsContext()
 	{
+		COMPTR_RELEASE(deviceContext1_);
 		COMPTR_RELEASE(deviceContext_);
 	}
 
 	void GraphicsContext::Initialize(ID3D11DeviceContext* context)
 	{
 		deviceContext_ = context;
+		if (FAILED(context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&deviceContext1_)))) {
+			deviceContext1_ = nullptr;
+		}
+		stateDevice_.SetDeviceContext(context, deviceContext1_);
+		stateFilter_.Invalidate();
 	}
 
 	void GraphicsContext::Finalize()
@@ -30,7 +132,16 @@ namespace se
 		if (deviceContext_) {
 			deviceContext_->ClearState();
 		}
+		COMPTR_RELEASE(deviceContext1_);
 		COMPTR_RELEASE(deviceContext_);
+		stateDevice_.SetDeviceContext(nullptr, nullptr);
+		stateFilter_.Invalidate();
+	}
+
+	void GraphicsContext::ClearState()
+	{
+		deviceContext_->ClearState();
+		stateFilter_.Invalidate();
 	}
 
 	void GraphicsContext::SetRenderTarget(const ColorBuffer* colorBuffers, uint32_t count, const DepthStencilBuffer* depthStencil)
@@ -57,27 +168,27 @@ namespace se
 
 	void GraphicsContext::SetVertexShader(const VertexShader& shader)
 	{
-		deviceContext_->VSSetShader(shader.Get(), nullptr, 0);
+		stateFilter_.SetVertexShader(shader.Get());
 	}
 
 	void GraphicsContext::SetPixelShader(const PixelShader& shader)
 	{
-		deviceContext_->PSSetShader(shader.Get(), nullptr, 0);
+		stateFilter_.SetPixelShader(shader.Get());
 	}
 
 	void GraphicsContext::SetBlendState(const BlendState& blend)
 	{
-		deviceContext_->OMSetBlendState(blend.state_, 0, 0xFFFFFFFF);
+		stateFilter_.SetBlendState(blend.state_);
 	}
 
 	void GraphicsContext::SetDepthStencilState(const DepthStencilState& depthStencil, uint32_t stencilRef)
 	{
-		deviceContext_->OMSetDepthStencilState(depthStencil.state_, stencilRef);
+		stateFilter_.SetDepthStencilState(depthStencil.state_, stencilRef);
 	}
 
 	void GraphicsContext::SetRasterizerState(const RasterizerState& raster)
 	{
-		deviceContext_->RSSetState(raster.state_);
+		stateFilter_.SetRasterizerState(raster.state_);
 	}
 
 	void GraphicsContext::SetPrimitiveType(PrimitiveType type)
@@ -86,7 +197,7 @@ namespace se
 			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
 			D3D11_PRIMITIVE_TOPOLOGY_LINELIST,
 		};
-		deviceContext_->IASetPrimitiveTopology(types[type]);
+		stateFilter_.SetPrimitiveTopology(types[type]);
 	}
 
 	void GraphicsContext::SetViewport(const Rect& rect, float minDepth, float maxDepth)
@@ -109,15 +220,17 @@ namespace se
 
 	void GraphicsContext::SetInputLayout(const VertexInputLayout& layout)
 	{
-		deviceContext_->IASetInputLayout(layout.layout);
+		stateFilter_.SetInputLayout(layout.layout);
 	}
 
 	void GraphicsContext::SetVertexBuffer(uint32_t slot, const VertexBuffer& vb)
 	{
-		ID3D11Buffer* buffers[] = { vb.Get<ID3D11Buffer>() };
-		uint32_t stride = vb.GetStride();
-		uint32_t offset = 0;
-		deviceContext_->IASetVertexBuffers(slot, 1, buffers, &stride, &offset);
+		stateFilter_.SetVertexBuffer(slot, vb.Get<ID3D11Buffer>(), vb.GetStride(), 0);
+	}
+
+	void GraphicsContext::SetVertexBuffer(uint32_t slot, const GPUResource& buffer, uint32_t stride, uint32_t offset)
+	{
+		stateFilter_.SetVertexBuffer(slot, buffer.Get<ID3D11Buffer>(), stride, offset);
 	}
 
 	void GraphicsContext::SetIndexBuffer(const IndexBuffer& ib)
@@ -126,39 +239,49 @@ namespace se
 			DXGI_FORMAT_R16_UINT,
 			DXGI_FORMAT_R32_UINT,
 		};
-		deviceContext_->IASetIndexBuffer(ib.Get<ID3D11Buffer>(), formats[ib.stride_], 0);
+		stateFilter_.SetIndexBuffer(ib.Get<ID3D11Buffer>(), formats[ib.stride_]);
 	}
 
 	void GraphicsContext::SetVSResource(uint32_t slot, const GPUResource& resource)
 	{
-		ID3D11ShaderResourceView* resources[] = { resource.GetSRV() };
-		deviceContext_->VSSetShaderResources(slot, 1, resources);
+		stateFilter_.SetVSResource(slot, resource.GetSRV());
 	}
 
 	void GraphicsContext::SetPSResource(uint32_t slot, const GPUResource& resource)
 	{
-		ID3D11ShaderResourceView* resources[] = { resource.GetSRV() };
-		deviceContext_->PSSetShaderResources(slot, 1, resources);
+		stateFilter_.SetPSResource(slot, resource.GetSRV());
 	}
 
 	void GraphicsContext::SetPSSamplerState(uint32_t slot, const SamplerState& sampler)
 	{
-		deviceContext_->PSSetSamplers(slot, 1, &sampler.state_);
+		stateFilter_.SetPSSamplerState(slot, sampler.state_);
 	}
 
 	void GraphicsContext::SetVSConstantBuffer(uint32_t slot, const ConstantBuffer& buffer)
 	{
-		deviceContext_->VSSetConstantBuffers(slot, 1, &buffer.buffer_);
+		if (buffer.IsTransient()) {
+			stateFilter_.SetVSConstantBuffer(slot, buffer.ringBuffer_, buffer.ringOffset_ / 16, buffer.GetConstantCount());
+		} else {
+			stateFilter_.SetVSConstantBuffer(slot, buffer.buffer_);
+		}
 	}
 
 	void GraphicsContext::SetPSConstantBuffer(uint32_t slot, const ConstantBuffer& buffer)
 	{
-		deviceContext_->PSSetConstantBuffers(slot, 1, &buffer.buffer_);
+		if (buffer.IsTransient()) {
+			stateFilter_.SetPSConstantBuffer(slot, buffer.ringBuffer_, buffer.ringOffset_ / 16, buffer.GetConstantCount());
+		} else {
+			stateFilter_.SetPSConstantBuffer(slot, buffer.buffer_);
+		}
 	}
 
 	void GraphicsContext::SetCSConstantBuffer(uint32_t slot, const ConstantBuffer& buffer)
 	{
-		deviceContext_->CSSetConstantBuffers(slot, 1, &buffer.buffer_);
+		if (buffer.IsTransient()) {
+			stateFilter_.SetCSConstantBuffer(slot, buffer.ringBuffer_, buffer.ringOffset_ / 16, buffer.GetConstantCount());
+		} else {
+			stateFilter_.SetCSConstantBuffer(slot, buffer.buffer_);
+		}
 	}
 
 	void GraphicsContext::DrawIndexed(uint32_t indexStart, uint32_t indexCount)
@@ -166,8 +289,59 @@ namespace se
 		deviceContext_->DrawIndexed(indexCount, indexStart, 0);
 	}
 
+	void GraphicsContext::DrawIndexedInstanced(uint32_t indexStart, uint32_t indexCount, uint32_t instanceCount, uint32_t instanceStart)
+	{
+		deviceContext_->DrawIndexedInstanced(indexCount, instanceCount, indexStart, 0, instanceStart);
+	}
+
+	ID3D11CommandList* GraphicsContext::FinishCommandList()
+	{
+		ID3D11CommandList* commandList = nullptr;
+		if (FAILED(deviceContext_->FinishCommandList(FALSE, &commandList))) {
+			commandList = nullptr;
+		}
+		stateFilter_.Invalidate();
+		return commandList;
+	}
+
+	void GraphicsContext::ExecuteCommandList(ID3D11CommandList* commandList)
+	{
+		deviceContext_->ExecuteCommandList(commandList, TRUE);
+	}
+
 	void GraphicsContext::UpdateSubresource(ConstantBuffer& resource, const void* data, size_t size)
 	{
 		deviceContext_->UpdateSubresource(resource.buffer_, 0, nullptr, data, 0, 0);
 	}
+
+	void GraphicsContext::UpdateSubresource(GPUResource& resource, const void* data, size_t size)
+	{
+		D3D11_BOX box = { 0, 0, 0, static_cast<UINT>(size), 1, 1 };
+		deviceContext_->UpdateSubresource(resource.GetResource(), 0, &box, data, 0, 0);
+	}
+
+	void GraphicsContext::UpdateSubresource(GPUResource& resource, uint32_t offset, const void* data, size_t size)
+	{
+		D3D11_BOX box = { offset, 0, 0, offset + static_cast<UINT>(size), 1, 1 };
+		deviceContext_->UpdateSubresource(resource.GetResource(), 0, &box, data, 0, 0);
+	}
+
+	void GraphicsContext::UpdateDynamic(GPUResource& resource, const void* data, size_t size)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		if (FAILED(deviceContext_->Map(resource.GetResource(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+		memcpy(mapped.pData, data, size);
+		deviceContext_->Unmap(resource.GetResource(), 0);
+	}
+
+	bool GraphicsContext::UpdateNoOverwrite(GPUResource& resource, uint32_t offset, const void* data, size_t size)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		if (FAILED(deviceContext_->Map(resource.GetResource(), 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped))) return false;
+		memcpy(static_cast<uint8_t*>(mapped.pData) + offset, data, size);
+		deviceContext_->Unmap(resource.GetResource(), 0);
+		return true;
+	}
+
+#pragma endregion
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #pragma once 
 
 #include "engine/Graphics/GraphicsCommon.h"
+#include "engine/Graphics/StateFilter.h"
 #include "engine/Math/Math.h"
 
 namespace se
@@ -24,13 +25,49 @@ namespace se
 	class DepthStencilState;
 	class RasterizerState;
 
+	/**
+	 * ID3D11DeviceContextへのステート設定
+	 */
+	class D3D11StateDevice : public StateDevice
+	{
+	private:
+		ID3D11DeviceContext* deviceContext_;
+		ID3D11DeviceContext1* deviceContext1_;		// 範囲を指定したコンスタントバッファの設定用(D3D11.1ランタイムのみ)
+
+	public:
+		D3D11StateDevice() : deviceContext_(nullptr), deviceContext1_(nullptr) {}
+
+		void SetDeviceContext(ID3D11DeviceContext* context, ID3D11DeviceContext1* context1) { deviceContext_ = context; deviceContext1_ = context1; }
+
+		virtual void SetVertexShader(ID3D11VertexShader* shader) override;
+		virtual void SetPixelShader(ID3D11PixelShader* shader) override;
+		virtual void SetInputLayout(ID3D11InputLayout* layout) override;
+		virtual void SetPrimitiveTopology(uint32_t topology) override;
+		virtual void SetBlendState(ID3D11BlendState* state) override;
+		virtual void SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef) override;
+		virtual void SetRasterizerState(ID3D11RasterizerState* state) override;
+		virtual void SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset) override;
+		virtual void SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format) override;
+		virtual void SetVSResource(uint32_t slot, ID3D11ShaderResourceView* srv) override;
+		virtual void SetPSResource(uint32_t slot, ID3D11ShaderResourceView* srv) override;
+		virtual void SetPSSamplerState(uint32_t slot, ID3D11SamplerState* sampler) override;
+		virtual void SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) override;
+		virtual void SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) override;
+		virtual void SetCSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) override;
+	};
+
+
 	/**
 	 * グラフィクスコンテキスト
+	 * シェーダ、ステート、リソースの設定はStateFilterを通して冗長な呼び出しを除去する
 	 */
 	class GraphicsContext
 	{
 	private:
 		ID3D11DeviceContext* deviceContext_;
+		ID3D11DeviceContext1* deviceContext1_;
+		D3D11StateDevice stateDevice_;
+		StateFilter stateFilter_;
 
 	public:
 		GraphicsContext();
@@ -39,6 +76,16 @@ namespace se
 		void Initialize(ID3D11DeviceContext* context);
 		void Finalize();
 		ID3D11DeviceContext* GetDeviceContext() { return deviceContext_; }
+		// コンスタントバッファを範囲指定で設定できるか(ID3D11DeviceContext1が取得できた)
+		bool SupportsConstantBufferOffset() const { return deviceContext1_ != nullptr; }
+
+		// ステートを初期化する(デバイスコンテキストを直接操作した場合はInvalidateStateを呼ぶこと)
+		void ClearState();
+		void InvalidateState() { stateFilter_.Invalidate(); }
+
+		// ステート設定の統計
+		const StateFilter::Stats& GetStateStats() const { return stateFilter_.GetStats(); }
+		void ResetStateStats() { stateFilter_.ResetStats(); }
 
 		// RenderTarget
 		void SetRenderTarget(const ColorBuffer* colorBuffers, uint32_t count, const DepthStencilBuffer* depthStencil);
@@ -60,6 +107,7 @@ namespace se
 		// Resource binding
 		void SetInputLayout(const VertexInputLayout& layout);
 		void SetVertexBuffer(uint32_t slot, const VertexBuffer& vb);
+		void SetVertexBuffer(uint32_t slot, const GPUResource& buffer, uint32_t stride, uint32_t offset);	// UploadRing等の途中から
 		void SetIndexBuffer(const IndexBuffer& ib);
 		void SetVSResource(uint32_t slot, const GPUResource& resource);
 		void SetPSResource(uint32_t slot, const GPUResource& resource);
@@ -70,8 +118,19 @@ namespace se
 
 		// Batching
 		void DrawIndexed(uint32_t indexStart, uint32_t indexCount);
+		void DrawIndexedInstanced(uint32_t indexStart, uint32_t indexCount, uint32_t instanceCount, uint32_t instanceStart = 0);
+
+		// CommandList
+		// 遅延コンテキストの記録を閉じる(失敗時はnullptr、遅延コンテキストのステートは初期状態に戻る)
+		ID3D11CommandList* FinishCommandList();
+		// 即時コンテキストで実行する(実行後はステートを実行前に戻すので、保持しているステートはそのまま使える)
+		void ExecuteCommandList(ID3D11CommandList* commandList);
 
 		// Resource
 		void UpdateSubresource(ConstantBuffer& resource, const void* data, size_t size);
+		void UpdateSubresource(GPUResource& resource, const void* data, size_t size);	// バッファの先頭からsize分を更新
+		void UpdateSubresource(GPUResource& resource, uint32_t offset, const void* data, size_t size);	// バッファのoffsetからsize分を更新
+		void UpdateDynamic(GPUResource& resource, const void* data, size_t size);		// BUFFER_USAGE_DYNAMICのバッファを破棄して書き直す
+		bool UpdateNoOverwrite(GPUResource& resource, uint32_t offset, const void* data, size_t size);	// GPUが使用中でない範囲に追記する
 	};
 }
\ No newline at end of file
@@ -16,6 +16,10 @@ namespace se
 	GraphicsContext			GraphicsCore::immediateContext_;
 	ColorBuffer				GraphicsCore::displayBuffer_;
 	DepthStencilBuffer		GraphicsCore::displayDepthBuffer_;
+	UploadRing				GraphicsCore::vertexRing_;
+	UploadRing				GraphicsCore::constantRing_;
+	uint64_t				GraphicsCore::frameIndex_;
+	std::vector<std::unique_ptr<GraphicsContext>>	GraphicsCore::deferredContexts_;
 
 	void GraphicsCore::Initialize(HWND hWnd)
 	{
@@ -117,6 +121,7 @@ namespace se
 		immediateContext_.SetRasterizerState(RasterizerState::Get(RasterizerState::BackFaceCull));
 
 		VertexLayoutManager::Get().Initialize();
+		InitializeUploadRings();
 	}
 
 	void GraphicsCore::InitializeByExternalDevice(ID3D11Device* device)
@@ -138,11 +143,58 @@ namespace se
 		immediateContext_.SetRasterizerState(RasterizerState::Get(RasterizerState::BackFaceCull));
 
 		VertexLayoutManager::Get().Initialize();
+		InitializeUploadRings();
+	}
+
+	void GraphicsCore::InitializeUploadRings()
+	{
+		frameIndex_ = 0;
+		vertexRing_.Create(VertexRingSize, D3D11_BIND_VERTEX_BUFFER);
+
+		// コンスタントバッファの範囲指定とNO_OVERWRITEでのMapはD3D11.1の機能(未対応ならUpdateSubresourceのまま)
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+		ZeroMemory(&options, sizeof(options));
+		if (immediateContext_.SupportsConstantBufferOffset()
+			&& SUCCEEDED(device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))
+			&& options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer) {
+			constantRing_.Create(ConstantRingSize, D3D11_BIND_CONSTANT_BUFFER);
+		}
+	}
+
+
+	void GraphicsCore::InitializeDeferredContexts(uint32_t count)
+	{
+		deferredContexts_.clear();
+		count = (std::min)(count, MaxDeferredContexts);
+		if (count <= 1) return;
+
+		// ランタイムのエミュレーションでは即時コンテキストに直接描画するより遅くなるので使わない
+		D3D11_FEATURE_DATA_THREADING threading;
+		ZeroMemory(&threading, sizeof(threading));
+		if (FAILED(device_->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading)))
+			|| !threading.DriverCommandLists) {
+			return;
+		}
+
+		// シングルスレッドで作成されたデバイスでは作成に失敗する
+		for (uint32_t i = 0; i < count; i++) {
+			ID3D11DeviceContext* deviceContext;
+			if (FAILED(device_->CreateDeferredContext(0, &deviceContext))) {
+				deferredContexts_.clear();
+				return;
+			}
+			std::unique_ptr<GraphicsContext> context(new GraphicsContext());
+			context->Initialize(deviceContext);
+			deferredContexts_.push_back(std::move(context));
+		}
 	}
 
 
 	void GraphicsCore::Finalize()
 	{
+		deferredContexts_.clear();
+		vertexRing_.Destroy();
+		constantRing_.Destroy();
 		VertexLayoutManager::Get().Finalize();
 
 		immediateContext_.Finalize();
@@ -156,4 +208,19 @@ namespace se
 		swapChain_->Present(syncInterval, flags);
 	}
 
+
+	void GraphicsCore::BeginFrame()
+	{
+		frameIndex_++;
+		vertexRing_.BeginFrame(immediateContext_);
+		constantRing_.BeginFrame(immediateContext_);
+	}
+
+
+	void GraphicsCore::EndFrame()
+	{
+		vertexRing_.EndFrame(immediateContext_);
+		constantRing_.EndFrame(immediateContext_);
+	}
+
 }
\ No newline at end of file
@@ -8,11 +8,18 @@
 #include "engine/Graphics/GraphicsCommon.h"
 #include "engine/Graphics/GraphicsContext.h"
 #include "engine/Graphics/GPUBuffer.h"
+#include <memory>
+#include <vector>
 
 namespace se
 {
 	class GraphicsCore
 	{
+	public:
+		static const uint32_t VertexRingSize = 32 << 20;
+		static const uint32_t ConstantRingSize = 1 << 20;
+		static const uint32_t MaxDeferredContexts = 8;
+
 	private:
 		static D3D_DRIVER_TYPE			driverType_;
 		static D3D_FEATURE_LEVEL		featureLevel_;
@@ -23,16 +30,38 @@ namespace se
 		static ColorBuffer				displayBuffer_;
 		static DepthStencilBuffer		displayDepthBuffer_;
 
+		// フレーム毎に書き換えるデータ用のリング
+		static UploadRing				vertexRing_;
+		static UploadRing				constantRing_;		// 範囲指定のコンスタントバッファに対応している場合のみ作成
+		static uint64_t					frameIndex_;
+
+		// 描画パケットの並列記録用(ドライバがコマンドリストに対応している場合のみ作成)
+		static std::vector<std::unique_ptr<GraphicsContext>>	deferredContexts_;
+
+	private:
+		static void InitializeUploadRings();
+
 	public:
 		static void Initialize(HWND hwnd);
 		static void InitializeByExternalDevice(ID3D11Device* device);
+		// 遅延コンテキストを作成する(countは並列に記録するスレッド数、作成できなければ0個のまま)
+		static void InitializeDeferredContexts(uint32_t count);
 		static void Finalize();
 
 		static ID3D11Device* GetDevice() { return device_; }
 		static GraphicsContext& GetImmediateContext() { return immediateContext_; }
+		static uint32_t GetDeferredContextCount() { return static_cast<uint32_t>(deferredContexts_.size()); }
+		static GraphicsContext& GetDeferredContext(uint32_t index) { return *deferredContexts_[index]; }
 
 		static void Present(uint32_t syncInterval, uint32_t flags);
 
+		// リングへの書き込みはBeginFrame()とEndFrame()の間で行う
+		static void BeginFrame();
+		static void EndFrame();
+		static uint64_t GetFrameIndex() { return frameIndex_; }
+		static UploadRing& GetVertexRing() { return vertexRing_; }
+		static UploadRing* GetConstantRing() { return constantRing_.GetResource() ? &constantRing_ : nullptr; }
+
 		static const ColorBuffer& GetDisplayColorBuffer() { return displayBuffer_; }
 		static const DepthStencilBuffer& GetDisplayDepthStencilBuffer() { return displayDepthBuffer_; }
 	};
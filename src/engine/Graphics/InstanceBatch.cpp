@@ -0,0 +1,33 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/InstanceBatch.h"
+
+namespace se
+{
+	void InstanceBatch::Clear()
+	{
+		objects_.clear();
+		prevObjects_.clear();
+	}
+
+	void InstanceBatch::Begin()
+	{
+		prevObjects_.swap(objects_);
+		objects_.clear();
+	}
+
+	void InstanceBatch::Add(uint32_t objectIndex)
+	{
+		objects_.push_back(objectIndex);
+	}
+
+	bool InstanceBatch::End()
+	{
+		// 空の場合は転送不要
+		if (objects_.empty()) return false;
+		return objects_ != prevObjects_;
+	}
+}
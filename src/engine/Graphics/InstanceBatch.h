@@ -0,0 +1,36 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * インスタンス描画で参照するオブジェクトパラメータの番号の配列を組み立てる
+	 * パラメータ自体はObjectParameterTableにまとめてあるので、トランスフォームの更新では組み直す必要はない
+	 * 前回の組み立て結果と比較し、GPUへの転送が必要かを判定する(デバイスには依存しない)
+	 */
+	class InstanceBatch
+	{
+	private:
+		std::vector<uint32_t> objects_;			// 各インスタンスのObjectParameterTable内の番号
+		std::vector<uint32_t> prevObjects_;		// 前回の組み立て結果
+
+	public:
+		void Clear();
+
+		// 組み立て開始(前回の結果は変更判定用に保持)
+		void Begin();
+		void Add(uint32_t objectIndex);
+		// 組み立て終了(描画するインスタンスが前回から変わっていればtrue)
+		bool End();
+
+		uint32_t Count() const { return static_cast<uint32_t>(objects_.size()); }
+		const uint32_t* Data() const { return objects_.data(); }
+	};
+}
@@ -0,0 +1,270 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/MeshClusterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace se
+{
+	namespace {
+		const uint32_t InvalidStamp = ~0u;
+
+		// 10bitの値を3bit間隔に広げる
+		inline uint32_t Part1By2(uint32_t x)
+		{
+			x &= 0x000003ff;
+			x = (x ^ (x << 16)) & 0xff0000ff;
+			x = (x ^ (x << 8)) & 0x0300f00f;
+			x = (x ^ (x << 4)) & 0x030c30c3;
+			x = (x ^ (x << 2)) & 0x09249249;
+			return x;
+		}
+
+		inline float Dot(const float* a, const float* b)
+		{
+			return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+		}
+
+		// 三角形の面の法線(正規化しない、反時計回りが表)
+		inline void FaceNormal(const uint32_t* indices, uint32_t triangle, const float* positions, uint32_t stride, float* normal)
+		{
+			const float* a = positions + static_cast<size_t>(indices[triangle * 3 + 0]) * stride;
+			const float* b = positions + static_cast<size_t>(indices[triangle * 3 + 1]) * stride;
+			const float* c = positions + static_cast<size_t>(indices[triangle * 3 + 2]) * stride;
+			float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+			normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+			normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+		}
+
+		void BeginChunk(MeshChunk& chunk, uint32_t triangleOffset)
+		{
+			chunk.triangleOffset = triangleOffset;
+			chunk.triangleCount = 0;
+			chunk.meshletCount = 0;
+			chunk.vertexCount = 0;
+			for (int32_t i = 0; i < 3; i++) {
+				chunk.boundsMin[i] = FLT_MAX;
+				chunk.boundsMax[i] = -FLT_MAX;
+			}
+		}
+	}
+
+
+	void MeshClusterizer::Build(const uint32_t* indices, size_t indexCount, const float* positions, uint32_t stride, uint32_t vertexCount,
+		std::vector<uint32_t>* triangles, std::vector<MeshChunk>* chunks, uint32_t meshletTriangles, uint32_t chunkVertices)
+	{
+		triangles->clear();
+		chunks->clear();
+		uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+		if (triangleCount == 0) return;
+
+		// 1つのメッシュレットは必ずチャンクに収まるようにする
+		meshletTriangles = (std::max)(meshletTriangles, 1u);
+		chunkVertices = (std::max)(chunkVertices, meshletTriangles * 3);
+
+		// 重心の範囲
+		float centerMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float centerMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (int32_t i = 0; i < 3; i++) {
+				float center = (positions[static_cast<size_t>(indices[t * 3 + 0]) * stride + i]
+					+ positions[static_cast<size_t>(indices[t * 3 + 1]) * stride + i]
+					+ positions[static_cast<size_t>(indices[t * 3 + 2]) * stride + i]) * (1.0f / 3.0f);
+				centerMin[i] = (std::min)(centerMin[i], center);
+				centerMax[i] = (std::max)(centerMax[i], center);
+			}
+		}
+		float scale[3];
+		for (int32_t i = 0; i < 3; i++) {
+			float extent = centerMax[i] - centerMin[i];
+			scale[i] = (extent > 0.0f) ? 1023.0f / extent : 0.0f;
+		}
+
+		// 重心のモートン符号(上位32bit)と三角形番号(下位32bit)をまとめてソート
+		std::vector<uint64_t> keys(triangleCount);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			uint32_t code = 0;
+			for (int32_t i = 0; i < 3; i++) {
+				float center = (positions[static_cast<size_t>(indices[t * 3 + 0]) * stride + i]
+					+ positions[static_cast<size_t>(indices[t * 3 + 1]) * stride + i]
+					+ positions[static_cast<size_t>(indices[t * 3 + 2]) * stride + i]) * (1.0f / 3.0f);
+				float q = (center - centerMin[i]) * scale[i];
+				uint32_t cell = static_cast<uint32_t>((std::min)((std::max)(q, 0.0f), 1023.0f));
+				code |= Part1By2(cell) << i;
+			}
+			keys[t] = (static_cast<uint64_t>(code) << 32) | t;
+		}
+		std::sort(keys.begin(), keys.end());
+		triangles->resize(triangleCount);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			(*triangles)[t] = static_cast<uint32_t>(keys[t]);
+		}
+		std::vector<uint64_t>().swap(keys);
+
+		// 並べた順にメッシュレットに区切り、頂点数が上限を超えるまで同じチャンクにまとめる
+		// 頂点がどのメッシュレット、チャンクで数えられたかを印にして重複を除く
+		std::vector<uint32_t> meshletStamp(vertexCount, InvalidStamp);
+		std::vector<uint32_t> chunkStamp(vertexCount, InvalidStamp);
+		uint32_t chunkIndex = 0;
+		MeshChunk chunk;
+		BeginChunk(chunk, 0);
+		for (uint32_t begin = 0, meshlet = 0; begin < triangleCount; begin += meshletTriangles, meshlet++) {
+			uint32_t end = (std::min)(begin + meshletTriangles, triangleCount);
+
+			// メッシュレット内の頂点数と、チャンクに新たに加わる頂点数
+			uint32_t unique = 0;
+			uint32_t added = 0;
+			for (uint32_t t = begin; t < end; t++) {
+				const uint32_t* triangle = indices + static_cast<size_t>((*triangles)[t]) * 3;
+				for (int32_t k = 0; k < 3; k++) {
+					uint32_t v = triangle[k];
+					if (meshletStamp[v] == meshlet) continue;
+					meshletStamp[v] = meshlet;
+					unique++;
+					if (chunkStamp[v] != chunkIndex) added++;
+				}
+			}
+
+			// 収まらなければ新しいチャンクを始める
+			if (chunk.triangleCount > 0 && chunk.vertexCount + added > chunkVertices) {
+				chunks->push_back(chunk);
+				chunkIndex++;
+				BeginChunk(chunk, begin);
+				added = unique;
+			}
+
+			for (uint32_t t = begin; t < end; t++) {
+				const uint32_t* triangle = indices + static_cast<size_t>((*triangles)[t]) * 3;
+				for (int32_t k = 0; k < 3; k++) {
+					uint32_t v = triangle[k];
+					if (chunkStamp[v] == chunkIndex) continue;
+					chunkStamp[v] = chunkIndex;
+					const float* p = positions + static_cast<size_t>(v) * stride;
+					for (int32_t i = 0; i < 3; i++) {
+						chunk.boundsMin[i] = (std::min)(chunk.boundsMin[i], p[i]);
+						chunk.boundsMax[i] = (std::max)(chunk.boundsMax[i], p[i]);
+					}
+				}
+			}
+			chunk.vertexCount += added;
+			chunk.triangleCount += end - begin;
+			chunk.meshletCount++;
+		}
+		chunks->push_back(chunk);
+
+		for (auto& c : *chunks) {
+			c.cone = ComputeCone(indices, triangles->data() + c.triangleOffset, c.triangleCount, positions, stride, c.boundsMin, c.boundsMax);
+		}
+	}
+
+	NormalCone MeshClusterizer::ComputeCone(const uint32_t* indices, const uint32_t* triangles, uint32_t triangleCount,
+		const float* positions, uint32_t stride, const float boundsMin[3], const float boundsMax[3])
+	{
+		// 包む球はバウンディングボックスから求める
+		NormalCone cone = InvalidCone();
+		float radius2 = 0.0f;
+		for (int32_t i = 0; i < 3; i++) {
+			float half = (boundsMax[i] - boundsMin[i]) * 0.5f;
+			cone.center[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+			radius2 += half * half;
+		}
+		cone.radius = sqrtf(radius2);
+
+		// 軸は面の法線(単位ベクトル)の平均
+		float sum[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			float normal[3];
+			FaceNormal(indices, triangles[t], positions, stride, normal);
+			float length = sqrtf(Dot(normal, normal));
+			if (length <= 0.0f) continue;
+			for (int32_t i = 0; i < 3; i++) {
+				sum[i] += normal[i] / length;
+			}
+		}
+		float sumLength = sqrtf(Dot(sum, sum));
+		if (sumLength <= 1e-6f) return cone;
+		float axis[3] = { sum[0] / sumLength, sum[1] / sumLength, sum[2] / sumLength };
+
+		// 軸から最も離れた法線で広がり角を決める(半球以上に広がる場合は判定しない)
+		float minDot = 1.0f;
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			float normal[3];
+			FaceNormal(indices, triangles[t], positions, stride, normal);
+			float length = sqrtf(Dot(normal, normal));
+			if (length <= 0.0f) continue;
+			minDot = (std::min)(minDot, Dot(normal, axis) / length);
+		}
+		if (minDot <= 0.0f) return cone;
+
+		for (int32_t i = 0; i < 3; i++) {
+			cone.axis[i] = axis[i];
+		}
+		cone.cutoff = sqrtf((std::max)(1.0f - minDot * minDot, 0.0f));
+		return cone;
+	}
+
+	NormalCone MeshClusterizer::TransformCone(const NormalCone& cone, const float* matrix)
+	{
+		if (!IsConeValid(cone)) return cone;
+
+		const float* r0 = matrix;
+		const float* r1 = matrix + 4;
+		const float* r2 = matrix + 8;
+		const float* t = matrix + 12;
+
+		// 回転と一様スケールのみか(裏返る場合は表裏も入れ替わる)
+		float s0 = Dot(r0, r0);
+		float s1 = Dot(r1, r1);
+		float s2 = Dot(r2, r2);
+		const float tolerance = 1e-3f * s0;
+		float cross[3] = { r1[1] * r2[2] - r1[2] * r2[1], r1[2] * r2[0] - r1[0] * r2[2], r1[0] * r2[1] - r1[1] * r2[0] };
+		if (s0 <= 0.0f || Dot(r0, cross) <= 0.0f
+			|| fabsf(s0 - s1) > tolerance || fabsf(s0 - s2) > tolerance
+			|| fabsf(Dot(r0, r1)) > tolerance || fabsf(Dot(r0, r2)) > tolerance || fabsf(Dot(r1, r2)) > tolerance) {
+			return InvalidCone();
+		}
+
+		float scale = sqrtf(s0);
+		NormalCone result;
+		for (int32_t i = 0; i < 3; i++) {
+			result.center[i] = cone.center[0] * r0[i] + cone.center[1] * r1[i] + cone.center[2] * r2[i] + t[i];
+			result.axis[i] = (cone.axis[0] * r0[i] + cone.axis[1] * r1[i] + cone.axis[2] * r2[i]) / scale;
+		}
+		result.radius = cone.radius * scale;
+		result.cutoff = cone.cutoff;
+		return result;
+	}
+
+	bool MeshClusterizer::IsBackfacing(const NormalCone& cone, const float* viewPosition)
+	{
+		if (!IsConeValid(cone)) return false;
+
+		// 視点から球の中心への方向がコーンの広がりと球の大きさを見込んでも軸と同じ側にあれば全て裏
+		float direction[3] = { cone.center[0] - viewPosition[0], cone.center[1] - viewPosition[1], cone.center[2] - viewPosition[2] };
+		float distance = sqrtf(Dot(direction, direction));
+		return Dot(direction, cone.axis) >= cone.cutoff * distance + cone.radius;
+	}
+
+	bool MeshClusterizer::IsBackfacingDirection(const NormalCone& cone, const float* viewDirection)
+	{
+		if (!IsConeValid(cone)) return false;
+		return Dot(viewDirection, cone.axis) > cone.cutoff;
+	}
+
+	NormalCone MeshClusterizer::InvalidCone()
+	{
+		NormalCone cone;
+		cone.center[0] = cone.center[1] = cone.center[2] = 0.0f;
+		cone.radius = 0.0f;
+		cone.axis[0] = cone.axis[1] = 0.0f;
+		cone.axis[2] = 1.0f;
+		cone.cutoff = 1.0f;
+		return cone;
+	}
+}
\ No newline at end of file
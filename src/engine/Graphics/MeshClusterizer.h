@@ -0,0 +1,73 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * 法線コーン(三角形の向きの範囲)
+	 * 包む球の中心と半径、法線の平均の軸、cutoff(軸からの広がり角のsin、1以上は背面判定しない)
+	 */
+	struct NormalCone
+	{
+		float center[3];
+		float radius;
+		float axis[3];
+		float cutoff;
+	};
+
+	/**
+	 * 空間的に近い三角形をまとめたチャンク
+	 */
+	struct MeshChunk
+	{
+		uint32_t triangleOffset;	// 並べ替え後の三角形リスト内の先頭位置
+		uint32_t triangleCount;
+		uint32_t meshletCount;		// まとめたメッシュレット数
+		uint32_t vertexCount;		// 参照する頂点数
+		float boundsMin[3];
+		float boundsMax[3];
+		NormalCone cone;
+	};
+
+	/**
+	 * 巨大なメッシュをチャンクに分割する(デバイスには依存しない)
+	 * 三角形を重心のモートン順に並べてメッシュレットに区切り、頂点数が上限に収まるまでメッシュレットをチャンクにまとめる
+	 * チャンク毎のバウンディングと法線コーンで視錐台カリングと背面カリングを行う
+	 */
+	class MeshClusterizer
+	{
+	public:
+		static const uint32_t DefaultMeshletTriangles = 128;
+		static const uint32_t DefaultChunkVertices = 0x10000;	// 16bitインデックスに収まる頂点数
+
+		// triangles: 並べ替え後の三角形番号(チャンク順)、chunks: チャンク毎の範囲とバウンディング
+		// positions: stride(float単位)間隔で並んだ頂点の位置
+		static void Build(const uint32_t* indices, size_t indexCount, const float* positions, uint32_t stride, uint32_t vertexCount,
+			std::vector<uint32_t>* triangles, std::vector<MeshChunk>* chunks,
+			uint32_t meshletTriangles = DefaultMeshletTriangles, uint32_t chunkVertices = DefaultChunkVertices);
+
+		// 三角形群の法線コーン(反時計回りを表とする。面積のない三角形は無視する)
+		static NormalCone ComputeCone(const uint32_t* indices, const uint32_t* triangles, uint32_t triangleCount,
+			const float* positions, uint32_t stride, const float boundsMin[3], const float boundsMax[3]);
+
+		// 行ベクトル規約のアフィン変換(4x4)でコーンを変換する
+		// 一様スケールで裏返らない変換以外は広がり角が保たれないので背面判定しないコーンを返す
+		static NormalCone TransformCone(const NormalCone& cone, const float* matrix);
+
+		// 視点(透視投影)から見てコーン内の三角形が全て裏を向いているか
+		static bool IsBackfacing(const NormalCone& cone, const float* viewPosition);
+		// 視線方向(平行投影)に対してコーン内の三角形が全て裏を向いているか
+		static bool IsBackfacingDirection(const NormalCone& cone, const float* viewDirection);
+
+		static bool IsConeValid(const NormalCone& cone) { return cone.cutoff < 1.0f; }
+		static NormalCone InvalidCone();
+	};
+}
\ No newline at end of file
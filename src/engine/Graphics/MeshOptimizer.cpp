@@ -0,0 +1,254 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/MeshOptimizer.h"
+#include "engine/Core/Hash.h"
+#include <algorithm>
+#include <cmath>
+
+namespace se
+{
+	namespace
+	{
+		struct Cluster
+		{
+			uint32_t begin;		// 先頭三角形
+			uint32_t end;
+			float sortKey;
+		};
+
+		// 三角形の面積で重み付けした中心と法線(長さは面積の2倍)
+		void GetTriangleInfo(const uint32_t* tri, const float* positions, uint32_t positionStride, float* center, float* normal)
+		{
+			const float* p0 = positions + static_cast<size_t>(tri[0]) * positionStride;
+			const float* p1 = positions + static_cast<size_t>(tri[1]) * positionStride;
+			const float* p2 = positions + static_cast<size_t>(tri[2]) * positionStride;
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+			for (uint32_t i = 0; i < 3; i++) {
+				center[i] = (p0[i] + p1[i] + p2[i]) / 3.0f;
+			}
+		}
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusters)
+	{
+		if (clusters) clusters->clear();
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0) return;
+
+		// 頂点 -> 三角形の隣接リスト
+		std::vector<uint32_t> live(vertexCount, 0);		// 未出力の隣接三角形数
+		for (size_t i = 0; i < triangleCount * 3; i++) {
+			live[indices[i]]++;
+		}
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			offsets[v + 1] = offsets[v] + live[v];
+		}
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++) {
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t v = indices[t * 3 + k];
+				adjacency[fill[v]++] = static_cast<uint32_t>(t);
+			}
+		}
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		deadEnd.reserve(triangleCount * 3);
+		output.reserve(triangleCount * 3);
+
+		uint32_t time = cacheSize + 1;
+		uint32_t cursor = 0;
+		uint32_t fanning = indices[0];
+		if (clusters) clusters->push_back(0);
+
+		while (fanning != InvalidIndex) {
+			// 扇の中心の頂点を含む三角形を全て出力
+			candidates.clear();
+			for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+				uint32_t t = adjacency[a];
+				if (emitted[t]) continue;
+
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t v = indices[t * 3 + k];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+					if (time - cacheTime[v] > cacheSize) {
+						cacheTime[v] = time;
+						time++;
+					}
+				}
+				emitted[t] = 1;
+			}
+
+			// 次の中心はキャッシュに残っている間に使い切れる頂点のうち最も古いもの
+			uint32_t next = InvalidIndex;
+			int64_t priority = -1;
+			for (uint32_t v : candidates) {
+				if (live[v] == 0) continue;
+				int64_t p = 0;
+				if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+					p = time - cacheTime[v];
+				}
+				if (p > priority) {
+					priority = p;
+					next = v;
+				}
+			}
+
+			// 行き止まりは直近に出力した頂点、なければ先頭から探す
+			if (next == InvalidIndex) {
+				while (!deadEnd.empty()) {
+					uint32_t v = deadEnd.back();
+					deadEnd.pop_back();
+					if (live[v] > 0) {
+						next = v;
+						break;
+					}
+				}
+				while (next == InvalidIndex && cursor < vertexCount) {
+					if (live[cursor] > 0) {
+						next = cursor;
+					} else {
+						cursor++;
+					}
+				}
+				// キャッシュから外れた頂点から再開する場合はクラスタの境界
+				if (clusters && next != InvalidIndex && time - cacheTime[next] > cacheSize) {
+					clusters->push_back(static_cast<uint32_t>(output.size() / 3));
+				}
+			}
+			fanning = next;
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& clusterStarts,
+		const float* positions, uint32_t positionStride, uint32_t vertexCount, uint32_t cacheSize, float threshold)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+		if (clusterStarts.size() <= 1 || triangleCount == 0) return;
+
+		// メッシュ全体の中心
+		float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+		float meshArea = 0.0f;
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			float center[3], normal[3];
+			GetTriangleInfo(indices + t * 3, positions, positionStride, center, normal);
+			float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (uint32_t i = 0; i < 3; i++) {
+				meshCenter[i] += center[i] * area;
+			}
+			meshArea += area;
+		}
+		if (meshArea <= 0.0f) return;
+		for (uint32_t i = 0; i < 3; i++) {
+			meshCenter[i] /= meshArea;
+		}
+
+		// クラスタの向き(外側を向いているほど大きい)
+		std::vector<Cluster> clusters(clusterStarts.size());
+		for (size_t c = 0; c < clusters.size(); c++) {
+			Cluster& cluster = clusters[c];
+			cluster.begin = clusterStarts[c];
+			cluster.end = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : triangleCount;
+
+			float clusterCenter[3] = { 0.0f, 0.0f, 0.0f };
+			float clusterNormal[3] = { 0.0f, 0.0f, 0.0f };
+			float clusterArea = 0.0f;
+			for (uint32_t t = cluster.begin; t < cluster.end; t++) {
+				float center[3], normal[3];
+				GetTriangleInfo(indices + t * 3, positions, positionStride, center, normal);
+				float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				for (uint32_t i = 0; i < 3; i++) {
+					clusterCenter[i] += center[i] * area;
+					clusterNormal[i] += normal[i];
+				}
+				clusterArea += area;
+			}
+
+			cluster.sortKey = 0.0f;
+			float length = std::sqrt(clusterNormal[0] * clusterNormal[0] + clusterNormal[1] * clusterNormal[1] + clusterNormal[2] * clusterNormal[2]);
+			if (clusterArea > 0.0f && length > 0.0f) {
+				for (uint32_t i = 0; i < 3; i++) {
+					cluster.sortKey += (clusterCenter[i] / clusterArea - meshCenter[i]) * clusterNormal[i] / length;
+				}
+			}
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<uint32_t> sorted;
+		sorted.reserve(static_cast<size_t>(triangleCount) * 3);
+		for (const Cluster& cluster : clusters) {
+			sorted.insert(sorted.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+		}
+
+		// 頂点キャッシュの効率が落ちすぎる場合は元の順番のまま
+		float before = AnalyzeVertexCache(indices, triangleCount * 3, vertexCount, cacheSize).acmr;
+		float after = AnalyzeVertexCache(sorted.data(), sorted.size(), vertexCount, cacheSize).acmr;
+		if (after > before * threshold) return;
+
+		std::copy(sorted.begin(), sorted.end(), indices);
+	}
+
+	uint32_t MeshOptimizer::OptimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t* remap)
+	{
+		std::fill(remap, remap + vertexCount, InvalidIndex);
+		uint32_t next = 0;
+		for (size_t i = 0; i < indexCount; i++) {
+			uint32_t& v = indices[i];
+			if (remap[v] == InvalidIndex) {
+				remap[v] = next++;
+			}
+			v = remap[v];
+		}
+		return next;
+	}
+
+	VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		// FIFO: 頂点が入った時点のミス数から、その後cacheSize回ミスするまで残る
+		std::vector<uint32_t> insertedAt(vertexCount, InvalidIndex);
+		uint32_t misses = 0;
+		uint32_t unique = 0;
+		for (size_t i = 0; i < indexCount; i++) {
+			uint32_t v = indices[i];
+			if (insertedAt[v] == InvalidIndex) {
+				unique++;
+			} else if (misses - insertedAt[v] <= cacheSize) {
+				continue;
+			}
+			insertedAt[v] = misses;
+			misses++;
+		}
+
+		VertexCacheStats stats;
+		size_t triangleCount = indexCount / 3;
+		stats.acmr = (triangleCount > 0) ? static_cast<float>(misses) / triangleCount : 0.0f;
+		stats.atvr = (unique > 0) ? static_cast<float>(misses) / unique : 0.0f;
+		return stats;
+	}
+
+	uint64_t MeshOptimizer::HashTopology(const uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+	{
+		uint64_t hash = Hash64(indices, sizeof(uint32_t) * indexCount);
+		hash = HashCombine(hash, vertexCount);
+		return hash;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * 頂点キャッシュの効率
+	 */
+	struct VertexCacheStats
+	{
+		float acmr;		// 三角形あたりの頂点シェーダ実行数(0.5 - 3.0)
+		float atvr;		// 頂点あたりの頂点シェーダ実行数(1.0が最良)
+	};
+
+	/**
+	 * トライアングルリストのインデックス最適化(デバイスには依存しない)
+	 */
+	class MeshOptimizer
+	{
+	public:
+		static const uint32_t DefaultCacheSize = 16;
+
+		// 頂点キャッシュの局所性が上がるように三角形を並べ替える(Tipsify)
+		// clustersには各クラスタ(キャッシュが途切れる位置)の先頭三角形を返す
+		static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+			uint32_t cacheSize = DefaultCacheSize, std::vector<uint32_t>* clusters = nullptr);
+
+		// オーバードローが減るようにクラスタ単位で並べ替える(OptimizeVertexCache()の後に行う)
+		// 外側を向いたクラスタから描画し、ACMRの悪化はthreshold倍までに抑える
+		static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& clusters,
+			const float* positions, uint32_t positionStride, uint32_t vertexCount,
+			uint32_t cacheSize = DefaultCacheSize, float threshold = 1.05f);
+
+		// 頂点フェッチの局所性が上がるようにインデックスに現れる順に頂点を並べ替える
+		// remap[元の頂点] = 新しい頂点(参照されない頂点はInvalidIndex)、戻り値は新しい頂点数
+		static uint32_t OptimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t* remap);
+
+		// FIFOキャッシュを仮定した頂点キャッシュの効率
+		static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+			uint32_t cacheSize = DefaultCacheSize);
+
+		// インデックスと頂点数から求めるトポロジのハッシュ値
+		static uint64_t HashTopology(const uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+
+		static const uint32_t InvalidIndex = ~0u;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/ObjectParameterTable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace se
+{
+	ObjectParameterTable::ObjectParameterTable()
+	{
+		memset(&stats_, 0, sizeof(stats_));
+	}
+
+	uint32_t ObjectParameterTable::Allocate()
+	{
+		uint32_t index;
+		if (!freeIndices_.empty()) {
+			index = freeIndices_.back();
+			freeIndices_.pop_back();
+		} else {
+			index = static_cast<uint32_t>(objects_.size());
+			objects_.emplace_back();
+			dirtyFlags_.push_back(0);
+		}
+		// Matrix44の既定コンストラクタは初期化しないので明示的に0にする
+		ObjectParameterData& data = objects_[index];
+		std::fill(&data.localToWorld.m[0][0], &data.localToWorld.m[0][0] + 16, 0.0f);
+		MarkDirty(index);
+		return index;
+	}
+
+	void ObjectParameterTable::Free(uint32_t index)
+	{
+		if (index >= objects_.size()) return;
+		freeIndices_.push_back(index);
+	}
+
+	void ObjectParameterTable::Clear()
+	{
+		objects_.clear();
+		dirtyFlags_.clear();
+		dirtyIndices_.clear();
+		freeIndices_.clear();
+		ranges_.clear();
+	}
+
+	void ObjectParameterTable::MarkDirty(uint32_t index)
+	{
+		if (dirtyFlags_[index]) return;
+		dirtyFlags_[index] = 1;
+		dirtyIndices_.push_back(index);
+	}
+
+	void ObjectParameterTable::Set(uint32_t index, const ObjectParameterData& data)
+	{
+		objects_[index] = data;
+		MarkDirty(index);
+		stats_.updates++;
+	}
+
+	void ObjectParameterTable::MarkAllDirty()
+	{
+		dirtyIndices_.clear();
+		for (uint32_t i = 0; i < static_cast<uint32_t>(objects_.size()); i++) {
+			dirtyFlags_[i] = 1;
+			dirtyIndices_.push_back(i);
+		}
+	}
+
+	const std::vector<ObjectParameterTable::Range>& ObjectParameterTable::CollectDirtyRanges(uint32_t mergeGap)
+	{
+		ranges_.clear();
+		if (dirtyIndices_.empty()) return ranges_;
+
+		// 番号順に並べ、隣接(間隔がmergeGap以下)するものを1つの範囲にする
+		std::sort(dirtyIndices_.begin(), dirtyIndices_.end());
+		Range range = { dirtyIndices_[0], 1 };
+		for (size_t i = 1; i < dirtyIndices_.size(); i++) {
+			uint32_t index = dirtyIndices_[i];
+			uint32_t end = range.first + range.count;
+			if (index - end <= mergeGap) {
+				range.count = index - range.first + 1;
+			} else {
+				ranges_.push_back(range);
+				range.first = index;
+				range.count = 1;
+			}
+		}
+		ranges_.push_back(range);
+
+		for (uint32_t index : dirtyIndices_) {
+			dirtyFlags_[index] = 0;
+		}
+		dirtyIndices_.clear();
+
+		stats_.uploadRanges += ranges_.size();
+		for (const Range& r : ranges_) {
+			stats_.uploadObjects += r.count;
+		}
+		return ranges_;
+	}
+}
@@ -0,0 +1,69 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Graphics/ShaderConstants.h"
+#include <vector>
+
+namespace se
+{
+	/**
+	 * 全オブジェクトのパラメータを1本の配列にまとめる(デバイスには依存しない)
+	 * オブジェクトは番号で参照し、更新された番号は転送時に連続した範囲にまとめる
+	 * 配列はGPUの構造化バッファにそのまま転送し、シェーダはインスタンス毎の番号で参照する
+	 */
+	class ObjectParameterTable
+	{
+	public:
+		static const uint32_t InvalidIndex = 0xFFFFFFFF;
+
+		// 転送する範囲(要素単位)
+		struct Range
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct Stats
+		{
+			uint64_t uploadRanges;		// 転送した範囲の数
+			uint64_t uploadObjects;		// 転送した要素の数(範囲をまとめた際の未更新の要素を含む)
+			uint64_t updates;			// Set()の呼び出し数
+		};
+
+	private:
+		std::vector<ObjectParameterData> objects_;
+		std::vector<uint8_t> dirtyFlags_;
+		std::vector<uint32_t> dirtyIndices_;	// 更新された番号(重複なし、未整列)
+		std::vector<uint32_t> freeIndices_;
+		std::vector<Range> ranges_;
+		Stats stats_;
+
+	private:
+		void MarkDirty(uint32_t index);
+
+	public:
+		ObjectParameterTable();
+
+		// 番号を割り当てる(解放済みの番号を優先して再利用する)
+		uint32_t Allocate();
+		void Free(uint32_t index);
+		void Clear();
+
+		void Set(uint32_t index, const ObjectParameterData& data);
+		const ObjectParameterData& Get(uint32_t index) const { return objects_[index]; }
+
+		// 全体を転送し直す場合に全て更新済みにする(GPUバッファを作り直した場合など)
+		void MarkAllDirty();
+		// 更新された範囲をまとめて返し、更新の印を消す(間隔がmergeGap以下の範囲は1つにまとめる)
+		const std::vector<Range>& CollectDirtyRanges(uint32_t mergeGap);
+
+		uint32_t GetCapacity() const { return static_cast<uint32_t>(objects_.size()); }
+		uint32_t GetCount() const { return static_cast<uint32_t>(objects_.size() - freeIndices_.size()); }
+		const ObjectParameterData* GetData() const { return objects_.data(); }
+		const Stats& GetStats() const { return stats_; }
+	};
+}
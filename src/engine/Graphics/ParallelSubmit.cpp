@@ -0,0 +1,70 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/ParallelSubmit.h"
+#include "engine/Core/ThreadPool.h"
+#include <algorithm>
+
+namespace se
+{
+	ParallelSubmit::ParallelSubmit()
+		: minChunkPackets_(DefaultMinChunkPackets)
+	{
+		stats_.packets = 0;
+		stats_.chunks = 0;
+	}
+
+	void ParallelSubmit::Split(uint32_t packetCount, uint32_t contextCount, uint32_t minChunkPackets, std::vector<Chunk>& chunks)
+	{
+		chunks.clear();
+		if (packetCount == 0) return;
+
+		uint32_t chunkCount = 1;
+		if (contextCount > 1) {
+			chunkCount = (minChunkPackets > 0) ? packetCount / minChunkPackets : packetCount;
+			chunkCount = (std::max)(1u, (std::min)(chunkCount, contextCount));
+		}
+
+		// 端数は各範囲に1つずつ振り分ける
+		for (uint32_t i = 0; i < chunkCount; i++) {
+			Chunk chunk;
+			chunk.begin = static_cast<uint32_t>(static_cast<uint64_t>(packetCount) * i / chunkCount);
+			chunk.end = static_cast<uint32_t>(static_cast<uint64_t>(packetCount) * (i + 1) / chunkCount);
+			chunks.push_back(chunk);
+		}
+	}
+
+	void ParallelSubmit::Submit(CommandListDevice& device, uint32_t packetCount, ThreadPool* pool)
+	{
+		stats_.packets = packetCount;
+		stats_.chunks = 0;
+
+		// ワーカーがなければ記録しても並列にならないので分割しない
+		uint32_t contextCount = (pool && pool->GetWorkerCount() > 0) ? device.GetContextCount() : 0;
+		Split(packetCount, contextCount, minChunkPackets_, chunks_);
+		if (chunks_.size() <= 1) {
+			if (packetCount > 0) {
+				device.SubmitDirect(0, packetCount);
+			}
+			return;
+		}
+
+		// 範囲毎に別のコンテキストに記録する(呼び出しスレッドも記録に参加する)
+		uint32_t chunkCount = static_cast<uint32_t>(chunks_.size());
+		device.Begin(chunkCount);
+		pool->ParallelFor(chunkCount, 1, [this, &device](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				device.Record(i, chunks_[i].begin, chunks_[i].end);
+			}
+		});
+
+		// 記録順に実行
+		for (uint32_t i = 0; i < chunkCount; i++) {
+			device.Execute(i);
+		}
+		device.End();
+		stats_.chunks = chunkCount;
+	}
+}
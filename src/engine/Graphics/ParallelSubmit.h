@@ -0,0 +1,86 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace se
+{
+	class ThreadPool;
+
+	/**
+	 * 描画パケットを分割して記録するコマンドリストの記録先(D3D11には依存しない)
+	 * Record()はワーカースレッドから呼ばれるので、コンテキスト毎に独立して記録できること
+	 * D3D11では遅延コンテキスト毎にコマンドリストを作り、即時コンテキストで記録順に実行する
+	 */
+	class CommandListDevice
+	{
+	public:
+		virtual ~CommandListDevice() {}
+
+		// 同時に記録できるコンテキスト数(1以下なら分割しない)
+		virtual uint32_t GetContextCount() const = 0;
+
+		// 記録の開始、終了(呼び出しスレッドで記録の前、全て実行した後に呼ばれる)
+		virtual void Begin(uint32_t chunkCount) = 0;
+		virtual void End() = 0;
+		// [begin, end)のパケットをcontextIndexのコンテキストに記録する(ワーカースレッドから呼ばれる)
+		virtual void Record(uint32_t contextIndex, uint32_t begin, uint32_t end) = 0;
+		// contextIndexに記録したコマンドリストを実行する(呼び出しスレッドでcontextIndexの順に呼ばれる)
+		virtual void Execute(uint32_t contextIndex) = 0;
+
+		// 分割せずに呼び出しスレッドで直接描画する
+		virtual void SubmitDirect(uint32_t begin, uint32_t end) = 0;
+	};
+
+
+	/**
+	 * 描画パケットの並列記録
+	 * ソート済みのパケット列を連続した範囲に分割し、範囲毎にスレッドプールで記録してから順に実行する
+	 * 範囲は連続していて実行は記録順なので、描画順は分割しない場合と同じ
+	 * パケットが少ない場合、記録先やワーカーがない場合は直接描画する
+	 */
+	class ParallelSubmit
+	{
+	public:
+		// 1範囲あたりの最小パケット数(コマンドリストの作成、実行のコストに見合う量)
+		static const uint32_t DefaultMinChunkPackets = 128;
+
+		struct Chunk
+		{
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		// 直近のSubmit()の結果
+		struct Stats
+		{
+			uint32_t packets;
+			uint32_t chunks;		// 0: 直接描画した
+		};
+
+	private:
+		std::vector<Chunk> chunks_;
+		uint32_t minChunkPackets_;
+		Stats stats_;
+
+	public:
+		ParallelSubmit();
+
+		void SetMinChunkPackets(uint32_t count) { minChunkPackets_ = count; }
+		uint32_t GetMinChunkPackets() const { return minChunkPackets_; }
+
+		// packetCountをcontextCount個以下の範囲に均等に分割する(各範囲はminChunkPackets以上、パケットがあれば最低1範囲)
+		static void Split(uint32_t packetCount, uint32_t contextCount, uint32_t minChunkPackets, std::vector<Chunk>& chunks);
+
+		// [0, packetCount)を分割してpoolで記録し、呼び出しスレッドで順に実行する
+		void Submit(CommandListDevice& device, uint32_t packetCount, ThreadPool* pool);
+
+		const std::vector<Chunk>& GetChunks() const { return chunks_; }
+		const Stats& GetStats() const { return stats_; }
+	};
+}
@@ -0,0 +1,41 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/PolygonBuckets.h"
+
+namespace se
+{
+	void PolygonBuckets::Build(const int32_t* ids, uint32_t count, uint32_t bucketCount)
+	{
+		// バケット毎の数を数え上げて先頭位置を求める
+		offsets_.assign(bucketCount + 1, 0);
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t bucket = static_cast<uint32_t>(ids[i]);
+			if (bucket < bucketCount) {
+				offsets_[bucket + 1]++;
+			}
+		}
+		for (uint32_t b = 0; b < bucketCount; b++) {
+			offsets_[b + 1] += offsets_[b];
+		}
+
+		// 各バケットにポリゴン番号順に書き込む
+		cursors_.assign(offsets_.begin(), offsets_.end() - 1);
+		polygons_.resize(offsets_[bucketCount]);
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t bucket = static_cast<uint32_t>(ids[i]);
+			if (bucket < bucketCount) {
+				polygons_[cursors_[bucket]++] = static_cast<int32_t>(i);
+			}
+		}
+	}
+
+	void PolygonBuckets::Release()
+	{
+		std::vector<uint32_t>().swap(offsets_);
+		std::vector<uint32_t>().swap(cursors_);
+		std::vector<int32_t>().swap(polygons_);
+	}
+}
@@ -0,0 +1,35 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <vector>
+
+namespace se
+{
+	/**
+	 * ポリゴン毎のバケット番号(シェーダ番号)からバケット毎のポリゴン番号リストを作る(デバイスには依存しない)
+	 * 1回の走査で数え上げ、もう1回の走査で全バケットに振り分ける計数ソート
+	 * バッファは使い回すので、同じインスタンスで繰り返し振り分ければ最大サイズに達した後は確保が発生しない
+	 */
+	class PolygonBuckets
+	{
+	private:
+		std::vector<uint32_t> offsets_;		// バケットの先頭位置(バケット数 + 1)
+		std::vector<uint32_t> cursors_;		// 振り分け中の書き込み位置
+		std::vector<int32_t> polygons_;		// バケット順、各バケット内はポリゴン番号順
+
+	public:
+		// ids[i]がポリゴンiのバケット番号(範囲外(未アサインの-1等)のポリゴンはどこにも入れない)
+		void Build(const int32_t* ids, uint32_t count, uint32_t bucketCount);
+		// 確保したバッファを解放する
+		void Release();
+
+		uint32_t GetBucketCount() const { return offsets_.empty() ? 0 : static_cast<uint32_t>(offsets_.size() - 1); }
+		uint32_t GetCount(uint32_t bucket) const { return offsets_[bucket + 1] - offsets_[bucket]; }
+		const int32_t* GetPolygons(uint32_t bucket) const { return polygons_.data() + offsets_[bucket]; }
+	};
+}
@@ -0,0 +1,136 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/RenderQueue.h"
+#include <cstring>
+
+namespace se
+{
+	namespace {
+		// 基数ソートの1パスあたりのビット数
+		const uint32_t RadixBits = 8;
+		const uint32_t RadixSize = 1 << RadixBits;
+		const uint32_t RadixPassNum = 64 / RadixBits;
+
+		inline uint64_t MaskBits(uint64_t value, uint32_t bits)
+		{
+			return value & ((1ull << bits) - 1);
+		}
+
+		// 正の浮動小数はビット列の大小と値の大小が一致するので上位ビットを深度値に使う
+		inline uint32_t QuantizeDepth(float depth, uint32_t bits)
+		{
+			if (!(depth > 0.0f)) return 0;
+			uint32_t value;
+			memcpy(&value, &depth, sizeof(value));
+			return value >> (32 - bits);
+		}
+	}
+
+
+	RenderQueue::RenderQueue()
+	{
+		worldToView_.Ident();
+	}
+
+	uint64_t RenderQueue::MakeSortKey(uint32_t pass, uint32_t blend, uint32_t shader, uint32_t layout, uint32_t material, float depth)
+	{
+		uint64_t key = MaskBits(pass, 2) << 62;
+		key |= MaskBits(blend, 3) << 59;
+		if (blend == 0) {
+			// 不透明はステート変更が少なくなるよう並べ、同じステート内は手前から
+			key |= MaskBits(shader, 16) << 43;
+			key |= MaskBits(layout, 12) << 31;
+			key |= MaskBits(material, 16) << 15;
+			key |= QuantizeDepth(depth, 15);
+		} else {
+			// 半透明は奥から手前に描画
+			key |= MaskBits(~QuantizeDepth(depth, 24), 24) << 35;
+			key |= MaskBits(shader, 16) << 19;
+			key |= MaskBits(material, 19);
+		}
+		return key;
+	}
+
+	float RenderQueue::GetViewDepth(const Vector3& position) const
+	{
+		const Matrix44& m = worldToView_;
+		float z = position.x * m._13 + position.y * m._23 + position.z * m._33 + m._43;
+		return -z;
+	}
+
+	void RenderQueue::Clear()
+	{
+		packets_.clear();
+	}
+
+	void RenderQueue::Reserve(uint32_t count)
+	{
+		packets_.reserve(count);
+		sortBuffer_.reserve(count);
+	}
+
+	void RenderQueue::Push(uint64_t sortKey, Drawable* drawable, uint32_t param)
+	{
+		DrawPacket packet = { sortKey, drawable, param };
+		packets_.push_back(packet);
+	}
+
+	void RenderQueue::Sort()
+	{
+		uint32_t count = Count();
+		if (count <= 1) return;
+
+		// 全桁のヒストグラムを一度に作成
+		uint32_t histogram[RadixPassNum][RadixSize] = {};
+		for (const DrawPacket& packet : packets_) {
+			uint64_t key = packet.sortKey;
+			for (uint32_t pass = 0; pass < RadixPassNum; pass++) {
+				histogram[pass][(key >> (pass * RadixBits)) & (RadixSize - 1)]++;
+			}
+		}
+
+		// 下位の桁から安定ソート(全要素が同じ桁はスキップ)
+		sortBuffer_.resize(count);
+		DrawPacket* src = packets_.data();
+		DrawPacket* dst = sortBuffer_.data();
+		for (uint32_t pass = 0; pass < RadixPassNum; pass++) {
+			uint32_t* counts = histogram[pass];
+			uint32_t shift = pass * RadixBits;
+			if (counts[(src[0].sortKey >> shift) & (RadixSize - 1)] == count) continue;
+
+			uint32_t offsets[RadixSize];
+			uint32_t sum = 0;
+			for (uint32_t i = 0; i < RadixSize; i++) {
+				offsets[i] = sum;
+				sum += counts[i];
+			}
+			for (uint32_t i = 0; i < count; i++) {
+				dst[offsets[(src[i].sortKey >> shift) & (RadixSize - 1)]++] = src[i];
+			}
+			std::swap(src, dst);
+		}
+
+		// 結果が作業バッファ側にある場合は入れ替える
+		if (src != packets_.data()) {
+			packets_.swap(sortBuffer_);
+		}
+	}
+
+	void RenderQueue::Submit(GraphicsContext& context)
+	{
+		for (const DrawPacket& packet : packets_) {
+			packet.drawable->SubmitDrawPacket(context, packet.param);
+		}
+	}
+
+	void RenderQueue::Submit(GraphicsContext& context, uint32_t begin, uint32_t end) const
+	{
+		for (uint32_t i = begin; i < end; i++) {
+			const DrawPacket& packet = packets_[i];
+			packet.drawable->SubmitDrawPacket(context, packet.param);
+		}
+	}
+}
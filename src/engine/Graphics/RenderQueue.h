@@ -0,0 +1,76 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Math/Math.h"
+#include <vector>
+
+namespace se
+{
+	class GraphicsContext;
+
+	/**
+	 * 描画パケットの発行元
+	 */
+	class Drawable
+	{
+	public:
+		virtual ~Drawable() {}
+
+		// paramはパケット登録時に指定した値
+		virtual void SubmitDrawPacket(GraphicsContext& context, uint32_t param) = 0;
+	};
+
+
+	/**
+	 * 描画パケット
+	 */
+	struct DrawPacket
+	{
+		uint64_t sortKey;
+		Drawable* drawable;
+		uint32_t param;
+	};
+
+
+	/**
+	 * 描画キュー
+	 * 登録されたパケットをソートキーの昇順に並べ替えてから描画する
+	 *
+	 * ソートキーの構成(上位ビットから)
+	 *   不透明 : パス(2) ブレンド(3) シェーダ(16) 頂点レイアウト(12) マテリアル(16) 深度(15, 手前から)
+	 *   半透明 : パス(2) ブレンド(3) 深度(24, 奥から) シェーダ(16) マテリアル(19)
+	 */
+	class RenderQueue
+	{
+	private:
+		std::vector<DrawPacket> packets_;
+		std::vector<DrawPacket> sortBuffer_;
+		Matrix44 worldToView_;
+
+	public:
+		RenderQueue();
+
+		// ソートキー作成
+		// blendは0が不透明、それ以外は半透明として奥から手前に並べる
+		// shader, layout, materialは同じ値をまとめるための識別値(上位ビットは切り捨てる)
+		static uint64_t MakeSortKey(uint32_t pass, uint32_t blend, uint32_t shader, uint32_t layout, uint32_t material, float depth);
+
+		// 深度計算用のビューマトリクス(行ベクトル規約、-Z方向が前方)
+		void SetView(const Matrix44& worldToView) { worldToView_ = worldToView; }
+		float GetViewDepth(const Vector3& position) const;
+
+		void Clear();
+		void Reserve(uint32_t count);
+		void Push(uint64_t sortKey, Drawable* drawable, uint32_t param);
+		void Sort();
+		void Submit(GraphicsContext& context);
+		void Submit(GraphicsContext& context, uint32_t begin, uint32_t end) const;		// ソート後の[begin, end)のみ
+
+		uint32_t Count() const { return static_cast<uint32_t>(packets_.size()); }
+		const DrawPacket& GetPacket(uint32_t index) const { return packets_[index]; }
+	};
+}
@@ -0,0 +1,102 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/RingAllocator.h"
+#include <cstring>
+
+namespace se
+{
+	RingAllocator::RingAllocator()
+		: capacity_(0)
+		, head_(0)
+		, used_(0)
+		, frameSize_(0)
+	{
+		memset(&stats_, 0, sizeof(stats_));
+	}
+
+	void RingAllocator::Initialize(uint32_t capacity)
+	{
+		Finalize();
+		capacity_ = capacity;
+		stats_.capacity = capacity;
+	}
+
+	void RingAllocator::Finalize()
+	{
+		capacity_ = 0;
+		head_ = 0;
+		used_ = 0;
+		frameSize_ = 0;
+		frames_.clear();
+		memset(&stats_, 0, sizeof(stats_));
+	}
+
+	uint32_t RingAllocator::Allocate(uint32_t size, uint32_t alignment)
+	{
+		if (size == 0 || size > capacity_) {
+			stats_.failures++;
+			return InvalidOffset;
+		}
+
+		// 末尾に収まらなければ先頭に折り返す(末尾の余りも使用中として扱い、そのフレームと一緒に解放する)
+		uint64_t aligned = (static_cast<uint64_t>(head_) + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+		uint64_t consumed;
+		bool wrap = aligned + size > capacity_;
+		if (wrap) {
+			aligned = 0;
+			consumed = static_cast<uint64_t>(capacity_ - head_) + size;
+		} else {
+			consumed = aligned - head_ + size;
+		}
+
+		// 使用中の領域に重ならないか(使用中の量と合わせて容量に収まれば重ならない)
+		if (used_ + consumed > capacity_) {
+			stats_.failures++;
+			return InvalidOffset;
+		}
+
+		uint32_t offset = static_cast<uint32_t>(aligned);
+		head_ = offset + size;
+		if (head_ == capacity_) head_ = 0;
+		used_ += static_cast<uint32_t>(consumed);
+		frameSize_ += static_cast<uint32_t>(consumed);
+
+		stats_.allocations++;
+		stats_.allocatedBytes += size;
+		if (wrap) stats_.wraps++;
+		stats_.inFlightBytes = used_;
+		if (used_ > stats_.peakBytes) stats_.peakBytes = used_;
+		return offset;
+	}
+
+	void RingAllocator::EndFrame(uint64_t fence)
+	{
+		// 割り当てのないフレームは記録しない
+		if (frameSize_ > 0) {
+			Frame frame;
+			frame.fence = fence;
+			frame.size = frameSize_;
+			frames_.push_back(frame);
+			frameSize_ = 0;
+		}
+		stats_.inFlightFrames = static_cast<uint32_t>(frames_.size());
+	}
+
+	void RingAllocator::Retire(uint64_t completedFence)
+	{
+		while (!frames_.empty() && frames_.front().fence <= completedFence) {
+			used_ -= frames_.front().size;
+			frames_.pop_front();
+		}
+
+		// 全て空いたら先頭から使う(折り返しを減らす)
+		if (used_ == 0) {
+			head_ = 0;
+		}
+		stats_.inFlightBytes = used_;
+		stats_.inFlightFrames = static_cast<uint32_t>(frames_.size());
+	}
+}
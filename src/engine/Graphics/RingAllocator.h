@@ -0,0 +1,68 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <deque>
+
+namespace se
+{
+	/**
+	 * リングバッファの領域の割り当て(GPUバッファには依存しない)
+	 * 割り当てた領域はフレーム単位でまとめ、GPUがそのフレームを使い終えたフェンス値を受け取ってから再利用する
+	 * 空きが足りない場合は失敗を返すので、呼び出し側は個別のバッファに書き込むなどして対応する
+	 */
+	class RingAllocator
+	{
+	public:
+		static const uint32_t InvalidOffset = 0xFFFFFFFF;
+
+		struct Stats
+		{
+			uint32_t capacity;
+			uint32_t inFlightBytes;		// GPUの使用待ちを含む使用中の量(末尾で折り返した余りを含む)
+			uint32_t peakBytes;			// inFlightBytesの最大
+			uint32_t inFlightFrames;	// 使用待ちのフレーム数
+			uint64_t allocations;
+			uint64_t allocatedBytes;
+			uint64_t failures;			// 空きが足りずに失敗した数
+			uint64_t wraps;				// 先頭に折り返した数
+		};
+
+	private:
+		// 使用待ちのフレーム
+		struct Frame
+		{
+			uint64_t fence;
+			uint32_t size;		// フレーム内で消費した量
+		};
+
+		uint32_t capacity_;
+		uint32_t head_;			// 次に書き込む位置
+		uint32_t used_;			// 使用中の量(head_の手前のused_バイト、フレーム順に解放するので先頭の位置は持たない)
+		uint32_t frameSize_;	// 現在のフレームで消費した量
+		std::deque<Frame> frames_;
+		Stats stats_;
+
+	public:
+		RingAllocator();
+
+		void Initialize(uint32_t capacity);
+		void Finalize();
+
+		// alignmentは2のべき乗、失敗した場合はInvalidOffset
+		uint32_t Allocate(uint32_t size, uint32_t alignment);
+
+		// 現在のフレームの割り当てをfenceで締める(fenceは単調増加)
+		void EndFrame(uint64_t fence);
+		// completedFence以下のフレームの領域を解放する
+		void Retire(uint64_t completedFence);
+
+		uint32_t GetCapacity() const { return capacity_; }
+		uint32_t GetUsedBytes() const { return used_; }
+		const Stats& GetStats() const { return stats_; }
+	};
+}
@@ -5,13 +5,14 @@
 
 #include "engine/Graphics/Shader.h"
 #include "engine/Graphics/GraphicsCore.h"
+#include "engine/Graphics/VertexPacker.h"
 #include "ext/picojson/picojson.h"
 
 namespace se
 {
 	namespace
 	{
-		void CompileShaderFromFile(const wchar_t* szFileName, const char* szEntryPoint, const char* szShaderModel, ID3DBlob** ppBlobOut)
+		void CompileShaderFromFile(const wchar_t* szFileName, const char* szEntryPoint, const char* szShaderModel, ID3DBlob** ppBlobOut, const D3D_SHADER_MACRO* defines = nullptr)
 		{
 			HRESULT hr = S_OK;
 			DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
@@ -23,7 +24,7 @@ namespace se
 			ID3DBlob* pErrorBlob = nullptr;
 			hr = D3DCompileFromFile(
 				szFileName,
-				NULL,
+				defines,
 				D3D_COMPILE_STANDARD_FILE_INCLUDE,
 				szEntryPoint,
 				szShaderModel,
@@ -44,13 +45,13 @@ namespace se
 			COMPTR_RELEASE(pErrorBlob);
 		}
 
-		void CompileShaderFromFile(const char* szFileName, const char* szEntryPoint, const char* szShaderModel, ID3DBlob** ppBlobOut)
+		void CompileShaderFromFile(const char* szFileName, const char* szEntryPoint, const char* szShaderModel, ID3DBlob** ppBlobOut, const D3D_SHADER_MACRO* defines = nullptr)
 		{
 			size_t size = 0;
 			wchar_t buffer[MAX_PATH] = { 0 };
 			size_t chr_len = strlen(szFileName) + 1;
 			mbstowcs_s(&size, buffer, chr_len, szFileName, _TRUNCATE);
-			CompileShaderFromFile(buffer, szEntryPoint, szShaderModel, ppBlobOut);
+			CompileShaderFromFile(buffer, szEntryPoint, szShaderModel, ppBlobOut, defines);
 		}
 
 		void CompileShaderFromString(const char* str, int length, const char* szEntryPoint, const char* szShaderModel, ID3DBlob** ppBlobOut)
@@ -146,6 +147,12 @@ namespace se
 		return attr;
 	}
 
+	bool ShaderReflection::HasResource(const char* name)
+	{
+		D3D11_SHADER_INPUT_BIND_DESC desc;
+		return SUCCEEDED(reflection_->GetResourceBindingDescByName(name, &desc));
+	}
+
 	/* ********************************************************************************************* */
 
 	void VertexLayoutManager::Initialize()
@@ -157,11 +164,13 @@ namespace se
 		layoutMap_.clear();
 	}
 
-	const VertexInputLayout* VertexLayoutManager::GetLayout(const VertexShader& shader, uint32_t vertexAttr)
+	const VertexInputLayout* VertexLayoutManager::GetLayout(const VertexShader& shader, uint32_t vertexAttr, bool interleaved, bool quantized)
 	{
 		// 既存データから検索
 		Assert(sizeof(size_t) == 8);	// 64bit only
-		size_t hash = (vertexAttr | (static_cast<size_t>(shader.GetVertexAttribute()) << 32));
+		Assert((vertexAttr & (VertexLayoutInterleaved | VertexLayoutQuantized)) == 0);
+		uint32_t key = vertexAttr | (interleaved ? VertexLayoutInterleaved : 0) | (quantized ? VertexLayoutQuantized : 0);
+		size_t hash = (key | (static_cast<size_t>(shader.GetVertexAttribute()) << 32));
 		auto iter = layoutMap_.find(hash);
 		if (iter != layoutMap_.end()) {
 			Assert((iter->second.shaderAttr = shader.GetVertexAttribute()) && iter->second.vertexAttr == vertexAttr);
@@ -173,50 +182,39 @@ namespace se
 		VertexInputLayout& layout = pair.first->second;
 
 		// 見つからなかったら生成
-		D3D11_INPUT_ELEMENT_DESC desc[16];
+		// 分割時は属性毎にスロットを割り当て、インターリーブ時はスロット0にVertexPackerのオフセットで並べる
+		// 量子化時のフォーマットはVertexQuantizerと一致させる
+		static const struct {
+			const char* semantic;
+			uint32_t index;
+			DXGI_FORMAT format;
+			DXGI_FORMAT quantizedFormat;
+		} elements[VERTEX_ATTR_NUM] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT },
+			{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R16G16_SNORM },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R16G16_FLOAT },
+			{ "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R16G16_FLOAT },
+			{ "TEXCOORD", 2, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R16G16_FLOAT },
+			{ "TEXCOORD", 3, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R16G16_FLOAT },
+			{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R16G16_SNORM },
+			{ "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R16G16_SNORM },
+		};
+		D3D11_INPUT_ELEMENT_DESC desc[VERTEX_ATTR_NUM];
 		uint32_t count = 0;
-		if (vertexAttr & VERTEX_ATTR_FLAG_POSITION) {
-			D3D11_INPUT_ELEMENT_DESC t = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_NORMAL) {
-			D3D11_INPUT_ELEMENT_DESC t = { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_COLOR) {
-			D3D11_INPUT_ELEMENT_DESC t = { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_TEXCOORD0) {
-			D3D11_INPUT_ELEMENT_DESC t = { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_TEXCOORD1) {
-			D3D11_INPUT_ELEMENT_DESC t = { "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_TEXCOORD2) {
-			D3D11_INPUT_ELEMENT_DESC t = { "TEXCOORD", 2, DXGI_FORMAT_R32G32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_TEXCOORD3) {
-			D3D11_INPUT_ELEMENT_DESC t = { "TEXCOORD", 3, DXGI_FORMAT_R32G32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_TANGENT) {
-			D3D11_INPUT_ELEMENT_DESC t = { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-			desc[count] = t;
-			count++;
-		}
-		if (vertexAttr & VERTEX_ATTR_FLAG_BITANGENT) {
-			D3D11_INPUT_ELEMENT_DESC t = { "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, count, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+		for (uint32_t i = 0; i < VERTEX_ATTR_NUM; i++) {
+			if (!(vertexAttr & (1 << i))) continue;
+
+			VertexAttribute attribute = static_cast<VertexAttribute>(i);
+			D3D11_INPUT_ELEMENT_DESC t = {
+				elements[i].semantic,
+				elements[i].index,
+				quantized ? elements[i].quantizedFormat : elements[i].format,
+				interleaved ? 0 : count,
+				interleaved ? VertexPacker::GetOffset(vertexAttr, attribute, quantized) : 0,
+				D3D11_INPUT_PER_VERTEX_DATA,
+				0
+			};
 			desc[count] = t;
 			count++;
 		}
@@ -225,6 +223,8 @@ namespace se
 		Assert(SUCCEEDED(hr));
 		layout.shaderAttr = shader.GetVertexAttribute();
 		layout.vertexAttr = vertexAttr;
+		layout.interleaved = interleaved;
+		layout.quantized = quantized;
 
 		return &layout;
 	}
@@ -261,9 +261,9 @@ namespace se
 		}
 	}
 
-	void VertexShader::CompileFromFile(const char* fileName, const char* entryPoint, ShaderReflection* reflection)
+	void VertexShader::CompileFromFile(const char* fileName, const char* entryPoint, ShaderReflection* reflection, const D3D_SHADER_MACRO* defines)
 	{
-		CompileShaderFromFile(fileName, entryPoint, "vs_5_0", &blob_);
+		CompileShaderFromFile(fileName, entryPoint, "vs_5_0", &blob_, defines);
 		HRESULT hr = GraphicsCore::GetDevice()->CreateVertexShader(blob_->GetBufferPointer(), blob_->GetBufferSize(), nullptr, &shader_);
 		THROW_IF_FAILED(hr);
 		data_ = blob_->GetBufferPointer();
@@ -357,6 +357,68 @@ namespace se
 
 	/* ********************************************************************************************* */
 
+	namespace {
+		// 量子化頂点用のVS(法線系をDecodeOctahedral()で復元する)
+		// UV、カラーはハードウェアで変換されるので法線系を使わないシェーダはそのまま使える
+		const uint32_t OctahedralAttributes = VERTEX_ATTR_FLAG_NORMAL | VERTEX_ATTR_FLAG_TANGENT | VERTEX_ATTR_FLAG_BITANGENT;
+		const D3D_SHADER_MACRO QuantizedVertexDefines[] = {
+			{ "VERTEX_QUANTIZED", "1" },
+			{ nullptr, nullptr },
+		};
+
+		void CompileQuantizedVS(VertexShader& quantizedVS, const VertexShader& vs, const std::string& fileName, const std::string& entryPoint)
+		{
+			if (!(vs.GetVertexAttribute() & OctahedralAttributes)) return;
+			quantizedVS.CompileFromFile(fileName.c_str(), entryPoint.c_str(), nullptr, QuantizedVertexDefines);
+		}
+
+		// GPUスキニング用のVS(SkinVertexPosition()等でSkinPaletteを参照するシェーダのみ)
+		const D3D_SHADER_MACRO SkinnedVertexDefines[] = {
+			{ "VERTEX_SKINNED", "1" },
+			{ nullptr, nullptr },
+		};
+		const D3D_SHADER_MACRO SkinnedQuantizedVertexDefines[] = {
+			{ "VERTEX_SKINNED", "1" },
+			{ "VERTEX_QUANTIZED", "1" },
+			{ nullptr, nullptr },
+		};
+
+		void CompileSkinnedVS(VertexShader& skinnedVS, VertexShader& skinnedQuantizedVS, const VertexShader& vs, const std::string& fileName, const std::string& entryPoint)
+		{
+			ShaderReflection reflection;
+			skinnedVS.CompileFromFile(fileName.c_str(), entryPoint.c_str(), &reflection, SkinnedVertexDefines);
+			if (!reflection.HasResource("SkinPalette")) {
+				skinnedVS.Destroy();
+				return;
+			}
+			if (!(vs.GetVertexAttribute() & OctahedralAttributes)) return;
+			skinnedQuantizedVS.CompileFromFile(fileName.c_str(), entryPoint.c_str(), nullptr, SkinnedQuantizedVertexDefines);
+		}
+
+		// シェーダ定義のブレンド指定を取得(省略時は不透明)
+		BlendState::BlendType GetBlendType(picojson::object& obj)
+		{
+			static const char* names[] = {
+				"Opacity",
+				"Translucent",
+				"Additive",
+				"Modulate",
+				"Subtruct",
+			};
+			static_assert(ARRAYSIZE(names) == BlendState::BlendTypeNum, "blend type names mismatch");
+
+			auto iter = obj.find("Blend");
+			if (iter == obj.end() || !iter->second.is<std::string>()) return BlendState::Opacity;
+
+			const std::string& name = iter->second.get<std::string>();
+			for (int32_t i = 0; i < BlendState::BlendTypeNum; i++) {
+				if (name == names[i]) return static_cast<BlendState::BlendType>(i);
+			}
+			Printf("Unknown blend type / %s\n", name.c_str());
+			return BlendState::Opacity;
+		}
+	}
+
 	void ShaderManager::Initialize(const char* directoryPath)
 	{
 		try {
@@ -383,9 +445,14 @@ namespace se
 				auto pair = shaderMap_.emplace(shaderHash, ShaderSet());
 				Assert(pair.second);
 				ShaderSet& shader = pair.first->second;
+				shader.hash_ = shaderHash;
+				shader.name_ = name;
+				shader.blendType_ = GetBlendType(obj);
 				
 				Printf("Shader Compile / %s : %s\n", name.c_str(), fileName.c_str());
 				shader.vs_.CompileFromFile(fileName.c_str(), vs.c_str());
+				CompileQuantizedVS(shader.quantizedVS_, shader.vs_, fileName, vs);
+				CompileSkinnedVS(shader.skinnedVS_, shader.skinnedQuantizedVS_, shader.vs_, fileName, vs);
 				if (ps.length() > 0) {
 					shader.ps_.CompileFromFile(fileName.c_str(), ps.c_str());
 				}
@@ -429,10 +496,16 @@ namespace se
 				if (shader) {
 					// 元のシェーダを破棄
 					shader->vs_.Destroy();
+					shader->quantizedVS_.Destroy();
+					shader->skinnedVS_.Destroy();
+					shader->skinnedQuantizedVS_.Destroy();
 					shader->ps_.Destroy();
+					shader->blendType_ = GetBlendType(obj);
 
 					Printf("Shader Compile / %s : %s\n", name.c_str(), fileName.c_str());
 					shader->vs_.CompileFromFile(fileName.c_str(), vs.c_str());
+					CompileQuantizedVS(shader->quantizedVS_, shader->vs_, fileName, vs);
+					CompileSkinnedVS(shader->skinnedVS_, shader->skinnedQuantizedVS_, shader->vs_, fileName, vs);
 					if (ps.length() > 0) {
 						shader->ps_.CompileFromFile(fileName.c_str(), ps.c_str());
 					}
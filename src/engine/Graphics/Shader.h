@@ -7,6 +7,7 @@
 
 #include "engine/Graphics/GraphicsCommon.h"
 #include "engine/Graphics/GraphicsContext.h"
+#include "engine/Graphics/GraphicsStates.h"
 #include <unordered_map>
 
 namespace se
@@ -27,6 +28,7 @@ namespace se
 
 		void Create(const void* data, size_t size);
 		uint32_t GetVertexLayoutAttribute();
+		bool HasResource(const char* name);		// 指定した名前のリソースを参照しているか
 	};
 
 	/**
@@ -37,11 +39,15 @@ namespace se
 		ID3D11InputLayout* layout;
 		uint32_t vertexAttr;
 		uint32_t shaderAttr;
+		bool interleaved;		// 全属性を1本の頂点バッファから読み込む
+		bool quantized;			// VertexQuantizerの形式で読み込む
 
 		VertexInputLayout()
 			: layout(nullptr)
 			, vertexAttr(0)
 			, shaderAttr(0)
+			, interleaved(false)
+			, quantized(false)
 		{
 		}
 
@@ -72,6 +78,10 @@ namespace se
 			uint32_t shaderAttr;
 		};
 
+		// 検索キーでインターリーブ、量子化を区別するビット(頂点アトリビュートとは重ならない)
+		static const uint32_t VertexLayoutInterleaved = 1u << 31;
+		static const uint32_t VertexLayoutQuantized = 1u << 30;
+
 	private:
 		std::unordered_map<size_t, VertexInputLayout> layoutMap_;
 
@@ -79,7 +89,8 @@ namespace se
 		void Initialize();
 		void Finalize();
 
-		const VertexInputLayout* GetLayout(const VertexShader& shader, uint32_t vertexAttr);
+		// interleavedの場合はVertexPackerで詰めた1本のストリーム用、quantizedの場合はVertexQuantizerの形式のレイアウトを返す
+		const VertexInputLayout* GetLayout(const VertexShader& shader, uint32_t vertexAttr, bool interleaved = false, bool quantized = false);
 	};
 
 	/**
@@ -105,7 +116,7 @@ namespace se
 		size_t GetByteCodeSize() const { return dataSize_; }
 		uint32_t GetVertexAttribute() const { return vertexAttribute_; }
 		void CreateFromByteCode(const void* data, int size, ShaderReflection* reflection = nullptr);
-		void CompileFromFile(const char* fileName, const char* entryPoint = "main", ShaderReflection* reflection = nullptr);
+		void CompileFromFile(const char* fileName, const char* entryPoint = "main", ShaderReflection* reflection = nullptr, const D3D_SHADER_MACRO* defines = nullptr);
 		void CompileFromString(const char* source, int length, const char* entryPoint = "main", ShaderReflection* reflection = nullptr);
 		void Destroy();
 	};
@@ -140,14 +151,30 @@ namespace se
 		friend class ShaderManager;
 	private:
 		VertexShader vs_;
+		VertexShader quantizedVS_;		// 量子化頂点用(法線系を使わないシェーダでは作らない)
+		VertexShader skinnedVS_;		// GPUスキニング用(スキニングに対応しないシェーダでは作らない)
+		VertexShader skinnedQuantizedVS_;
 		PixelShader ps_;
+		size_t hash_;
+		std::string name_;
+		BlendState::BlendType blendType_;
 
 	public:
-		ShaderSet() {};
+		ShaderSet() : hash_(0), blendType_(BlendState::Opacity) {};
 		~ShaderSet() {};
 
 		const VertexShader& GetVS() const { return vs_; }
+		const VertexShader& GetVS(bool quantized) const { return (quantized && quantizedVS_.Get()) ? quantizedVS_ : vs_; }
+		const VertexShader& GetVS(bool quantized, bool skinned) const
+		{
+			if (!skinned || !skinnedVS_.Get()) return GetVS(quantized);
+			return (quantized && skinnedQuantizedVS_.Get()) ? skinnedQuantizedVS_ : skinnedVS_;
+		}
+		bool IsSkinningSupported() const { return skinnedVS_.Get() != nullptr; }
 		const PixelShader& GetPS() const { return ps_; }
+		size_t GetHash() const { return hash_; }						// 名前のハッシュ値
+		const std::string& GetName() const { return name_; }			// 名前
+		BlendState::BlendType GetBlendType() const { return blendType_; }
 	};
 
 
@@ -0,0 +1,175 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/Skinning.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace se
+{
+	namespace
+	{
+		// 行ベクトルp(w = 1)を行列で変換
+		inline void TransformPoint(const float* p, const float* m, float* output)
+		{
+			float x = p[0], y = p[1], z = p[2];
+			for (uint32_t c = 0; c < 3; c++) {
+				output[c] = x * m[c] + y * m[4 + c] + z * m[8 + c] + m[12 + c];
+			}
+		}
+	}
+
+	void Skinning::PackInfluences(const double* weights, uint32_t vertexCount, uint32_t jointCount, SkinInfluence* output)
+	{
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			const double* src = weights + static_cast<size_t>(v) * jointCount;
+			SkinInfluence& influence = output[v];
+
+			// 大きい順に4つ(同じ値はジョイント番号の小さい方を優先)
+			uint32_t joints[SKIN_INFLUENCE_NUM] = {};
+			double values[SKIN_INFLUENCE_NUM] = {};
+			uint32_t count = 0;
+			for (uint32_t j = 0; j < jointCount; j++) {
+				double w = src[j];
+				if (!(w > 0.0)) continue;
+				uint32_t k = (count < SKIN_INFLUENCE_NUM) ? count++ : SKIN_INFLUENCE_NUM;
+				if (k == SKIN_INFLUENCE_NUM) {
+					if (w <= values[SKIN_INFLUENCE_NUM - 1]) continue;
+					k = SKIN_INFLUENCE_NUM - 1;
+				}
+				for (; k > 0 && values[k - 1] < w; k--) {
+					values[k] = values[k - 1];
+					joints[k] = joints[k - 1];
+				}
+				values[k] = w;
+				joints[k] = j;
+			}
+
+			memset(&influence, 0, sizeof(influence));
+			if (count == 0) {
+				influence.weights[0] = 255;
+				continue;
+			}
+
+			// 正規化してunorm8に丸め、丸め誤差は最大のウェイトで吸収する
+			double total = 0.0;
+			for (uint32_t k = 0; k < count; k++) {
+				total += values[k];
+			}
+			int32_t sum = 0;
+			for (uint32_t k = 0; k < count; k++) {
+				int32_t q = static_cast<int32_t>(values[k] / total * 255.0 + 0.5);
+				influence.joints[k] = static_cast<uint16_t>(joints[k]);
+				influence.weights[k] = static_cast<uint8_t>(q);
+				sum += q;
+			}
+			influence.weights[0] = static_cast<uint8_t>(influence.weights[0] + (255 - sum));
+		}
+	}
+
+	void Skinning::BuildBindMatrices(const float* geometry, const float* bindPreMatrices, uint32_t jointCount, float* output)
+	{
+		for (uint32_t j = 0; j < jointCount; j++) {
+			MultiplyMatrix(geometry, bindPreMatrices + j * 16, output + j * 16);
+		}
+	}
+
+	void Skinning::BuildPalette(const float* bindMatrices, const float* jointMatrices, uint32_t jointCount, SkinMatrix* palette)
+	{
+		for (uint32_t j = 0; j < jointCount; j++) {
+			float m[16];
+			MultiplyMatrix(bindMatrices + j * 16, jointMatrices + j * 16, m);
+			for (uint32_t r = 0; r < 3; r++) {
+				for (uint32_t c = 0; c < 4; c++) {
+					palette[j].rows[r][c] = m[c * 4 + r];
+				}
+			}
+		}
+	}
+
+	void Skinning::SkinPosition(const SkinInfluence& influence, const SkinMatrix* palette, const float* position, float* output)
+	{
+		float rows[3][4] = {};
+		for (uint32_t k = 0; k < SKIN_INFLUENCE_NUM; k++) {
+			if (influence.weights[k] == 0) continue;
+			float w = influence.weights[k] / 255.0f;
+			const SkinMatrix& m = palette[influence.joints[k]];
+			for (uint32_t r = 0; r < 3; r++) {
+				for (uint32_t c = 0; c < 4; c++) {
+					rows[r][c] += m.rows[r][c] * w;
+				}
+			}
+		}
+		for (uint32_t r = 0; r < 3; r++) {
+			output[r] = rows[r][0] * position[0] + rows[r][1] * position[1] + rows[r][2] * position[2] + rows[r][3];
+		}
+	}
+
+	void Skinning::ComputeJointBounds(const float* positions, uint32_t positionStride, const SkinInfluence* influences, uint32_t vertexCount,
+		const float* bindMatrices, uint32_t jointCount, float* jointBounds)
+	{
+		for (uint32_t j = 0; j < jointCount; j++) {
+			float* bounds = jointBounds + j * 6;
+			bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+			bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			const SkinInfluence& influence = influences[v];
+			for (uint32_t k = 0; k < SKIN_INFLUENCE_NUM; k++) {
+				uint32_t j = influence.joints[k];
+				if (influence.weights[k] == 0 || j >= jointCount) continue;
+				float p[3];
+				TransformPoint(positions + static_cast<size_t>(v) * positionStride, bindMatrices + j * 16, p);
+				float* bounds = jointBounds + j * 6;
+				for (uint32_t c = 0; c < 3; c++) {
+					bounds[c] = (std::min)(bounds[c], p[c]);
+					bounds[3 + c] = (std::max)(bounds[3 + c], p[c]);
+				}
+			}
+		}
+	}
+
+	bool Skinning::ComputeSkinnedBounds(const float* jointBounds, const float* jointMatrices, uint32_t jointCount, float* boundsMin, float* boundsMax)
+	{
+		// 頂点はジョイント毎の変換結果の凸結合なので、各ジョイントで変換したボックスの和に含まれる
+		bool empty = true;
+		for (uint32_t j = 0; j < jointCount; j++) {
+			const float* bounds = jointBounds + j * 6;
+			if (bounds[0] > bounds[3]) continue;
+
+			const float* m = jointMatrices + j * 16;
+			float center[3], extents[3];
+			for (uint32_t c = 0; c < 3; c++) {
+				float bc = (bounds[c] + bounds[3 + c]) * 0.5f;
+				center[c] = bc;
+				extents[c] = (bounds[3 + c] - bounds[c]) * 0.5f;
+			}
+			float tc[3];
+			TransformPoint(center, m, tc);
+			for (uint32_t c = 0; c < 3; c++) {
+				float te = extents[0] * std::fabs(m[c]) + extents[1] * std::fabs(m[4 + c]) + extents[2] * std::fabs(m[8 + c]);
+				float lo = tc[c] - te;
+				float hi = tc[c] + te;
+				boundsMin[c] = empty ? lo : (std::min)(boundsMin[c], lo);
+				boundsMax[c] = empty ? hi : (std::max)(boundsMax[c], hi);
+			}
+			empty = false;
+		}
+		return !empty;
+	}
+
+	void Skinning::MultiplyMatrix(const float* a, const float* b, float* output)
+	{
+		float m[16];
+		for (uint32_t r = 0; r < 4; r++) {
+			for (uint32_t c = 0; c < 4; c++) {
+				m[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c] + a[r * 4 + 2] * b[8 + c] + a[r * 4 + 3] * b[12 + c];
+			}
+		}
+		memcpy(output, m, sizeof(m));
+	}
+}
@@ -0,0 +1,65 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+
+namespace se
+{
+	// 頂点あたりの最大インフルエンス数
+	const uint32_t SKIN_INFLUENCE_NUM = 4;
+
+	/**
+	 * 頂点のインフルエンス(シェーダのSkinInfluencesの1要素、12バイト)
+	 * ウェイトはunorm8で合計が必ず255になる
+	 */
+	struct SkinInfluence
+	{
+		uint16_t joints[SKIN_INFLUENCE_NUM];
+		uint8_t weights[SKIN_INFLUENCE_NUM];
+	};
+	static_assert(sizeof(SkinInfluence) == 12, "SkinInfluence must match the shader layout");
+
+	/**
+	 * パレット行列(シェーダのSkinPaletteの1要素、48バイト)
+	 * 行ベクトル規約の4x4行列を転置した上3行で、float4(p, 1)との内積で変換する
+	 */
+	struct SkinMatrix
+	{
+		float rows[3][4];
+	};
+
+	/**
+	 * GPUスキニングのウェイトの詰め込みとパレット行列の計算(デバイスには依存しない)
+	 * 行列は行ベクトル規約の行優先4x4(Matrix44と同じ並び)のfloat[16]で扱う
+	 */
+	class Skinning
+	{
+	public:
+		// 頂点毎のジョイント数分のウェイト(頂点優先)から大きい順に4つを選び、合計が1になるよう正規化して詰める
+		// 負のウェイトは0とみなし、全て0の頂点はジョイント0に固定する
+		static void PackInfluences(const double* weights, uint32_t vertexCount, uint32_t jointCount, SkinInfluence* output);
+
+		// バインド行列 = geometry * bindPre[j] (バインド時のメッシュ空間 -> ジョイント空間)
+		static void BuildBindMatrices(const float* geometry, const float* bindPreMatrices, uint32_t jointCount, float* output);
+		// パレット行列 = bind[j] * joint[j] (スキンクラスタの出力と同じくメッシュのローカル空間に変換する)
+		static void BuildPalette(const float* bindMatrices, const float* jointMatrices, uint32_t jointCount, SkinMatrix* palette);
+		// 詰めたインフルエンスとパレットで1頂点の位置を変換する(シェーダと同じ計算)
+		static void SkinPosition(const SkinInfluence& influence, const SkinMatrix* palette, const float* position, float* output);
+
+		// ジョイント毎に影響を受ける頂点のバインド時のジョイント空間でのバウンディング(min xyz, max xyzの6要素 x jointCount)
+		// 影響を受ける頂点がないジョイントは空(min > max)になる
+		static void ComputeJointBounds(const float* positions, uint32_t positionStride, const SkinInfluence* influences, uint32_t vertexCount,
+			const float* bindMatrices, uint32_t jointCount, float* jointBounds);
+		// ジョイントのバウンディングを現在のジョイント行列で変換して合わせたもの(変形後の頂点を必ず包む)
+		// 空の場合はfalseを返す
+		static bool ComputeSkinnedBounds(const float* jointBounds, const float* jointMatrices, uint32_t jointCount, float* boundsMin, float* boundsMax);
+
+		// 4x4行列の積(output = a * b、outputはa, bと重なってもよい)
+		static void MultiplyMatrix(const float* a, const float* b, float* output);
+	};
+}
@@ -0,0 +1,173 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/StateFilter.h"
+
+namespace se
+{
+	StateFilter::StateFilter()
+		: device_(nullptr)
+	{
+		ResetStats();
+	}
+
+	void StateFilter::Invalidate()
+	{
+		vertexShader_.valid = false;
+		pixelShader_.valid = false;
+		inputLayout_.valid = false;
+		topology_.valid = false;
+		blendState_.valid = false;
+		depthStencilState_.valid = false;
+		rasterizerState_.valid = false;
+		indexBuffer_.valid = false;
+		for (auto& shadow : vertexBuffers_) shadow.valid = false;
+		for (auto& shadow : vsResources_) shadow.valid = false;
+		for (auto& shadow : psResources_) shadow.valid = false;
+		for (auto& shadow : psSamplers_) shadow.valid = false;
+		for (auto& shadow : vsConstantBuffers_) shadow.valid = false;
+		for (auto& shadow : psConstantBuffers_) shadow.valid = false;
+		for (auto& shadow : csConstantBuffers_) shadow.valid = false;
+	}
+
+	void StateFilter::ResetStats()
+	{
+		stats_.issued = 0;
+		stats_.filtered = 0;
+	}
+
+	template <class T>
+	bool StateFilter::Filter(Shadow<T>& shadow, const T& value)
+	{
+		if (shadow.Set(value)) {
+			stats_.issued++;
+			return true;
+		}
+		stats_.filtered++;
+		return false;
+	}
+
+	template <class T>
+	bool StateFilter::FilterSlot(Shadow<T>* shadows, uint32_t slotNum, uint32_t slot, const T& value)
+	{
+		// 保持していないスロットはそのまま通す
+		if (slot >= slotNum) {
+			stats_.issued++;
+			return true;
+		}
+		return Filter(shadows[slot], value);
+	}
+
+	void StateFilter::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		if (Filter(vertexShader_, shader)) {
+			device_->SetVertexShader(shader);
+		}
+	}
+
+	void StateFilter::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		if (Filter(pixelShader_, shader)) {
+			device_->SetPixelShader(shader);
+		}
+	}
+
+	void StateFilter::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		if (Filter(inputLayout_, layout)) {
+			device_->SetInputLayout(layout);
+		}
+	}
+
+	void StateFilter::SetPrimitiveTopology(uint32_t topology)
+	{
+		if (Filter(topology_, topology)) {
+			device_->SetPrimitiveTopology(topology);
+		}
+	}
+
+	void StateFilter::SetBlendState(ID3D11BlendState* state)
+	{
+		if (Filter(blendState_, state)) {
+			device_->SetBlendState(state);
+		}
+	}
+
+	void StateFilter::SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef)
+	{
+		DepthStencilBinding binding = { state, stencilRef };
+		if (Filter(depthStencilState_, binding)) {
+			device_->SetDepthStencilState(state, stencilRef);
+		}
+	}
+
+	void StateFilter::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		if (Filter(rasterizerState_, state)) {
+			device_->SetRasterizerState(state);
+		}
+	}
+
+	void StateFilter::SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset)
+	{
+		VertexBufferBinding binding = { buffer, stride, offset };
+		if (FilterSlot(vertexBuffers_, VertexBufferSlotNum, slot, binding)) {
+			device_->SetVertexBuffer(slot, buffer, stride, offset);
+		}
+	}
+
+	void StateFilter::SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format)
+	{
+		IndexBufferBinding binding = { buffer, format };
+		if (Filter(indexBuffer_, binding)) {
+			device_->SetIndexBuffer(buffer, format);
+		}
+	}
+
+	void StateFilter::SetVSResource(uint32_t slot, ID3D11ShaderResourceView* srv)
+	{
+		if (FilterSlot(vsResources_, ResourceSlotNum, slot, srv)) {
+			device_->SetVSResource(slot, srv);
+		}
+	}
+
+	void StateFilter::SetPSResource(uint32_t slot, ID3D11ShaderResourceView* srv)
+	{
+		if (FilterSlot(psResources_, ResourceSlotNum, slot, srv)) {
+			device_->SetPSResource(slot, srv);
+		}
+	}
+
+	void StateFilter::SetPSSamplerState(uint32_t slot, ID3D11SamplerState* sampler)
+	{
+		if (FilterSlot(psSamplers_, SamplerSlotNum, slot, sampler)) {
+			device_->SetPSSamplerState(slot, sampler);
+		}
+	}
+
+	void StateFilter::SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+	{
+		ConstantBufferBinding binding = { buffer, firstConstant, constantCount };
+		if (FilterSlot(vsConstantBuffers_, ConstantBufferSlotNum, slot, binding)) {
+			device_->SetVSConstantBuffer(slot, buffer, firstConstant, constantCount);
+		}
+	}
+
+	void StateFilter::SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+	{
+		ConstantBufferBinding binding = { buffer, firstConstant, constantCount };
+		if (FilterSlot(psConstantBuffers_, ConstantBufferSlotNum, slot, binding)) {
+			device_->SetPSConstantBuffer(slot, buffer, firstConstant, constantCount);
+		}
+	}
+
+	void StateFilter::SetCSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+	{
+		ConstantBufferBinding binding = { buffer, firstConstant, constantCount };
+		if (FilterSlot(csConstantBuffers_, ConstantBufferSlotNum, slot, binding)) {
+			device_->SetCSConstantBuffer(slot, buffer, firstConstant, constantCount);
+		}
+	}
+}
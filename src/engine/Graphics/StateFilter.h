@@ -0,0 +1,191 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+
+// D3D11のヘッダに依存しないよう前方宣言のみ
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+struct ID3D11RasterizerState;
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+
+namespace se
+{
+	/**
+	 * ステート設定先のデバイス
+	 * StateFilterを通過した呼び出しのみが届く
+	 */
+	class StateDevice
+	{
+	public:
+		virtual ~StateDevice() {}
+
+		virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+		virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+		virtual void SetInputLayout(ID3D11InputLayout* layout) = 0;
+		virtual void SetPrimitiveTopology(uint32_t topology) = 0;
+		virtual void SetBlendState(ID3D11BlendState* state) = 0;
+		virtual void SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef) = 0;
+		virtual void SetRasterizerState(ID3D11RasterizerState* state) = 0;
+		virtual void SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset) = 0;
+		virtual void SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format) = 0;
+		virtual void SetVSResource(uint32_t slot, ID3D11ShaderResourceView* srv) = 0;
+		virtual void SetPSResource(uint32_t slot, ID3D11ShaderResourceView* srv) = 0;
+		virtual void SetPSSamplerState(uint32_t slot, ID3D11SamplerState* sampler) = 0;
+		// constantCountが0の場合はバッファ全体、それ以外はfirstConstantからの範囲(定数は16バイト単位)
+		virtual void SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) = 0;
+		virtual void SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) = 0;
+		virtual void SetCSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) = 0;
+	};
+
+
+	/**
+	 * 冗長なステート設定の除去
+	 * 設定済みの値をスロット毎に保持し、変化がない呼び出しはデバイスに渡さない
+	 * 外部(Maya等)がデバイスのステートを変更した場合はInvalidate()で保持値を破棄すること
+	 */
+	class StateFilter
+	{
+	public:
+		static const uint32_t VertexBufferSlotNum = 16;
+		static const uint32_t ResourceSlotNum = 16;
+		static const uint32_t SamplerSlotNum = 16;
+		static const uint32_t ConstantBufferSlotNum = 14;
+
+		// 呼び出し数の統計
+		struct Stats
+		{
+			uint32_t issued;		// デバイスに渡した数
+			uint32_t filtered;		// 除去した数
+		};
+
+	private:
+		// 保持値(validがfalseの間は必ずデバイスに渡す)
+		template <class T>
+		struct Shadow
+		{
+			T value;
+			bool valid;
+
+			Shadow() : value(), valid(false) {}
+
+			// 値が変わった場合はtrue
+			bool Set(const T& v)
+			{
+				if (valid && value == v) return false;
+				value = v;
+				valid = true;
+				return true;
+			}
+		};
+
+		struct VertexBufferBinding
+		{
+			ID3D11Buffer* buffer;
+			uint32_t stride;
+			uint32_t offset;
+
+			bool operator==(const VertexBufferBinding& other) const
+			{
+				return buffer == other.buffer && stride == other.stride && offset == other.offset;
+			}
+		};
+
+		struct ConstantBufferBinding
+		{
+			ID3D11Buffer* buffer;
+			uint32_t firstConstant;
+			uint32_t constantCount;
+
+			bool operator==(const ConstantBufferBinding& other) const
+			{
+				return buffer == other.buffer && firstConstant == other.firstConstant && constantCount == other.constantCount;
+			}
+		};
+
+		struct IndexBufferBinding
+		{
+			ID3D11Buffer* buffer;
+			uint32_t format;
+
+			bool operator==(const IndexBufferBinding& other) const
+			{
+				return buffer == other.buffer && format == other.format;
+			}
+		};
+
+		struct DepthStencilBinding
+		{
+			ID3D11DepthStencilState* state;
+			uint32_t stencilRef;
+
+			bool operator==(const DepthStencilBinding& other) const
+			{
+				return state == other.state && stencilRef == other.stencilRef;
+			}
+		};
+
+	private:
+		StateDevice* device_;
+		Stats stats_;
+
+		Shadow<ID3D11VertexShader*> vertexShader_;
+		Shadow<ID3D11PixelShader*> pixelShader_;
+		Shadow<ID3D11InputLayout*> inputLayout_;
+		Shadow<uint32_t> topology_;
+		Shadow<ID3D11BlendState*> blendState_;
+		Shadow<DepthStencilBinding> depthStencilState_;
+		Shadow<ID3D11RasterizerState*> rasterizerState_;
+		Shadow<VertexBufferBinding> vertexBuffers_[VertexBufferSlotNum];
+		Shadow<IndexBufferBinding> indexBuffer_;
+		Shadow<ID3D11ShaderResourceView*> vsResources_[ResourceSlotNum];
+		Shadow<ID3D11ShaderResourceView*> psResources_[ResourceSlotNum];
+		Shadow<ID3D11SamplerState*> psSamplers_[SamplerSlotNum];
+		Shadow<ConstantBufferBinding> vsConstantBuffers_[ConstantBufferSlotNum];
+		Shadow<ConstantBufferBinding> psConstantBuffers_[ConstantBufferSlotNum];
+		Shadow<ConstantBufferBinding> csConstantBuffers_[ConstantBufferSlotNum];
+
+	private:
+		template <class T>
+		bool Filter(Shadow<T>& shadow, const T& value);
+		template <class T>
+		bool FilterSlot(Shadow<T>* shadows, uint32_t slotNum, uint32_t slot, const T& value);
+
+	public:
+		StateFilter();
+
+		void SetDevice(StateDevice* device) { device_ = device; }
+		StateDevice* GetDevice() const { return device_; }
+
+		// 保持値を破棄する(次の設定は必ずデバイスに渡る)
+		void Invalidate();
+
+		const Stats& GetStats() const { return stats_; }
+		void ResetStats();
+
+		void SetVertexShader(ID3D11VertexShader* shader);
+		void SetPixelShader(ID3D11PixelShader* shader);
+		void SetInputLayout(ID3D11InputLayout* layout);
+		void SetPrimitiveTopology(uint32_t topology);
+		void SetBlendState(ID3D11BlendState* state);
+		void SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef);
+		void SetRasterizerState(ID3D11RasterizerState* state);
+		void SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset);
+		void SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format);
+		void SetVSResource(uint32_t slot, ID3D11ShaderResourceView* srv);
+		void SetPSResource(uint32_t slot, ID3D11ShaderResourceView* srv);
+		void SetPSSamplerState(uint32_t slot, ID3D11SamplerState* sampler);
+		void SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant = 0, uint32_t constantCount = 0);
+		void SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant = 0, uint32_t constantCount = 0);
+		void SetCSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant = 0, uint32_t constantCount = 0);
+	};
+}
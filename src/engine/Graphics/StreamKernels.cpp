@@ -0,0 +1,252 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/StreamKernels.h"
+#include "engine/Graphics/VertexQuantizer.h"
+#include <cfloat>
+#if SE_STREAM_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace se
+{
+#if SE_STREAM_KERNELS_SSE2
+	namespace {
+		inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		// 4要素のfloatをhalfに変換(結果は32bitの下位16bit、符号は上位まで拡張する)
+		inline __m128i FloatToHalf4(__m128 value)
+		{
+			const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);		// これ以上はInf
+			const __m128i f32Inf = _mm_set1_epi32(255 << 23);
+			const __m128i normalMin = _mm_set1_epi32(113 << 23);			// これ未満は非正規化数
+			const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+			const __m128i rebias = _mm_set1_epi32(static_cast<int32_t>(0xC8000FFFu));	// ((15 - 127) << 23) + 0xfff(負の値のシフトを避ける)
+
+			__m128i f = _mm_castps_si128(value);
+			__m128i sign = _mm_and_si128(f, _mm_set1_epi32(static_cast<int32_t>(0x80000000u)));
+			f = _mm_xor_si128(f, sign);
+
+			// オーバーフローはInf、NaNは0x7e00
+			__m128i isHuge = _mm_cmpgt_epi32(f, _mm_sub_epi32(f16Max, _mm_set1_epi32(1)));
+			__m128i isNaN = _mm_cmpgt_epi32(f, f32Inf);
+			__m128i huge = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(isNaN, _mm_set1_epi32(0x200)));
+
+			// 非正規化数は加算の丸めで仮数を求める
+			__m128i isSmall = _mm_cmplt_epi32(f, normalMin);
+			__m128i small = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(denormMagic))), denormMagic);
+
+			// 正規化数は指数を付け替えて最近接偶数丸め
+			__m128i odd = _mm_and_si128(_mm_srli_epi32(f, 13), _mm_set1_epi32(1));
+			__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(f, rebias), odd), 13);
+
+			__m128i result = Select(isSmall, small, normal);
+			result = Select(isHuge, huge, result);
+			return _mm_or_si128(result, _mm_srai_epi32(sign, 16));
+		}
+
+		// 4要素をsnorm16に変換(結果は32bit)
+		inline __m128i FloatToSnorm4(__m128 value)
+		{
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 half = _mm_set1_ps(0.5f);
+			__m128 scaled = _mm_mul_ps(_mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), one), _mm_set1_ps(32767.0f));
+
+			// 切り捨てた端数が0.5以上なら0から遠い方に1つずらす(端数の計算は誤差なし)
+			__m128i truncated = _mm_cvttps_epi32(scaled);
+			__m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated));
+			__m128i up = _mm_castps_si128(_mm_cmpge_ps(fraction, half));
+			__m128i down = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_sub_ps(_mm_setzero_ps(), half)));
+			return _mm_add_epi32(_mm_sub_epi32(truncated, up), down);
+		}
+	}
+#endif
+
+
+	void StreamKernels::FlipV(float* data, uint32_t vertexCount, uint32_t components)
+	{
+#if SE_STREAM_KERNELS_SSE2
+		// UV(2要素)は4要素ずつ奇数番目のみ反転
+		if (components == 2) {
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, -1));
+			size_t count = static_cast<size_t>(vertexCount) * 2;
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m128 value = _mm_loadu_ps(data + i);
+				_mm_storeu_ps(data + i, Select(mask, _mm_sub_ps(one, value), value));
+			}
+			FlipVScalar(data + i, static_cast<uint32_t>((count - i) / 2), 2);
+			return;
+		}
+#endif
+		FlipVScalar(data, vertexCount, components);
+	}
+
+	void StreamKernels::FlipVScalar(float* data, uint32_t vertexCount, uint32_t components)
+	{
+		if (components < 2) return;
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			float* uv = data + static_cast<size_t>(v) * components;
+			uv[1] = 1.0f - uv[1];
+		}
+	}
+
+	void StreamKernels::FloatToHalf(const float* input, size_t count, uint16_t* output)
+	{
+		size_t i = 0;
+#if SE_STREAM_KERNELS_SSE2
+		for (; i + 8 <= count; i += 8) {
+			__m128i lo = FloatToHalf4(_mm_loadu_ps(input + i));
+			__m128i hi = FloatToHalf4(_mm_loadu_ps(input + i + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(lo, hi));
+		}
+#endif
+		FloatToHalfScalar(input + i, count - i, output + i);
+	}
+
+	void StreamKernels::FloatToHalfScalar(const float* input, size_t count, uint16_t* output)
+	{
+		for (size_t i = 0; i < count; i++) {
+			output[i] = VertexQuantizer::FloatToHalf(input[i]);
+		}
+	}
+
+	void StreamKernels::FloatToSnorm16(const float* input, size_t count, int16_t* output)
+	{
+		size_t i = 0;
+#if SE_STREAM_KERNELS_SSE2
+		for (; i + 8 <= count; i += 8) {
+			__m128i lo = FloatToSnorm4(_mm_loadu_ps(input + i));
+			__m128i hi = FloatToSnorm4(_mm_loadu_ps(input + i + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(lo, hi));
+		}
+#endif
+		FloatToSnorm16Scalar(input + i, count - i, output + i);
+	}
+
+	void StreamKernels::FloatToSnorm16Scalar(const float* input, size_t count, int16_t* output)
+	{
+		for (size_t i = 0; i < count; i++) {
+			output[i] = VertexQuantizer::FloatToSnorm16(input[i]);
+		}
+	}
+
+	void StreamKernels::EncodeOctahedral(const float* input, uint32_t components, uint32_t vertexCount, int16_t* output)
+	{
+		uint32_t v = 0;
+#if SE_STREAM_KERNELS_SSE2
+		if (components >= 3) {
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 minusOne = _mm_set1_ps(-1.0f);
+			const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+			for (; v + 4 <= vertexCount; v += 4) {
+				// 4頂点分を要素毎に集める
+				const float* p0 = input + static_cast<size_t>(v) * components;
+				const float* p1 = p0 + components;
+				const float* p2 = p1 + components;
+				const float* p3 = p2 + components;
+				__m128 x = _mm_setr_ps(p0[0], p1[0], p2[0], p3[0]);
+				__m128 y = _mm_setr_ps(p0[1], p1[1], p2[1], p3[1]);
+				__m128 z = _mm_setr_ps(p0[2], p1[2], p2[2], p3[2]);
+
+				// 8面体に射影し、下半球は折り返す(VertexQuantizer::EncodeOctahedral()と同じ演算順)
+				__m128 l1 = _mm_add_ps(_mm_add_ps(_mm_and_ps(x, absMask), _mm_and_ps(y, absMask)), _mm_and_ps(z, absMask));
+				__m128 valid = _mm_and_ps(_mm_cmpgt_ps(l1, zero), _mm_cmple_ps(l1, _mm_set1_ps(FLT_MAX)));
+				__m128 ox = _mm_div_ps(x, l1);
+				__m128 oy = _mm_div_ps(y, l1);
+				__m128 signX = Select(_mm_cmpge_ps(ox, zero), one, minusOne);
+				__m128 signY = Select(_mm_cmpge_ps(oy, zero), one, minusOne);
+				__m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(oy, absMask)), signX);
+				__m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(ox, absMask)), signY);
+				__m128 lower = _mm_cmplt_ps(z, zero);
+				ox = _mm_and_ps(valid, Select(lower, fx, ox));
+				oy = _mm_and_ps(valid, Select(lower, fy, oy));
+
+				// x0, y0, x1, y1...の順に詰める
+				__m128i ex = FloatToSnorm4(ox);
+				__m128i ey = FloatToSnorm4(oy);
+				__m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(ex, ey), _mm_unpackhi_epi32(ex, ey));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + static_cast<size_t>(v) * 2), packed);
+			}
+		}
+#endif
+		EncodeOctahedralScalar(input + static_cast<size_t>(v) * components, components, vertexCount - v, output + static_cast<size_t>(v) * 2);
+	}
+
+	void StreamKernels::EncodeOctahedralScalar(const float* input, uint32_t components, uint32_t vertexCount, int16_t* output)
+	{
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			const float* src = input + static_cast<size_t>(v) * components;
+			float value[3] = { 0.0f, 0.0f, 0.0f };
+			for (uint32_t i = 0; i < 3 && i < components; i++) {
+				value[i] = src[i];
+			}
+			VertexQuantizer::EncodeOctahedral(value, output + static_cast<size_t>(v) * 2);
+		}
+	}
+
+	void StreamKernels::ComputeBounds(const float* positions, uint32_t stride, uint32_t count, float* boundsMin, float* boundsMax)
+	{
+#if SE_STREAM_KERNELS_SSE2
+		// 1頂点を4要素で読むので、最後の頂点は読み過ぎないようにスカラーで扱う
+		if (stride >= 3 && count >= 2) {
+			__m128 min0 = _mm_set1_ps(FLT_MAX);
+			__m128 max0 = _mm_set1_ps(-FLT_MAX);
+			__m128 min1 = min0;
+			__m128 max1 = max0;
+			uint32_t last = count - 1;
+			uint32_t v = 0;
+			for (; v + 2 <= last; v += 2) {
+				__m128 a = _mm_loadu_ps(positions + static_cast<size_t>(v) * stride);
+				__m128 b = _mm_loadu_ps(positions + static_cast<size_t>(v + 1) * stride);
+				min0 = _mm_min_ps(min0, a);
+				max0 = _mm_max_ps(max0, a);
+				min1 = _mm_min_ps(min1, b);
+				max1 = _mm_max_ps(max1, b);
+			}
+			for (; v <= last; v++) {
+				const float* p = positions + static_cast<size_t>(v) * stride;
+				__m128 a = _mm_setr_ps(p[0], p[1], p[2], p[2]);
+				min0 = _mm_min_ps(min0, a);
+				max0 = _mm_max_ps(max0, a);
+			}
+			float resultMin[4], resultMax[4];
+			_mm_storeu_ps(resultMin, _mm_min_ps(min0, min1));
+			_mm_storeu_ps(resultMax, _mm_max_ps(max0, max1));
+			for (int32_t i = 0; i < 3; i++) {
+				boundsMin[i] = resultMin[i];
+				boundsMax[i] = resultMax[i];
+			}
+			return;
+		}
+#endif
+		ComputeBoundsScalar(positions, stride, count, boundsMin, boundsMax);
+	}
+
+	void StreamKernels::ComputeBoundsScalar(const float* positions, uint32_t stride, uint32_t count, float* boundsMin, float* boundsMax)
+	{
+		for (int32_t i = 0; i < 3; i++) {
+			boundsMin[i] = FLT_MAX;
+			boundsMax[i] = -FLT_MAX;
+		}
+		for (uint32_t v = 0; v < count; v++) {
+			const float* p = positions + static_cast<size_t>(v) * stride;
+			for (int32_t i = 0; i < 3; i++) {
+				boundsMin[i] = (p[i] < boundsMin[i]) ? p[i] : boundsMin[i];
+				boundsMax[i] = (boundsMax[i] < p[i]) ? p[i] : boundsMax[i];
+			}
+		}
+	}
+}
\ No newline at end of file
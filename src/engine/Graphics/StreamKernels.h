@@ -0,0 +1,48 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include <cstdint>
+#include <cstddef>
+
+// x86/x64ではSSE2で4要素ずつ変換する(SE_STREAM_KERNELS_SCALARを定義するとスカラーのみ)
+#if !defined(SE_STREAM_KERNELS_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define SE_STREAM_KERNELS_SSE2 1
+#else
+#define SE_STREAM_KERNELS_SSE2 0
+#endif
+
+namespace se
+{
+	/**
+	 * 頂点ストリームの変換カーネル(デバイスには依存しない)
+	 * SIMD版はスカラー版(VertexQuantizerの1要素ずつの変換)とビット単位で同じ結果を返す
+	 * NaNはhalfではNaN、snorm16では-1になり、8面体写像ではNaN、Infを含むベクトルを(0, 0)にする
+	 */
+	class StreamKernels
+	{
+	public:
+		// components要素ずつ並んだUVのVを1 - vに反転する
+		static void FlipV(float* data, uint32_t vertexCount, uint32_t components);
+		static void FlipVScalar(float* data, uint32_t vertexCount, uint32_t components);
+
+		// floatをhalfに変換する(最近接偶数丸め)
+		static void FloatToHalf(const float* input, size_t count, uint16_t* output);
+		static void FloatToHalfScalar(const float* input, size_t count, uint16_t* output);
+
+		// [-1, 1]に丸めてsnorm16に変換する(0.5は0から遠い方に丸める)
+		static void FloatToSnorm16(const float* input, size_t count, int16_t* output);
+		static void FloatToSnorm16Scalar(const float* input, size_t count, int16_t* output);
+
+		// components要素ずつ並んだベクトルを8面体写像してsnorm16 x2に変換する
+		static void EncodeOctahedral(const float* input, uint32_t components, uint32_t vertexCount, int16_t* output);
+		static void EncodeOctahedralScalar(const float* input, uint32_t components, uint32_t vertexCount, int16_t* output);
+
+		// stride(float単位、3以上)間隔で並んだ位置のバウンディング(空の場合はmin > max)
+		static void ComputeBounds(const float* positions, uint32_t stride, uint32_t count, float* boundsMin, float* boundsMax);
+		static void ComputeBoundsScalar(const float* positions, uint32_t stride, uint32_t count, float* boundsMin, float* boundsMax);
+	};
+}
\ No newline at end of file
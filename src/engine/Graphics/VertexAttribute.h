@@ -0,0 +1,44 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace se
+{
+	// 頂点アトリビュート
+	enum VertexAttribute
+	{
+		VERTEX_ATTR_POSITION		= 0,
+		VERTEX_ATTR_NORMAL			= 1,
+		VERTEX_ATTR_COLOR			= 2,
+		VERTEX_ATTR_TEXCOORD0		= 3,
+		VERTEX_ATTR_TEXCOORD1		= 4,
+		VERTEX_ATTR_TEXCOORD2		= 5,
+		VERTEX_ATTR_TEXCOORD3		= 6,
+		VERTEX_ATTR_TANGENT			= 7,
+		VERTEX_ATTR_BITANGENT		= 8,
+	};
+	enum VertexAttributeFlag
+	{
+		VERTEX_ATTR_FLAG_POSITION		= 1 << VERTEX_ATTR_POSITION,
+		VERTEX_ATTR_FLAG_NORMAL			= 1 << VERTEX_ATTR_NORMAL,
+		VERTEX_ATTR_FLAG_COLOR			= 1 << VERTEX_ATTR_COLOR,
+		VERTEX_ATTR_FLAG_TEXCOORD0		= 1 << VERTEX_ATTR_TEXCOORD0,
+		VERTEX_ATTR_FLAG_TEXCOORD1		= 1 << VERTEX_ATTR_TEXCOORD1,
+		VERTEX_ATTR_FLAG_TEXCOORD2		= 1 << VERTEX_ATTR_TEXCOORD2,
+		VERTEX_ATTR_FLAG_TEXCOORD3		= 1 << VERTEX_ATTR_TEXCOORD3,
+		VERTEX_ATTR_FLAG_TANGENT		= 1 << VERTEX_ATTR_TANGENT,
+		VERTEX_ATTR_FLAG_BITANGENT		= 1 << VERTEX_ATTR_BITANGENT,
+	};
+	typedef uint32_t VertexAttributeFlags;
+
+	// UV数
+	const uint32_t VERTEX_ATTR_TEXCOORD_NUM = 4;
+
+	// アトリビュート数
+	const uint32_t VERTEX_ATTR_NUM = 9;
+}
\ No newline at end of file
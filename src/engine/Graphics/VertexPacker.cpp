@@ -0,0 +1,105 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/VertexPacker.h"
+#include "engine/Graphics/VertexQuantizer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace se
+{
+	namespace
+	{
+		// 属性毎のfloat要素数(VertexAttribute順)
+		const uint32_t attributeComponents[VERTEX_ATTR_NUM] = {
+			3,	// POSITION
+			3,	// NORMAL
+			4,	// COLOR
+			2,	// TEXCOORD0
+			2,	// TEXCOORD1
+			2,	// TEXCOORD2
+			2,	// TEXCOORD3
+			3,	// TANGENT
+			3,	// BITANGENT
+		};
+
+		// 単一属性のフラグから属性を取得(見つからなければVERTEX_ATTR_NUM)
+		uint32_t FindAttribute(VertexAttributeFlags flag)
+		{
+			for (uint32_t i = 0; i < VERTEX_ATTR_NUM; i++) {
+				if (flag == (1u << i)) return i;
+			}
+			return VERTEX_ATTR_NUM;
+		}
+	}
+
+	uint32_t VertexPacker::GetAttributeSize(VertexAttribute attribute, bool quantized)
+	{
+		if (quantized) {
+			return VertexQuantizer::GetAttributeSize(attribute);
+		}
+		return attributeComponents[attribute] * sizeof(float);
+	}
+
+	uint32_t VertexPacker::GetStride(VertexAttributeFlags attributes, bool quantized)
+	{
+		uint32_t size = 0;
+		for (uint32_t i = 0; i < VERTEX_ATTR_NUM; i++) {
+			if (attributes & (1 << i)) {
+				size += GetAttributeSize(static_cast<VertexAttribute>(i), quantized);
+			}
+		}
+		return size;
+	}
+
+	uint32_t VertexPacker::GetOffset(VertexAttributeFlags attributes, VertexAttribute attribute, bool quantized)
+	{
+		// 手前にある属性の合計
+		return GetStride(attributes & ((1 << attribute) - 1), quantized);
+	}
+
+	void VertexPacker::Pack(VertexAttributeFlags attributes, const VertexStreamSource* streams, uint32_t streamCount, uint32_t vertexCount, void* output, bool quantized)
+	{
+		const uint32_t stride = GetStride(attributes, quantized);
+		if (stride == 0 || vertexCount == 0) return;
+		uint8_t* bytes = static_cast<uint8_t*>(output);
+
+		// 全要素がストリームで埋まらない場合のみ先に0クリア
+		// (量子化時は足りない要素をVertexQuantizerが補う)
+		uint32_t covered = 0;
+		for (uint32_t i = 0; i < streamCount; i++) {
+			const VertexStreamSource& stream = streams[i];
+			uint32_t attribute = FindAttribute(stream.attribute);
+			if ((attributes & stream.attribute) == 0 || !stream.data || attribute >= VERTEX_ATTR_NUM) continue;
+			covered += quantized
+				? VertexQuantizer::GetAttributeSize(static_cast<VertexAttribute>(attribute))
+				: (std::min)(stream.components, attributeComponents[attribute]) * sizeof(float);
+		}
+		if (covered < stride) {
+			memset(bytes, 0, static_cast<size_t>(stride) * vertexCount);
+		}
+
+		// ストリーム単位で書き込む(読み込みは連続、書き込みはストライド間隔)
+		for (uint32_t i = 0; i < streamCount; i++) {
+			const VertexStreamSource& stream = streams[i];
+			uint32_t attribute = FindAttribute(stream.attribute);
+			if ((attributes & stream.attribute) == 0 || !stream.data || attribute >= VERTEX_ATTR_NUM) continue;
+
+			uint8_t* dst = bytes + GetOffset(attributes, static_cast<VertexAttribute>(attribute), quantized);
+			if (quantized) {
+				VertexQuantizer::Encode(static_cast<VertexAttribute>(attribute), stream.data, stream.components, vertexCount, dst, stride);
+				continue;
+			}
+
+			const uint32_t size = (std::min)(stream.components, attributeComponents[attribute]) * sizeof(float);
+			const float* src = stream.data;
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				memcpy(dst, src, size);
+				src += stream.components;
+				dst += stride;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Graphics/VertexAttribute.h"
+
+namespace se
+{
+	/**
+	 * 頂点属性毎のストリーム(float配列)
+	 */
+	struct VertexStreamSource
+	{
+		const float* data;
+		VertexAttributeFlags attribute;		// 1ストリーム1属性
+		uint32_t components;				// 1頂点あたりの要素数
+	};
+
+	/**
+	 * 属性毎のストリームを1本のインターリーブストリームに詰める(デバイスには依存しない)
+	 * 属性はVertexAttributeの順に並び、オフセットはVertexLayoutManagerのインターリーブレイアウトと一致する
+	 * quantizedの場合は各属性をVertexQuantizerの形式で書き込む
+	 */
+	class VertexPacker
+	{
+	public:
+		// 属性1つあたりのバイト数
+		static uint32_t GetAttributeSize(VertexAttribute attribute, bool quantized = false);
+		// 属性をまとめた1頂点のバイト数
+		static uint32_t GetStride(VertexAttributeFlags attributes, bool quantized = false);
+		// 頂点内での属性のバイトオフセット
+		static uint32_t GetOffset(VertexAttributeFlags attributes, VertexAttribute attribute, bool quantized = false);
+
+		// attributesの属性を詰めてoutputに書き込む(outputはvertexCount * GetStride(attributes, quantized)バイト)
+		// 対応するストリームが無い属性、足りない要素は0で埋め、attributesに無いストリームは無視する
+		static void Pack(VertexAttributeFlags attributes, const VertexStreamSource* streams, uint32_t streamCount, uint32_t vertexCount, void* output, bool quantized = false);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,359 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Graphics/VertexQuantizer.h"
+#include "engine/Graphics/StreamKernels.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace se
+{
+	namespace
+	{
+		enum Encoding
+		{
+			ENCODING_FLOAT3,
+			ENCODING_OCTAHEDRAL,
+			ENCODING_UNORM8X4,
+			ENCODING_HALF2,
+		};
+
+		// 属性毎の量子化方法(VertexAttribute順)
+		const Encoding attributeEncodings[VERTEX_ATTR_NUM] = {
+			ENCODING_FLOAT3,		// POSITION
+			ENCODING_OCTAHEDRAL,	// NORMAL
+			ENCODING_UNORM8X4,		// COLOR
+			ENCODING_HALF2,			// TEXCOORD0
+			ENCODING_HALF2,			// TEXCOORD1
+			ENCODING_HALF2,			// TEXCOORD2
+			ENCODING_HALF2,			// TEXCOORD3
+			ENCODING_OCTAHEDRAL,	// TANGENT
+			ENCODING_OCTAHEDRAL,	// BITANGENT
+		};
+
+		const uint32_t encodingSizes[] = {
+			12,		// FLOAT3
+			4,		// OCTAHEDRAL
+			4,		// UNORM8X4
+			4,		// HALF2
+		};
+
+		// NaNはloにする(SSEのmaxps, minpsと同じ比較順)
+		inline float Clamp(float v, float lo, float hi)
+		{
+			float t = (v > lo) ? v : lo;
+			return (t < hi) ? t : hi;
+		}
+
+		inline float SignNotZero(float v)
+		{
+			return (v >= 0.0f) ? 1.0f : -1.0f;
+		}
+
+		inline float FromSnorm16(int16_t v)
+		{
+			// D3Dのsnorm変換と同じく-32768は-1にする
+			return (std::max)(static_cast<float>(v) / 32767.0f, -1.0f);
+		}
+
+		// 要素数が足りない場合は0(カラーのアルファは1)を補う
+		inline void Fetch(const float* input, uint32_t components, uint32_t count, float defaultLast, float* output)
+		{
+			for (uint32_t i = 0; i < count; i++) {
+				output[i] = (i < components) ? input[i] : ((i == count - 1) ? defaultLast : 0.0f);
+			}
+		}
+
+		// 8面体写像できるベクトル(長さ0、非有限のものは写像できない)
+		inline bool IsEncodable(float l1)
+		{
+			return l1 > 0.0f && l1 <= FLT_MAX;
+		}
+
+		inline void Normalize3(float* v)
+		{
+			float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			if (len > 0.0f) {
+				v[0] /= len;
+				v[1] /= len;
+				v[2] /= len;
+			}
+		}
+	}
+
+	uint32_t VertexQuantizer::GetAttributeSize(VertexAttribute attribute)
+	{
+		return encodingSizes[attributeEncodings[attribute]];
+	}
+
+	uint16_t VertexQuantizer::FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t exponent = (bits >> 23) & 0xff;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		// NaN, Inf
+		if (exponent == 0xff) {
+			return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+		}
+
+		int32_t e = static_cast<int32_t>(exponent) - 127 + 15;
+		if (e >= 0x1f) {
+			// オーバーフローはInf
+			return static_cast<uint16_t>(sign | 0x7c00);
+		}
+		if (e <= 0) {
+			// 非正規化数(小さすぎるものは0)
+			if (e < -10) return static_cast<uint16_t>(sign);
+			mantissa |= 0x800000;
+			uint32_t shift = static_cast<uint32_t>(14 - e);
+			uint32_t half = mantissa >> shift;
+			uint32_t rest = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1))) half++;
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		// 最近接偶数丸め(繰り上がりで指数が増えてもそのまま正しい値になる)
+		uint32_t half = (static_cast<uint32_t>(e) << 10) | (mantissa >> 13);
+		uint32_t rest = mantissa & 0x1fff;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	float VertexQuantizer::HalfToFloat(uint16_t value)
+	{
+		uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1f;
+		uint32_t mantissa = value & 0x3ff;
+
+		uint32_t bits;
+		if (exponent == 0) {
+			if (mantissa == 0) {
+				bits = sign;
+			} else {
+				// 非正規化数を正規化
+				int32_t e = -1;
+				do {
+					e++;
+					mantissa <<= 1;
+				} while ((mantissa & 0x400) == 0);
+				bits = sign | (static_cast<uint32_t>(127 - 15 - e) << 23) | ((mantissa & 0x3ff) << 13);
+			}
+		} else if (exponent == 0x1f) {
+			bits = sign | 0x7f800000 | (mantissa << 13);
+		} else {
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	int16_t VertexQuantizer::FloatToSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(Clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	void VertexQuantizer::EncodeOctahedral(const float* normal, int16_t* output)
+	{
+		// 単位ベクトルを8面体に射影し、下半球は折り返す
+		// 長さ0、NaN、Infを含むベクトルは(0, 0)にする(復元すると+Z)
+		float l1 = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+		if (!IsEncodable(l1)) {
+			output[0] = 0;
+			output[1] = 0;
+			return;
+		}
+		float x = normal[0] / l1;
+		float y = normal[1] / l1;
+		if (normal[2] < 0.0f) {
+			float ox = x;
+			x = (1.0f - std::abs(y)) * SignNotZero(ox);
+			y = (1.0f - std::abs(ox)) * SignNotZero(y);
+		}
+		output[0] = FloatToSnorm16(x);
+		output[1] = FloatToSnorm16(y);
+	}
+
+	void VertexQuantizer::DecodeOctahedral(const int16_t* input, float* normal)
+	{
+		// シェーダのDecodeOctahedral()と同じ計算
+		float x = FromSnorm16(input[0]);
+		float y = FromSnorm16(input[1]);
+		float z = 1.0f - std::abs(x) - std::abs(y);
+		float t = Clamp(-z, 0.0f, 1.0f);
+		x += (x >= 0.0f) ? -t : t;
+		y += (y >= 0.0f) ? -t : t;
+		normal[0] = x;
+		normal[1] = y;
+		normal[2] = z;
+		Normalize3(normal);
+	}
+
+	void VertexQuantizer::Encode(VertexAttribute attribute, const float* input, uint32_t components, uint32_t vertexCount, void* output, uint32_t outputStride)
+	{
+		// 詰めて書き込む場合はストリーム単位のSIMD変換を使う
+		const Encoding encoding = attributeEncodings[attribute];
+		if (outputStride == encodingSizes[encoding]) {
+			if (encoding == ENCODING_HALF2 && components == 2) {
+				StreamKernels::FloatToHalf(input, static_cast<size_t>(vertexCount) * 2, static_cast<uint16_t*>(output));
+				return;
+			}
+			if (encoding == ENCODING_OCTAHEDRAL && components >= 3) {
+				StreamKernels::EncodeOctahedral(input, components, vertexCount, static_cast<int16_t*>(output));
+				return;
+			}
+		}
+
+		uint8_t* dst = static_cast<uint8_t*>(output);
+		for (uint32_t v = 0; v < vertexCount; v++, input += components, dst += outputStride) {
+			switch (encoding) {
+			case ENCODING_FLOAT3: {
+				float value[3];
+				Fetch(input, components, 3, 0.0f, value);
+				memcpy(dst, value, sizeof(value));
+				break;
+			}
+			case ENCODING_OCTAHEDRAL: {
+				float value[3];
+				Fetch(input, components, 3, 0.0f, value);
+				int16_t encoded[2];
+				EncodeOctahedral(value, encoded);
+				memcpy(dst, encoded, sizeof(encoded));
+				break;
+			}
+			case ENCODING_UNORM8X4: {
+				float value[4];
+				Fetch(input, components, 4, 1.0f, value);
+				for (uint32_t i = 0; i < 4; i++) {
+					dst[i] = static_cast<uint8_t>(std::lround(Clamp(value[i], 0.0f, 1.0f) * 255.0f));
+				}
+				break;
+			}
+			case ENCODING_HALF2: {
+				float value[2];
+				Fetch(input, components, 2, 0.0f, value);
+				uint16_t encoded[2] = { FloatToHalf(value[0]), FloatToHalf(value[1]) };
+				memcpy(dst, encoded, sizeof(encoded));
+				break;
+			}
+			}
+		}
+	}
+
+	void VertexQuantizer::Decode(VertexAttribute attribute, const void* input, uint32_t inputStride, uint32_t vertexCount, float* output, uint32_t components)
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(input);
+		for (uint32_t v = 0; v < vertexCount; v++, src += inputStride, output += components) {
+			float value[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			switch (attributeEncodings[attribute]) {
+			case ENCODING_FLOAT3:
+				memcpy(value, src, sizeof(float) * 3);
+				break;
+			case ENCODING_OCTAHEDRAL: {
+				int16_t encoded[2];
+				memcpy(encoded, src, sizeof(encoded));
+				DecodeOctahedral(encoded, value);
+				break;
+			}
+			case ENCODING_UNORM8X4:
+				for (uint32_t i = 0; i < 4; i++) {
+					value[i] = static_cast<float>(src[i]) / 255.0f;
+				}
+				break;
+			case ENCODING_HALF2: {
+				uint16_t encoded[2];
+				memcpy(encoded, src, sizeof(encoded));
+				value[0] = HalfToFloat(encoded[0]);
+				value[1] = HalfToFloat(encoded[1]);
+				break;
+			}
+			}
+			for (uint32_t i = 0; i < components; i++) {
+				output[i] = (i < 4) ? value[i] : 0.0f;
+			}
+		}
+	}
+
+	float VertexQuantizer::MeasureError(VertexAttribute attribute, const float* input, uint32_t components, uint32_t vertexCount)
+	{
+		const Encoding encoding = attributeEncodings[attribute];
+		const uint32_t size = encodingSizes[encoding];
+
+		// 少しずつ量子化->復元して比較
+		const uint32_t blockSize = 1024;
+		uint8_t encoded[blockSize * 12];
+		float decoded[blockSize * 4];
+
+		float maxError = 0.0f;
+		for (uint32_t begin = 0; begin < vertexCount; begin += blockSize) {
+			uint32_t count = (std::min)(blockSize, vertexCount - begin);
+			const float* src = input + static_cast<size_t>(begin) * components;
+			Encode(attribute, src, components, count, encoded, size);
+			Decode(attribute, encoded, size, count, decoded, 4);
+
+			for (uint32_t v = 0; v < count; v++) {
+				float expected[4];
+				Fetch(src + v * components, components, 4, (encoding == ENCODING_UNORM8X4) ? 1.0f : 0.0f, expected);
+				const float* actual = decoded + v * 4;
+				switch (encoding) {
+				case ENCODING_FLOAT3:
+					break;
+				case ENCODING_OCTAHEDRAL: {
+					// 長さ0、非有限のベクトルは比較しない
+					// 非正規化数や大きな値でも長さを計算できるよう、先に写像と同じくl1で割る
+					float l1 = std::abs(expected[0]) + std::abs(expected[1]) + std::abs(expected[2]);
+					if (!IsEncodable(l1)) break;
+					for (uint32_t i = 0; i < 3; i++) {
+						expected[i] /= l1;
+					}
+					Normalize3(expected);
+					for (uint32_t i = 0; i < 3; i++) {
+						maxError = (std::max)(maxError, std::abs(actual[i] - expected[i]));
+					}
+					break;
+				}
+				case ENCODING_UNORM8X4:
+					for (uint32_t i = 0; i < 4; i++) {
+						maxError = (std::max)(maxError, std::abs(actual[i] - Clamp(expected[i], 0.0f, 1.0f)));
+					}
+					break;
+				case ENCODING_HALF2:
+					for (uint32_t i = 0; i < 2; i++) {
+						// halfの範囲外、NaNは比較しない
+						if (!(std::abs(expected[i]) <= 65504.0f)) continue;
+						maxError = (std::max)(maxError, std::abs(actual[i] - expected[i]) / (std::max)(1.0f, std::abs(expected[i])));
+					}
+					break;
+				}
+			}
+		}
+		return maxError;
+	}
+
+	float VertexQuantizer::GetErrorBound(VertexAttribute attribute)
+	{
+		// 比較時の浮動小数点の計算誤差分を少し足す
+		const float epsilon = 1.0e-6f;
+		switch (attributeEncodings[attribute]) {
+		case ENCODING_OCTAHEDRAL:
+			return 1.0f / 8192.0f;		// snorm16の量子化幅が8面体から球面に戻す際に数倍に広がる
+		case ENCODING_UNORM8X4:
+			return 0.5f / 255.0f + epsilon;
+		case ENCODING_HALF2:
+			return 1.0f / 2048.0f + epsilon;		// 仮数10bitの丸め誤差(相対)
+		default:
+			return 0.0f;
+		}
+	}
+}
\ No newline at end of file
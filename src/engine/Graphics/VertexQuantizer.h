@@ -0,0 +1,42 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Graphics/VertexAttribute.h"
+
+namespace se
+{
+	/**
+	 * 頂点属性の量子化(デバイスには依存しない)
+	 * 位置     : float3そのまま
+	 * 法線/接線/従法線 : 8面体写像したsnorm16 x2 (シェーダ側でDecodeOctahedral()が必要)
+	 * カラー   : unorm8 x4
+	 * UV       : half x2
+	 */
+	class VertexQuantizer
+	{
+	public:
+		// 量子化後の属性1つあたりのバイト数
+		static uint32_t GetAttributeSize(VertexAttribute attribute);
+
+		// 1属性分のストリームを量子化してoutputに書き込む(outputStrideはバイト単位)
+		static void Encode(VertexAttribute attribute, const float* input, uint32_t components, uint32_t vertexCount, void* output, uint32_t outputStride);
+		// 量子化したストリームを復元する(outputはcomponents要素ずつ詰める)
+		static void Decode(VertexAttribute attribute, const void* input, uint32_t inputStride, uint32_t vertexCount, float* output, uint32_t components);
+
+		// 量子化->復元した際の最大誤差
+		// 法線系は正規化後の要素毎の差、UVはmax(1, |v|)で割った相対誤差、カラーは[0, 1]に丸めた値との差
+		static float MeasureError(VertexAttribute attribute, const float* input, uint32_t components, uint32_t vertexCount);
+		// MeasureError()の誤差の上限
+		static float GetErrorBound(VertexAttribute attribute);
+
+		static uint16_t FloatToHalf(float value);
+		static float HalfToFloat(uint16_t value);
+		static int16_t FloatToSnorm16(float value);
+		static void EncodeOctahedral(const float* normal, int16_t* output);
+		static void DecodeOctahedral(const int16_t* input, float* normal);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Math/Math.h"
+#include <cfloat>
+
+namespace se
+{
+	/**
+	 * 軸平行境界ボックス
+	 */
+	struct AABB
+	{
+		Vector3 minPos;
+		Vector3 maxPos;
+
+		AABB()
+			: minPos(FLT_MAX)
+			, maxPos(-FLT_MAX)
+		{
+		}
+		AABB(const Vector3& minPos, const Vector3& maxPos)
+			: minPos(minPos)
+			, maxPos(maxPos)
+		{
+		}
+
+		bool IsEmpty() const
+		{
+			return minPos.x > maxPos.x || minPos.y > maxPos.y || minPos.z > maxPos.z;
+		}
+
+		Vector3 Center() const
+		{
+			return Vector3((minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f);
+		}
+
+		Vector3 Extents() const
+		{
+			return Vector3((maxPos.x - minPos.x) * 0.5f, (maxPos.y - minPos.y) * 0.5f, (maxPos.z - minPos.z) * 0.5f);
+		}
+
+		void Extend(const Vector3& p)
+		{
+			minPos.x = Min(minPos.x, p.x);
+			minPos.y = Min(minPos.y, p.y);
+			minPos.z = Min(minPos.z, p.z);
+			maxPos.x = Max(maxPos.x, p.x);
+			maxPos.y = Max(maxPos.y, p.y);
+			maxPos.z = Max(maxPos.z, p.z);
+		}
+
+		void Extend(const AABB& other)
+		{
+			if (other.IsEmpty()) return;
+			Extend(other.minPos);
+			Extend(other.maxPos);
+		}
+
+		// stride(float単位)間隔で並んだ座標から作成
+		static AABB FromPositions(const float* positions, uint32_t count, uint32_t stride)
+		{
+			AABB result;
+			for (uint32_t i = 0; i < count; i++) {
+				const float* p = positions + i * stride;
+				result.Extend(Vector3(p[0], p[1], p[2]));
+			}
+			return result;
+		}
+
+		// 変換後のボックスを包むボックス(行ベクトル規約のアフィン変換)
+		static AABB Transform(const AABB& box, const Matrix44& m)
+		{
+			if (box.IsEmpty()) return box;
+
+			Vector3 c = box.Center();
+			Vector3 e = box.Extents();
+			XMMATRIX matrix = m.ToMatrix();
+			XMVECTOR center = XMVectorMultiplyAdd(XMVectorReplicate(c.x), matrix.r[0],
+				XMVectorMultiplyAdd(XMVectorReplicate(c.y), matrix.r[1],
+				XMVectorMultiplyAdd(XMVectorReplicate(c.z), matrix.r[2], matrix.r[3])));
+			XMVECTOR extents = XMVectorMultiplyAdd(XMVectorReplicate(e.x), XMVectorAbs(matrix.r[0]),
+				XMVectorMultiplyAdd(XMVectorReplicate(e.y), XMVectorAbs(matrix.r[1]),
+				XMVectorMultiply(XMVectorReplicate(e.z), XMVectorAbs(matrix.r[2]))));
+			return AABB(Vector3(XMVectorSubtract(center, extents)), Vector3(XMVectorAdd(center, extents)));
+		}
+	};
+}
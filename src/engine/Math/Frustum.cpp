@@ -0,0 +1,123 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Math/Frustum.h"
+
+namespace se
+{
+	namespace {
+		inline Vector4 NormalizePlane(float a, float b, float c, float d)
+		{
+			float length = sqrtf(a * a + b * b + c * c);
+			float inv = (length > 0.0f) ? 1.0f / length : 0.0f;
+			return Vector4(a * inv, b * inv, c * inv, d * inv);
+		}
+	}
+
+
+	Frustum::Frustum()
+		: viewPosition_(0.0f)
+		, viewDirection_(0.0f, 0.0f, -1.0f)
+		, orthographic_(false)
+	{
+		// 初期状態は全てを内側とする
+		for (int32_t i = 0; i < PlaneNum; i++) {
+			planes_[i] = Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	void Frustum::SetFromMatrix(const Matrix44& m)
+	{
+		// clip = pos * M なので各平面はMの列の組み合わせになる
+		// Nearは0 <= zと-w <= zのどちらの深度範囲でも内側を欠かないよう-w <= z(広い方)を使う
+		planes_[Left]   = NormalizePlane(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+		planes_[Right]  = NormalizePlane(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+		planes_[Bottom] = NormalizePlane(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+		planes_[Top]    = NormalizePlane(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+		planes_[Near]   = NormalizePlane(m._14 + m._13, m._24 + m._23, m._34 + m._33, m._44 + m._43);
+		planes_[Far]    = NormalizePlane(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+	}
+
+	void Frustum::SetViewPoint(const Vector3& position, const Vector3& direction, bool orthographic)
+	{
+		viewPosition_ = position;
+		viewDirection_ = Vector3(XMVector3Normalize(XMLoadFloat3(&direction)));
+		orthographic_ = orthographic;
+	}
+
+	bool Frustum::Intersects(const AABB& box) const
+	{
+		if (box.IsEmpty()) return false;
+
+		Vector3 c = box.Center();
+		Vector3 e = box.Extents();
+		for (int32_t i = 0; i < PlaneNum; i++) {
+			const Vector4& p = planes_[i];
+			float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+			float radius = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+			if (distance + radius < 0.0f) return false;
+		}
+		return true;
+	}
+
+	void Frustum::CullAABBs(const AABB* boxes, uint32_t count, uint8_t* results) const
+	{
+		// 平面の各成分を4レーンに複製
+		XMVECTOR px[PlaneNum], py[PlaneNum], pz[PlaneNum], pw[PlaneNum];
+		XMVECTOR ax[PlaneNum], ay[PlaneNum], az[PlaneNum];
+		for (int32_t i = 0; i < PlaneNum; i++) {
+			px[i] = XMVectorReplicate(planes_[i].x);
+			py[i] = XMVectorReplicate(planes_[i].y);
+			pz[i] = XMVectorReplicate(planes_[i].z);
+			pw[i] = XMVectorReplicate(planes_[i].w);
+			ax[i] = XMVectorAbs(px[i]);
+			ay[i] = XMVectorAbs(py[i]);
+			az[i] = XMVectorAbs(pz[i]);
+		}
+
+		const XMVECTOR half = XMVectorReplicate(0.5f);
+		const XMVECTOR zero = XMVectorZero();
+
+		uint32_t index = 0;
+		for (; index + 4 <= count; index += 4) {
+			const AABB* box = boxes + index;
+
+			// 4つのボックスを成分毎(x, y, z)に並べ替え
+			XMMATRIX minPos = XMMatrixTranspose(XMMATRIX(
+				XMLoadFloat3(&box[0].minPos), XMLoadFloat3(&box[1].minPos),
+				XMLoadFloat3(&box[2].minPos), XMLoadFloat3(&box[3].minPos)));
+			XMMATRIX maxPos = XMMatrixTranspose(XMMATRIX(
+				XMLoadFloat3(&box[0].maxPos), XMLoadFloat3(&box[1].maxPos),
+				XMLoadFloat3(&box[2].maxPos), XMLoadFloat3(&box[3].maxPos)));
+
+			XMVECTOR cx = XMVectorMultiply(XMVectorAdd(maxPos.r[0], minPos.r[0]), half);
+			XMVECTOR cy = XMVectorMultiply(XMVectorAdd(maxPos.r[1], minPos.r[1]), half);
+			XMVECTOR cz = XMVectorMultiply(XMVectorAdd(maxPos.r[2], minPos.r[2]), half);
+			XMVECTOR ex = XMVectorMultiply(XMVectorSubtract(maxPos.r[0], minPos.r[0]), half);
+			XMVECTOR ey = XMVectorMultiply(XMVectorSubtract(maxPos.r[1], minPos.r[1]), half);
+			XMVECTOR ez = XMVectorMultiply(XMVectorSubtract(maxPos.r[2], minPos.r[2]), half);
+
+			// 空のボックスはextentsが負になるので外側として扱う
+			XMVECTOR outside = XMVectorOrInt(XMVectorLess(ex, zero), XMVectorOrInt(XMVectorLess(ey, zero), XMVectorLess(ez, zero)));
+			for (int32_t i = 0; i < PlaneNum; i++) {
+				XMVECTOR distance = XMVectorMultiplyAdd(cx, px[i], XMVectorMultiplyAdd(cy, py[i], XMVectorMultiplyAdd(cz, pz[i], pw[i])));
+				XMVECTOR radius = XMVectorMultiplyAdd(ex, ax[i], XMVectorMultiplyAdd(ey, ay[i], XMVectorMultiply(ez, az[i])));
+				outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), zero));
+			}
+
+			uint32_t mask[4];
+			XMStoreInt4(mask, outside);
+			results[index + 0] = mask[0] ? 0 : 1;
+			results[index + 1] = mask[1] ? 0 : 1;
+			results[index + 2] = mask[2] ? 0 : 1;
+			results[index + 3] = mask[3] ? 0 : 1;
+		}
+
+		// 端数
+		for (; index < count; index++) {
+			results[index] = Intersects(boxes[index]) ? 1 : 0;
+		}
+	}
+}
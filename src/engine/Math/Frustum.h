@@ -0,0 +1,56 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Math/Math.h"
+#include "engine/Math/Bounds.h"
+
+namespace se
+{
+	/**
+	 * 視錐台
+	 * 各平面は内側を正とする(ax + by + cz + d >= 0 が内側)
+	 */
+	class Frustum
+	{
+	public:
+		enum Plane
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+
+			PlaneNum,
+		};
+
+	private:
+		Vector4 planes_[PlaneNum];
+		Vector3 viewPosition_;		// 背面判定の視点(透視投影)
+		Vector3 viewDirection_;		// 背面判定の視線方向(平行投影、正規化済み)
+		bool orthographic_;
+
+	public:
+		Frustum();
+
+		// ワールド->クリップ空間のマトリクス(行ベクトル規約、転置前)から作成
+		void SetFromMatrix(const Matrix44& worldToClip);
+
+		// 背面判定の視点(ワールド空間)
+		void SetViewPoint(const Vector3& position, const Vector3& direction, bool orthographic);
+
+		const Vector4& GetPlane(Plane plane) const { return planes_[plane]; }
+		const Vector3& GetViewPosition() const { return viewPosition_; }
+		const Vector3& GetViewDirection() const { return viewDirection_; }
+		bool IsOrthographic() const { return orthographic_; }
+		bool Intersects(const AABB& box) const;
+
+		// ボックスを4つずつまとめて判定する(results: 視錐台と交差していれば1)
+		void CullAABBs(const AABB* boxes, uint32_t count, uint8_t* results) const;
+	};
+}
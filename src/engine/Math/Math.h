@@ -5,9 +5,18 @@
 
 #pragma once 
 
+#include <cstdint>
+#if defined(_WIN32)
 #include <DirectXMath.h>
+#else
+#include "engine/Math/MathFallback.h"	// コマンドラインツールをLinuxでビルドする場合
+#endif
 using namespace DirectX;
 
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
 namespace se
 {
 	/**
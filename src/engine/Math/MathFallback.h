@@ -0,0 +1,255 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * DirectXMathのない環境(Linuxのコマンドラインツール等)用の代替
+ * engine内で使っている型、関数のみをスカラーで実装する(名前、引数、行ベクトル規約はDirectXMathに合わせる)
+ * Windowsのビルドでは使わない
+ */
+namespace DirectX
+{
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() {}
+		XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() {}
+		XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() {}
+	};
+
+	struct XMVECTOR
+	{
+		union
+		{
+			float f[4];
+			uint32_t u[4];
+		};
+	};
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() {}
+		XMMATRIX(const XMVECTOR& r0, const XMVECTOR& r1, const XMVECTOR& r2, const XMVECTOR& r3)
+		{
+			r[0] = r0;
+			r[1] = r1;
+			r[2] = r2;
+			r[3] = r3;
+		}
+	};
+
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMMATRIX& CXMMATRIX;
+
+
+	/* ロード、ストア */
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w)
+	{
+		XMVECTOR v;
+		v.f[0] = x;
+		v.f[1] = y;
+		v.f[2] = z;
+		v.f[3] = w;
+		return v;
+	}
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source)
+	{
+		return XMVectorSet(source->x, source->y, source->z, 0.0f);
+	}
+
+	inline void XMStoreFloat3(XMFLOAT3* dest, FXMVECTOR v)
+	{
+		dest->x = v.f[0];
+		dest->y = v.f[1];
+		dest->z = v.f[2];
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* dest, FXMVECTOR v)
+	{
+		dest->x = v.f[0];
+		dest->y = v.f[1];
+		dest->z = v.f[2];
+		dest->w = v.f[3];
+	}
+
+	inline void XMStoreInt4(uint32_t* dest, FXMVECTOR v)
+	{
+		for (int i = 0; i < 4; i++) dest[i] = v.u[i];
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) {
+			result.r[i] = XMVectorSet(source->m[i][0], source->m[i][1], source->m[i][2], source->m[i][3]);
+		}
+		return result;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* dest, CXMMATRIX m)
+	{
+		for (int i = 0; i < 4; i++) {
+			for (int k = 0; k < 4; k++) dest->m[i][k] = m.r[i].f[k];
+		}
+	}
+
+
+	/* ベクトル */
+	inline XMVECTOR XMVectorZero()
+	{
+		return XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	inline XMVECTOR XMVectorReplicate(float value)
+	{
+		return XMVectorSet(value, value, value, value);
+	}
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2], a.f[3] + b.f[3]);
+	}
+
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.f[0] - b.f[0], a.f[1] - b.f[1], a.f[2] - b.f[2], a.f[3] - b.f[3]);
+	}
+
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2], a.f[3] * b.f[3]);
+	}
+
+	// a * b + c
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c)
+	{
+		return XMVectorAdd(XMVectorMultiply(a, b), c);
+	}
+
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v)
+	{
+		return XMVectorSet(fabsf(v.f[0]), fabsf(v.f[1]), fabsf(v.f[2]), fabsf(v.f[3]));
+	}
+
+	// 成分毎の比較(真は全ビット1)
+	inline XMVECTOR XMVectorLess(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++) result.u[i] = (a.f[i] < b.f[i]) ? 0xffffffffu : 0u;
+		return result;
+	}
+
+	inline XMVECTOR XMVectorOrInt(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++) result.u[i] = a.u[i] | b.u[i];
+		return result;
+	}
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = sqrtf(v.f[0] * v.f[0] + v.f[1] * v.f[1] + v.f[2] * v.f[2]);
+		float inv = (length > 0.0f) ? 1.0f / length : 0.0f;
+		return XMVectorSet(v.f[0] * inv, v.f[1] * inv, v.f[2] * inv, v.f[3] * inv);
+	}
+
+
+	/* マトリクス */
+	inline XMMATRIX XMMatrixMultiply(CXMMATRIX a, CXMMATRIX b)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) {
+			XMVECTOR row = XMVectorMultiply(XMVectorReplicate(a.r[i].f[0]), b.r[0]);
+			row = XMVectorMultiplyAdd(XMVectorReplicate(a.r[i].f[1]), b.r[1], row);
+			row = XMVectorMultiplyAdd(XMVectorReplicate(a.r[i].f[2]), b.r[2], row);
+			result.r[i] = XMVectorMultiplyAdd(XMVectorReplicate(a.r[i].f[3]), b.r[3], row);
+		}
+		return result;
+	}
+
+	inline XMMATRIX operator*(CXMMATRIX a, CXMMATRIX b)
+	{
+		return XMMatrixMultiply(a, b);
+	}
+
+	inline XMMATRIX XMMatrixTranspose(CXMMATRIX m)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) {
+			result.r[i] = XMVectorSet(m.r[0].f[i], m.r[1].f[i], m.r[2].f[i], m.r[3].f[i]);
+		}
+		return result;
+	}
+
+	// 余因子展開(行列式が0の場合は0の行列)
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, CXMMATRIX matrix)
+	{
+		float m[16];
+		for (int i = 0; i < 16; i++) m[i] = matrix.r[i / 4].f[i % 4];
+
+		float inv[16];
+		inv[0]  =  m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inv[4]  = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inv[8]  =  m[4] * m[9]  * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inv[12] = -m[4] * m[9]  * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inv[1]  = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inv[5]  =  m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inv[9]  = -m[0] * m[9]  * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inv[13] =  m[0] * m[9]  * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inv[2]  =  m[1] * m[6]  * m[15] - m[1] * m[7]  * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7]  - m[13] * m[3] * m[6];
+		inv[6]  = -m[0] * m[6]  * m[15] + m[0] * m[7]  * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7]  + m[12] * m[3] * m[6];
+		inv[10] =  m[0] * m[5]  * m[15] - m[0] * m[7]  * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7]  - m[12] * m[3] * m[5];
+		inv[14] = -m[0] * m[5]  * m[14] + m[0] * m[6]  * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6]  + m[12] * m[2] * m[5];
+		inv[3]  = -m[1] * m[6]  * m[11] + m[1] * m[7]  * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9]  * m[2] * m[7]  + m[9]  * m[3] * m[6];
+		inv[7]  =  m[0] * m[6]  * m[11] - m[0] * m[7]  * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8]  * m[2] * m[7]  - m[8]  * m[3] * m[6];
+		inv[11] = -m[0] * m[5]  * m[11] + m[0] * m[7]  * m[9]  + m[4] * m[1] * m[11] - m[4] * m[3] * m[9]  - m[8]  * m[1] * m[7]  + m[8]  * m[3] * m[5];
+		inv[15] =  m[0] * m[5]  * m[10] - m[0] * m[6]  * m[9]  - m[4] * m[1] * m[10] + m[4] * m[2] * m[9]  + m[8]  * m[1] * m[6]  - m[8]  * m[2] * m[5];
+
+		float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+		if (determinant) *determinant = XMVectorReplicate(det);
+
+		float scale = (det != 0.0f) ? 1.0f / det : 0.0f;
+		XMMATRIX result;
+		for (int i = 0; i < 16; i++) result.r[i / 4].f[i % 4] = inv[i] * scale;
+		return result;
+	}
+}
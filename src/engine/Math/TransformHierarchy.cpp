@@ -0,0 +1,123 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#include "engine/Math/TransformHierarchy.h"
+#include "engine/Core/ThreadPool.h"
+#include <cassert>
+
+namespace se
+{
+	namespace {
+		// 1タスクあたりの処理数
+		const uint32_t EvaluateGrainSize = 256;
+	}
+
+
+	TransformHierarchy::TransformHierarchy()
+		: levelsDirty_(false)
+	{
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		local_.clear();
+		world_.clear();
+		parent_.clear();
+		depth_.clear();
+		changed_.clear();
+		order_.clear();
+		levelOffset_.clear();
+		levelsDirty_ = false;
+	}
+
+	void TransformHierarchy::Reserve(uint32_t count)
+	{
+		local_.reserve(count);
+		world_.reserve(count);
+		parent_.reserve(count);
+		depth_.reserve(count);
+		changed_.reserve(count);
+		order_.reserve(count);
+	}
+
+	uint32_t TransformHierarchy::Add(uint32_t parent, const Matrix44& local, const Matrix44& prevWorld)
+	{
+		uint32_t index = Count();
+		assert(parent == InvalidIndex || parent < index);
+
+		local_.push_back(local);
+		world_.push_back(prevWorld);
+		parent_.push_back(parent);
+		depth_.push_back((parent == InvalidIndex) ? 0 : depth_[parent] + 1);
+		changed_.push_back(0);
+		levelsDirty_ = true;
+		return index;
+	}
+
+	void TransformHierarchy::Set(uint32_t index, const Matrix44& local, const Matrix44& prevWorld)
+	{
+		assert(index < Count());
+		local_[index] = local;
+		world_[index] = prevWorld;
+	}
+
+	void TransformHierarchy::BuildLevels()
+	{
+		// 深さでカウンティングソート
+		uint32_t maxDepth = 0;
+		for (uint32_t depth : depth_) {
+			maxDepth = Max(maxDepth, depth);
+		}
+
+		levelOffset_.assign(maxDepth + 2, 0);
+		for (uint32_t depth : depth_) {
+			levelOffset_[depth + 1]++;
+		}
+		for (uint32_t i = 1; i < levelOffset_.size(); i++) {
+			levelOffset_[i] += levelOffset_[i - 1];
+		}
+
+		std::vector<uint32_t> cursor(levelOffset_.begin(), levelOffset_.end() - 1);
+		order_.resize(Count());
+		for (uint32_t i = 0; i < Count(); i++) {
+			order_[cursor[depth_[i]]++] = i;
+		}
+	}
+
+	void TransformHierarchy::EvaluateRange(const uint32_t* indices, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t index = indices[i];
+			uint32_t parent = parent_[index];
+
+			// 行ベクトル規約なので world = local * parentWorld
+			Matrix44 world = (parent != InvalidIndex) ? local_[index] * world_[parent] : local_[index];
+			changed_[index] = (world != world_[index]) ? 1 : 0;
+			world_[index] = world;
+		}
+	}
+
+	void TransformHierarchy::Evaluate(ThreadPool* pool)
+	{
+		if (levelsDirty_) {
+			BuildLevels();
+			levelsDirty_ = false;
+		}
+
+		// 親の深さの計算が終わってから次の深さを計算する
+		for (uint32_t level = 0; level < GetLevelCount(); level++) {
+			const uint32_t* indices = &order_[levelOffset_[level]];
+			uint32_t count = levelOffset_[level + 1] - levelOffset_[level];
+
+			if (pool) {
+				pool->ParallelFor(count, EvaluateGrainSize, [this, indices](uint32_t begin, uint32_t end) {
+					EvaluateRange(indices + begin, end - begin);
+				});
+			} else {
+				EvaluateRange(indices, count);
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+#pragma once 
+
+#include "engine/Math/Math.h"
+#include <vector>
+
+namespace se
+{
+	class ThreadPool;
+
+	/**
+	 * トランスフォーム階層
+	 * ローカル、ワールド、親インデックスを配列で持ち、階層の深さ順にワールドマトリクスを合成する
+	 * 同じ深さのノードは互いに依存しないので並列に計算できる
+	 * 深さ順の並びは親子関係が変わった場合(Add、Clear)のみ作り直し、マトリクスのみの更新はSetで行う
+	 */
+	class TransformHierarchy
+	{
+	public:
+		static const uint32_t InvalidIndex = 0xffffffff;
+
+	private:
+		std::vector<Matrix44> local_;
+		std::vector<Matrix44> world_;
+		std::vector<uint32_t> parent_;
+		std::vector<uint32_t> depth_;
+		std::vector<uint8_t> changed_;
+
+		std::vector<uint32_t> order_;			// 深さ順に並べたインデックス
+		std::vector<uint32_t> levelOffset_;		// 深さ毎のorder_の開始位置
+		bool levelsDirty_;
+
+	private:
+		void BuildLevels();
+		void EvaluateRange(const uint32_t* indices, uint32_t count);
+
+	public:
+		TransformHierarchy();
+
+		void Clear();
+		void Reserve(uint32_t count);
+
+		// 親は子より先に追加する(parentにはInvalidIndexか追加済みのインデックスを指定)
+		// 親がない場合localはワールドとして扱う
+		// prevWorldは変更判定用の前回のワールドマトリクス
+		uint32_t Add(uint32_t parent, const Matrix44& local, const Matrix44& prevWorld);
+
+		// 追加済みのノードのマトリクスのみ更新する(親子関係は変えない)
+		void Set(uint32_t index, const Matrix44& local, const Matrix44& prevWorld);
+
+		// ワールドマトリクスを計算する(poolがnullの場合は呼び出しスレッドのみで計算)
+		void Evaluate(ThreadPool* pool = nullptr);
+
+		uint32_t Count() const { return static_cast<uint32_t>(local_.size()); }
+		uint32_t GetParent(uint32_t index) const { return parent_[index]; }
+		const Matrix44& GetLocal(uint32_t index) const { return local_[index]; }
+		const Matrix44& GetWorld(uint32_t index) const { return world_[index]; }
+		bool IsChanged(uint32_t index) const { return changed_[index] != 0; }
+		uint32_t GetLevelCount() const { return levelOffset_.empty() ? 0 : static_cast<uint32_t>(levelOffset_.size()) - 1; }
+	};
+}
@@ -25,6 +25,11 @@
 #include <DirectXMath.h>
 #include "engine/Graphics/Graphics.h"
 #include "engine/Math/Math.h"
+#include "engine/Math/TransformHierarchy.h"
+#include "engine/Math/Bounds.h"
+#include "engine/Math/Frustum.h"
+#include "engine/Core/ThreadPool.h"
+#include "engine/Core/UpdateQueue.h"
 
 #ifdef _DEBUG
 
@@ -7,6 +7,14 @@
 
 MTypeId CustomViewportGlobals::id(0x7fff0);
 MObject CustomViewportGlobals::fxaaEnable_;
+MObject CustomViewportGlobals::interleavedVertex_;
+MObject CustomViewportGlobals::quantizedVertex_;
+MObject CustomViewportGlobals::optimizeVertexCache_;
+MObject CustomViewportGlobals::optimizeOverdraw_;
+MObject CustomViewportGlobals::diskCache_;
+MObject CustomViewportGlobals::diskCacheSize_;
+MObject CustomViewportGlobals::gpuSkinning_;
+MObject CustomViewportGlobals::chunkedMesh_;
 
 
 CustomViewportGlobals::CustomViewportGlobals()
@@ -44,5 +52,60 @@ MStatus CustomViewportGlobals::initialize()
 	fnNewAttr.setAffectsAppearance(true);
 	addAttribute(fxaaEnable_);
 
+	interleavedVertex_ = fnAttr.create("interleavedVertex", "ilv", MFnNumericData::kBoolean, false, &s);
+	MFnAttribute fnInterleavedAttr(interleavedVertex_);
+	fnInterleavedAttr.setStorable(true);
+	fnInterleavedAttr.setKeyable(false);
+	fnInterleavedAttr.setAffectsAppearance(true);
+	addAttribute(interleavedVertex_);
+
+	quantizedVertex_ = fnAttr.create("quantizedVertex", "qvx", MFnNumericData::kBoolean, false, &s);
+	MFnAttribute fnQuantizedAttr(quantizedVertex_);
+	fnQuantizedAttr.setStorable(true);
+	fnQuantizedAttr.setKeyable(false);
+	fnQuantizedAttr.setAffectsAppearance(true);
+	addAttribute(quantizedVertex_);
+
+	optimizeVertexCache_ = fnAttr.create("optimizeVertexCache", "ovc", MFnNumericData::kBoolean, false, &s);
+	MFnAttribute fnVertexCacheAttr(optimizeVertexCache_);
+	fnVertexCacheAttr.setStorable(true);
+	fnVertexCacheAttr.setKeyable(false);
+	fnVertexCacheAttr.setAffectsAppearance(true);
+	addAttribute(optimizeVertexCache_);
+
+	optimizeOverdraw_ = fnAttr.create("optimizeOverdraw", "ood", MFnNumericData::kBoolean, false, &s);
+	MFnAttribute fnOverdrawAttr(optimizeOverdraw_);
+	fnOverdrawAttr.setStorable(true);
+	fnOverdrawAttr.setKeyable(false);
+	fnOverdrawAttr.setAffectsAppearance(true);
+	addAttribute(optimizeOverdraw_);
+
+	diskCache_ = fnAttr.create("diskCache", "dkc", MFnNumericData::kBoolean, true, &s);
+	MFnAttribute fnDiskCacheAttr(diskCache_);
+	fnDiskCacheAttr.setStorable(true);
+	fnDiskCacheAttr.setKeyable(false);
+	addAttribute(diskCache_);
+
+	diskCacheSize_ = fnAttr.create("diskCacheSize", "dcs", MFnNumericData::kInt, 1024, &s);
+	fnAttr.setMin(0);
+	MFnAttribute fnDiskCacheSizeAttr(diskCacheSize_);
+	fnDiskCacheSizeAttr.setStorable(true);
+	fnDiskCacheSizeAttr.setKeyable(false);
+	addAttribute(diskCacheSize_);
+
+	gpuSkinning_ = fnAttr.create("gpuSkinning", "gsk", MFnNumericData::kBoolean, false, &s);
+	MFnAttribute fnGpuSkinningAttr(gpuSkinning_);
+	fnGpuSkinningAttr.setStorable(true);
+	fnGpuSkinningAttr.setKeyable(false);
+	fnGpuSkinningAttr.setAffectsAppearance(true);
+	addAttribute(gpuSkinning_);
+
+	chunkedMesh_ = fnAttr.create("chunkedMesh", "cmk", MFnNumericData::kBoolean, false, &s);
+	MFnAttribute fnChunkedMeshAttr(chunkedMesh_);
+	fnChunkedMeshAttr.setStorable(true);
+	fnChunkedMeshAttr.setKeyable(false);
+	fnChunkedMeshAttr.setAffectsAppearance(true);
+	addAttribute(chunkedMesh_);
+
 	return MS::kSuccess;
 }
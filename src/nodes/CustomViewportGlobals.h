@@ -17,6 +17,14 @@ public:
 
 public:
 	static MObject fxaaEnable_;
+	static MObject interleavedVertex_;
+	static MObject quantizedVertex_;
+	static MObject optimizeVertexCache_;
+	static MObject optimizeOverdraw_;
+	static MObject diskCache_;
+	static MObject diskCacheSize_;
+	static MObject gpuSkinning_;
+	static MObject chunkedMesh_;
 
 private:
 
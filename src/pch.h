@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <memory>
 #include <functional>
+#include <chrono>
 #include <unordered_set>
 #include <unordered_map>
 
@@ -23,6 +24,8 @@
 #include <maya/MObjectHandle.h>
 #include <maya/MNodeMessage.h>
 #include <maya/MDagMessage.h>
+#include <maya/MSceneMessage.h>
+#include <maya/MCallbackIdArray.h>
 #include <maya/MStateManager.h>
 #include <maya/MGeometryRequirements.h>
 #include <maya/MHWGeometry.h>
@@ -46,6 +49,12 @@
 #include <maya/MArgList.h>
 #include <maya/MPxCommand.h>
 #include <maya/MItInstancer.h>
+#include <maya/MIntArray.h>
+#include <maya/MFloatArray.h>
+#include <maya/MColorArray.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MDagPathArray.h>
+#include <maya/MItDependencyGraph.h>
 
 #include <maya/MFnMesh.h>
 #include <maya/MFnAttribute.h>
@@ -59,6 +68,8 @@
 #include <maya/MFnMessageAttribute.h>
 #include <maya/MFnInstancer.h>
 #include <maya/MFnSet.h>
+#include <maya/MFnSkinCluster.h>
+#include <maya/MFnMatrixData.h>
 
 #include "engine/engine.h"
 #include "Common.h"
@@ -0,0 +1,47 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// コマンドラインツール共通の検証と計測の補助
+// 各ツールは1つのソースからビルドするので、ヘッダのみで完結させる
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace tools
+{
+	// 全ての検証に成功したか
+	inline bool& Passed()
+	{
+		static bool passed = true;
+		return passed;
+	}
+
+	// 条件を満たさなければメッセージを表示して失敗を記録する
+	inline void Check(bool condition, const char* message)
+	{
+		if (!condition) {
+			printf("FAILED: %s\n", message);
+			Passed() = false;
+		}
+	}
+
+	// beginからの経過時間(ミリ秒)
+	inline double ElapsedMs(std::chrono::high_resolution_clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+	}
+
+	// 検証の結果を表示して終了コードを返す
+	inline int Finish()
+	{
+		if (!Passed()) return 1;
+		printf("all checks passed\n");
+		return 0;
+	}
+}
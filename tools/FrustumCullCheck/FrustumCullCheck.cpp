@@ -0,0 +1,259 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// FrustumCullCheck
+// DAGMeshの視錐台カリング(AABB::Transform、Frustum::CullAABBs)を検証する(Mayaに依存しないのでコマンドラインで実行できる)
+// ランダムなボックスを8頂点で判定した結果と比較し、視錐台と交差するボックスを除外しないこと、
+// 4つずつの判定が1つずつの判定(Intersects)と一致することを確認して判定時間を表示する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src FrustumCullCheck.cpp ..\..\src\engine\Math\Frustum.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src FrustumCullCheck.cpp ../../src/engine/Math/Frustum.cpp -o FrustumCullCheck
+//
+// 使い方
+//   FrustumCullCheck [-n boxCount] [-i iterations]
+//     -n : 1回の判定のボックス数(既定値100000)
+//     -i : ランダムな視点で判定する回数(既定値20)
+//
+
+#include "engine/Math/Frustum.h"
+#include "../Common/Check.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	// 右手系の透視投影(行ベクトル規約、-Z方向を見る、深度0～1)
+	Matrix44 Perspective(float fovY, float aspect, float nearZ, float farZ)
+	{
+		float yScale = 1.0f / tanf(fovY * 0.5f);
+		Matrix44 m;
+		m.Ident();
+		m._11 = yScale / aspect;
+		m._22 = yScale;
+		m._33 = farZ / (nearZ - farZ);
+		m._34 = -1.0f;
+		m._43 = nearZ * farZ / (nearZ - farZ);
+		m._44 = 0.0f;
+		return m;
+	}
+
+	// Z軸回りの回転と平行移動(行ベクトル規約)
+	Matrix44 RotateTranslate(float angle, const Vector3& t)
+	{
+		Matrix44 m;
+		m.Ident();
+		m._11 = cosf(angle);
+		m._12 = sinf(angle);
+		m._21 = -sinf(angle);
+		m._22 = cosf(angle);
+		m.SetTranslation(t);
+		return m;
+	}
+
+	Vector3 Corner(const AABB& box, int i)
+	{
+		return Vector3((i & 1) ? box.maxPos.x : box.minPos.x, (i & 2) ? box.maxPos.y : box.minPos.y, (i & 4) ? box.maxPos.z : box.minPos.z);
+	}
+
+	Vector3 TransformPoint(const Vector3& p, const Matrix44& m)
+	{
+		return Vector3(p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+			p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+			p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43);
+	}
+
+	float PlaneDistance(const Vector4& plane, const Vector3& p)
+	{
+		return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+	}
+
+	// 8頂点のすべてがいずれかの平面の外側(margin以上離れている)
+	bool IsOutside(const Frustum& frustum, const AABB& box, float margin)
+	{
+		for (int plane = 0; plane < Frustum::PlaneNum; plane++) {
+			bool allOutside = true;
+			for (int i = 0; i < 8 && allOutside; i++) {
+				if (PlaneDistance(frustum.GetPlane(static_cast<Frustum::Plane>(plane)), Corner(box, i)) >= -margin) allOutside = false;
+			}
+			if (allOutside) return true;
+		}
+		return false;
+	}
+
+	// 8頂点のいずれかがすべての平面の内側(margin以上入っている)
+	bool HasCornerInside(const Frustum& frustum, const AABB& box, float margin)
+	{
+		for (int i = 0; i < 8; i++) {
+			bool inside = true;
+			for (int plane = 0; plane < Frustum::PlaneNum && inside; plane++) {
+				if (PlaneDistance(frustum.GetPlane(static_cast<Frustum::Plane>(plane)), Corner(box, i)) < margin) inside = false;
+			}
+			if (inside) return true;
+		}
+		return false;
+	}
+
+	std::vector<AABB> MakeBoxes(uint32_t count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(0.0f, 20.0f);
+		std::vector<AABB> boxes(count);
+		for (uint32_t i = 0; i < count; i++) {
+			Vector3 minPos(position(random), position(random), position(random));
+			Vector3 extents(size(random), size(random), size(random));
+			if (random() % 64 == 0) {
+				boxes[i] = AABB();	// 空のボックス
+			} else if (random() % 64 == 0) {
+				boxes[i] = AABB(minPos, minPos);	// 大きさのないボックス
+			} else {
+				boxes[i] = AABB(minPos, Vector3(minPos.x + extents.x, minPos.y + extents.y, minPos.z + extents.z));
+			}
+		}
+		return boxes;
+	}
+
+	// 決まった条件での確認
+	void CheckBasic()
+	{
+		// 初期状態は全て内側
+		Frustum all;
+		AABB unit(Vector3(-1.0f), Vector3(1.0f));
+		Check(all.Intersects(unit) && !all.Intersects(AABB()), "default frustum");
+
+		Frustum frustum;
+		frustum.SetFromMatrix(Perspective(1.0f, 1.5f, 0.1f, 100.0f));
+		Check(frustum.Intersects(AABB(Vector3(-1.0f, -1.0f, -11.0f), Vector3(1.0f, 1.0f, -9.0f))), "box in front");
+		Check(!frustum.Intersects(AABB(Vector3(-1.0f, -1.0f, 9.0f), Vector3(1.0f, 1.0f, 11.0f))), "box behind");
+		Check(!frustum.Intersects(AABB(Vector3(-1.0f, -1.0f, -211.0f), Vector3(1.0f, 1.0f, -209.0f))), "box beyond far");
+		Check(frustum.Intersects(AABB(Vector3(-1.0f, -1.0f, -1.0f), Vector3(1.0f, 1.0f, 1.0f))), "box around the near plane");
+
+		// 端数(4の倍数でない数)と空のボックス
+		AABB boxes[7] = {
+			AABB(Vector3(-1.0f, -1.0f, -11.0f), Vector3(1.0f, 1.0f, -9.0f)),
+			AABB(Vector3(-1.0f, -1.0f, 9.0f), Vector3(1.0f, 1.0f, 11.0f)),
+			AABB(),
+			AABB(Vector3(0.0f, 0.0f, -5.0f), Vector3(0.0f, 0.0f, -5.0f)),
+			AABB(Vector3(500.0f, 0.0f, -5.0f), Vector3(501.0f, 1.0f, -4.0f)),
+			AABB(Vector3(-1.0f, -1.0f, -11.0f), Vector3(1.0f, 1.0f, -9.0f)),
+			AABB(),
+		};
+		const uint8_t expected[7] = { 1, 0, 0, 1, 0, 1, 0 };
+		uint8_t results[7];
+		frustum.CullAABBs(boxes, 7, results);
+		Check(memcmp(results, expected, sizeof(results)) == 0, "cull with remainder");
+
+		// 視点の向きは正規化される
+		frustum.SetViewPoint(Vector3(1.0f, 2.0f, 3.0f), Vector3(0.0f, 0.0f, -4.0f), false);
+		Check(frustum.GetViewDirection().z == -1.0f && frustum.GetViewPosition().y == 2.0f, "view point");
+
+		// 回転したボックスは元の8頂点を包む
+		Matrix44 m = RotateTranslate(0.7f, Vector3(3.0f, -2.0f, 5.0f));
+		m._33 = 2.0f;
+		AABB box(Vector3(-1.0f, -2.0f, -3.0f), Vector3(4.0f, 5.0f, 6.0f));
+		AABB transformed = AABB::Transform(box, m);
+		bool contains = true;
+		for (int i = 0; i < 8; i++) {
+			Vector3 p = TransformPoint(Corner(box, i), m);
+			if (p.x < transformed.minPos.x - 1e-4f || p.x > transformed.maxPos.x + 1e-4f
+				|| p.y < transformed.minPos.y - 1e-4f || p.y > transformed.maxPos.y + 1e-4f
+				|| p.z < transformed.minPos.z - 1e-4f || p.z > transformed.maxPos.z + 1e-4f) contains = false;
+		}
+		Check(contains, "transformed box does not contain the corners");
+		Check(AABB::Transform(AABB(), m).IsEmpty(), "transformed empty box");
+	}
+
+	// ランダムな視点での確認と計測
+	void CheckRandom(uint32_t count, uint32_t iterations)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<AABB> boxes = MakeBoxes(count, random);
+		std::vector<uint8_t> results(count);
+
+		bool conservative = true;
+		bool tight = true;
+		bool consistent = true;
+		uint64_t visible = 0;
+		double cullMs = 0.0;
+		double scalarMs = 0.0;
+		for (uint32_t n = 0; n < iterations; n++) {
+			Matrix44 view = RotateTranslate(unit(random) * 3.14f, Vector3(unit(random) * 50.0f, unit(random) * 50.0f, unit(random) * 50.0f));
+			Frustum frustum;
+			frustum.SetFromMatrix(view * Perspective(0.5f + (unit(random) + 1.0f), 1.0f + (unit(random) + 1.0f) * 0.5f, 0.1f, 150.0f));
+
+			auto begin = std::chrono::high_resolution_clock::now();
+			frustum.CullAABBs(boxes.data(), count, results.data());
+			cullMs += ElapsedMs(begin);
+
+			begin = std::chrono::high_resolution_clock::now();
+			uint32_t differs = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				if ((frustum.Intersects(boxes[i]) ? 1 : 0) != results[i]) differs++;
+			}
+			scalarMs += ElapsedMs(begin);
+
+			for (uint32_t i = 0; i < count; i++) {
+				const AABB& box = boxes[i];
+				if (box.IsEmpty()) {
+					if (results[i]) consistent = false;
+					continue;
+				}
+				visible += results[i];
+
+				// 交差するボックスは除外しない、平面の外側のボックスは除外する(境界付近の誤差は許容)
+				if (!results[i] && HasCornerInside(frustum, box, 1e-3f)) conservative = false;
+				if (results[i] && IsOutside(frustum, box, 1e-3f)) tight = false;
+				if ((frustum.Intersects(box) ? 1 : 0) != results[i] && !IsOutside(frustum, box, 1e-3f) && !HasCornerInside(frustum, box, 1e-3f)) {
+					// 境界上は演算順の違いで判定が分かれることがある
+					differs--;
+				}
+			}
+			if (differs != 0) consistent = false;
+		}
+		Check(conservative, "a box intersecting the frustum was culled");
+		Check(tight, "a box outside a plane was not culled");
+		Check(consistent, "CullAABBs differs from Intersects");
+
+		printf("box: %u, iteration: %u, visible: %.1f%%\n", count, iterations, 100.0 * visible / (static_cast<double>(count) * iterations));
+		printf("  CullAABBs  : %8.3f ms\n", cullMs / iterations);
+		printf("  Intersects : %8.3f ms\n", scalarMs / iterations);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = 100000;
+	uint32_t iterations = 20;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: FrustumCullCheck [-n boxCount] [-i iterations]\n");
+			return 1;
+		}
+	}
+	if (count == 0 || iterations == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	CheckBasic();
+	CheckRandom(count, iterations);
+
+	return Finish();
+}
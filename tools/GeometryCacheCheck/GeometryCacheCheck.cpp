@@ -0,0 +1,399 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// GeometryCacheCheck
+// 加工済みジオメトリのキャッシュファイル(GeometryCacheFile)とディスクキャッシュ(GeometryDiskCache)を検証する
+// Mayaに依存しないのでコマンドラインで実行できる
+// 書き出したファイルが同じ内容で読めること、切り詰めや書き換えで壊れたファイルは読み込みに失敗するか、
+// 成功してもファイル内のアライメントされた範囲のみを指すことを確認する
+// ディスクキャッシュは追い出しの順序(LRU)、再起動後の使用順の引き継ぎ、壊れたファイルやインデックスの扱いを確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src GeometryCacheCheck.cpp ..\..\src\engine\Graphics\GeometryCacheFile.cpp ..\..\src\engine\Graphics\GeometryDiskCache.cpp ..\..\src\engine\Core\MappedFile.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src GeometryCacheCheck.cpp ../../src/engine/Graphics/GeometryCacheFile.cpp ../../src/engine/Graphics/GeometryDiskCache.cpp ../../src/engine/Core/MappedFile.cpp -o GeometryCacheCheck
+//
+// 使い方
+//   GeometryCacheCheck [-d directory] [-i iterations]
+//     -d : 作業ディレクトリ(既定値GeometryCacheCheck.tmp、終了時に削除する)
+//     -i : 壊したファイルを読み込む回数(既定値2000)
+//
+
+#include "engine/Graphics/GeometryCacheFile.h"
+#include "engine/Graphics/GeometryDiskCache.h"
+#include "../Common/Check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace se;
+using namespace tools;
+
+namespace {
+#ifdef _WIN32
+	const char PathSeparator = '\\';
+	void MakeDirectory(const std::string& path) { _mkdir(path.c_str()); }
+	void RemoveDirectory(const std::string& path) { _rmdir(path.c_str()); }
+#else
+	const char PathSeparator = '/';
+	void MakeDirectory(const std::string& path) { mkdir(path.c_str(), 0755); }
+	void RemoveDirectory(const std::string& path) { rmdir(path.c_str()); }
+#endif
+
+	std::vector<uint8_t> ReadFile(const std::string& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		return std::vector<uint8_t>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+	{
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	}
+
+	bool Exists(const std::string& path)
+	{
+		return static_cast<bool>(std::ifstream(path, std::ios::binary));
+	}
+
+	/**
+	 * 書き出す内容(DAGMeshGeometryのStoreDiskCache相当)
+	 */
+	struct SourceMesh
+	{
+		std::vector<uint32_t> indices;
+		std::vector<uint8_t> userData;
+		std::vector<std::vector<float>> streams;
+		GeometryCacheSubMesh desc;
+	};
+
+	std::vector<SourceMesh> MakeMeshes(uint32_t count, std::mt19937& random)
+	{
+		std::vector<SourceMesh> meshes(count);
+		for (uint32_t i = 0; i < count; i++) {
+			SourceMesh& mesh = meshes[i];
+			uint32_t vertexCount = (i == 1) ? 0 : 1 + random() % 300;		// 頂点のないサブメッシュも含める
+			mesh.indices.resize((vertexCount > 0) ? 3 * (random() % 200) : 0);
+			for (uint32_t& index : mesh.indices) index = random() % vertexCount;
+			mesh.userData.resize(random() % 40);
+			for (uint8_t& b : mesh.userData) b = static_cast<uint8_t>(random());
+
+			GeometryCacheSubMesh& desc = mesh.desc;
+			desc.contentHash = (static_cast<uint64_t>(random()) << 32) | random();
+			desc.attributes = random() % 512;
+			desc.vertexCount = vertexCount;
+			desc.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			desc.indexStride = sizeof(uint32_t);
+			desc.flags = random() % 4;
+			for (uint32_t k = 0; k < 3; k++) {
+				desc.boundsMin[k] = -static_cast<float>(random() % 100);
+				desc.boundsMax[k] = static_cast<float>(random() % 100);
+			}
+			desc.indices = mesh.indices.data();
+			desc.userData = mesh.userData.data();
+			desc.userDataSize = static_cast<uint32_t>(mesh.userData.size());
+
+			uint32_t streamCount = (i == 2) ? 0 : 1 + random() % 4;		// ストリームのないサブメッシュも含める
+			mesh.streams.resize(streamCount);
+			desc.streams.resize(streamCount);
+			for (uint32_t s = 0; s < streamCount; s++) {
+				uint32_t components = 1 + random() % 4;
+				mesh.streams[s].resize(static_cast<size_t>(components) * vertexCount);
+				for (float& f : mesh.streams[s]) f = static_cast<float>(random() % 1000) * 0.5f;
+				desc.streams[s].attribute = 1u << s;
+				desc.streams[s].components = components;
+				desc.streams[s].stride = components * sizeof(float);
+				desc.streams[s].flags = random() % 8;
+				desc.streams[s].data = mesh.streams[s].data();
+			}
+		}
+		return meshes;
+	}
+
+	std::vector<GeometryCacheSubMesh> Descs(const std::vector<SourceMesh>& meshes)
+	{
+		std::vector<GeometryCacheSubMesh> descs;
+		for (const SourceMesh& mesh : meshes) descs.push_back(mesh.desc);
+		return descs;
+	}
+
+	bool SameBytes(const void* a, const void* b, size_t size)
+	{
+		return size == 0 || memcmp(a, b, size) == 0;
+	}
+
+	// 読み込んだ内容が書き出したものと一致
+	bool SameContent(const GeometryCacheFile& file, const std::vector<SourceMesh>& meshes)
+	{
+		const auto& subMeshes = file.GetSubMeshes();
+		if (subMeshes.size() != meshes.size()) return false;
+		for (size_t i = 0; i < meshes.size(); i++) {
+			const GeometryCacheSubMesh& actual = subMeshes[i];
+			const GeometryCacheSubMesh& expected = meshes[i].desc;
+			if (actual.contentHash != expected.contentHash || actual.attributes != expected.attributes
+				|| actual.vertexCount != expected.vertexCount || actual.indexCount != expected.indexCount
+				|| actual.indexStride != expected.indexStride || actual.flags != expected.flags
+				|| actual.userDataSize != expected.userDataSize || actual.streams.size() != expected.streams.size()
+				|| memcmp(actual.boundsMin, expected.boundsMin, sizeof(actual.boundsMin)) != 0
+				|| memcmp(actual.boundsMax, expected.boundsMax, sizeof(actual.boundsMax)) != 0
+				|| !SameBytes(actual.indices, expected.indices, sizeof(uint32_t) * expected.indexCount)
+				|| !SameBytes(actual.userData, expected.userData, expected.userDataSize)) return false;
+			for (size_t s = 0; s < expected.streams.size(); s++) {
+				const GeometryCacheStream& a = actual.streams[s];
+				const GeometryCacheStream& e = expected.streams[s];
+				if (a.attribute != e.attribute || a.components != e.components || a.stride != e.stride || a.flags != e.flags
+					|| !SameBytes(a.data, e.data, static_cast<size_t>(e.stride) * expected.vertexCount)) return false;
+			}
+		}
+		return true;
+	}
+
+	// 全てのデータがマップ領域内のアライメントされた範囲を指す
+	bool InsideFile(const GeometryCacheFile& file)
+	{
+		const uint8_t* begin = file.GetData();
+		size_t size = file.GetSize();
+		auto inside = [&](const void* data, uint64_t bytes) {
+			const uint8_t* p = static_cast<const uint8_t*>(data);
+			if (p < begin || static_cast<size_t>(p - begin) > size || bytes > size - static_cast<size_t>(p - begin)) return false;
+			return (static_cast<size_t>(p - begin) % GeometryCacheFile::Alignment) == 0;
+		};
+		for (const GeometryCacheSubMesh& subMesh : file.GetSubMeshes()) {
+			if (!inside(subMesh.indices, static_cast<uint64_t>(subMesh.indexStride) * subMesh.indexCount)) return false;
+			if (!inside(subMesh.userData, subMesh.userDataSize)) return false;
+			for (const GeometryCacheStream& stream : subMesh.streams) {
+				if (!inside(stream.data, static_cast<uint64_t>(stream.stride) * subMesh.vertexCount)) return false;
+			}
+		}
+		return true;
+	}
+
+	// 書き出しと読み込み
+	void CheckFile(const std::string& directory, uint32_t iterations)
+	{
+		std::mt19937 random(1);
+		std::vector<SourceMesh> meshes = MakeMeshes(6, random);
+		std::vector<GeometryCacheSubMesh> descs = Descs(meshes);
+		const std::string path = directory + PathSeparator + "file.sgc";
+		const uint64_t key = 0x0123456789abcdefull;
+
+		uint64_t fileSize = 0;
+		Check(GeometryCacheFile::Write(path.c_str(), key, descs.data(), static_cast<uint32_t>(descs.size()), &fileSize), "write");
+		std::vector<uint8_t> original = ReadFile(path);
+		Check(fileSize == original.size(), "written size");
+
+		GeometryCacheFile file;
+		Check(file.Open(path.c_str(), key) && file.GetKey() == key && file.GetSize() == fileSize, "open");
+		Check(SameContent(file, meshes), "read content differs from the written content");
+		Check(InsideFile(file), "read data is not aligned inside the file");
+		file.Close();
+		Check(file.GetSubMeshes().empty() && file.GetData() == nullptr, "close");
+
+		// キーの不一致、存在しないファイル、ディレクトリ、空のファイル
+		Check(!file.Open(path.c_str(), key + 1) && file.GetSubMeshes().empty(), "open with a different key");
+		Check(!file.Open((directory + PathSeparator + "missing.sgc").c_str(), key), "open a missing file");
+		Check(!file.Open(directory.c_str(), key), "open a directory");
+		const std::string corrupt = directory + PathSeparator + "corrupt.sgc";
+		WriteFile(corrupt, std::vector<uint8_t>());
+		Check(!file.Open(corrupt.c_str(), key), "open an empty file");
+
+		// サブメッシュなし
+		Check(GeometryCacheFile::Write(corrupt.c_str(), key, nullptr, 0), "write without sub meshes");
+		Check(file.Open(corrupt.c_str(), key) && file.GetSubMeshes().empty(), "open without sub meshes");
+		file.Close();
+
+		// 切り詰めたファイル(ヘッダのサイズを合わせたものも含む)
+		bool truncated = true;
+		for (size_t size = 0; size < original.size(); size += 1 + size / 8) {
+			std::vector<uint8_t> data(original.begin(), original.begin() + size);
+			WriteFile(corrupt, data);
+			if (file.Open(corrupt.c_str(), key)) truncated = false;
+			if (size >= 24) {
+				uint64_t patched = size;
+				memcpy(data.data() + 16, &patched, sizeof(patched));
+				WriteFile(corrupt, data);
+				if (file.Open(corrupt.c_str(), key) && !InsideFile(file)) truncated = false;
+			}
+		}
+		Check(truncated, "truncated file was opened or pointed outside the file");
+
+		// ランダムに書き換えたファイル(ヘッダの照合部分は残してレコードの検証まで進める)
+		uint32_t opened = 0;
+		bool inside = true;
+		for (uint32_t n = 0; n < iterations; n++) {
+			std::vector<uint8_t> data = original;
+			uint32_t changes = 1 + random() % 4;
+			for (uint32_t c = 0; c < changes; c++) {
+				size_t limit = (random() % 4 == 0) ? data.size() : (std::min)(data.size(), static_cast<size_t>(1024));
+				size_t offset = random() % limit;
+				if (random() % 2) {
+					data[offset] = static_cast<uint8_t>(random());
+				} else {
+					// 大きな値にして範囲外を指させる
+					data[offset] = 0xff;
+				}
+			}
+			if (random() % 4 != 0) {
+				memcpy(data.data(), original.data(), 24);
+			}
+			WriteFile(corrupt, data);
+			if (file.Open(corrupt.c_str(), key)) {
+				opened++;
+				if (!InsideFile(file)) inside = false;
+				file.Close();
+			}
+		}
+		Check(inside, "corrupted file pointed outside the file");
+		printf("file: %llu bytes, corrupted: %u, opened: %u\n", static_cast<unsigned long long>(fileSize), iterations, opened);
+
+		std::remove(corrupt.c_str());
+		std::remove(path.c_str());
+	}
+
+	// ディスクキャッシュ
+	void CheckDiskCache(const std::string& directory)
+	{
+		std::mt19937 random(2);
+		std::vector<SourceMesh> meshes = MakeMeshes(1, random);
+		meshes[0].streams[0].resize(1000 * 4, 1.0f);
+		meshes[0].desc.vertexCount = 1000;
+		meshes[0].desc.streams[0].components = 4;
+		meshes[0].desc.streams[0].stride = 16;
+		meshes[0].desc.streams[0].data = meshes[0].streams[0].data();
+		meshes[0].desc.indexCount = 0;
+		const GeometryCacheSubMesh& desc = meshes[0].desc;
+
+		const std::string cacheDirectory = directory + PathSeparator + "cache";
+		GeometryDiskCache cache;
+		Check(!cache.IsEnabled() && cache.Find(1) == nullptr && !cache.Store(1, &desc, 1), "disabled cache");
+		Check(cache.Initialize(cacheDirectory.c_str(), 1 << 30) && cache.IsEnabled(), "initialize");
+		cache.Clear();
+
+		// 書き込んだものは同じ内容で見つかる
+		Check(cache.Store(1, &desc, 1) && cache.Store(2, &desc, 1) && cache.Store(3, &desc, 1), "store");
+		auto found = cache.Find(2);
+		Check(found && found->GetKey() == 2 && SameContent(*found, meshes), "find");
+		Check(cache.Find(4) == nullptr, "find a missing key");
+		uint64_t entrySize = cache.GetTotalBytes() / 3;
+		Check(cache.GetEntryCount() == 3 && entrySize >= 16000, "entry size");
+
+		// 置き換え(マップ中のものは置き換えられないことがある)
+		found.reset();
+		Check(cache.Store(2, &desc, 1) && cache.GetEntryCount() == 3 && cache.GetTotalBytes() == entrySize * 3, "replace");
+
+		// 使用順は1 < 3 < 2、容量を減らすと古いものから消える
+		cache.Find(1);
+		cache.Find(3);
+		cache.Find(2);
+		cache.Find(1);		// 3 < 2 < 1
+		cache.SetCapacity(entrySize * 2);
+		Check(cache.GetEntryCount() == 2 && !cache.Find(3) && cache.Find(2) && cache.Find(1), "evict the least recently used");
+
+		// 使用順は再初期化後も引き継ぐ(2 < 1)
+		cache.Finalize();
+		Check(!cache.IsEnabled(), "finalize");
+		Check(cache.Initialize(cacheDirectory.c_str(), entrySize * 2), "initialize again");
+		Check(cache.GetEntryCount() == 2, "entries after initialize");
+		Check(cache.Store(5, &desc, 1) && !cache.Find(2) && cache.Find(1) && cache.Find(5), "use order after initialize");
+
+		// 容量を超えるものは書き込まない
+		cache.SetCapacity(entrySize - 1);
+		Check(cache.GetEntryCount() == 0 && !cache.Store(6, &desc, 1), "store over the capacity");
+		cache.SetCapacity(1 << 30);
+
+		// 壊れたファイルは見つからず削除される
+		Check(cache.Store(7, &desc, 1), "store before corruption");
+		const std::string path7 = cacheDirectory + PathSeparator + "0000000000000007.sgc";
+		std::vector<uint8_t> data = ReadFile(path7);
+		data.resize(data.size() / 2);
+		WriteFile(path7, data);
+		Check(!cache.Find(7) && cache.GetEntryCount() == 0 && !Exists(path7), "corrupted file is removed");
+
+		// キーの異なるファイルを別のキーの名前にしたもの
+		cache.Store(8, &desc, 1);
+		WriteFile(cacheDirectory + PathSeparator + "0000000000000009.sgc", ReadFile(cacheDirectory + PathSeparator + "0000000000000008.sgc"));
+		cache.Finalize();
+
+		// キャッシュ以外のファイル、壊れたインデックス(巨大なレコード数)
+		WriteFile(cacheDirectory + PathSeparator + "note.sgc", std::vector<uint8_t>(8, 0));
+		WriteFile(cacheDirectory + PathSeparator + "0000000000000008.sgc.0000000000000001.tmp", std::vector<uint8_t>(8, 0));
+		const uint32_t badIndex[2] = { 0x31494753, 0xffffffff };
+		std::vector<uint8_t> index(reinterpret_cast<const uint8_t*>(badIndex), reinterpret_cast<const uint8_t*>(badIndex) + sizeof(badIndex));
+		WriteFile(cacheDirectory + PathSeparator + "index.bin", index);
+		Check(cache.Initialize(cacheDirectory.c_str(), 1 << 30), "initialize with a corrupted index");
+		Check(cache.GetEntryCount() == 2, "only cache files are listed");
+		Check(cache.Find(8) && !cache.Find(9) && cache.GetEntryCount() == 1, "file with a different key is removed");
+
+		// 削除できないファイル(マップ中の代わりに同じ名前のディレクトリにする)はサイズを計上したまま残り、見つからない扱いになる
+		Check(cache.Store(10, &desc, 1), "store before a failed delete");
+		const std::string path10 = cacheDirectory + PathSeparator + "000000000000000a.sgc";
+		std::remove(path10.c_str());
+		MakeDirectory(path10);
+		cache.Clear();
+		Check(cache.GetEntryCount() == 1 && cache.GetTotalBytes() == entrySize, "failed delete keeps the accounting");
+		Check(!cache.Find(10), "failed delete is not found");
+		RemoveDirectory(path10);
+		cache.SetCapacity(entrySize - 1);
+		Check(cache.GetEntryCount() == 0 && cache.GetTotalBytes() == 0, "failed delete is retried on eviction");
+		cache.SetCapacity(1 << 30);
+
+		printf("disk cache: entry %llu bytes, lookups: %llu, hits: %llu\n", static_cast<unsigned long long>(entrySize),
+			static_cast<unsigned long long>(cache.GetLookupCount()), static_cast<unsigned long long>(cache.GetHitCount()));
+
+		// 後始末
+		cache.Clear();
+		cache.Finalize();
+		std::remove((cacheDirectory + PathSeparator + "note.sgc").c_str());
+		std::remove((cacheDirectory + PathSeparator + "0000000000000008.sgc.0000000000000001.tmp").c_str());
+		std::remove((cacheDirectory + PathSeparator + "index.bin").c_str());
+		RemoveDirectory(cacheDirectory);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string directory = "GeometryCacheCheck.tmp";
+	uint32_t iterations = 2000;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			directory = argv[++i];
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: GeometryCacheCheck [-d directory] [-i iterations]\n");
+			return 1;
+		}
+	}
+
+	// 作業ディレクトリはディスクキャッシュの作成処理で作る
+	{
+		GeometryDiskCache cache;
+		if (!cache.Initialize(directory.c_str(), 0)) {
+			printf("failed to create %s\n", directory.c_str());
+			return 1;
+		}
+		cache.Finalize();
+		std::remove((directory + PathSeparator + "index.bin").c_str());
+	}
+
+	CheckFile(directory, iterations);
+	CheckDiskCache(directory);
+	RemoveDirectory(directory);
+
+	return Finish();
+}
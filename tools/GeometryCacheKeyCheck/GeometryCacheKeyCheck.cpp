@@ -0,0 +1,216 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// GeometryCacheKeyCheck
+// ディスクキャッシュのキー(GeometryCacheKey)がセッションをまたいで同じになることを検証する
+// Mayaに依存しないのでコマンドラインで実行できる
+// DAGMeshと同じ順序で組み立てたキーを固定値と比較し(前回の実行と同じキー)、
+// 同じ内容を別のアドレスに置いても同じキーになること、内容やシェーダ名が変わるとキーが変わることを確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src GeometryCacheKeyCheck.cpp ..\..\src\engine\Core\Hash.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src GeometryCacheKeyCheck.cpp ../../src/engine/Core/Hash.cpp -o GeometryCacheKeyCheck
+//
+// 使い方
+//   GeometryCacheKeyCheck [-p]
+//     -p : 組み立てたキーを表示する(固定値を更新する時に使う)
+//
+
+#include "engine/Graphics/GeometryCacheKey.h"
+#include "../Common/Check.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	// 抽出元のメッシュの代わり
+	struct SourceMesh
+	{
+		std::vector<int> counts;
+		std::vector<int> vertexIds;
+		std::vector<int> normalIds;
+		std::vector<float> points;
+		std::vector<float> normals;
+		std::vector<float> u, v;
+		std::vector<int> uvIds;
+		std::vector<int32_t> polygons;
+		std::string uvSet;
+		std::string shader;
+		uint32_t attributes;
+		uint32_t flags;
+	};
+
+	SourceMesh MakeCube()
+	{
+		SourceMesh mesh;
+		mesh.counts = { 4, 4, 4, 4, 4, 4 };
+		mesh.vertexIds = { 0, 1, 3, 2, 2, 3, 5, 4, 4, 5, 7, 6, 6, 7, 1, 0, 1, 7, 5, 3, 6, 0, 2, 4 };
+		mesh.normalIds = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 };
+		for (int i = 0; i < 8; i++) {
+			mesh.points.push_back((i & 1) ? 0.5f : -0.5f);
+			mesh.points.push_back((i & 2) ? 0.5f : -0.5f);
+			mesh.points.push_back((i & 4) ? 0.5f : -0.5f);
+		}
+		for (int i = 0; i < 24; i++) {
+			int axis = (i / 4) % 3;
+			float sign = (i < 12) ? 1.0f : -1.0f;
+			for (int j = 0; j < 3; j++) mesh.normals.push_back((j == axis) ? sign : 0.0f);
+		}
+		for (int i = 0; i < 14; i++) {
+			mesh.u.push_back(static_cast<float>(i % 2));
+			mesh.v.push_back(static_cast<float>(i / 2) * 0.25f);
+		}
+		mesh.uvIds = { 0, 1, 3, 2, 2, 3, 5, 4, 4, 5, 7, 6, 6, 7, 9, 8, 1, 10, 11, 3, 12, 0, 2, 13 };
+		mesh.polygons = { 0, 1, 2, 3, 4, 5 };
+		mesh.uvSet = "map1";
+		mesh.shader = "Standard";
+		mesh.attributes = 0x13;
+		mesh.flags = 1 | 2;
+		return mesh;
+	}
+
+	// 同じ内容を別のアドレスに置き直す(前後にずらした領域にコピーする)
+	template <class T>
+	void Relocate(std::vector<T>& values, std::vector<std::unique_ptr<std::vector<T>>>& keep)
+	{
+		keep.emplace_back(new std::vector<T>(values.size() + 17));
+		std::vector<T> moved(values.begin(), values.end());
+		values.swap(moved);
+	}
+
+	// DAGMeshのHashMeshTopology、HashSubMeshSource、HashMeshShapeと同じ順序で組み立てる
+	uint64_t BuildDiskCacheKey(const SourceMesh& mesh)
+	{
+		const uint64_t version = 1;
+		GeometryCacheKey topology(Hash64(&version, sizeof(version)));
+		topology.Add(mesh.counts.data(), sizeof(int) * mesh.counts.size());
+		topology.Add(mesh.vertexIds.data(), sizeof(int) * mesh.vertexIds.size());
+		topology.Add(mesh.counts.data(), sizeof(int) * mesh.counts.size());
+		topology.Add(mesh.normalIds.data(), sizeof(int) * mesh.normalIds.size());
+		uint64_t layoutHash = HashCombine(topology.Get(), 0u);
+
+		GeometryCacheKey source(layoutHash);
+		source.Add(mesh.attributes);
+		source.Add(mesh.shader);
+		source.Add(mesh.flags);
+		source.Add(mesh.polygons.data(), sizeof(int32_t) * mesh.polygons.size());
+		source.Add(mesh.uvSet);
+		source.Add(mesh.u.data(), sizeof(float) * mesh.u.size());
+		source.Add(mesh.v.data(), sizeof(float) * mesh.v.size());
+		source.Add(mesh.counts.data(), sizeof(int) * mesh.counts.size());
+		source.Add(mesh.uvIds.data(), sizeof(int) * mesh.uvIds.size());
+
+		GeometryCacheKey shape;
+		shape.Add(mesh.points.data(), sizeof(float) * mesh.points.size());
+		shape.Add(mesh.normals.data(), sizeof(float) * mesh.normals.size());
+
+		GeometryCacheKey key(source.Get());
+		key.Add(shape.Get());
+		return key.GetDiskCacheKey();
+	}
+
+	// 前回の実行で得たキー(組み立てを変えたらDAGMeshのDiskCacheVersionとあわせて更新する)
+	const uint64_t CubeKey = 0xECCA56EE584619B6ull;
+
+	void CheckStable(bool print)
+	{
+		SourceMesh mesh = MakeCube();
+		uint64_t key = BuildDiskCacheKey(mesh);
+		if (print) {
+			printf("cube key : 0x%016llX\n", static_cast<unsigned long long>(key));
+		}
+		Check(key == CubeKey, "key differs from previous runs");
+
+		// 空の入力はxxHash64の既定値
+		GeometryCacheKey empty;
+		empty.Add(nullptr, 0);
+		Check(empty.Get() == HashCombine(0, 0xEF46DB3751D8E999ull), "empty input hash");
+
+		// 0はキャッシュを使わない印なので避ける
+		Check(GeometryCacheKey().GetDiskCacheKey() == 1, "zero key is remapped");
+	}
+
+	void CheckAddressIndependent()
+	{
+		SourceMesh mesh = MakeCube();
+		uint64_t expected = BuildDiskCacheKey(mesh);
+
+		std::vector<std::unique_ptr<std::vector<int>>> keepInts;
+		std::vector<std::unique_ptr<std::vector<float>>> keepFloats;
+		for (int i = 0; i < 8; i++) {
+			Relocate(mesh.counts, keepInts);
+			Relocate(mesh.vertexIds, keepInts);
+			Relocate(mesh.normalIds, keepInts);
+			Relocate(mesh.uvIds, keepInts);
+			Relocate(mesh.polygons, keepInts);
+			Relocate(mesh.points, keepFloats);
+			Relocate(mesh.normals, keepFloats);
+			Relocate(mesh.u, keepFloats);
+			Relocate(mesh.v, keepFloats);
+			mesh.shader = std::string(mesh.shader.c_str());
+			Check(BuildDiskCacheKey(mesh) == expected, "key depends on buffer addresses");
+		}
+	}
+
+	void CheckSensitive()
+	{
+		const SourceMesh base = MakeCube();
+		uint64_t baseKey = BuildDiskCacheKey(base);
+
+		SourceMesh mesh = base;
+		mesh.shader = "Unlit";
+		Check(BuildDiskCacheKey(mesh) != baseKey, "shader name changes key");
+
+		mesh = base;
+		mesh.flags ^= 4;
+		Check(BuildDiskCacheKey(mesh) != baseKey, "settings change key");
+
+		mesh = base;
+		mesh.polygons.pop_back();
+		Check(BuildDiskCacheKey(mesh) != baseKey, "polygon list changes key");
+
+		mesh = base;
+		mesh.u[3] += 0.125f;
+		Check(BuildDiskCacheKey(mesh) != baseKey, "uv changes key");
+
+		mesh = base;
+		mesh.uvSet = "map2";
+		Check(BuildDiskCacheKey(mesh) != baseKey, "uv set name changes key");
+
+		mesh = base;
+		mesh.points[5] += 0.25f;
+		Check(BuildDiskCacheKey(mesh) != baseKey, "point changes key");
+
+		mesh = base;
+		std::swap(mesh.vertexIds[0], mesh.vertexIds[1]);
+		Check(BuildDiskCacheKey(mesh) != baseKey, "topology changes key");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool print = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0) {
+			print = true;
+		} else {
+			printf("usage: GeometryCacheKeyCheck [-p]\n");
+			return 1;
+		}
+	}
+
+	CheckStable(print);
+	CheckAddressIndependent();
+	CheckSensitive();
+
+	return Finish();
+}
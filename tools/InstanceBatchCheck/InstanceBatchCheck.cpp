@@ -0,0 +1,279 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// InstanceBatchCheck
+// DAGMeshのインスタンス描画の組み立て(InstanceBatch)と共有のオブジェクトパラメータ(ObjectParameterTable)を検証する
+// Mayaに依存しないのでコマンドラインで実行できる
+// DAGMesh::Update、BuildInstances、DAGManager::UploadObjectParametersと同じ手順でフレームを繰り返し、
+// GPUバッファの代わりの配列に転送した内容が、毎フレーム描画するインスタンスとそのパラメータに一致することを確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src InstanceBatchCheck.cpp ..\..\src\engine\Graphics\InstanceBatch.cpp ..\..\src\engine\Graphics\ObjectParameterTable.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src InstanceBatchCheck.cpp ../../src/engine/Graphics/InstanceBatch.cpp ../../src/engine/Graphics/ObjectParameterTable.cpp -o InstanceBatchCheck
+//
+// 使い方
+//   InstanceBatchCheck [-n instanceCount] [-f frames]
+//     -n : インスタンス数(既定値1000)
+//     -f : フレーム数(既定値2000)
+//
+
+#include "engine/Graphics/InstanceBatch.h"
+#include "engine/Graphics/ObjectParameterTable.h"
+#include "../Common/Check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	const uint32_t MergeGap = 16;
+
+	/**
+	 * インスタンス(DAGMeshのTransformData相当)
+	 */
+	struct Instance
+	{
+		uint32_t objectIndex;
+		bool visible;
+		bool inFrustum;
+		bool updated;
+		float position;		// ワールドマトリクスの代わり
+	};
+
+	/**
+	 * GPUバッファの代わり
+	 */
+	struct DeviceBuffers
+	{
+		std::vector<uint32_t> instanceBuffer;		// 描画するインスタンスの番号(DAGMeshのinstanceBuffer)
+		uint32_t instanceCount;
+		std::vector<ObjectParameterData> objectBuffer;	// 共有のオブジェクトパラメータ(DAGManagerのobjectBuffer_)
+		uint32_t instanceUploads;
+
+		DeviceBuffers() : instanceCount(0), instanceUploads(0) {}
+	};
+
+	ObjectParameterData MakeObject(float position)
+	{
+		ObjectParameterData data;
+		data.localToWorld = Matrix44::TranslationMatrix(Vector3(position, 0.0f, 0.0f));
+		return data;
+	}
+
+	// DAGManager::UploadObjectParametersと同じ手順
+	void UploadObjects(ObjectParameterTable& table, DeviceBuffers& device)
+	{
+		uint32_t capacity = table.GetCapacity();
+		if (capacity == 0) return;
+		if (device.objectBuffer.size() < capacity) {
+			device.objectBuffer.assign(Max<size_t>(capacity, device.objectBuffer.size() * 2), MakeObject(0.0f));
+			table.MarkAllDirty();
+		}
+		for (const auto& range : table.CollectDirtyRanges(MergeGap)) {
+			memcpy(&device.objectBuffer[range.first], table.GetData() + range.first, sizeof(ObjectParameterData) * range.count);
+		}
+	}
+
+	// DAGMesh::BuildInstancesと同じ手順(描画するインスタンスがなければfalse)
+	bool BuildInstances(InstanceBatch& batch, const std::vector<Instance>& instances, DeviceBuffers& device)
+	{
+		batch.Begin();
+		for (const Instance& instance : instances) {
+			if (instance.visible && instance.inFrustum) {
+				batch.Add(instance.objectIndex);
+			}
+		}
+		if (batch.Count() == 0) return false;
+
+		if (batch.End()) {
+			if (device.instanceBuffer.size() < batch.Count()) {
+				device.instanceBuffer.resize(Max<size_t>(batch.Count(), device.instanceBuffer.size() * 2));
+			}
+			memcpy(device.instanceBuffer.data(), batch.Data(), sizeof(uint32_t) * batch.Count());
+			device.instanceUploads++;
+		}
+		device.instanceCount = batch.Count();
+		return true;
+	}
+
+	// 決まった手順での確認
+	void CheckBasic()
+	{
+		InstanceBatch batch;
+		batch.Begin();
+		Check(!batch.End() && batch.Count() == 0, "empty batch");
+
+		batch.Begin();
+		batch.Add(3);
+		batch.Add(5);
+		Check(batch.End() && batch.Count() == 2 && batch.Data()[1] == 5, "first batch");
+
+		// 同じ並びなら転送不要
+		batch.Begin();
+		batch.Add(3);
+		batch.Add(5);
+		Check(!batch.End(), "same batch");
+
+		// 数、順序、番号の変更
+		batch.Begin();
+		batch.Add(5);
+		batch.Add(3);
+		Check(batch.End(), "reordered batch");
+		batch.Begin();
+		batch.Add(5);
+		Check(batch.End(), "smaller batch");
+
+		batch.Clear();
+		batch.Begin();
+		batch.Add(5);
+		Check(batch.End(), "batch after clear");
+
+		// 番号の再利用と更新範囲
+		ObjectParameterTable table;
+		uint32_t a = table.Allocate();
+		uint32_t b = table.Allocate();
+		uint32_t c = table.Allocate();
+		table.Free(b);
+		Check(table.Allocate() == b && table.GetCount() == 3, "reuse freed index");
+		table.CollectDirtyRanges(MergeGap);
+		Check(table.CollectDirtyRanges(MergeGap).empty(), "no dirty range");
+		table.Set(a, MakeObject(1.0f));
+		table.Set(c, MakeObject(2.0f));
+		const auto& merged = table.CollectDirtyRanges(MergeGap);
+		Check(merged.size() == 1 && merged[0].first == a && merged[0].count == 3, "merged range");
+		table.Set(a, MakeObject(1.0f));
+		table.Set(c, MakeObject(2.0f));
+		const auto& split = table.CollectDirtyRanges(0);
+		Check(split.size() == 2 && split[1].first == c && split[1].count == 1, "split ranges");
+	}
+
+	// ランダムなフレームの繰り返し
+	void CheckRandom(uint32_t count, uint32_t frames)
+	{
+		std::mt19937 random(1);
+		ObjectParameterTable table;
+		InstanceBatch batch;
+		DeviceBuffers device;
+		std::vector<Instance> instances;
+
+		bool drawn = true;
+		bool parameters = true;
+		uint32_t transformOnlyFrames = 0;
+		uint32_t transformOnlyUploads = 0;
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			uint32_t before = device.instanceUploads;
+
+			// インスタンスの追加、削除(LinkParent、UnlinkParent)はまれ
+			bool layoutChanged = false;
+			if (instances.size() < count || random() % 50 == 0) {
+				Instance instance;
+				instance.objectIndex = table.Allocate();
+				instance.visible = true;
+				instance.inFrustum = true;
+				instance.updated = true;
+				instance.position = static_cast<float>(random() % 1000);
+				instances.push_back(instance);
+				layoutChanged = true;
+			}
+			if (instances.size() > 1 && random() % 60 == 0) {
+				size_t index = random() % instances.size();
+				table.Free(instances[index].objectIndex);
+				instances.erase(instances.begin() + index);
+				layoutChanged = true;
+			}
+
+			// 可視性、カリング結果の変化はときどき、トランスフォームの更新は毎フレーム
+			bool visibilityChanged = false;
+			if (random() % 10 == 0) {
+				Instance& instance = instances[random() % instances.size()];
+				if (random() % 2) {
+					instance.visible = !instance.visible;
+				} else {
+					instance.inFrustum = !instance.inFrustum;
+				}
+				visibilityChanged = true;
+			}
+			for (uint32_t n = 0; n < 8; n++) {
+				Instance& instance = instances[random() % instances.size()];
+				instance.position += 1.0f;
+				instance.updated = true;
+			}
+
+			// DAGMesh::Update(表示中のインスタンスのみパラメータを書き込む)
+			for (Instance& instance : instances) {
+				if (!instance.visible || !instance.updated) continue;
+				table.Set(instance.objectIndex, MakeObject(instance.position));
+				instance.updated = false;
+			}
+
+			// 描画
+			UploadObjects(table, device);
+			bool hasInstances = BuildInstances(batch, instances, device);
+
+			// 転送済みの番号、パラメータが描画するインスタンスと一致
+			std::vector<const Instance*> expected;
+			for (const Instance& instance : instances) {
+				if (instance.visible && instance.inFrustum) expected.push_back(&instance);
+			}
+			if (hasInstances != !expected.empty()) drawn = false;
+			if (hasInstances) {
+				if (device.instanceCount != expected.size()) drawn = false;
+				for (uint32_t i = 0; i < device.instanceCount && i < expected.size(); i++) {
+					uint32_t objectIndex = device.instanceBuffer[i];
+					if (objectIndex != expected[i]->objectIndex) drawn = false;
+					if (device.objectBuffer[objectIndex].localToWorld._41 != expected[i]->position) parameters = false;
+				}
+			}
+
+			// トランスフォームのみの更新では番号を転送しない
+			if (!layoutChanged && !visibilityChanged) {
+				transformOnlyFrames++;
+				transformOnlyUploads += device.instanceUploads - before;
+			}
+		}
+		Check(drawn, "uploaded instances differ from the visible instances");
+		Check(parameters, "uploaded parameters differ from the instance transforms");
+		Check(transformOnlyUploads == 0, "instance indices were uploaded on a transform-only frame");
+
+		const ObjectParameterTable::Stats& stats = table.GetStats();
+		printf("instance: %u, frame: %u\n", static_cast<uint32_t>(instances.size()), frames);
+		printf("  index uploads      : %u (%u transform-only frames)\n", device.instanceUploads, transformOnlyFrames);
+		printf("  parameter updates  : %llu, upload ranges: %llu, uploaded objects: %llu\n",
+			static_cast<unsigned long long>(stats.updates), static_cast<unsigned long long>(stats.uploadRanges),
+			static_cast<unsigned long long>(stats.uploadObjects));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = 1000;
+	uint32_t frames = 2000;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			frames = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: InstanceBatchCheck [-n instanceCount] [-f frames]\n");
+			return 1;
+		}
+	}
+	if (count == 0 || frames == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	CheckBasic();
+	CheckRandom(count, frames);
+
+	return Finish();
+}
@@ -0,0 +1,126 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// MeshCacheStats
+// 書き出したメッシュ(OBJ)に対してインデックス最適化前後の頂点キャッシュ効率(ACMR/ATVR)を表示する
+// Mayaに依存しないのでコマンドラインで実行できる
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src MeshCacheStats.cpp ..\..\src\engine\Graphics\MeshOptimizer.cpp ..\..\src\engine\Core\Hash.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src MeshCacheStats.cpp ../../src/engine/Graphics/MeshOptimizer.cpp ../../src/engine/Core/Hash.cpp -o MeshCacheStats
+//
+// 使い方
+//   MeshCacheStats [-c cacheSize] [-o] file.obj ...
+//     -c : キャッシュサイズ(既定値16)
+//     -o : オーバードロー最適化も行う
+//
+
+#include "engine/Graphics/MeshOptimizer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	struct ObjMesh
+	{
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// 頂点位置と面だけを読み込む(多角形は扇状に三角形化、UV、法線の分割は考慮しない)
+	bool LoadObj(const char* fileName, ObjMesh* mesh)
+	{
+		std::ifstream stream(fileName);
+		if (!stream) return false;
+
+		std::string line;
+		std::vector<uint32_t> face;
+		while (std::getline(stream, line)) {
+			std::istringstream tokens(line);
+			std::string type;
+			tokens >> type;
+			if (type == "v") {
+				float x = 0.0f, y = 0.0f, z = 0.0f;
+				tokens >> x >> y >> z;
+				mesh->positions.push_back(x);
+				mesh->positions.push_back(y);
+				mesh->positions.push_back(z);
+			} else if (type == "f") {
+				face.clear();
+				std::string vertex;
+				while (tokens >> vertex) {
+					long index = strtol(vertex.c_str(), nullptr, 10);
+					uint32_t count = static_cast<uint32_t>(mesh->positions.size() / 3);
+					face.push_back(static_cast<uint32_t>((index < 0) ? count + index : index - 1));
+				}
+				for (size_t i = 2; i < face.size(); i++) {
+					mesh->indices.push_back(face[0]);
+					mesh->indices.push_back(face[i - 1]);
+					mesh->indices.push_back(face[i]);
+				}
+			}
+		}
+		return true;
+	}
+
+	void PrintStats(const char* label, const ObjMesh& mesh, uint32_t cacheSize)
+	{
+		uint32_t vertexCount = static_cast<uint32_t>(mesh.positions.size() / 3);
+		se::VertexCacheStats stats = se::MeshOptimizer::AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount, cacheSize);
+		printf("  %-10s ACMR: %.3f  ATVR: %.3f\n", label, stats.acmr, stats.atvr);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t cacheSize = se::MeshOptimizer::DefaultCacheSize;
+	bool overdraw = false;
+	int fileCount = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			cacheSize = static_cast<uint32_t>(atoi(argv[++i]));
+			continue;
+		}
+		if (strcmp(argv[i], "-o") == 0) {
+			overdraw = true;
+			continue;
+		}
+
+		ObjMesh mesh;
+		if (!LoadObj(argv[i], &mesh)) {
+			fprintf(stderr, "Failed to load %s\n", argv[i]);
+			continue;
+		}
+		fileCount++;
+
+		uint32_t vertexCount = static_cast<uint32_t>(mesh.positions.size() / 3);
+		printf("%s (vertex: %u, triangle: %u, cache: %u)\n", argv[i], vertexCount, static_cast<uint32_t>(mesh.indices.size() / 3), cacheSize);
+		PrintStats("original", mesh, cacheSize);
+
+		// DAGMeshのジオメトリ加工と同じ順番で最適化
+		std::vector<uint32_t> clusters;
+		se::MeshOptimizer::OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount, cacheSize, &clusters);
+		PrintStats("cache", mesh, cacheSize);
+
+		if (overdraw) {
+			se::MeshOptimizer::OptimizeOverdraw(mesh.indices.data(), mesh.indices.size(), clusters, mesh.positions.data(), 3, vertexCount, cacheSize);
+			PrintStats("overdraw", mesh, cacheSize);
+			printf("  clusters: %u\n", static_cast<uint32_t>(clusters.size()));
+		}
+	}
+
+	if (fileCount == 0) {
+		printf("usage: MeshCacheStats [-c cacheSize] [-o] file.obj ...\n");
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
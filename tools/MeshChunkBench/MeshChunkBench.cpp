@@ -0,0 +1,197 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// MeshChunkBench
+// MeshClusterizerによるチャンク分割の検証と、チャンク単位の背面カリングで省ける三角形の割合を計測する
+// 分割の時間、チャンクの頂点数の上限、全三角形が1回ずつ含まれること、法線コーンの判定が保守的であることを確認する
+// Mayaに依存しないのでコマンドラインで実行できる
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src MeshChunkBench.cpp ..\..\src\engine\Graphics\MeshClusterizer.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src MeshChunkBench.cpp ../../src/engine/Graphics/MeshClusterizer.cpp -o MeshChunkBench
+//
+// 使い方
+//   MeshChunkBench [-s segments] [-v views]
+//     -s : 球の経度方向の分割数(緯度方向はその半分、既定値2048で約400万三角形)
+//     -v : 背面カリングを計測する視点の数(既定値16)
+//
+
+#include "engine/Graphics/MeshClusterizer.h"
+#include "../Common/Check.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	const float Pi = 3.14159265358979f;
+
+	// 外向きが反時計回りになるUV球(極は縮退三角形を含む)
+	void BuildSphere(uint32_t segments, std::vector<float>* positions, std::vector<uint32_t>* indices)
+	{
+		uint32_t rings = segments / 2;
+		for (uint32_t r = 0; r <= rings; r++) {
+			float theta = Pi * r / rings;
+			for (uint32_t s = 0; s <= segments; s++) {
+				float phi = 2.0f * Pi * s / segments;
+				positions->push_back(sinf(theta) * cosf(phi));
+				positions->push_back(cosf(theta));
+				positions->push_back(-sinf(theta) * sinf(phi));
+			}
+		}
+		for (uint32_t r = 0; r < rings; r++) {
+			for (uint32_t s = 0; s < segments; s++) {
+				uint32_t a = r * (segments + 1) + s;
+				uint32_t b = a + segments + 1;
+				uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+				indices->insert(indices->end(), quad, quad + 6);
+			}
+		}
+	}
+
+	// 視点から見て三角形が裏を向いているか(面積のない三角形は裏とみなす)
+	bool IsTriangleBackfacing(const float* positions, const uint32_t* triangle, const float* eye)
+	{
+		const float* a = positions + triangle[0] * 3;
+		const float* b = positions + triangle[1] * 3;
+		const float* c = positions + triangle[2] * 3;
+		float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float n[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+		return (a[0] - eye[0]) * n[0] + (a[1] - eye[1]) * n[1] + (a[2] - eye[2]) * n[2] >= 0.0f;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t segments = 2048;
+	uint32_t views = 16;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			segments = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+			views = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: MeshChunkBench [-s segments] [-v views]\n");
+			return 1;
+		}
+	}
+	if (segments < 4 || views == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	BuildSphere(segments, &positions, &indices);
+	uint32_t vertexCount = static_cast<uint32_t>(positions.size() / 3);
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	printf("vertex: %u, triangle: %u\n", vertexCount, triangleCount);
+
+	std::vector<uint32_t> triangles;
+	std::vector<se::MeshChunk> chunks;
+	auto start = std::chrono::high_resolution_clock::now();
+	se::MeshClusterizer::Build(indices.data(), indices.size(), positions.data(), 3, vertexCount, &triangles, &chunks);
+	double buildMs = ElapsedMs(start);
+
+	// 全三角形が1回ずつ含まれ、チャンクの頂点数とバウンディングが正しいか
+	bool valid = triangles.size() == triangleCount;
+	std::vector<uint8_t> used(triangleCount, 0);
+	std::vector<uint32_t> stamp(vertexCount, ~0u);
+	uint32_t offset = 0;
+	uint32_t meshlets = 0;
+	for (uint32_t c = 0; valid && c < chunks.size(); c++) {
+		const se::MeshChunk& chunk = chunks[c];
+		valid = chunk.triangleOffset == offset && chunk.vertexCount <= se::MeshClusterizer::DefaultChunkVertices;
+		uint32_t chunkVertices = 0;
+		for (uint32_t t = chunk.triangleOffset; valid && t < chunk.triangleOffset + chunk.triangleCount; t++) {
+			uint32_t triangle = triangles[t];
+			valid = triangle < triangleCount && !used[triangle];
+			used[triangle] = 1;
+			for (int32_t k = 0; valid && k < 3; k++) {
+				uint32_t v = indices[triangle * 3 + k];
+				if (stamp[v] != c) {
+					stamp[v] = c;
+					chunkVertices++;
+				}
+				for (int32_t i = 0; i < 3; i++) {
+					float p = positions[v * 3 + i];
+					valid = valid && p >= chunk.boundsMin[i] && p <= chunk.boundsMax[i];
+				}
+			}
+		}
+		valid = valid && chunkVertices == chunk.vertexCount;
+		offset += chunk.triangleCount;
+		meshlets += chunk.meshletCount;
+	}
+	valid = valid && offset == triangleCount;
+	if (!valid) {
+		printf("FAILED: chunks do not partition the triangles within the vertex limit\n");
+		return 1;
+	}
+	printf("  build   : %8.3f ms / chunk: %u / meshlet: %u\n", buildMs, static_cast<uint32_t>(chunks.size()), meshlets);
+
+	// 球の外側の視点から、背面と判定したチャンクの三角形が全て裏を向いているか
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	uint64_t backfacing = 0;
+	uint64_t culled = 0;
+	for (uint32_t v = 0; v < views; v++) {
+		float eye[3] = { unit(random), unit(random), unit(random) };
+		float length = sqrtf(eye[0] * eye[0] + eye[1] * eye[1] + eye[2] * eye[2]);
+		float distance = 1.5f + 3.0f * (unit(random) * 0.5f + 0.5f);
+		for (int32_t i = 0; i < 3; i++) {
+			eye[i] *= distance / (length > 0.0f ? length : 1.0f);
+		}
+
+		for (const se::MeshChunk& chunk : chunks) {
+			bool chunkCulled = se::MeshClusterizer::IsBackfacing(chunk.cone, eye);
+			for (uint32_t t = chunk.triangleOffset; t < chunk.triangleOffset + chunk.triangleCount; t++) {
+				bool back = IsTriangleBackfacing(positions.data(), &indices[triangles[t] * 3], eye);
+				if (chunkCulled && !back) {
+					printf("FAILED: a front-facing triangle was culled by its chunk cone\n");
+					return 1;
+				}
+				backfacing += back ? 1 : 0;
+				culled += chunkCulled ? 1 : 0;
+			}
+		}
+	}
+
+	// 回転と一様スケールで変換したコーンも同じ判定になるか(視点は原点からの変換後の位置)
+	const float c = cosf(0.5f), s = sinf(0.5f);
+	const float matrix[16] = {
+		2.0f * c, 0.0f, -2.0f * s, 0.0f,
+		0.0f, 2.0f, 0.0f, 0.0f,
+		2.0f * s, 0.0f, 2.0f * c, 0.0f,
+		1.0f, 2.0f, 3.0f, 1.0f,
+	};
+	const float localEye[3] = { 3.0f, 0.5f, -1.0f };
+	float worldEye[3];
+	for (int32_t i = 0; i < 3; i++) {
+		worldEye[i] = localEye[0] * matrix[i] + localEye[1] * matrix[4 + i] + localEye[2] * matrix[8 + i] + matrix[12 + i];
+	}
+	for (const se::MeshChunk& chunk : chunks) {
+		se::NormalCone world = se::MeshClusterizer::TransformCone(chunk.cone, matrix);
+		if (se::MeshClusterizer::IsConeValid(chunk.cone) != se::MeshClusterizer::IsConeValid(world)
+			|| se::MeshClusterizer::IsBackfacing(chunk.cone, localEye) != se::MeshClusterizer::IsBackfacing(world, worldEye)) {
+			printf("FAILED: transformed cone disagrees with the local cone\n");
+			return 1;
+		}
+	}
+
+	uint64_t total = static_cast<uint64_t>(triangleCount) * views;
+	printf("  backface: %5.1f%% of triangles face away / %5.1f%% culled by chunk cones\n",
+		100.0 * backfacing / total, 100.0 * culled / total);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,337 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// ParallelSubmitCheck
+// ParallelSubmitの分割と並列記録を検証する(D3Dに依存しないのでコマンドラインで実行できる)
+// D3D11の遅延コンテキストの代わりに、記録したパケット番号を保持するだけの記録先を使い、
+// 分割が連続して均等であること、同じコンテキストに同時に記録しないこと、実行後の描画順が分割しない場合と同じであることを確認する
+// また、ワーカーがバックグラウンドのタスクで塞がっていてもParallelForが呼び出しスレッドだけで完了し、
+// 呼び出しスレッドがバックグラウンドのタスクを実行しないことを確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src ParallelSubmitCheck.cpp ..\..\src\engine\Graphics\ParallelSubmit.cpp ..\..\src\engine\Core\ThreadPool.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -pthread -I../../src ParallelSubmitCheck.cpp ../../src/engine/Graphics/ParallelSubmit.cpp ../../src/engine/Core/ThreadPool.cpp -o ParallelSubmitCheck
+//
+// 使い方
+//   ParallelSubmitCheck [-i iterations] [-t threadCount]
+//     -i : ランダムなパケット数、コンテキスト数で記録する回数(既定値2000)
+//     -t : ワーカースレッド数(既定値は論理コア数 - 1)
+//
+
+#include "engine/Graphics/ParallelSubmit.h"
+#include "engine/Core/ThreadPool.h"
+#include "../Common/Check.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	/**
+	 * パケット番号を記録するだけの記録先
+	 * 実行時に記録した番号を描画順に並べ、直接描画した番号も同じ列に加える
+	 */
+	class RecordingDevice : public se::CommandListDevice
+	{
+	private:
+		uint32_t contextCount_;
+		std::vector<std::vector<uint32_t>> commandLists_;
+		std::unique_ptr<std::atomic<uint32_t>[]> recording_;	// コンテキスト毎の記録中の数
+		std::atomic<uint32_t> recordCount_;
+		uint32_t nextExecute_;
+		bool inFrame_;
+
+	public:
+		std::vector<uint32_t> drawn;		// 描画されたパケット番号(描画順)
+		uint32_t beginCount;
+		uint32_t directCount;
+		std::atomic<bool> conflict;		// 同じコンテキストに同時に記録した(ワーカースレッドから書き込む)
+		bool outOfOrder;	// 記録順に実行されなかった、フレーム外で呼ばれた
+
+	public:
+		explicit RecordingDevice(uint32_t contextCount)
+			: contextCount_(contextCount)
+			, commandLists_(contextCount)
+			, recording_(new std::atomic<uint32_t>[contextCount > 0 ? contextCount : 1])
+			, recordCount_(0)
+			, nextExecute_(0)
+			, inFrame_(false)
+			, beginCount(0)
+			, directCount(0)
+			, conflict(false)
+			, outOfOrder(false)
+		{
+			for (uint32_t i = 0; i < contextCount; i++) {
+				recording_[i] = 0;
+			}
+		}
+
+		virtual uint32_t GetContextCount() const override { return contextCount_; }
+
+		virtual void Begin(uint32_t chunkCount) override
+		{
+			if (inFrame_ || chunkCount > contextCount_) outOfOrder = true;
+			inFrame_ = true;
+			nextExecute_ = 0;
+			beginCount++;
+		}
+
+		virtual void End() override
+		{
+			if (!inFrame_) outOfOrder = true;
+			inFrame_ = false;
+		}
+
+		virtual void Record(uint32_t contextIndex, uint32_t begin, uint32_t end) override
+		{
+			if (contextIndex >= contextCount_) {
+				conflict = true;
+				return;
+			}
+			if (recording_[contextIndex].fetch_add(1) != 0) conflict = true;
+
+			// 描画パケットの処理の代わりに少し計算する
+			auto& list = commandLists_[contextIndex];
+			list.clear();
+			volatile uint32_t work = 0;
+			for (uint32_t i = begin; i < end; i++) {
+				for (uint32_t k = 0; k < 64; k++) work = work * 31 + i;
+				list.push_back(i);
+			}
+			recordCount_++;
+			recording_[contextIndex].fetch_sub(1);
+		}
+
+		virtual void Execute(uint32_t contextIndex) override
+		{
+			if (!inFrame_ || contextIndex != nextExecute_++) outOfOrder = true;
+			if (contextIndex >= contextCount_) return;
+			drawn.insert(drawn.end(), commandLists_[contextIndex].begin(), commandLists_[contextIndex].end());
+			commandLists_[contextIndex].clear();
+		}
+
+		virtual void SubmitDirect(uint32_t begin, uint32_t end) override
+		{
+			if (inFrame_) outOfOrder = true;
+			for (uint32_t i = begin; i < end; i++) {
+				drawn.push_back(i);
+			}
+			directCount++;
+		}
+
+		uint32_t GetRecordCount() const { return recordCount_.load(); }
+	};
+
+	bool IsSequential(const std::vector<uint32_t>& drawn, uint32_t count)
+	{
+		if (drawn.size() != count) return false;
+		for (uint32_t i = 0; i < count; i++) {
+			if (drawn[i] != i) return false;
+		}
+		return true;
+	}
+
+	// 分割の確認
+	void CheckSplit()
+	{
+		std::vector<se::ParallelSubmit::Chunk> chunks;
+
+		se::ParallelSubmit::Split(0, 4, 128, chunks);
+		Check(chunks.empty(), "split empty");
+
+		se::ParallelSubmit::Split(100, 4, 128, chunks);
+		Check(chunks.size() == 1 && chunks[0].begin == 0 && chunks[0].end == 100, "split below the minimum");
+
+		se::ParallelSubmit::Split(1000, 1, 128, chunks);
+		Check(chunks.size() == 1, "split with one context");
+
+		se::ParallelSubmit::Split(1000, 4, 128, chunks);
+		Check(chunks.size() == 4 && chunks[0].end == 250 && chunks[3].end == 1000, "split limited by contexts");
+
+		se::ParallelSubmit::Split(300, 8, 128, chunks);
+		Check(chunks.size() == 2 && chunks[0].end == 150, "split limited by packets");
+
+		se::ParallelSubmit::Split(7, 8, 0, chunks);
+		Check(chunks.size() == 7, "split without minimum");
+
+		// 連続していて、大きさの差は1以内
+		std::mt19937 random(1);
+		bool contiguous = true;
+		bool balanced = true;
+		for (uint32_t n = 0; n < 10000; n++) {
+			uint32_t count = 1 + random() % 100000;
+			uint32_t contexts = random() % 16;
+			uint32_t minPackets = random() % 512;
+			se::ParallelSubmit::Split(count, contexts, minPackets, chunks);
+			uint32_t next = 0;
+			uint32_t minSize = count;
+			uint32_t maxSize = 0;
+			for (const auto& chunk : chunks) {
+				if (chunk.begin != next || chunk.end <= chunk.begin) contiguous = false;
+				next = chunk.end;
+				minSize = (std::min)(minSize, chunk.end - chunk.begin);
+				maxSize = (std::max)(maxSize, chunk.end - chunk.begin);
+			}
+			if (next != count) contiguous = false;
+			if (maxSize - minSize > 1) balanced = false;
+			if (chunks.size() > 1 && (chunks.size() > contexts || minSize + 1 < minPackets)) balanced = false;
+		}
+		Check(contiguous, "random split is not contiguous");
+		Check(balanced, "random split is not balanced");
+	}
+
+	// 決まった条件での記録
+	void CheckBasic(se::ThreadPool& pool)
+	{
+		se::ParallelSubmit submit;
+
+		// 記録先がなければ直接描画
+		{
+			RecordingDevice device(0);
+			submit.Submit(device, 1000, &pool);
+			Check(device.directCount == 1 && device.beginCount == 0 && IsSequential(device.drawn, 1000), "no context");
+		}
+
+		// スレッドプールがなければ直接描画
+		{
+			RecordingDevice device(4);
+			submit.Submit(device, 1000, nullptr);
+			Check(device.directCount == 1 && device.beginCount == 0 && IsSequential(device.drawn, 1000), "no thread pool");
+		}
+
+		// パケットがなければ何もしない
+		{
+			RecordingDevice device(4);
+			submit.Submit(device, 0, &pool);
+			Check(device.directCount == 0 && device.beginCount == 0 && device.drawn.empty(), "no packet");
+		}
+
+		// 分割して記録
+		if (pool.GetWorkerCount() > 0) {
+			RecordingDevice device(4);
+			submit.Submit(device, 1000, &pool);
+			Check(device.directCount == 0 && device.beginCount == 1 && device.GetRecordCount() == 4, "parallel record");
+			Check(IsSequential(device.drawn, 1000), "parallel draw order");
+			Check(submit.GetStats().chunks == 4 && submit.GetStats().packets == 1000, "parallel stats");
+		}
+	}
+
+	// ワーカーがバックグラウンドのタスク(DAGMeshのジオメトリ加工)で塞がっている場合の並列実行
+	void CheckBackground(se::ThreadPool& pool)
+	{
+		uint32_t workerCount = pool.GetWorkerCount();
+		if (workerCount == 0) return;
+
+		std::thread::id caller = std::this_thread::get_id();
+		std::atomic<bool> release(false);
+		std::atomic<uint32_t> started(0);
+		std::atomic<uint32_t> finished(0);
+		std::atomic<bool> onCaller(false);
+
+		// 全てのワーカーを塞ぎ、さらにもう1つ待たせる
+		for (uint32_t i = 0; i < workerCount + 1; i++) {
+			pool.SubmitBackground([&]() {
+				if (std::this_thread::get_id() == caller) onCaller = true;
+				started++;
+				while (!release.load()) {
+					std::this_thread::yield();
+				}
+				finished++;
+			});
+		}
+		while (started.load() < workerCount) {
+			std::this_thread::yield();
+		}
+
+		// 投入した範囲のタスクはワーカーが空くまで始まらないので、呼び出しスレッドが全て処理する
+		const uint32_t count = 1000;
+		std::vector<uint32_t> visits(count, 0);
+		pool.ParallelFor(count, 10, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				visits[i]++;
+			}
+		});
+		bool once = true;
+		for (uint32_t i = 0; i < count; i++) {
+			if (visits[i] != 1) once = false;
+		}
+		Check(once, "ParallelFor with busy workers did not process each index once");
+		Check(!onCaller.load(), "ParallelFor ran a background task on the calling thread");
+
+		// 残ったタスクは呼び出し後に始まっても範囲を取らずに終わる
+		release = true;
+		while (finished.load() < workerCount + 1) {
+			std::this_thread::yield();
+		}
+		Check(!onCaller.load(), "background task ran on the calling thread");
+	}
+
+	// ランダムな条件での記録の繰り返し
+	void CheckRandom(se::ThreadPool& pool, uint32_t iterations)
+	{
+		se::ParallelSubmit submit;
+		std::mt19937 random(2);
+		bool order = true;
+		bool conflict = false;
+		uint64_t parallelCount = 0;
+		uint64_t chunkCount = 0;
+		for (uint32_t n = 0; n < iterations; n++) {
+			uint32_t count = random() % 5000;
+			RecordingDevice device(random() % 9);
+			submit.SetMinChunkPackets(random() % 256);
+			submit.Submit(device, count, &pool);
+
+			if (!IsSequential(device.drawn, count) || device.outOfOrder) order = false;
+			if (device.conflict) conflict = true;
+			if (submit.GetStats().chunks > 0) {
+				parallelCount++;
+				chunkCount += submit.GetStats().chunks;
+			}
+		}
+		Check(order, "random draw order differs from the sorted order");
+		Check(!conflict, "random record used a context concurrently");
+
+		printf("iteration: %u, worker: %u / parallel: %llu / chunk: %.2f (average)\n",
+			iterations, pool.GetWorkerCount(), static_cast<unsigned long long>(parallelCount),
+			parallelCount > 0 ? static_cast<double>(chunkCount) / parallelCount : 0.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t iterations = 2000;
+	uint32_t threadCount = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			threadCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: ParallelSubmitCheck [-i iterations] [-t threadCount]\n");
+			return 1;
+		}
+	}
+
+	se::ThreadPool pool;
+	pool.Initialize(threadCount);
+
+	CheckSplit();
+	CheckBasic(pool);
+	CheckBackground(pool);
+	CheckRandom(pool, iterations);
+	pool.Finalize();
+
+	return Finish();
+}
@@ -0,0 +1,124 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// PolygonBucketBench
+// シェーダ毎のポリゴンリスト作成について、シェーダ毎に全ポリゴンを走査する方式とPolygonBucketsの1回の振り分けを比較する
+// Mayaに依存しないのでコマンドラインで実行できる
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src PolygonBucketBench.cpp ..\..\src\engine\Graphics\PolygonBuckets.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src PolygonBucketBench.cpp ../../src/engine/Graphics/PolygonBuckets.cpp -o PolygonBucketBench
+//
+// 使い方
+//   PolygonBucketBench [-p polygonCount] [-s shaderCount] [-r repeat]
+//     -p : ポリゴン数(既定値5000000)
+//     -s : シェーダ数(既定値64)
+//     -r : 計測の繰り返し回数(既定値5)
+//
+
+#include "engine/Graphics/PolygonBuckets.h"
+#include "../Common/Check.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	// 従来の方式(シェーダ毎に数え上げと書き込みで2回走査する)
+	void ScanPerShader(const std::vector<int32_t>& ids, uint32_t shaderCount, std::vector<std::vector<int32_t>>* output)
+	{
+		output->resize(shaderCount);
+		uint32_t count = static_cast<uint32_t>(ids.size());
+		for (uint32_t s = 0; s < shaderCount; s++) {
+			uint32_t shaderPolyCount = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				if (ids[i] == static_cast<int32_t>(s)) {
+					shaderPolyCount++;
+				}
+			}
+			auto& polygons = (*output)[s];
+			polygons.resize(shaderPolyCount);
+			uint32_t n = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				if (ids[i] == static_cast<int32_t>(s)) {
+					polygons[n++] = static_cast<int32_t>(i);
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t polygonCount = 5000000;
+	uint32_t shaderCount = 64;
+	uint32_t repeat = 5;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			polygonCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			shaderCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			repeat = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: PolygonBucketBench [-p polygonCount] [-s shaderCount] [-r repeat]\n");
+			return 1;
+		}
+	}
+	if (shaderCount == 0 || repeat == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	// 地形のように領域毎にまとまったアサインと、少数の未アサイン(-1)のポリゴン
+	std::mt19937 random(1);
+	std::uniform_int_distribution<uint32_t> shader(0, shaderCount - 1);
+	std::uniform_int_distribution<uint32_t> run(1, 256);
+	std::vector<int32_t> ids(polygonCount);
+	for (uint32_t i = 0; i < polygonCount;) {
+		int32_t id = (random() % 1000 == 0) ? -1 : static_cast<int32_t>(shader(random));
+		for (uint32_t n = run(random); n > 0 && i < polygonCount; n--) {
+			ids[i++] = id;
+		}
+	}
+	printf("polygon: %u, shader: %u, repeat: %u\n", polygonCount, shaderCount, repeat);
+
+	std::vector<std::vector<int32_t>> expected;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t r = 0; r < repeat; r++) {
+		ScanPerShader(ids, shaderCount, &expected);
+	}
+	double scanMs = ElapsedMs(start) / repeat;
+
+	// 2回目以降はバッファを使い回すので確保が発生しない
+	se::PolygonBuckets buckets;
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t r = 0; r < repeat; r++) {
+		buckets.Build(ids.data(), polygonCount, shaderCount);
+	}
+	double bucketMs = ElapsedMs(start) / repeat;
+
+	// 結果の一致
+	bool match = buckets.GetBucketCount() == shaderCount;
+	for (uint32_t s = 0; match && s < shaderCount; s++) {
+		match = buckets.GetCount(s) == expected[s].size()
+			&& (expected[s].empty() || memcmp(buckets.GetPolygons(s), expected[s].data(), sizeof(int32_t) * expected[s].size()) == 0);
+	}
+	if (!match) {
+		printf("FAILED: bucketed polygons differ from the per-shader scan\n");
+		return 1;
+	}
+
+	printf("  per-shader scan : %8.3f ms\n", scanMs);
+	printf("  single bucketing: %8.3f ms (%.1fx faster)\n", bucketMs, scanMs / bucketMs);
+	return 0;
+}
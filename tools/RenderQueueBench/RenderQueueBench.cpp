@@ -0,0 +1,227 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// RenderQueueBench
+// 描画キュー(RenderQueue)のソートと発行を計測する(D3Dに依存しないのでコマンドラインで実行できる)
+// ランダムなステート、深度のパケットを登録してソートし、std::stable_sortと同じ順序になること、
+// 不透明は手前から、半透明は奥から並ぶこと、発行がソート順で範囲指定に従うことを確認してから、ソートと発行の時間を表示する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src RenderQueueBench.cpp ..\..\src\engine\Graphics\RenderQueue.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src RenderQueueBench.cpp ../../src/engine/Graphics/RenderQueue.cpp -o RenderQueueBench
+//
+// 使い方
+//   RenderQueueBench [-n packetCount] [-i iterations]
+//     -n : 1フレームのパケット数(既定値100000)
+//     -i : 計測するフレーム数(既定値50)
+//
+
+#include "engine/Graphics/RenderQueue.h"
+#include "../Common/Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace se
+{
+	// RenderQueueは描画先を受け渡すだけなので、中身のない代用で計測する
+	class GraphicsContext
+	{
+	};
+}
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	/**
+	 * 発行されたパラメータを記録するだけの発行元
+	 */
+	class RecordingDrawable : public Drawable
+	{
+	public:
+		std::vector<uint32_t> submitted;
+
+		void SubmitDrawPacket(GraphicsContext&, uint32_t param) override
+		{
+			submitted.push_back(param);
+		}
+	};
+
+	bool KeyLess(const DrawPacket& a, const DrawPacket& b)
+	{
+		return a.sortKey < b.sortKey;
+	}
+
+	// DAGMeshのサブメッシュ相当のランダムなパケット
+	// ステートの種類は実際のシーンと同程度に限り、同じキーのパケットも作る
+	void PushRandom(RenderQueue& queue, Drawable* drawable, uint32_t count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t pass = random() % 2;
+			uint32_t blend = (random() % 4 == 0) ? 1 + random() % 2 : 0;
+			uint32_t shader = random() % 32;
+			uint32_t layout = random() % 8;
+			uint32_t material = random() % 512;
+			float z = (random() % 16 == 0) ? 1.0f : depth(random);
+			queue.Push(RenderQueue::MakeSortKey(pass, blend, shader, layout, material, z), drawable, i);
+		}
+	}
+
+	// 決まった条件での確認
+	void CheckBasic()
+	{
+		// 不透明は手前から、半透明は奥から、半透明は不透明の後
+		uint64_t nearOpaque = RenderQueue::MakeSortKey(0, 0, 1, 1, 1, 1.0f);
+		uint64_t farOpaque = RenderQueue::MakeSortKey(0, 0, 1, 1, 1, 100.0f);
+		uint64_t nearTranslucent = RenderQueue::MakeSortKey(0, 1, 1, 1, 1, 1.0f);
+		uint64_t farTranslucent = RenderQueue::MakeSortKey(0, 1, 1, 1, 1, 100.0f);
+		Check(nearOpaque < farOpaque, "opaque packets are not sorted front to back");
+		Check(farTranslucent < nearTranslucent, "translucent packets are not sorted back to front");
+		Check(farOpaque < farTranslucent, "translucent packets are not drawn after opaque packets");
+		Check(RenderQueue::MakeSortKey(0, 1, 0, 0, 0, 500.0f) < RenderQueue::MakeSortKey(1, 0, 0, 0, 0, 1.0f), "pass is not the primary key");
+
+		// 不透明はステートが深度より優先
+		Check(RenderQueue::MakeSortKey(0, 0, 1, 0, 0, 100.0f) < RenderQueue::MakeSortKey(0, 0, 2, 0, 0, 1.0f), "opaque shader is not grouped before depth");
+
+		// 背後(深度0以下)や非数は最も手前として扱う
+		float nan = std::numeric_limits<float>::quiet_NaN();
+		Check(RenderQueue::MakeSortKey(0, 0, 1, 1, 1, -5.0f) == RenderQueue::MakeSortKey(0, 0, 1, 1, 1, 0.0f), "negative depth");
+		Check(RenderQueue::MakeSortKey(0, 0, 1, 1, 1, nan) == RenderQueue::MakeSortKey(0, 0, 1, 1, 1, 0.0f), "nan depth");
+
+		// ビュー深度は-Z方向が正
+		RenderQueue queue;
+		Matrix44 view;
+		view.Ident();
+		view._43 = -10.0f;
+		queue.SetView(view);
+		Check(queue.GetViewDepth(Vector3(0.0f, 0.0f, -5.0f)) == 15.0f, "view depth");
+
+		// 空と1つのキュー、全て同じキー(安定ソート)
+		RecordingDrawable drawable;
+		queue.Sort();
+		Check(queue.Count() == 0, "empty queue");
+		queue.Push(nearOpaque, &drawable, 0);
+		queue.Sort();
+		Check(queue.Count() == 1 && queue.GetPacket(0).param == 0, "single packet");
+		queue.Clear();
+		for (uint32_t i = 0; i < 300; i++) {
+			queue.Push(farTranslucent, &drawable, i);
+		}
+		queue.Sort();
+		bool stable = true;
+		for (uint32_t i = 0; i < queue.Count(); i++) {
+			if (queue.GetPacket(i).param != i) stable = false;
+		}
+		Check(stable, "packets with the same key changed order");
+	}
+
+	// ランダムなパケットでの確認と計測
+	void CheckRandom(uint32_t count, uint32_t iterations)
+	{
+		std::mt19937 random(1);
+		RenderQueue queue;
+		queue.Reserve(count);
+		RecordingDrawable drawable;
+		drawable.submitted.reserve(count);
+		std::vector<DrawPacket> reference;
+		reference.reserve(count);
+
+		bool ordered = true;
+		bool submitted = true;
+		double pushMs = 0.0;
+		double sortMs = 0.0;
+		double stdSortMs = 0.0;
+		double submitMs = 0.0;
+		for (uint32_t n = 0; n < iterations; n++) {
+			queue.Clear();
+			auto begin = std::chrono::high_resolution_clock::now();
+			PushRandom(queue, &drawable, count, random);
+			pushMs += ElapsedMs(begin);
+
+			reference.clear();
+			for (uint32_t i = 0; i < count; i++) {
+				reference.push_back(queue.GetPacket(i));
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+			queue.Sort();
+			sortMs += ElapsedMs(begin);
+
+			begin = std::chrono::high_resolution_clock::now();
+			std::stable_sort(reference.begin(), reference.end(), KeyLess);
+			stdSortMs += ElapsedMs(begin);
+
+			// 比較ソートと同じ順序(同じキーは登録順)
+			for (uint32_t i = 0; i < count; i++) {
+				const DrawPacket& packet = queue.GetPacket(i);
+				if (packet.sortKey != reference[i].sortKey || packet.param != reference[i].param) ordered = false;
+			}
+
+			drawable.submitted.clear();
+			GraphicsContext context;
+			begin = std::chrono::high_resolution_clock::now();
+			queue.Submit(context);
+			submitMs += ElapsedMs(begin);
+
+			if (drawable.submitted.size() != count) submitted = false;
+			for (uint32_t i = 0; i < count && i < drawable.submitted.size(); i++) {
+				if (drawable.submitted[i] != reference[i].param) submitted = false;
+			}
+
+			// 範囲指定の発行はソート後の[begin, end)のみ
+			drawable.submitted.clear();
+			uint32_t rangeBegin = random() % count;
+			uint32_t rangeEnd = rangeBegin + random() % (count - rangeBegin + 1);
+			queue.Submit(context, rangeBegin, rangeEnd);
+			if (drawable.submitted.size() != rangeEnd - rangeBegin) submitted = false;
+			for (uint32_t i = rangeBegin; i < rangeEnd && i - rangeBegin < drawable.submitted.size(); i++) {
+				if (drawable.submitted[i - rangeBegin] != reference[i].param) submitted = false;
+			}
+		}
+		Check(ordered, "radix sort differs from std::stable_sort");
+		Check(submitted, "packets were not submitted in the sorted order");
+
+		printf("packet: %u, iteration: %u\n", count, iterations);
+		printf("  push             : %8.3f ms\n", pushMs / iterations);
+		printf("  Sort             : %8.3f ms\n", sortMs / iterations);
+		printf("  std::stable_sort : %8.3f ms\n", stdSortMs / iterations);
+		printf("  Submit           : %8.3f ms\n", submitMs / iterations);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = 100000;
+	uint32_t iterations = 50;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: RenderQueueBench [-n packetCount] [-i iterations]\n");
+			return 1;
+		}
+	}
+	if (count == 0 || iterations == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	CheckBasic();
+	CheckRandom(count, iterations);
+
+	return Finish();
+}
@@ -0,0 +1,166 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// RingAllocatorCheck
+// RingAllocatorの割り当てを検証する(D3Dに依存しないのでコマンドラインで実行できる)
+// 決まった手順で折り返し、アラインメント、空き不足、フェンスによる解放を確認した後、
+// GPUの遅延をランダムに変えたフレームを繰り返し、使用中の領域が重ならないこと、範囲外にならないことを確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src RingAllocatorCheck.cpp ..\..\src\engine\Graphics\RingAllocator.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src RingAllocatorCheck.cpp ../../src/engine/Graphics/RingAllocator.cpp -o RingAllocatorCheck
+//
+// 使い方
+//   RingAllocatorCheck [-f frameCount] [-c capacity]
+//     -f : ランダムに割り当てるフレーム数(既定値100000)
+//     -c : リングの容量(既定値65536)
+//
+
+#include "engine/Graphics/RingAllocator.h"
+#include "../Common/Check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	struct Range
+	{
+		uint64_t fence;
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	// 決まった手順の確認
+	void CheckBasic()
+	{
+		se::RingAllocator ring;
+		ring.Initialize(1024);
+
+		// アラインメント
+		uint32_t a = ring.Allocate(10, 4);
+		uint32_t b = ring.Allocate(16, 256);
+		Check(a == 0 && b == 256, "alignment");
+
+		// 締めていないフレームは解放されない
+		ring.Retire(100);
+		Check(ring.GetUsedBytes() == 272, "retire before EndFrame");
+
+		// 空き不足(末尾に収まらず、先頭はまだ使用中)
+		ring.EndFrame(1);
+		uint32_t c = ring.Allocate(700, 4);
+		Check(c == 272, "allocate after first frame");
+		uint32_t d = ring.Allocate(100, 4);
+		Check(d == se::RingAllocator::InvalidOffset, "allocation over the tail");
+		Check(ring.GetStats().failures == 1, "failure count");
+		ring.EndFrame(2);
+
+		// フレーム1の解放後は先頭に折り返す(末尾の余りは使用中として数える)
+		ring.Retire(1);
+		Check(ring.GetUsedBytes() == 700, "retire first frame");
+		uint32_t e = ring.Allocate(200, 16);
+		Check(e == 0 && ring.GetStats().wraps == 1, "wrap to the head");
+		Check(ring.GetUsedBytes() == 700 + (1024 - 972) + 200, "wrapped padding");
+		ring.EndFrame(3);
+
+		// 全て解放すると先頭から使う
+		ring.Retire(3);
+		Check(ring.GetUsedBytes() == 0 && ring.GetStats().inFlightFrames == 0, "retire all frames");
+		Check(ring.Allocate(1024, 4) == 0, "allocate the whole ring");
+		Check(ring.Allocate(1, 1) == se::RingAllocator::InvalidOffset, "allocate from a full ring");
+		Check(ring.Allocate(2048, 4) == se::RingAllocator::InvalidOffset, "allocate over the capacity");
+		ring.EndFrame(4);
+		ring.Retire(4);
+		Check(ring.GetUsedBytes() == 0, "retire full ring");
+	}
+
+	// GPUの遅延をランダムにしたフレームの繰り返し
+	void CheckRandom(uint32_t frameCount, uint32_t capacity)
+	{
+		se::RingAllocator ring;
+		ring.Initialize(capacity);
+
+		std::mt19937 random(1);
+		std::vector<uint8_t> owner(capacity, 0);
+		std::deque<Range> live;
+		uint64_t completed = 0;
+		bool overlap = false;
+		bool outOfRange = false;
+		for (uint64_t fence = 1; fence <= frameCount; fence++) {
+			// GPUは0〜3フレーム遅れて完了する
+			uint64_t latency = random() % 4;
+			if (fence > latency + 1 && fence - latency - 1 > completed) {
+				completed = fence - latency - 1;
+				ring.Retire(completed);
+				while (!live.empty() && live.front().fence <= completed) {
+					memset(owner.data() + live.front().offset, 0, live.front().size);
+					live.pop_front();
+				}
+			}
+
+			uint32_t count = random() % 16;
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t size = 1 + random() % (capacity / 16);
+				uint32_t alignment = 1u << (random() % 9);
+				uint32_t offset = ring.Allocate(size, alignment);
+				if (offset == se::RingAllocator::InvalidOffset) continue;
+				if (offset % alignment != 0 || static_cast<uint64_t>(offset) + size > capacity) {
+					outOfRange = true;
+					continue;
+				}
+				for (uint32_t k = 0; k < size; k++) {
+					if (owner[offset + k]) overlap = true;
+					owner[offset + k] = 1;
+				}
+				Range range = { fence, offset, size };
+				live.push_back(range);
+			}
+			ring.EndFrame(fence);
+		}
+		Check(!outOfRange, "random allocation out of range or misaligned");
+		Check(!overlap, "random allocation overlaps a live range");
+
+		ring.Retire(frameCount);
+		Check(ring.GetUsedBytes() == 0, "random retire all frames");
+
+		const se::RingAllocator::Stats& stats = ring.GetStats();
+		printf("frame: %u, capacity: %u / allocation: %llu (%.1f MB) / failure: %llu / wrap: %llu / peak: %u\n",
+			frameCount, capacity,
+			static_cast<unsigned long long>(stats.allocations), stats.allocatedBytes / (1024.0 * 1024.0),
+			static_cast<unsigned long long>(stats.failures), static_cast<unsigned long long>(stats.wraps), stats.peakBytes);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frameCount = 100000;
+	uint32_t capacity = 65536;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			frameCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			capacity = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: RingAllocatorCheck [-f frameCount] [-c capacity]\n");
+			return 1;
+		}
+	}
+	if (frameCount == 0 || capacity < 16) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	CheckBasic();
+	CheckRandom(frameCount, capacity);
+
+	return Finish();
+}
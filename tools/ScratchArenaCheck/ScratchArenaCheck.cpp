@@ -0,0 +1,222 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// ScratchArenaCheck
+// 加工ジョブの一時バッファ(ScratchArena)を検証する
+// Mayaに依存しないのでコマンドラインで実行できる
+// アライメント、使用量と最大使用量、Rewind()で同じ領域を使い直すこと、ブロックの追加とReset()でのまとめ直し、
+// プールに返す際の統計(確保とまとめ直しをその借用に数える)と保持する容量の上限を超えた分の解放を確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src ScratchArenaCheck.cpp ..\..\src\engine\Core\ScratchArena.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -pthread -I../../src ScratchArenaCheck.cpp ../../src/engine/Core/ScratchArena.cpp -o ScratchArenaCheck
+//
+// 使い方
+//   ScratchArenaCheck [-i iterations]
+//     -i : ランダムな確保と巻き戻しの回数(既定値10000)
+//
+
+#include "engine/Core/ScratchArena.h"
+#include "../Common/Check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	const size_t MB = 1 << 20;
+
+	bool IsAligned(const void* pointer, size_t alignment)
+	{
+		return (reinterpret_cast<uintptr_t>(pointer) & (alignment - 1)) == 0;
+	}
+
+	void CheckBasic()
+	{
+		ScratchArena arena;
+		Check(arena.GetCapacity() == 0 && arena.GetUsedBytes() == 0, "empty arena has no block");
+
+		// アライメントと使用量
+		void* a = arena.Allocate(3, 1);
+		void* b = arena.Allocate(8, 64);
+		Check(IsAligned(b, 64), "alignment");
+		Check(static_cast<uint8_t*>(b) >= static_cast<uint8_t*>(a) + 3, "allocations do not overlap");
+		Check(arena.GetUsedBytes() >= 11 && arena.GetUsedBytes() <= 3 + 63 + 8, "used bytes include padding");
+		Check(arena.GetCapacity() == ScratchArena::DefaultBlockSize && arena.GetGrowCount() == 1, "first block");
+
+		// 巻き戻すと同じ領域を使い、最大使用量は残る
+		ScratchArena::Marker marker = arena.GetMarker();
+		size_t used = arena.GetUsedBytes();
+		void* c = arena.Allocate(1000);
+		arena.Allocate(5000);
+		size_t highWater = arena.GetHighWaterBytes();
+		arena.Rewind(marker);
+		Check(arena.GetUsedBytes() == used, "rewind restores used bytes");
+		Check(arena.Allocate(1000) == c, "rewind reuses the same memory");
+		Check(arena.GetHighWaterBytes() == highWater && highWater >= used + 6000, "high water survives rewind");
+
+		// ブロックが足りなければ追加し、Reset()で1ブロックにまとめる
+		arena.Allocate(ScratchArena::DefaultBlockSize);
+		Check(arena.GetGrowCount() == 2, "grow on overflow");
+		size_t capacity = arena.GetCapacity();
+		Check(capacity >= 2 * ScratchArena::DefaultBlockSize, "capacity doubles");
+		arena.Reset();
+		Check(arena.GetCapacity() == capacity && arena.GetMergeCount() == 1, "reset merges blocks");
+		Check(arena.GetGrowCount() == 2, "merge is not counted as growth");
+		Check(arena.GetUsedBytes() == 0, "reset clears used bytes");
+
+		// まとめた後は同じ使い方で確保しない
+		arena.Allocate(ScratchArena::DefaultBlockSize / 2);
+		arena.Allocate(ScratchArena::DefaultBlockSize);
+		Check(arena.GetGrowCount() == 2, "merged block fits the same workload");
+		arena.Reset();
+		Check(arena.GetMergeCount() == 1, "single block is not merged again");
+
+		// 上限を超えていれば解放し、次の確保で既定のサイズから作り直す
+		arena.Reset(capacity - 1);
+		Check(arena.GetCapacity() == 0 && arena.GetTrimCount() == 1, "reset trims above the limit");
+		arena.Allocate(16);
+		Check(arena.GetCapacity() == ScratchArena::DefaultBlockSize, "trimmed arena starts over");
+	}
+
+	void CheckPool()
+	{
+		ScratchArena::Stats before = ScratchArena::GetStats();
+
+		// 借用中に2回確保してまとめ直した分は、その借用の統計に入る
+		{
+			ScratchScope scope;
+			scope.Get().Allocate(ScratchArena::DefaultBlockSize / 2);
+			scope.Get().Allocate(ScratchArena::DefaultBlockSize);
+		}
+		ScratchArena::Stats first = ScratchArena::GetStats();
+		Check(first.scopeCount == before.scopeCount + 1, "scope count");
+		Check(first.growCount == before.growCount + 2, "growth counted in the scope that grew");
+		Check(first.mergeCount == before.mergeCount + 1, "merge counted in the scope that grew");
+		Check(first.highWater >= ScratchArena::DefaultBlockSize * 3 / 2, "pool high water");
+		Check(first.capacity >= ScratchArena::DefaultBlockSize * 2, "released capacity");
+
+		// 同じ使い方なら確保もまとめ直しも発生しない
+		{
+			ScratchScope scope;
+			scope.Get().Allocate(ScratchArena::DefaultBlockSize / 2);
+			scope.Get().Allocate(ScratchArena::DefaultBlockSize);
+		}
+		ScratchArena::Stats second = ScratchArena::GetStats();
+		Check(second.growCount == first.growCount && second.mergeCount == first.mergeCount, "steady workload does not allocate");
+		Check(second.arenaCount == first.arenaCount, "arena is reused");
+
+		// 上限を超えた容量は返す際に解放する
+		ScratchArena::SetRetainedCapacity(2 * MB);
+		{
+			ScratchScope scope;
+			scope.Get().Allocate(5 * MB);
+		}
+		ScratchArena::Stats trimmed = ScratchArena::GetStats();
+		Check(trimmed.trimCount == second.trimCount + 1, "trim counted");
+		Check(trimmed.capacity == 0, "trimmed arena keeps no block");
+		Check(trimmed.highWater >= 5 * MB, "high water keeps the large scope");
+		{
+			ScratchScope scope;
+			scope.Get().Allocate(MB / 2);
+		}
+		ScratchArena::Stats small = ScratchArena::GetStats();
+		Check(small.capacity == ScratchArena::DefaultBlockSize && small.trimCount == trimmed.trimCount, "small scope is retained");
+		ScratchArena::SetRetainedCapacity(ScratchArena::DefaultRetainedCapacity);
+
+		// 同時に借りると別のアリーナになる
+		{
+			ScratchScope a;
+			ScratchScope b;
+			Check(&a.Get() != &b.Get(), "concurrent scopes get different arenas");
+		}
+		Check(ScratchArena::GetStats().arenaCount == 2, "arena count is the peak of concurrent scopes");
+	}
+
+	// ランダムな確保と入れ子の巻き戻しで、書き込んだ内容が壊れないこと
+	void CheckRandom(uint32_t iterations)
+	{
+		struct Allocation
+		{
+			uint8_t* data;
+			size_t size;
+			uint8_t value;
+		};
+		struct Level
+		{
+			ScratchArena::Marker marker;
+			size_t count;
+		};
+
+		std::mt19937 random(1);
+		ScratchArena arena;
+		std::vector<Allocation> allocations;
+		std::vector<Level> levels;
+		bool intact = true;
+		bool aligned = true;
+		for (uint32_t i = 0; i < iterations; i++) {
+			uint32_t action = random() % 16;
+			if (action == 0) {
+				Level level = { arena.GetMarker(), allocations.size() };
+				levels.push_back(level);
+			} else if (action == 1 && !levels.empty()) {
+				arena.Rewind(levels.back().marker);
+				allocations.resize(levels.back().count);
+				levels.pop_back();
+			} else if (action == 2 && random() % 64 == 0) {
+				arena.Reset();
+				allocations.clear();
+				levels.clear();
+			} else {
+				size_t size = (random() % 8 == 0) ? random() % (3 * MB / 2) : random() % 4096;
+				size_t alignment = size_t(1) << (random() % 8);
+				Allocation allocation;
+				allocation.data = static_cast<uint8_t*>(arena.Allocate(size, alignment));
+				allocation.size = size;
+				allocation.value = static_cast<uint8_t>(i);
+				aligned = aligned && IsAligned(allocation.data, alignment);
+				memset(allocation.data, allocation.value, size);
+				allocations.push_back(allocation);
+			}
+			if (i % 64 == 0) {
+				for (const Allocation& allocation : allocations) {
+					for (size_t j = 0; j < allocation.size; j += 97) {
+						intact = intact && allocation.data[j] == allocation.value;
+					}
+					intact = intact && (allocation.size == 0 || allocation.data[allocation.size - 1] == allocation.value);
+				}
+			}
+		}
+		Check(aligned, "random allocations are aligned");
+		Check(intact, "live allocations are not overwritten");
+		printf("random: %u operations / capacity: %.2f MB / high water: %.2f MB / grow: %llu / merge: %llu\n",
+			iterations, static_cast<double>(arena.GetCapacity()) / MB, static_cast<double>(arena.GetHighWaterBytes()) / MB,
+			static_cast<unsigned long long>(arena.GetGrowCount()), static_cast<unsigned long long>(arena.GetMergeCount()));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t iterations = 10000;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: ScratchArenaCheck [-i iterations]\n");
+			return 1;
+		}
+	}
+
+	CheckBasic();
+	CheckPool();
+	CheckRandom(iterations);
+	return Finish();
+}
@@ -0,0 +1,253 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// SkinningBench
+// GPUスキニングのウェイトの詰め込みとパレット行列の計算を検証し、
+// 位置と法線を毎フレーム書き直す方式(変形のみの更新)とパレットのみ転送する方式の1フレームあたりの転送量と処理時間を比較する
+// Mayaとデバイスに依存しないのでコマンドラインで実行できる
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src SkinningBench.cpp ..\..\src\engine\Graphics\Skinning.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src SkinningBench.cpp ../../src/engine/Graphics/Skinning.cpp -o SkinningBench
+//
+// 使い方
+//   SkinningBench [-v vertexCount] [-j jointCount] [-f frames]
+//     -v : 頂点数(既定値100000)
+//     -j : ジョイント数(既定値64)
+//     -f : 計測するフレーム数(既定値100)
+//
+
+#include "engine/Graphics/Skinning.h"
+#include "../Common/Check.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	void Identity(float* m)
+	{
+		memset(m, 0, sizeof(float) * 16);
+		m[0] = m[5] = m[10] = m[15] = 1.0f;
+	}
+
+	void Translation(float* m, float x, float y, float z)
+	{
+		Identity(m);
+		m[12] = x;
+		m[13] = y;
+		m[14] = z;
+	}
+
+	// Z軸回りの回転と平行移動
+	void RotationZ(float* m, float angle, float x, float y, float z)
+	{
+		Translation(m, x, y, z);
+		m[0] = m[5] = std::cos(angle);
+		m[1] = std::sin(angle);
+		m[4] = -m[1];
+	}
+
+	// 平行移動と回転のみの行列の逆行列
+	void InverseRigid(const float* m, float* output)
+	{
+		float r[16];
+		Identity(r);
+		for (uint32_t i = 0; i < 3; i++) {
+			for (uint32_t j = 0; j < 3; j++) {
+				r[i * 4 + j] = m[j * 4 + i];
+			}
+		}
+		for (uint32_t c = 0; c < 3; c++) {
+			r[12 + c] = -(m[12] * r[c] + m[13] * r[4 + c] + m[14] * r[8 + c]);
+		}
+		memcpy(output, r, sizeof(r));
+	}
+
+	void TestPackInfluences()
+	{
+		printf("PackInfluences\n");
+
+		// 上位4つの選択と正規化
+		const double weights[] = { 0.05, 0.3, 0.0, 0.1, 0.25, 0.3 };
+		se::SkinInfluence influence;
+		se::Skinning::PackInfluences(weights, 1, 6, &influence);
+		Check(influence.joints[0] == 1 && influence.joints[1] == 5 && influence.joints[2] == 4 && influence.joints[3] == 3, "top 4 joints in descending order");
+		uint32_t sum = influence.weights[0] + influence.weights[1] + influence.weights[2] + influence.weights[3];
+		Check(sum == 255, "weights sum to 255");
+		Check(std::abs(influence.weights[0] - 0.3 / 0.95 * 255.0) <= 1.0, "weights renormalized after dropping the smallest");
+
+		// 4つ未満、負のウェイト、全て0
+		const double sparse[] = { -0.5, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		se::SkinInfluence packed[2];
+		se::Skinning::PackInfluences(sparse, 2, 4, packed);
+		Check(packed[0].joints[0] == 2 && packed[0].weights[0] == 255 && packed[0].weights[1] == 0, "single influence gets full weight");
+		Check(packed[1].joints[0] == 0 && packed[1].weights[0] == 255, "unweighted vertex is bound to joint 0");
+
+		// 丸め誤差の吸収
+		const double even[] = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+		se::Skinning::PackInfluences(even, 1, 7, &influence);
+		sum = influence.weights[0] + influence.weights[1] + influence.weights[2] + influence.weights[3];
+		Check(sum == 255, "rounding error is absorbed");
+		Check(influence.joints[0] == 0 && influence.joints[3] == 3, "ties keep the lower joint");
+	}
+
+	void TestPalette()
+	{
+		printf("BuildPalette\n");
+
+		// バインド時のジョイント行列で変換すると元の位置に戻る
+		const uint32_t jointCount = 2;
+		float geometry[16], bindPre[32], joints[32], bind[32];
+		Translation(geometry, 0.0f, 1.0f, 0.0f);
+		RotationZ(joints, 0.5f, 1.0f, 2.0f, 3.0f);
+		RotationZ(joints + 16, -1.0f, 0.0f, 5.0f, 0.0f);
+		InverseRigid(joints, bindPre);
+		InverseRigid(joints + 16, bindPre + 16);
+		se::Skinning::BuildBindMatrices(geometry, bindPre, jointCount, bind);
+
+		se::SkinMatrix palette[jointCount];
+		se::Skinning::BuildPalette(bind, joints, jointCount, palette);
+		const float position[3] = { 1.0f, 2.0f, 3.0f };
+		const double weights[] = { 0.25, 0.75 };
+		se::SkinInfluence influence;
+		se::Skinning::PackInfluences(weights, 1, jointCount, &influence);
+		float skinned[3];
+		se::Skinning::SkinPosition(influence, palette, position, skinned);
+		Check(std::fabs(skinned[0] - 1.0f) < 1e-4f && std::fabs(skinned[1] - 3.0f) < 1e-4f && std::fabs(skinned[2] - 3.0f) < 1e-4f,
+			"bind pose reproduces geometry matrix");
+
+		// ジョイントを動かすと移動量がそのまま反映される
+		Translation(joints, 2.0f, 0.0f, 0.0f);
+		Translation(joints + 16, 2.0f, 0.0f, 0.0f);
+		Translation(bind, 0.0f, 0.0f, 0.0f);
+		Translation(bind + 16, 0.0f, 0.0f, 0.0f);
+		se::Skinning::BuildPalette(bind, joints, jointCount, palette);
+		se::Skinning::SkinPosition(influence, palette, position, skinned);
+		Check(std::fabs(skinned[0] - 3.0f) < 1e-4f && std::fabs(skinned[1] - 2.0f) < 1e-4f, "joint translation moves the vertex");
+	}
+
+	void TestBounds()
+	{
+		printf("ComputeSkinnedBounds\n");
+
+		const uint32_t vertexCount = 256;
+		const uint32_t jointCount = 3;
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+		std::uniform_real_distribution<double> weight(0.0, 1.0);
+		std::vector<float> positions(vertexCount * 3);
+		std::vector<double> weights(vertexCount * jointCount);
+		for (auto& p : positions) p = coord(random);
+		for (auto& w : weights) w = weight(random);
+		std::vector<se::SkinInfluence> influences(vertexCount);
+		se::Skinning::PackInfluences(weights.data(), vertexCount, jointCount, influences.data());
+
+		float bind[16 * jointCount], joints[16 * jointCount], jointBounds[6 * jointCount];
+		for (uint32_t j = 0; j < jointCount; j++) {
+			Identity(bind + j * 16);
+			RotationZ(joints + j * 16, 0.7f * j, 1.0f * j, -2.0f, 0.5f);
+		}
+		se::Skinning::ComputeJointBounds(positions.data(), 3, influences.data(), vertexCount, bind, jointCount, jointBounds);
+
+		se::SkinMatrix palette[jointCount];
+		se::Skinning::BuildPalette(bind, joints, jointCount, palette);
+		float boundsMin[3], boundsMax[3];
+		Check(se::Skinning::ComputeSkinnedBounds(jointBounds, joints, jointCount, boundsMin, boundsMax), "bounds are not empty");
+		bool inside = true;
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			float p[3];
+			se::Skinning::SkinPosition(influences[v], palette, &positions[v * 3], p);
+			for (uint32_t c = 0; c < 3; c++) {
+				inside = inside && p[c] >= boundsMin[c] - 1e-4f && p[c] <= boundsMax[c] + 1e-4f;
+			}
+		}
+		Check(inside, "skinned vertices are inside the bounds");
+	}
+
+	void Benchmark(uint32_t vertexCount, uint32_t jointCount, uint32_t frames)
+	{
+		printf("Benchmark (vertex: %u, joint: %u, frame: %u)\n", vertexCount, jointCount, frames);
+
+		std::mt19937 random(2);
+		std::uniform_real_distribution<double> weight(0.0, 1.0);
+		std::uniform_int_distribution<uint32_t> joint(0, jointCount - 1);
+		std::vector<double> weights(static_cast<size_t>(vertexCount) * jointCount, 0.0);
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			for (uint32_t k = 0; k < 6; k++) {
+				weights[static_cast<size_t>(v) * jointCount + joint(random)] = weight(random);
+			}
+		}
+
+		// 抽出時に1回だけ行う処理
+		std::vector<se::SkinInfluence> influences(vertexCount);
+		auto start = std::chrono::high_resolution_clock::now();
+		se::Skinning::PackInfluences(weights.data(), vertexCount, jointCount, influences.data());
+		printf("  pack influences     : %8.3f ms (once, %llu bytes)\n", ElapsedMs(start),
+			static_cast<unsigned long long>(sizeof(se::SkinInfluence)) * vertexCount);
+
+		// 毎フレームの処理
+		std::vector<float> bind(16 * jointCount), joints(16 * jointCount);
+		std::vector<se::SkinMatrix> palette(jointCount);
+		for (uint32_t j = 0; j < jointCount; j++) {
+			Identity(&bind[j * 16]);
+		}
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < frames; f++) {
+			for (uint32_t j = 0; j < jointCount; j++) {
+				RotationZ(&joints[j * 16], 0.01f * f, 0.0f, 0.1f * j, 0.0f);
+			}
+			se::Skinning::BuildPalette(bind.data(), joints.data(), jointCount, palette.data());
+		}
+		double paletteMs = ElapsedMs(start) / frames;
+
+		// 変形のみの更新は位置と法線(float3 x2)を毎フレーム転送する
+		uint64_t deformBytes = static_cast<uint64_t>(vertexCount) * sizeof(float) * 6;
+		uint64_t paletteBytes = static_cast<uint64_t>(jointCount) * sizeof(se::SkinMatrix);
+		printf("  build palette       : %8.3f ms / frame\n", paletteMs);
+		printf("  upload (deform only): %10llu bytes / frame\n", static_cast<unsigned long long>(deformBytes));
+		printf("  upload (gpu skin)   : %10llu bytes / frame (%.1fx less)\n", static_cast<unsigned long long>(paletteBytes),
+			static_cast<double>(deformBytes) / paletteBytes);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t vertexCount = 100000;
+	uint32_t jointCount = 64;
+	uint32_t frames = 100;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+			vertexCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			jointCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			frames = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: SkinningBench [-v vertexCount] [-j jointCount] [-f frames]\n");
+			return 1;
+		}
+	}
+	if (vertexCount == 0 || jointCount == 0 || jointCount > 0x10000 || frames == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	TestPackInfluences();
+	TestPalette();
+	TestBounds();
+	if (!Passed()) return 1;
+
+	Benchmark(vertexCount, jointCount, frames);
+	return 0;
+}
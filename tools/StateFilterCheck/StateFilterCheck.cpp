@@ -0,0 +1,292 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// StateFilterCheck
+// 冗長なステート設定の除去(StateFilter)を検証する(D3Dに依存しないのでコマンドラインで実行できる)
+// D3D11のコンテキストの代わりに、設定された値をスロット毎に記録するだけの設定先を使い、
+// フィルタを通した設定先の状態が、全ての呼び出しを直接渡した設定先の状態と常に一致することを確認して除去率を表示する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src StateFilterCheck.cpp ..\..\src\engine\Graphics\StateFilter.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src StateFilterCheck.cpp ../../src/engine/Graphics/StateFilter.cpp -o StateFilterCheck
+//
+// 使い方
+//   StateFilterCheck [-i iterations] [-p packets]
+//     -i : ランダムな呼び出しの回数(既定値200000)
+//     -p : 描画パケット列の長さ(既定値10000)
+//
+
+#include "engine/Graphics/StateFilter.h"
+#include "../Common/Check.h"
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <utility>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	enum Call
+	{
+		Call_VertexShader,
+		Call_PixelShader,
+		Call_InputLayout,
+		Call_Topology,
+		Call_BlendState,
+		Call_DepthStencilState,
+		Call_RasterizerState,
+		Call_VertexBuffer,
+		Call_IndexBuffer,
+		Call_VSResource,
+		Call_PSResource,
+		Call_PSSampler,
+		Call_VSConstantBuffer,
+		Call_PSConstantBuffer,
+		Call_CSConstantBuffer,
+
+		Call_Num,
+	};
+
+	// 保持しているスロット数を超えるスロットも試す
+	const uint32_t SlotRange = 20;
+
+	template <class T>
+	T* Handle(uintptr_t value)
+	{
+		// 参照しないので番号をそのままポインタにする(0はnullptr)
+		return reinterpret_cast<T*>(value * 16);
+	}
+
+	/**
+	 * 設定された値をスロット毎に記録するだけの設定先
+	 */
+	class RecordingDevice : public StateDevice
+	{
+	public:
+		typedef std::array<uintptr_t, 3> Value;
+		typedef std::map<std::pair<int, uint32_t>, Value> State;
+
+		State state;
+		uint32_t callCount;
+
+	private:
+		void Record(Call call, uint32_t slot, uintptr_t a, uintptr_t b = 0, uintptr_t c = 0)
+		{
+			Value value = {{ a, b, c }};
+			state[std::make_pair(static_cast<int>(call), slot)] = value;
+			callCount++;
+		}
+
+	public:
+		RecordingDevice() : callCount(0) {}
+
+		virtual void SetVertexShader(ID3D11VertexShader* shader) override { Record(Call_VertexShader, 0, reinterpret_cast<uintptr_t>(shader)); }
+		virtual void SetPixelShader(ID3D11PixelShader* shader) override { Record(Call_PixelShader, 0, reinterpret_cast<uintptr_t>(shader)); }
+		virtual void SetInputLayout(ID3D11InputLayout* layout) override { Record(Call_InputLayout, 0, reinterpret_cast<uintptr_t>(layout)); }
+		virtual void SetPrimitiveTopology(uint32_t topology) override { Record(Call_Topology, 0, topology); }
+		virtual void SetBlendState(ID3D11BlendState* state) override { Record(Call_BlendState, 0, reinterpret_cast<uintptr_t>(state)); }
+		virtual void SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilRef) override { Record(Call_DepthStencilState, 0, reinterpret_cast<uintptr_t>(state), stencilRef); }
+		virtual void SetRasterizerState(ID3D11RasterizerState* state) override { Record(Call_RasterizerState, 0, reinterpret_cast<uintptr_t>(state)); }
+		virtual void SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset) override { Record(Call_VertexBuffer, slot, reinterpret_cast<uintptr_t>(buffer), stride, offset); }
+		virtual void SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format) override { Record(Call_IndexBuffer, 0, reinterpret_cast<uintptr_t>(buffer), format); }
+		virtual void SetVSResource(uint32_t slot, ID3D11ShaderResourceView* srv) override { Record(Call_VSResource, slot, reinterpret_cast<uintptr_t>(srv)); }
+		virtual void SetPSResource(uint32_t slot, ID3D11ShaderResourceView* srv) override { Record(Call_PSResource, slot, reinterpret_cast<uintptr_t>(srv)); }
+		virtual void SetPSSamplerState(uint32_t slot, ID3D11SamplerState* sampler) override { Record(Call_PSSampler, slot, reinterpret_cast<uintptr_t>(sampler)); }
+		virtual void SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) override { Record(Call_VSConstantBuffer, slot, reinterpret_cast<uintptr_t>(buffer), firstConstant, constantCount); }
+		virtual void SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) override { Record(Call_PSConstantBuffer, slot, reinterpret_cast<uintptr_t>(buffer), firstConstant, constantCount); }
+		virtual void SetCSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount) override { Record(Call_CSConstantBuffer, slot, reinterpret_cast<uintptr_t>(buffer), firstConstant, constantCount); }
+	};
+
+	/**
+	 * 1回の呼び出し(値の種類は少なくして同じ値が続くようにする)
+	 */
+	struct Command
+	{
+		Call call;
+		uint32_t slot;
+		uint32_t a;
+		uint32_t b;
+		uint32_t c;
+
+		static Command Random(std::mt19937& random)
+		{
+			Command command;
+			command.call = static_cast<Call>(random() % Call_Num);
+			command.slot = random() % SlotRange;
+			command.a = random() % 4;
+			command.b = random() % 2;
+			command.c = random() % 2;
+			return command;
+		}
+
+		template <class Target>
+		void Apply(Target& target) const
+		{
+			switch (call) {
+			case Call_VertexShader: target.SetVertexShader(Handle<ID3D11VertexShader>(a)); break;
+			case Call_PixelShader: target.SetPixelShader(Handle<ID3D11PixelShader>(a)); break;
+			case Call_InputLayout: target.SetInputLayout(Handle<ID3D11InputLayout>(a)); break;
+			case Call_Topology: target.SetPrimitiveTopology(a); break;
+			case Call_BlendState: target.SetBlendState(Handle<ID3D11BlendState>(a)); break;
+			case Call_DepthStencilState: target.SetDepthStencilState(Handle<ID3D11DepthStencilState>(a), b); break;
+			case Call_RasterizerState: target.SetRasterizerState(Handle<ID3D11RasterizerState>(a)); break;
+			case Call_VertexBuffer: target.SetVertexBuffer(slot, Handle<ID3D11Buffer>(a), 16 + b * 16, c * 64); break;
+			case Call_IndexBuffer: target.SetIndexBuffer(Handle<ID3D11Buffer>(a), b); break;
+			case Call_VSResource: target.SetVSResource(slot, Handle<ID3D11ShaderResourceView>(a)); break;
+			case Call_PSResource: target.SetPSResource(slot, Handle<ID3D11ShaderResourceView>(a)); break;
+			case Call_PSSampler: target.SetPSSamplerState(slot, Handle<ID3D11SamplerState>(a)); break;
+			case Call_VSConstantBuffer: target.SetVSConstantBuffer(slot, Handle<ID3D11Buffer>(a), b * 16, c * 16); break;
+			case Call_PSConstantBuffer: target.SetPSConstantBuffer(slot, Handle<ID3D11Buffer>(a), b * 16, c * 16); break;
+			case Call_CSConstantBuffer: target.SetCSConstantBuffer(slot, Handle<ID3D11Buffer>(a), b * 16, c * 16); break;
+			default: break;
+			}
+		}
+	};
+
+	// 決まった手順での確認
+	void CheckBasic()
+	{
+		RecordingDevice device;
+		StateFilter filter;
+		filter.SetDevice(&device);
+
+		// 初回はnullptrでも必ず渡す
+		filter.SetVertexShader(nullptr);
+		filter.SetVertexShader(nullptr);
+		Check(device.callCount == 1, "first call is issued");
+
+		// 値、範囲が変わった場合のみ
+		filter.SetVSConstantBuffer(1, Handle<ID3D11Buffer>(1));
+		filter.SetVSConstantBuffer(1, Handle<ID3D11Buffer>(1), 0, 0);
+		filter.SetVSConstantBuffer(1, Handle<ID3D11Buffer>(1), 16, 16);
+		filter.SetPSConstantBuffer(1, Handle<ID3D11Buffer>(1));
+		Check(device.callCount == 4, "constant buffer range");
+
+		// 保持していないスロットは毎回渡す
+		filter.SetPSResource(StateFilter::ResourceSlotNum, Handle<ID3D11ShaderResourceView>(1));
+		filter.SetPSResource(StateFilter::ResourceSlotNum, Handle<ID3D11ShaderResourceView>(1));
+		Check(device.callCount == 6, "slot out of range");
+
+		// 破棄後は同じ値でも渡す
+		filter.Invalidate();
+		filter.SetVertexShader(nullptr);
+		Check(device.callCount == 7, "call after invalidate");
+
+		const StateFilter::Stats& stats = filter.GetStats();
+		Check(stats.issued == 7 && stats.filtered == 2, "stats");
+		filter.ResetStats();
+		Check(filter.GetStats().issued == 0 && filter.GetStats().filtered == 0, "reset stats");
+	}
+
+	// ランダムな呼び出しでの確認(外部からのステート変更とInvalidateを含む)
+	void CheckRandom(uint32_t iterations)
+	{
+		std::mt19937 random(1);
+		RecordingDevice filtered;
+		RecordingDevice direct;
+		StateFilter filter;
+		filter.SetDevice(&filtered);
+
+		bool match = true;
+		uint32_t invalidates = 0;
+		for (uint32_t n = 0; n < iterations; n++) {
+			// 外部(Maya)によるステート変更は両方の設定先に反映し、フィルタの保持値を破棄する
+			if (random() % 1000 == 0) {
+				Command external = Command::Random(random);
+				external.a = 7;
+				external.Apply(filtered);
+				external.Apply(direct);
+				filter.Invalidate();
+				invalidates++;
+			}
+
+			Command command = Command::Random(random);
+			command.Apply(filter);
+			command.Apply(direct);
+			if (n % 64 == 0 && filtered.state != direct.state) match = false;
+		}
+		Check(match && filtered.state == direct.state, "filtered device state differs from the unfiltered state");
+
+		const StateFilter::Stats& stats = filter.GetStats();
+		Check(stats.issued + stats.filtered == iterations, "stats count");
+		Check(filtered.callCount == stats.issued + invalidates, "issued count");
+		printf("random calls: %u, issued: %u, filtered: %u (%.1f%%), invalidate: %u\n",
+			iterations, stats.issued, stats.filtered, 100.0 * stats.filtered / iterations, invalidates);
+	}
+
+	// 描画パケット列(マテリアル順に並んだメッシュの描画)での除去率
+	void CheckPackets(uint32_t packets)
+	{
+		std::mt19937 random(2);
+		RecordingDevice filtered;
+		RecordingDevice direct;
+		StateFilter filter;
+		filter.SetDevice(&filtered);
+
+		uint32_t material = 0;
+		for (uint32_t i = 0; i < packets; i++) {
+			// ソート済みなので同じマテリアルが続く
+			if (random() % 16 == 0) material++;
+			uint32_t mesh = i;
+
+			Command commands[] = {
+				{ Call_VertexShader, 0, 1 + material % 2, 0, 0 },
+				{ Call_PixelShader, 0, 1 + material % 3, 0, 0 },
+				{ Call_InputLayout, 0, 1 + material % 2, 0, 0 },
+				{ Call_Topology, 0, 4, 0, 0 },
+				{ Call_BlendState, 0, 1, 0, 0 },
+				{ Call_DepthStencilState, 0, 1, 0, 0 },
+				{ Call_RasterizerState, 0, 1, 0, 0 },
+				{ Call_VSConstantBuffer, 0, 1, 0, 0 },
+				{ Call_PSConstantBuffer, 2, 2 + material, 0, 0 },
+				{ Call_PSResource, 0, 2 + material, 0, 0 },
+				{ Call_PSSampler, 0, 1, 0, 0 },
+				{ Call_VSResource, 0, 1, 0, 0 },
+				{ Call_VSResource, 3, 2 + mesh, 0, 0 },
+				{ Call_VertexBuffer, 0, 2 + mesh, 0, 0 },
+				{ Call_IndexBuffer, 0, 2 + mesh, 1, 0 },
+			};
+			for (const Command& command : commands) {
+				command.Apply(filter);
+				command.Apply(direct);
+			}
+		}
+		Check(filtered.state == direct.state, "packet stream state differs from the unfiltered state");
+
+		const StateFilter::Stats& stats = filter.GetStats();
+		uint32_t total = stats.issued + stats.filtered;
+		printf("packets: %u, calls: %u, issued: %u, filtered: %u (%.1f%%)\n",
+			packets, total, stats.issued, stats.filtered, total > 0 ? 100.0 * stats.filtered / total : 0.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t iterations = 200000;
+	uint32_t packets = 10000;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			packets = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: StateFilterCheck [-i iterations] [-p packets]\n");
+			return 1;
+		}
+	}
+
+	CheckBasic();
+	CheckRandom(iterations);
+	CheckPackets(packets);
+
+	return Finish();
+}
@@ -0,0 +1,220 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// StreamKernelBench
+// StreamKernelsのSIMD版がスカラー版とビット単位で一致することを確認し、それぞれの処理時間を比較する
+// 半精度の境界値(非正規化数、丸めの中間値、オーバーフロー)、snorm16の0.5の端数、長さ0の法線、端数の要素数も検証する
+// Mayaに依存しないのでコマンドラインで実行できる
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src StreamKernelBench.cpp ..\..\src\engine\Graphics\StreamKernels.cpp ..\..\src\engine\Graphics\VertexQuantizer.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src StreamKernelBench.cpp ../../src/engine/Graphics/StreamKernels.cpp ../../src/engine/Graphics/VertexQuantizer.cpp -o StreamKernelBench
+//
+// 使い方
+//   StreamKernelBench [-n vertexCount] [-r repeat]
+//     -n : 頂点数(既定値1000000)
+//     -r : 計測の繰り返し回数(既定値10)
+//
+
+#include "engine/Graphics/StreamKernels.h"
+#include "../Common/Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	float FromBits(uint32_t bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	template<typename T>
+	bool Same(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0;
+	}
+
+	// 計測(repeat回の平均)
+	template<typename F>
+	double Measure(uint32_t repeat, F func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t r = 0; r < repeat; r++) {
+			func();
+		}
+		return ElapsedMs(start) / repeat;
+	}
+
+	void Report(const char* name, double scalarMs, double simdMs)
+	{
+		printf("  %-18s: scalar %8.3f ms / simd %8.3f ms (%.1fx)\n", name, scalarMs, simdMs, scalarMs / simdMs);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t vertexCount = 1000000;
+	uint32_t repeat = 10;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			vertexCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			repeat = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: StreamKernelBench [-n vertexCount] [-r repeat]\n");
+			return 1;
+		}
+	}
+	if (vertexCount == 0 || repeat == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+	printf("vertex: %u, repeat: %u, simd: %s\n", vertexCount, repeat, SE_STREAM_KERNELS_SSE2 ? "SSE2" : "none");
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> uv(-4.0f, 4.0f);
+
+	// halfの境界値: 全ての半精度値の前後と中間値、非正規化数、範囲外(端数の要素数になるよう奇数個)
+	{
+		std::vector<float> input;
+		for (uint32_t h = 0; h < 0x7c00; h++) {
+			uint32_t exponent = h >> 10;
+			uint32_t mantissa = h & 0x3ff;
+			float value = (exponent == 0) ? std::ldexp(static_cast<float>(mantissa), -24) : std::ldexp(static_cast<float>(mantissa | 0x400), static_cast<int>(exponent) - 25);
+			float next = (exponent == 0) ? std::ldexp(static_cast<float>(mantissa + 1), -24) : std::ldexp(static_cast<float>((mantissa | 0x400) + 1), static_cast<int>(exponent) - 25);
+			float middle = (value + next) * 0.5f;
+			float candidates[] = { value, middle, std::nextafter(middle, 0.0f), std::nextafter(middle, 1.0e9f) };
+			for (float c : candidates) {
+				input.push_back(c);
+				input.push_back(-c);
+			}
+		}
+		float extra[] = { 65504.0f, 65519.99f, 65520.0f, 65536.0f, 1.0e20f, FromBits(0x7f800000), FromBits(0x00000001), FromBits(0x33000000), FromBits(0x33000001) };
+		for (float e : extra) {
+			input.push_back(e);
+			input.push_back(-e);
+		}
+		input.push_back(0.25f);
+		std::vector<uint16_t> expected(input.size()), actual(input.size());
+		se::StreamKernels::FloatToHalfScalar(input.data(), input.size(), expected.data());
+		se::StreamKernels::FloatToHalf(input.data(), input.size(), actual.data());
+		Check(Same(expected, actual), "FloatToHalf edge values");
+	}
+
+	// snorm16: 0.5の端数、範囲外
+	{
+		std::vector<float> input;
+		for (int32_t k = -32800; k <= 32800; k++) {
+			input.push_back((k + 0.5f) / 32767.0f);
+			input.push_back(k / 32767.0f);
+		}
+		input.push_back(2.0f);
+		input.push_back(-2.0f);
+		input.push_back(0.0f);
+		std::vector<int16_t> expected(input.size()), actual(input.size());
+		se::StreamKernels::FloatToSnorm16Scalar(input.data(), input.size(), expected.data());
+		se::StreamKernels::FloatToSnorm16(input.data(), input.size(), actual.data());
+		Check(Same(expected, actual), "FloatToSnorm16 edge values");
+	}
+
+	// 計測用のストリーム(UV、法線(一部は長さ0や軸上)、位置)
+	std::vector<float> uvs(static_cast<size_t>(vertexCount) * 2);
+	for (float& v : uvs) {
+		v = uv(random);
+	}
+	std::vector<float> normals(static_cast<size_t>(vertexCount) * 3);
+	for (size_t v = 0; v < vertexCount; v++) {
+		float* n = &normals[v * 3];
+		switch (v % 64) {
+		case 0: n[0] = n[1] = n[2] = 0.0f; break;
+		case 1: n[0] = 0.0f; n[1] = 0.0f; n[2] = -1.0f; break;
+		case 2: n[0] = -0.0f; n[1] = 1.0f; n[2] = -0.0f; break;
+		default:
+			n[0] = unit(random);
+			n[1] = unit(random);
+			n[2] = unit(random);
+			break;
+		}
+	}
+	std::vector<float> positions(static_cast<size_t>(vertexCount) * 3);
+	for (float& p : positions) {
+		p = unit(random) * 1000.0f;
+	}
+
+	// V反転
+	{
+		std::vector<float> expected = uvs, actual = uvs;
+		se::StreamKernels::FlipVScalar(expected.data(), vertexCount, 2);
+		se::StreamKernels::FlipV(actual.data(), vertexCount, 2);
+		Check(Same(expected, actual), "FlipV");
+		double scalarMs = Measure(repeat, [&]() { se::StreamKernels::FlipVScalar(expected.data(), vertexCount, 2); });
+		double simdMs = Measure(repeat, [&]() { se::StreamKernels::FlipV(actual.data(), vertexCount, 2); });
+		Report("FlipV", scalarMs, simdMs);
+	}
+
+	// half
+	{
+		size_t count = uvs.size();
+		std::vector<uint16_t> expected(count), actual(count);
+		double scalarMs = Measure(repeat, [&]() { se::StreamKernels::FloatToHalfScalar(uvs.data(), count, expected.data()); });
+		double simdMs = Measure(repeat, [&]() { se::StreamKernels::FloatToHalf(uvs.data(), count, actual.data()); });
+		Check(Same(expected, actual), "FloatToHalf");
+		Report("FloatToHalf", scalarMs, simdMs);
+	}
+
+	// snorm16
+	{
+		size_t count = normals.size();
+		std::vector<int16_t> expected(count), actual(count);
+		double scalarMs = Measure(repeat, [&]() { se::StreamKernels::FloatToSnorm16Scalar(normals.data(), count, expected.data()); });
+		double simdMs = Measure(repeat, [&]() { se::StreamKernels::FloatToSnorm16(normals.data(), count, actual.data()); });
+		Check(Same(expected, actual), "FloatToSnorm16");
+		Report("FloatToSnorm16", scalarMs, simdMs);
+	}
+
+	// 8面体写像(端数の頂点数も確認)
+	{
+		std::vector<int16_t> expected(static_cast<size_t>(vertexCount) * 2), actual(static_cast<size_t>(vertexCount) * 2);
+		double scalarMs = Measure(repeat, [&]() { se::StreamKernels::EncodeOctahedralScalar(normals.data(), 3, vertexCount, expected.data()); });
+		double simdMs = Measure(repeat, [&]() { se::StreamKernels::EncodeOctahedral(normals.data(), 3, vertexCount, actual.data()); });
+		Check(Same(expected, actual), "EncodeOctahedral");
+		uint32_t odd = (std::min)(vertexCount, 7u);
+		std::vector<int16_t> oddExpected(odd * 2), oddActual(odd * 2);
+		se::StreamKernels::EncodeOctahedralScalar(normals.data(), 3, odd, oddExpected.data());
+		se::StreamKernels::EncodeOctahedral(normals.data(), 3, odd, oddActual.data());
+		Check(Same(oddExpected, oddActual), "EncodeOctahedral (odd count)");
+		Report("EncodeOctahedral", scalarMs, simdMs);
+	}
+
+	// バウンディング
+	{
+		float expectedMin[3], expectedMax[3], actualMin[3], actualMax[3];
+		double scalarMs = Measure(repeat, [&]() { se::StreamKernels::ComputeBoundsScalar(positions.data(), 3, vertexCount, expectedMin, expectedMax); });
+		double simdMs = Measure(repeat, [&]() { se::StreamKernels::ComputeBounds(positions.data(), 3, vertexCount, actualMin, actualMax); });
+		bool same = true;
+		for (int32_t i = 0; i < 3; i++) {
+			same = same && expectedMin[i] == actualMin[i] && expectedMax[i] == actualMax[i];
+		}
+		Check(same, "ComputeBounds");
+		Report("ComputeBounds", scalarMs, simdMs);
+	}
+
+	if (!Passed()) return 1;
+	printf("all kernels match the scalar reference\n");
+	return 0;
+}
\ No newline at end of file
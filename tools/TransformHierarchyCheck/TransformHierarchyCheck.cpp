@@ -0,0 +1,251 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// TransformHierarchyCheck
+// TransformHierarchyのワールドマトリクス計算を検証する(Mayaに依存しないのでコマンドラインで実行できる)
+// ランダムな階層を親から順に合成した結果と比較し、並列計算、変更判定、マトリクスのみの更新(Set)を確認して計算時間を表示する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src TransformHierarchyCheck.cpp ..\..\src\engine\Math\TransformHierarchy.cpp ..\..\src\engine\Core\ThreadPool.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -pthread -I../../src TransformHierarchyCheck.cpp ../../src/engine/Math/TransformHierarchy.cpp ../../src/engine/Core/ThreadPool.cpp -o TransformHierarchyCheck
+//
+// 使い方
+//   TransformHierarchyCheck [-n nodeCount] [-f frames] [-t threadCount]
+//     -n : ノード数(既定値100000)
+//     -f : 計測するフレーム数(既定値50)
+//     -t : ワーカースレッド数(既定値は論理コア数 - 1)
+//
+
+#include "engine/Math/TransformHierarchy.h"
+#include "engine/Core/ThreadPool.h"
+#include "../Common/Check.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	// スケール、Z軸回転、平行移動(行ベクトル規約)
+	Matrix44 MakeLocal(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		float angle = unit(random) * 3.14159265f;
+		float scale = 1.0f + unit(random) * 0.1f;
+		Matrix44 m;
+		m.Ident();
+		m._11 = cosf(angle) * scale;
+		m._12 = sinf(angle) * scale;
+		m._21 = -sinf(angle) * scale;
+		m._22 = cosf(angle) * scale;
+		m._33 = scale;
+		m.SetTranslation(Vector3(unit(random) * 10.0f, unit(random) * 10.0f, unit(random) * 10.0f));
+		return m;
+	}
+
+	/**
+	 * ランダムな階層(親は子より前、ルートは1割)
+	 */
+	struct Scene
+	{
+		std::vector<uint32_t> parents;
+		std::vector<Matrix44> locals;
+
+		Scene(uint32_t count, std::mt19937& random)
+			: parents(count)
+			, locals(count)
+		{
+			for (uint32_t i = 0; i < count; i++) {
+				// 近くの親を選んで深い階層も作る
+				bool root = (i == 0) || (random() % 10 == 0);
+				parents[i] = root ? TransformHierarchy::InvalidIndex : i - 1 - random() % Min(i, 8u);
+				locals[i] = MakeLocal(random);
+			}
+		}
+
+		// 親から順に合成した結果
+		std::vector<Matrix44> Reference() const
+		{
+			std::vector<Matrix44> world(locals.size());
+			for (size_t i = 0; i < locals.size(); i++) {
+				world[i] = (parents[i] == TransformHierarchy::InvalidIndex) ? locals[i] : locals[i] * world[parents[i]];
+			}
+			return world;
+		}
+	};
+
+	bool MatchesReference(const TransformHierarchy& hierarchy, const std::vector<Matrix44>& reference)
+	{
+		if (hierarchy.Count() != reference.size()) return false;
+		for (uint32_t i = 0; i < hierarchy.Count(); i++) {
+			if (hierarchy.GetWorld(i) != reference[i]) return false;
+		}
+		return true;
+	}
+
+	void Build(TransformHierarchy& hierarchy, const Scene& scene, const std::vector<Matrix44>& prevWorld)
+	{
+		hierarchy.Clear();
+		hierarchy.Reserve(static_cast<uint32_t>(scene.locals.size()));
+		for (size_t i = 0; i < scene.locals.size(); i++) {
+			hierarchy.Add(scene.parents[i], scene.locals[i], prevWorld[i]);
+		}
+	}
+
+	// 決まった階層での確認
+	void CheckBasic()
+	{
+		TransformHierarchy hierarchy;
+		hierarchy.Evaluate();
+		Check(hierarchy.Count() == 0 && hierarchy.GetLevelCount() == 0, "empty hierarchy");
+
+		// root - a - b、root2
+		Matrix44 identity;
+		identity.Ident();
+		Matrix44 move = Matrix44::TranslationMatrix(Vector3(1.0f, 2.0f, 3.0f));
+		uint32_t root = hierarchy.Add(TransformHierarchy::InvalidIndex, move, identity);
+		uint32_t a = hierarchy.Add(root, move, identity);
+		uint32_t b = hierarchy.Add(a, Matrix44::ScaleMatrix(2.0f), identity);
+		uint32_t root2 = hierarchy.Add(TransformHierarchy::InvalidIndex, identity, identity);
+		hierarchy.Evaluate();
+
+		Check(hierarchy.GetLevelCount() == 3, "level count");
+		Vector3 t = hierarchy.GetWorld(b).Translation();
+		Check(t.x == 2.0f && t.y == 4.0f && t.z == 6.0f && hierarchy.GetWorld(b)._11 == 2.0f, "composed world");
+		Check(hierarchy.IsChanged(root) && hierarchy.IsChanged(b) && !hierarchy.IsChanged(root2), "changed after add");
+
+		// 同じ値では変更なし
+		for (uint32_t i = 0; i < hierarchy.Count(); i++) {
+			hierarchy.Set(i, hierarchy.GetLocal(i), hierarchy.GetWorld(i));
+		}
+		hierarchy.Evaluate();
+		Check(!hierarchy.IsChanged(root) && !hierarchy.IsChanged(a) && !hierarchy.IsChanged(b), "unchanged after same set");
+
+		// 親の変更は子に伝わる
+		hierarchy.Set(root, identity, hierarchy.GetWorld(root));
+		hierarchy.Evaluate();
+		t = hierarchy.GetWorld(b).Translation();
+		Check(hierarchy.IsChanged(root) && hierarchy.IsChanged(a) && hierarchy.IsChanged(b) && !hierarchy.IsChanged(root2), "changed parent");
+		Check(t.x == 1.0f && t.y == 2.0f && t.z == 3.0f, "world after parent set");
+		Check(hierarchy.GetLevelCount() == 3, "level count after set");
+	}
+
+	// ランダムな階層での確認と計測
+	void CheckRandom(ThreadPool& pool, uint32_t count, uint32_t frames)
+	{
+		std::mt19937 random(1);
+		Scene scene(count, random);
+		std::vector<Matrix44> reference = scene.Reference();
+
+		Matrix44 identity;
+		identity.Ident();
+		std::vector<Matrix44> prevWorld(count, identity);
+
+		// 単一スレッドと並列で同じ結果
+		TransformHierarchy serial;
+		Build(serial, scene, prevWorld);
+		serial.Evaluate();
+		Check(MatchesReference(serial, reference), "serial world differs from the reference");
+
+		TransformHierarchy parallel;
+		Build(parallel, scene, prevWorld);
+		parallel.Evaluate(&pool);
+		Check(MatchesReference(parallel, reference), "parallel world differs from the reference");
+
+		// ルートの一部のみ動かして、その子孫のみ変更になる
+		std::vector<uint8_t> moved(count, 0);
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t parent = scene.parents[i];
+			if (parent == TransformHierarchy::InvalidIndex) {
+				if (random() % 4 == 0) {
+					scene.locals[i] = MakeLocal(random);
+					moved[i] = 1;
+				}
+			} else {
+				moved[i] = moved[parent];
+			}
+			parallel.Set(i, scene.locals[i], parallel.GetWorld(i));
+		}
+		parallel.Evaluate(&pool);
+		reference = scene.Reference();
+		Check(MatchesReference(parallel, reference), "world after set differs from the reference");
+		bool changed = true;
+		for (uint32_t i = 0; i < count; i++) {
+			if (parallel.IsChanged(i) != (moved[i] != 0)) changed = false;
+		}
+		Check(changed, "changed flags after set");
+
+		// 計測(階層の作り直しと、マトリクスのみの更新)
+		auto begin = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			Build(parallel, scene, reference);
+			parallel.Evaluate(&pool);
+		}
+		double rebuildMs = ElapsedMs(begin) / frames;
+
+		begin = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			for (uint32_t i = 0; i < count; i++) {
+				parallel.Set(i, scene.locals[i], parallel.GetWorld(i));
+			}
+			parallel.Evaluate(&pool);
+		}
+		double setMs = ElapsedMs(begin) / frames;
+
+		begin = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			for (uint32_t i = 0; i < count; i++) {
+				serial.Set(i, scene.locals[i], serial.GetWorld(i));
+			}
+			serial.Evaluate();
+		}
+		double serialMs = ElapsedMs(begin) / frames;
+
+		printf("node: %u, level: %u, worker: %u\n", count, parallel.GetLevelCount(), pool.GetWorkerCount());
+		printf("  rebuild + evaluate : %8.3f ms/frame\n", rebuildMs);
+		printf("  set + evaluate     : %8.3f ms/frame\n", setMs);
+		printf("  serial             : %8.3f ms/frame\n", serialMs);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = 100000;
+	uint32_t frames = 50;
+	uint32_t threadCount = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			frames = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			threadCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: TransformHierarchyCheck [-n nodeCount] [-f frames] [-t threadCount]\n");
+			return 1;
+		}
+	}
+	if (count == 0 || frames == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	ThreadPool pool;
+	pool.Initialize(threadCount);
+
+	CheckBasic();
+	CheckRandom(pool, count, frames);
+	pool.Finalize();
+
+	return Finish();
+}
@@ -0,0 +1,193 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// UpdateQueueBench
+// DAGManagerの更新キュー(se::UpdateQueue)を合成したノードで検証し、
+// 全ノードを毎フレーム更新する方式と、変更のあったノードのみキューから更新する方式の1フレームあたりの処理時間を比較する
+// Mayaに依存しないのでコマンドラインで実行できる
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src UpdateQueueBench.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src UpdateQueueBench.cpp -o UpdateQueueBench
+//
+// 使い方
+//   UpdateQueueBench [-n nodeCount] [-c churn] [-f frames]
+//     -n : ノード数(既定値100000)
+//     -c : 1フレームで変更されるノードの割合(%、既定値1)
+//     -f : 計測するフレーム数(既定値200)
+//
+
+#include "engine/Core/UpdateQueue.h"
+#include "../Common/Check.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace tools;
+
+namespace {
+	/**
+	 * 合成したノード(DAGTransformの更新の代わりに行列1つ分の計算をする)
+	 */
+	struct Node
+	{
+		int32_t updateQueueIndex;
+		uint32_t child;			// 更新時に子として再登録するノード(なければ自身)
+		uint32_t updateCount;
+		float matrix[16];
+
+		void Update()
+		{
+			for (int i = 0; i < 16; i++) {
+				matrix[i] = matrix[i] * 0.999f + 0.001f * static_cast<float>(i);
+			}
+			updateCount++;
+		}
+	};
+
+	typedef se::UpdateQueue<Node, &Node::updateQueueIndex> NodeQueue;
+
+	std::vector<Node> CreateNodes(uint32_t count)
+	{
+		std::vector<Node> nodes(count);
+		for (uint32_t i = 0; i < count; i++) {
+			Node& node = nodes[i];
+			memset(&node, 0, sizeof(node));
+			node.updateQueueIndex = -1;
+			node.child = (i * 2 + 1 < count) ? i * 2 + 1 : i;
+		}
+		return nodes;
+	}
+
+	// 決まった手順の確認
+	void CheckBasic()
+	{
+		std::vector<Node> nodes = CreateNodes(8);
+		NodeQueue queue;
+
+		// 重複した登録は1回のみ
+		Check(queue.Push(&nodes[1]) && !queue.Push(&nodes[1]), "duplicate push");
+		queue.Push(&nodes[2]);
+		queue.Push(&nodes[3]);
+		Check(queue.Size() == 3 && NodeQueue::IsQueued(&nodes[2]), "push count");
+
+		// 削除したノードは処理されない
+		queue.Remove(&nodes[2]);
+		Check(!NodeQueue::IsQueued(&nodes[2]), "remove");
+		queue.Remove(&nodes[2]);
+
+		// 処理中に登録したノード(処理済みの自身)は同じDrainで処理し、未処理で登録済みの子は1回のみ
+		std::vector<uint32_t> order;
+		queue.Drain([&](Node* node) {
+			uint32_t index = static_cast<uint32_t>(node - nodes.data());
+			order.push_back(index);
+			if (index == 1 && order.size() == 1) {
+				queue.Push(&nodes[node->child]);
+				queue.Push(node);
+			}
+		});
+		Check(order.size() == 3 && order[0] == 1 && order[1] == 3 && order[2] == 1, "drain order");
+		Check(queue.Empty(), "drain empty");
+		for (const Node& node : nodes) {
+			if (NodeQueue::IsQueued(&node)) Check(false, "index reset after drain");
+		}
+	}
+
+	// ランダムに変更したフレームの繰り返し
+	void Benchmark(uint32_t nodeCount, double churn, uint32_t frameCount)
+	{
+		std::vector<Node> nodes = CreateNodes(nodeCount);
+		NodeQueue queue;
+		std::mt19937 random(1);
+		uint32_t dirtyCount = static_cast<uint32_t>(nodeCount * churn / 100.0);
+
+		// 全ノードの更新(変更前の方式)
+		auto begin = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; frame++) {
+			for (Node& node : nodes) {
+				node.Update();
+			}
+		}
+		double fullMs = ElapsedMs(begin) / frameCount;
+
+		// 変更のあったノードのみ(1割は子も更新させる、同じノードへの重複した変更も含む)
+		for (Node& node : nodes) {
+			node.updateCount = 0;
+		}
+		std::vector<uint32_t> dirty(dirtyCount);
+		std::vector<uint32_t> expected(nodeCount, 0);
+		uint64_t updated = 0;
+		bool exact = true;
+		double queueMs = 0.0;
+		for (uint32_t frame = 0; frame < frameCount; frame++) {
+			for (uint32_t& index : dirty) {
+				index = random() % nodeCount;
+			}
+
+			begin = std::chrono::high_resolution_clock::now();
+			for (uint32_t index : dirty) {
+				queue.Push(&nodes[index]);
+			}
+			queue.Drain([&](Node* node) {
+				node->Update();
+				updated++;
+				if (node->updateCount % 10 == 0) {
+					queue.Push(&nodes[node->child]);
+				}
+			});
+			queueMs += ElapsedMs(begin);
+
+			// 変更したノードはそのフレームで1回以上、重複しても各登録につき1回のみ更新されている
+			for (uint32_t index : dirty) {
+				if (nodes[index].updateCount == expected[index]) exact = false;
+			}
+			for (uint32_t i = 0; i < nodeCount; i++) {
+				expected[i] = nodes[i].updateCount;
+			}
+		}
+		queueMs /= frameCount;
+		Check(exact, "dirty node was not updated");
+		Check(queue.Empty(), "queue is not empty after the frames");
+
+		printf("node: %u, churn: %.2f%%, frame: %u\n", nodeCount, churn, frameCount);
+		printf("  full traversal : %8.4f ms/frame\n", fullMs);
+		printf("  update queue   : %8.4f ms/frame (%.1f updates/frame, %.1fx)\n",
+			queueMs, static_cast<double>(updated) / frameCount, queueMs > 0.0 ? fullMs / queueMs : 0.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t nodeCount = 100000;
+	double churn = 1.0;
+	uint32_t frameCount = 200;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			nodeCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			churn = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			frameCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: UpdateQueueBench [-n nodeCount] [-c churn] [-f frames]\n");
+			return 1;
+		}
+	}
+	if (nodeCount == 0 || frameCount == 0 || churn < 0.0 || churn > 100.0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	CheckBasic();
+	Benchmark(nodeCount, churn, frameCount);
+
+	return Finish();
+}
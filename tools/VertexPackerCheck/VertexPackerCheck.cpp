@@ -0,0 +1,261 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// VertexPackerCheck
+// インターリーブ頂点バッファの詰め込み(VertexPacker)を検証する(D3Dに依存しないのでコマンドラインで実行できる)
+// 全ての属性の組み合わせでストライドとオフセットが属性の並び順と一致し、属性同士が重ならないこと、
+// ランダムなストリーム(要素数の過不足、欠けたストリーム、対象外のストリーム)を詰めた結果が頂点毎に書き込んだ結果と一致することを
+// 通常と量子化の両方で確認してから、詰め込みの時間を表示する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src VertexPackerCheck.cpp ..\..\src\engine\Graphics\VertexPacker.cpp ..\..\src\engine\Graphics\VertexQuantizer.cpp ..\..\src\engine\Graphics\StreamKernels.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src VertexPackerCheck.cpp ../../src/engine/Graphics/VertexPacker.cpp ../../src/engine/Graphics/VertexQuantizer.cpp ../../src/engine/Graphics/StreamKernels.cpp -o VertexPackerCheck
+//
+// 使い方
+//   VertexPackerCheck [-n vertexCount] [-i iterations]
+//     -n : 計測する頂点数(既定値1000000)
+//     -i : ランダムなストリームで確認する回数(既定値2000)
+//
+
+#include "engine/Graphics/VertexPacker.h"
+#include "engine/Graphics/VertexQuantizer.h"
+#include "../Common/Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	// 属性毎のfloat要素数(VertexAttribute順)
+	const uint32_t attributeComponents[VERTEX_ATTR_NUM] = { 3, 3, 4, 2, 2, 2, 2, 3, 3 };
+
+	/**
+	 * 属性1つ分の入力(DAGMeshGeometryのGeometryStream相当)
+	 */
+	struct Stream
+	{
+		std::vector<float> data;
+		VertexAttributeFlags attribute;
+		uint32_t components;
+		bool null;		// dataを渡さない
+	};
+
+	std::vector<VertexStreamSource> MakeSources(const std::vector<Stream>& streams)
+	{
+		std::vector<VertexStreamSource> sources(streams.size());
+		for (size_t i = 0; i < streams.size(); i++) {
+			sources[i].data = streams[i].null ? nullptr : streams[i].data.data();
+			sources[i].attribute = streams[i].attribute;
+			sources[i].components = streams[i].components;
+		}
+		return sources;
+	}
+
+	// 1頂点ずつ属性を書き込んだ期待値(対応するストリームが無い属性は0)
+	std::vector<uint8_t> PackReference(VertexAttributeFlags attributes, const std::vector<Stream>& streams, uint32_t vertexCount, bool quantized)
+	{
+		const uint32_t stride = VertexPacker::GetStride(attributes, quantized);
+		std::vector<uint8_t> output(static_cast<size_t>(stride) * vertexCount, 0);
+		for (const Stream& stream : streams) {
+			if ((attributes & stream.attribute) == 0 || stream.null) continue;
+			uint32_t attribute = 0;
+			while (stream.attribute != (1u << attribute)) attribute++;
+			VertexAttribute attr = static_cast<VertexAttribute>(attribute);
+			uint32_t offset = VertexPacker::GetOffset(attributes, attr, quantized);
+
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				const float* src = stream.data.data() + static_cast<size_t>(v) * stream.components;
+				uint8_t* dst = output.data() + static_cast<size_t>(v) * stride + offset;
+				if (quantized) {
+					VertexQuantizer::Encode(attr, src, stream.components, 1, dst, VertexQuantizer::GetAttributeSize(attr));
+				} else {
+					memcpy(dst, src, (std::min)(stream.components, attributeComponents[attribute]) * sizeof(float));
+				}
+			}
+		}
+		return output;
+	}
+
+	std::vector<uint8_t> Pack(VertexAttributeFlags attributes, const std::vector<Stream>& streams, uint32_t vertexCount, bool quantized)
+	{
+		// 書き込まれなかった箇所が分かるよう0以外で埋めておく
+		std::vector<uint8_t> output(static_cast<size_t>(VertexPacker::GetStride(attributes, quantized)) * vertexCount, 0xcd);
+		std::vector<VertexStreamSource> sources = MakeSources(streams);
+		VertexPacker::Pack(attributes, sources.data(), static_cast<uint32_t>(sources.size()), vertexCount, output.data(), quantized);
+		return output;
+	}
+
+	// 全ての属性の組み合わせでのストライドとオフセット
+	void CheckLayout()
+	{
+		bool ordered = true;
+		bool aligned = true;
+		for (uint32_t q = 0; q < 2; q++) {
+			bool quantized = (q != 0);
+			for (VertexAttributeFlags attributes = 0; attributes < (1u << VERTEX_ATTR_NUM); attributes++) {
+				uint32_t stride = VertexPacker::GetStride(attributes, quantized);
+				uint32_t expected = 0;
+				for (uint32_t i = 0; i < VERTEX_ATTR_NUM; i++) {
+					if ((attributes & (1u << i)) == 0) continue;
+					VertexAttribute attribute = static_cast<VertexAttribute>(i);
+					// 属性は前の属性の直後に並ぶ
+					if (VertexPacker::GetOffset(attributes, attribute, quantized) != expected) ordered = false;
+					expected += VertexPacker::GetAttributeSize(attribute, quantized);
+				}
+				if (stride != expected) ordered = false;
+				// DAGMeshGeometryはfloat配列として確保する
+				if (stride % sizeof(float) != 0) aligned = false;
+			}
+		}
+		Check(ordered, "offsets do not follow the attribute order");
+		Check(aligned, "stride is not a multiple of float");
+
+		const VertexAttributeFlags common = VERTEX_ATTR_FLAG_POSITION | VERTEX_ATTR_FLAG_NORMAL | VERTEX_ATTR_FLAG_TEXCOORD0;
+		Check(VertexPacker::GetStride(common) == 32 && VertexPacker::GetOffset(common, VERTEX_ATTR_TEXCOORD0) == 24, "float layout");
+		Check(VertexPacker::GetStride(common, true) == 20 && VertexPacker::GetOffset(common, VERTEX_ATTR_TEXCOORD0, true) == 16, "quantized layout");
+		Check(VertexPacker::GetStride(0) == 0 && VertexPacker::GetStride(0, true) == 0, "empty layout");
+	}
+
+	// 決まった入力での詰め込み
+	void CheckBasic()
+	{
+		// 位置、法線、UV0の2頂点
+		std::vector<Stream> streams(3);
+		streams[0].data = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+		streams[0].attribute = VERTEX_ATTR_FLAG_POSITION;
+		streams[0].components = 3;
+		streams[1].data = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f };
+		streams[1].attribute = VERTEX_ATTR_FLAG_NORMAL;
+		streams[1].components = 3;
+		streams[2].data = { 0.25f, 0.5f, 0.75f, 1.0f };
+		streams[2].attribute = VERTEX_ATTR_FLAG_TEXCOORD0;
+		streams[2].components = 2;
+		for (Stream& stream : streams) stream.null = false;
+
+		const VertexAttributeFlags attributes = VERTEX_ATTR_FLAG_POSITION | VERTEX_ATTR_FLAG_NORMAL | VERTEX_ATTR_FLAG_TEXCOORD0;
+		std::vector<uint8_t> packed = Pack(attributes, streams, 2, false);
+		const float expected[16] = { 1.0f, 2.0f, 3.0f, 0.0f, 0.0f, 1.0f, 0.25f, 0.5f, 4.0f, 5.0f, 6.0f, 0.0f, 1.0f, 0.0f, 0.75f, 1.0f };
+		Check(packed.size() == sizeof(expected) && memcmp(packed.data(), expected, sizeof(expected)) == 0, "interleaved float vertices");
+
+		// 量子化したものは復元すると元の値に近い
+		std::vector<uint8_t> quantized = Pack(attributes, streams, 2, true);
+		float normals[6];
+		float uvs[4];
+		VertexQuantizer::Decode(VERTEX_ATTR_NORMAL, quantized.data() + 12, 20, 2, normals, 3);
+		VertexQuantizer::Decode(VERTEX_ATTR_TEXCOORD0, quantized.data() + 16, 20, 2, uvs, 2);
+		Check(memcmp(quantized.data() + 20, expected + 8, sizeof(float) * 3) == 0, "quantized position");
+		Check(normals[2] > 0.9999f && normals[4] > 0.9999f && uvs[0] == 0.25f && uvs[3] == 1.0f, "quantized normal and uv");
+
+		// 無い属性は0、対象外のストリームは無視
+		std::vector<Stream> partial(1, streams[2]);
+		partial.push_back(streams[0]);
+		partial[1].attribute = VERTEX_ATTR_FLAG_COLOR;
+		packed = Pack(VERTEX_ATTR_FLAG_POSITION | VERTEX_ATTR_FLAG_TEXCOORD0, partial, 2, false);
+		const float missing[10] = { 0.0f, 0.0f, 0.0f, 0.25f, 0.5f, 0.0f, 0.0f, 0.0f, 0.75f, 1.0f };
+		Check(packed.size() == sizeof(missing) && memcmp(packed.data(), missing, sizeof(missing)) == 0, "missing stream is not zero");
+
+		// 頂点数0は何も書き込まない
+		Check(Pack(attributes, streams, 0, false).empty(), "zero vertices");
+	}
+
+	// ランダムなストリームでの詰め込み
+	void CheckRandom(uint32_t iterations)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+		bool same = true;
+		bool sameQuantized = true;
+		for (uint32_t n = 0; n < iterations; n++) {
+			VertexAttributeFlags attributes = random() % (1u << VERTEX_ATTR_NUM);
+			uint32_t vertexCount = random() % 200;
+
+			// 要素数の過不足、データなし、対象外の属性を含むストリーム
+			std::vector<Stream> streams;
+			for (uint32_t i = 0; i < VERTEX_ATTR_NUM; i++) {
+				if (random() % 4 == 0) continue;
+				Stream stream;
+				stream.attribute = 1u << i;
+				stream.components = 1 + random() % 5;
+				stream.null = (random() % 16 == 0);
+				stream.data.resize(static_cast<size_t>(stream.components) * vertexCount);
+				for (float& f : stream.data) f = value(random);
+				streams.push_back(std::move(stream));
+			}
+			std::shuffle(streams.begin(), streams.end(), random);
+
+			if (Pack(attributes, streams, vertexCount, false) != PackReference(attributes, streams, vertexCount, false)) same = false;
+			if (Pack(attributes, streams, vertexCount, true) != PackReference(attributes, streams, vertexCount, true)) sameQuantized = false;
+		}
+		Check(same, "packed vertices differ from the per-vertex reference");
+		Check(sameQuantized, "packed quantized vertices differ from the per-vertex reference");
+	}
+
+	// 一般的なメッシュの詰め込み時間
+	void Measure(uint32_t vertexCount)
+	{
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+		const uint32_t attributeList[] = { VERTEX_ATTR_POSITION, VERTEX_ATTR_NORMAL, VERTEX_ATTR_TEXCOORD0, VERTEX_ATTR_TANGENT };
+		std::vector<Stream> streams;
+		VertexAttributeFlags attributes = 0;
+		for (uint32_t attribute : attributeList) {
+			Stream stream;
+			stream.attribute = 1u << attribute;
+			stream.components = attributeComponents[attribute];
+			stream.null = false;
+			stream.data.resize(static_cast<size_t>(stream.components) * vertexCount);
+			for (float& f : stream.data) f = value(random);
+			streams.push_back(std::move(stream));
+			attributes |= 1u << attribute;
+		}
+
+		std::vector<VertexStreamSource> sources = MakeSources(streams);
+		printf("vertex: %u\n", vertexCount);
+		for (uint32_t q = 0; q < 2; q++) {
+			bool quantized = (q != 0);
+			uint32_t stride = VertexPacker::GetStride(attributes, quantized);
+			std::vector<uint8_t> output(static_cast<size_t>(stride) * vertexCount);
+			auto begin = std::chrono::high_resolution_clock::now();
+			VertexPacker::Pack(attributes, sources.data(), static_cast<uint32_t>(sources.size()), vertexCount, output.data(), quantized);
+			printf("  %-9s : stride %2u, %8.3f ms\n", quantized ? "quantized" : "float", stride, ElapsedMs(begin));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t vertexCount = 1000000;
+	uint32_t iterations = 2000;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			vertexCount = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: VertexPackerCheck [-n vertexCount] [-i iterations]\n");
+			return 1;
+		}
+	}
+	if (vertexCount == 0) {
+		printf("invalid arguments\n");
+		return 1;
+	}
+
+	CheckLayout();
+	CheckBasic();
+	CheckRandom(iterations);
+	Measure(vertexCount);
+
+	return Finish();
+}
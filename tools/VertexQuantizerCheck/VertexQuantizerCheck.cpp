@@ -0,0 +1,242 @@
+﻿//
+// Copyright (c) GANBARION Co., Ltd. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+//
+
+//
+// VertexQuantizerCheck
+// 頂点属性の量子化(VertexQuantizer)に不正、縮退した入力を与えて、異常終了せずに決まった値を返すことを検証する
+// Mayaに依存しないのでコマンドラインで実行できる
+// 長さ0、NaN、Infを含む法線、範囲外のカラー、halfの範囲外のUV、要素数の過不足、頂点数0を与え、
+// 復元した値が有限であること、SIMD版とスカラー版が一致すること、MeasureError()が誤差の上限を超えないことを確認する
+//
+// ビルド(開発者コマンドプロンプト)
+//   cl /O2 /EHsc /I..\..\src VertexQuantizerCheck.cpp ..\..\src\engine\Graphics\VertexQuantizer.cpp ..\..\src\engine\Graphics\StreamKernels.cpp
+// ビルド(Linux)
+//   g++ -O2 -std=c++11 -I../../src VertexQuantizerCheck.cpp ../../src/engine/Graphics/VertexQuantizer.cpp ../../src/engine/Graphics/StreamKernels.cpp -o VertexQuantizerCheck
+//
+// 使い方
+//   VertexQuantizerCheck [-n vertexCount]
+//     -n : ランダムな特殊値を混ぜて確認する頂点数(既定値100000)
+//
+
+#include "engine/Graphics/VertexQuantizer.h"
+#include "engine/Graphics/StreamKernels.h"
+#include "../Common/Check.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace se;
+using namespace tools;
+
+namespace {
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float inf = std::numeric_limits<float>::infinity();
+
+	bool IsFinite(const float* values, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			if (!std::isfinite(values[i])) return false;
+		}
+		return true;
+	}
+
+	// 復元した法線は単位ベクトル
+	bool IsUnit(const float* normals, uint32_t count)
+	{
+		for (uint32_t v = 0; v < count; v++) {
+			const float* n = normals + v * 3;
+			if (!IsFinite(n, 3) || std::abs(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] - 1.0f) > 1e-4f) return false;
+		}
+		return true;
+	}
+
+	// 詰めて書き込んだ結果(SIMD版)と間隔を空けて書き込んだ結果(スカラー版)
+	bool EncodeBothPaths(VertexAttribute attribute, const float* input, uint32_t components, uint32_t vertexCount, std::vector<uint8_t>& packed)
+	{
+		const uint32_t size = VertexQuantizer::GetAttributeSize(attribute);
+		const uint32_t stride = size + 4;
+		packed.assign(static_cast<size_t>(size) * vertexCount, 0);
+		std::vector<uint8_t> strided(static_cast<size_t>(stride) * vertexCount, 0);
+		VertexQuantizer::Encode(attribute, input, components, vertexCount, packed.data(), size);
+		VertexQuantizer::Encode(attribute, input, components, vertexCount, strided.data(), stride);
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			if (memcmp(packed.data() + v * size, strided.data() + v * stride, size) != 0) return false;
+		}
+		return true;
+	}
+
+	// 縮退した法線
+	void CheckNormals()
+	{
+		const float normals[][3] = {
+			{ 0.0f, 0.0f, 0.0f },
+			{ nan, 0.0f, 1.0f },
+			{ 0.0f, nan, -1.0f },
+			{ 1.0f, 0.0f, nan },
+			{ inf, 0.0f, 0.0f },
+			{ 0.0f, -inf, 0.0f },
+			{ inf, -inf, inf },
+			{ 1.0e-40f, 0.0f, 0.0f },		// 非正規化数
+			{ 3.0e38f, 3.0e38f, 3.0e38f },		// 長さがfloatの範囲外
+			{ -0.0f, -0.0f, -1.0f },
+			{ 1.0e30f, -2.0e30f, 0.5f },
+		};
+		const uint32_t count = sizeof(normals) / sizeof(normals[0]);
+
+		std::vector<uint8_t> packed;
+		Check(EncodeBothPaths(VERTEX_ATTR_NORMAL, normals[0], 3, count, packed), "degenerate normals differ between the SIMD and scalar paths");
+
+		float decoded[count * 3];
+		VertexQuantizer::Decode(VERTEX_ATTR_NORMAL, packed.data(), 4, count, decoded, 3);
+		Check(IsUnit(decoded, count), "degenerate normals did not decode to unit vectors");
+
+		// 写像できないベクトルは+Z
+		bool zeroMapped = true;
+		for (uint32_t v = 0; v < 7; v++) {
+			if (decoded[v * 3 + 2] != 1.0f) zeroMapped = false;
+		}
+		Check(zeroMapped, "zero, NaN or Inf normal did not map to +Z");
+		Check(decoded[7 * 3] > 0.9999f, "denormal normal lost its direction");
+
+		// 写像できないものは比較せず、誤差は上限以内
+		float error = VertexQuantizer::MeasureError(VERTEX_ATTR_NORMAL, normals[0], 3, count);
+		Check(std::isfinite(error) && error <= VertexQuantizer::GetErrorBound(VERTEX_ATTR_NORMAL), "degenerate normal error");
+
+		// 要素数が足りない(0、2)、多い(4)
+		const float single[8] = { 0.0f, 1.0f, 0.0f, 5.0f, 0.0f, 0.0f, -1.0f, 7.0f };
+		int16_t encoded[4];
+		VertexQuantizer::Encode(VERTEX_ATTR_TANGENT, single, 0, 2, encoded, 4);
+		Check(encoded[0] == 0 && encoded[1] == 0 && encoded[2] == 0 && encoded[3] == 0, "normal without components");
+		VertexQuantizer::Encode(VERTEX_ATTR_TANGENT, single, 4, 2, encoded, 4);
+		VertexQuantizer::Decode(VERTEX_ATTR_TANGENT, encoded, 4, 2, decoded, 3);
+		Check(decoded[1] > 0.9999f && decoded[5] < -0.9999f, "normal with extra components");
+		VertexQuantizer::Encode(VERTEX_ATTR_BITANGENT, single, 2, 2, encoded, 4);
+		VertexQuantizer::Decode(VERTEX_ATTR_BITANGENT, encoded, 4, 2, decoded, 3);
+		Check(IsUnit(decoded, 2) && decoded[1] > 0.9999f, "normal with missing components");
+	}
+
+	// 範囲外、NaNのスカラー値
+	void CheckScalars()
+	{
+		// snorm16は[-1, 1]に丸め、NaNは-1
+		Check(VertexQuantizer::FloatToSnorm16(nan) == -32767, "snorm16 NaN");
+		Check(VertexQuantizer::FloatToSnorm16(inf) == 32767 && VertexQuantizer::FloatToSnorm16(-inf) == -32767, "snorm16 Inf");
+		Check(VertexQuantizer::FloatToSnorm16(1.0e30f) == 32767 && VertexQuantizer::FloatToSnorm16(-2.0f) == -32767, "snorm16 out of range");
+
+		// halfはNaN、Infを保ち、範囲外はInf、小さすぎるものは0
+		uint16_t h = VertexQuantizer::FloatToHalf(nan);
+		Check((h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0 && std::isnan(VertexQuantizer::HalfToFloat(h)), "half NaN");
+		Check(VertexQuantizer::FloatToHalf(inf) == 0x7c00 && VertexQuantizer::FloatToHalf(-inf) == 0xfc00, "half Inf");
+		Check(VertexQuantizer::FloatToHalf(1.0e6f) == 0x7c00 && VertexQuantizer::FloatToHalf(-1.0e-30f) == 0x8000, "half out of range");
+
+		// SIMD版とスカラー版が特殊値で一致(8要素ずつSIMDで処理される)
+		const float values[16] = { nan, -nan, inf, -inf, 1.0e30f, -1.0e30f, 1.0e-40f, -0.0f, 65504.0f, 65520.0f, -65536.0f, 2.0f, -2.0f, 0.5f, nan, 1.0f };
+		uint16_t halfSimd[16];
+		uint16_t halfScalar[16];
+		StreamKernels::FloatToHalf(values, 16, halfSimd);
+		StreamKernels::FloatToHalfScalar(values, 16, halfScalar);
+		Check(memcmp(halfSimd, halfScalar, sizeof(halfSimd)) == 0, "half special values differ between the SIMD and scalar paths");
+		int16_t snormSimd[16];
+		int16_t snormScalar[16];
+		StreamKernels::FloatToSnorm16(values, 16, snormSimd);
+		StreamKernels::FloatToSnorm16Scalar(values, 16, snormScalar);
+		Check(memcmp(snormSimd, snormScalar, sizeof(snormSimd)) == 0, "snorm16 special values differ between the SIMD and scalar paths");
+
+		// カラーは[0, 1]に丸め、NaNは0、足りないアルファは1
+		const float colors[8] = { nan, inf, -inf, 2.0f, -1.0f, 0.5f, nan, nan };
+		uint8_t encoded[8];
+		VertexQuantizer::Encode(VERTEX_ATTR_COLOR, colors, 4, 2, encoded, 4);
+		const uint8_t expected[8] = { 0, 255, 0, 255, 0, 128, 0, 0 };
+		Check(memcmp(encoded, expected, sizeof(expected)) == 0, "color out of range");
+		VertexQuantizer::Encode(VERTEX_ATTR_COLOR, colors + 3, 3, 1, encoded, 4);
+		Check(encoded[3] == 255, "color without alpha");
+		float error = VertexQuantizer::MeasureError(VERTEX_ATTR_COLOR, colors, 4, 2);
+		Check(std::isfinite(error) && error <= VertexQuantizer::GetErrorBound(VERTEX_ATTR_COLOR), "out of range color error");
+
+		// halfの範囲外、NaNのUVは誤差の比較から除く
+		const float uvs[8] = { nan, 0.25f, 1.0e6f, -inf, 0.5f, 65504.0f, -0.0f, 1.0e-40f };
+		error = VertexQuantizer::MeasureError(VERTEX_ATTR_TEXCOORD0, uvs, 2, 4);
+		Check(std::isfinite(error) && error <= VertexQuantizer::GetErrorBound(VERTEX_ATTR_TEXCOORD0), "out of range uv error");
+	}
+
+	// 頂点数0、要素数0
+	void CheckEmpty()
+	{
+		for (uint32_t i = 0; i < VERTEX_ATTR_NUM; i++) {
+			VertexAttribute attribute = static_cast<VertexAttribute>(i);
+			uint32_t size = VertexQuantizer::GetAttributeSize(attribute);
+			VertexQuantizer::Encode(attribute, nullptr, 3, 0, nullptr, size);
+			VertexQuantizer::Decode(attribute, nullptr, size, 0, nullptr, 3);
+			Check(VertexQuantizer::MeasureError(attribute, nullptr, 3, 0) == 0.0f, "error without vertices");
+			Check(size > 0 && size % 4 == 0, "attribute size");
+		}
+		StreamKernels::FloatToHalf(nullptr, 0, nullptr);
+		StreamKernels::EncodeOctahedral(nullptr, 3, 0, nullptr);
+
+		// 要素数0は既定値(UVは0)
+		uint16_t uv[4] = { 1, 1, 1, 1 };
+		const float dummy = 1.0f;
+		VertexQuantizer::Encode(VERTEX_ATTR_TEXCOORD1, &dummy, 0, 2, uv, 4);
+		Check(uv[0] == 0 && uv[1] == 0 && uv[2] == 0 && uv[3] == 0, "uv without components");
+
+		// 復元先の要素数が多い場合は0で埋める
+		float decoded[6] = { 9.0f, 9.0f, 9.0f, 9.0f, 9.0f, 9.0f };
+		VertexQuantizer::Decode(VERTEX_ATTR_TEXCOORD1, uv, 4, 1, decoded, 6);
+		Check(decoded[0] == 0.0f && decoded[3] == 1.0f && decoded[4] == 0.0f && decoded[5] == 0.0f, "decode with extra components");
+	}
+
+	// 特殊値を混ぜたランダムな法線、UV
+	void CheckRandom(uint32_t count)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+		const float specials[] = { 0.0f, -0.0f, nan, inf, -inf, 1.0e-40f, 3.0e38f, -3.0e38f, 1.0e6f };
+		std::vector<float> data(static_cast<size_t>(count) * 3);
+		for (float& f : data) {
+			f = (random() % 8 == 0) ? specials[random() % (sizeof(specials) / sizeof(specials[0]))] : value(random);
+		}
+
+		std::vector<uint8_t> packed;
+		Check(EncodeBothPaths(VERTEX_ATTR_NORMAL, data.data(), 3, count, packed), "random special normals differ between the SIMD and scalar paths");
+		std::vector<float> decoded(static_cast<size_t>(count) * 3);
+		VertexQuantizer::Decode(VERTEX_ATTR_NORMAL, packed.data(), 4, count, decoded.data(), 3);
+		Check(IsUnit(decoded.data(), count), "random special normals did not decode to unit vectors");
+		float normalError = VertexQuantizer::MeasureError(VERTEX_ATTR_NORMAL, data.data(), 3, count);
+		Check(normalError <= VertexQuantizer::GetErrorBound(VERTEX_ATTR_NORMAL), "random special normal error");
+
+		uint32_t uvCount = static_cast<uint32_t>(data.size() / 2);
+		Check(EncodeBothPaths(VERTEX_ATTR_TEXCOORD0, data.data(), 2, uvCount, packed), "random special uvs differ between the SIMD and scalar paths");
+		float uvError = VertexQuantizer::MeasureError(VERTEX_ATTR_TEXCOORD0, data.data(), 2, uvCount);
+		Check(uvError <= VertexQuantizer::GetErrorBound(VERTEX_ATTR_TEXCOORD0), "random special uv error");
+
+		printf("vertex: %u, normal error: %g (bound %g), uv error: %g (bound %g)\n", count,
+			normalError, VertexQuantizer::GetErrorBound(VERTEX_ATTR_NORMAL), uvError, VertexQuantizer::GetErrorBound(VERTEX_ATTR_TEXCOORD0));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = 100000;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = static_cast<uint32_t>(atoi(argv[++i]));
+		} else {
+			printf("usage: VertexQuantizerCheck [-n vertexCount]\n");
+			return 1;
+		}
+	}
+
+	CheckNormals();
+	CheckScalars();
+	CheckEmpty();
+	CheckRandom(count);
+
+	return Finish();
+}